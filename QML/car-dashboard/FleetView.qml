@@ -0,0 +1,71 @@
+import QtQuick
+import QtQuick.Controls
+
+// Control-room overview of a whole fleet, one tile per vehicle
+ApplicationWindow {
+    id: fleetWindow
+
+    property int vehicleCount: 10000
+    property int tickRateHz: 10
+
+    visible: true
+    width: 1280
+    height: 800
+    title: "Fleet View - " + vehicleCount + " vehicles"
+    color: "#1A1A2E"
+
+    // Steps every vehicle on worker threads, off the GUI thread
+    FleetSimulationEngine {
+        id: simulation
+        vehicleCount: fleetWindow.vehicleCount
+        tickRateHz: fleetWindow.tickRateHz
+        running: true
+    }
+
+    FleetModel {
+        id: fleetModel
+        vehicleCount: fleetWindow.vehicleCount
+        engine: simulation
+    }
+
+    // Pick up the latest tick and publish the changes once per frame
+    FrameAnimation {
+        running: true
+        onTriggered: fleetModel.flushChanges()
+    }
+
+    GridView {
+        id: grid
+        anchors.fill: parent
+        anchors.margins: 4
+        model: fleetModel
+        cellWidth: 32
+        cellHeight: 32
+        reuseItems: true
+        clip: true
+
+        delegate: Rectangle {
+            required property int speed
+            required property int fuelLevel
+            required property bool engineWarning
+
+            width: grid.cellWidth - 2
+            height: grid.cellHeight - 2
+            radius: 3
+            color: Qt.hsla(0.33 * (1 - speed / 220), 0.8, 0.35, 1)
+            border.width: engineWarning ? 2 : 0
+            border.color: "red"
+
+            // Fuel level as a bar along the bottom edge
+            Rectangle {
+                anchors.left: parent.left
+                anchors.bottom: parent.bottom
+                height: 3
+                width: parent.width * fuelLevel / 100
+                color: fuelLevel < 20 ? "red" : "white"
+            }
+        }
+
+        ScrollBar.vertical: ScrollBar {}
+    }
+}
@@ -7,16 +7,28 @@ Item {
         color: "#333"
 
         Rectangle {
-            width: parent.width * (dashboardManager.fuelLevel / 100)
+            width: parent.width * (DashboardManager.displayFuelLevel / 100)
             height: parent.height
-            color: dashboardManager.fuelLevel < 20 ? "red" : "green"
+            // Re-evaluated only when lowFuel flips, not on every fuel sample
+            color: DashboardManager.lowFuel ? "red" : "green"
         }
 
         Text {
             anchors.centerIn: parent
-            text: dashboardManager.fuelLevel + "%"
+            text: DashboardManager.fuelLevel + "%"
             color: "white"
             font.pixelSize: 24
         }
+
+        Text {
+            anchors {
+                right: parent.right
+                bottom: parent.bottom
+                margins: 4
+            }
+            text: Math.round(DashboardManager.rangeKm) + " km"
+            color: "white"
+            font.pixelSize: 12
+        }
     }
 }
@@ -4,11 +4,21 @@ import QtQuick.Layouts
 import QtQuick.Particles
 
 ApplicationWindow {
+    id: appWindow
     visible: true
     width: 1024
     height: 600
     title: "Car Dashboard"
 
+    // Map file for the navigation display; empty shows a generated city
+    property string mapFile
+
+    // Steps the decorative layers down when frames run over budget
+    FrameGovernor {
+        id: governor
+        window: appWindow
+    }
+
     // Animated background with particle and gradient effects
     Rectangle {
         id: backgroundRoot
@@ -30,7 +40,7 @@ ApplicationWindow {
 
         // Animated color transitions
         SequentialAnimation {
-            running: true
+            running: governor.quality === FrameGovernor.Full
             loops: Animation.Infinite
 
             ColorAnimation {
@@ -59,67 +69,79 @@ ApplicationWindow {
             }
         }
 
-        // Particle system for subtle background movement
-        ParticleSystem {
-            id: particleSystem
+        // Decorative layers are incubated asynchronously so they do not
+        // delay the first frame with the gauges
+        Loader {
             anchors.fill: parent
-
-            ImageParticle {
-                source: "particle.png"
-                color: "#30FFFFFF"
-                colorVariation: 0.3
-                rotation: 0
-                rotationVariation: 360
-                entryEffect: ImageParticle.Scale
-            }
-
-            Emitter {
-                width: parent.width
-                height: parent.height
-                anchors.fill: parent
-                system: particleSystem
-
-                emitRate: 20
-                lifeSpan: 6000
-
-                velocity: PointDirection {
-                    x: -10
-                    y: 20
-                    xVariation: 10
-                    yVariation: 10
+            asynchronous: true
+            sourceComponent: Item {
+                // Particle system for subtle background movement
+                ParticleSystem {
+                    id: particleSystem
+                    anchors.fill: parent
+                    running: governor.quality !== FrameGovernor.Minimal
+
+                    ImageParticle {
+                        source: "particle.png"
+                        color: "#30FFFFFF"
+                        colorVariation: 0.3
+                        rotation: 0
+                        rotationVariation: 360
+                        entryEffect: ImageParticle.Scale
+                    }
+
+                    Emitter {
+                        width: parent.width
+                        height: parent.height
+                        anchors.fill: parent
+                        system: particleSystem
+
+                        emitRate: governor.quality === FrameGovernor.Full ? 20 : 5
+                        lifeSpan: 6000
+
+                        velocity: PointDirection {
+                            x: -10
+                            y: 20
+                            xVariation: 10
+                            yVariation: 10
+                        }
+
+                        size: 10
+                        sizeVariation: 20
+                    }
                 }
 
-                size: 10
-                sizeVariation: 20
-            }
-        }
-
-        // Subtle grid overlay
-        Canvas {
-            anchors.fill: parent
-            opacity: 0.1
-
-            onPaint: {
-                var ctx = getContext("2d");
-                ctx.reset();
-
-                ctx.strokeStyle = "rgba(255,255,255,0.05)";
-                ctx.lineWidth = 1;
-
-                // Vertical lines
-                for (var x = 0; x < width; x += 50) {
-                    ctx.beginPath();
-                    ctx.moveTo(x, 0);
-                    ctx.lineTo(x, height);
-                    ctx.stroke();
-                }
-
-                // Horizontal lines
-                for (var y = 0; y < height; y += 50) {
-                    ctx.beginPath();
-                    ctx.moveTo(0, y);
-                    ctx.lineTo(width, y);
-                    ctx.stroke();
+                // Subtle grid overlay, painted once into a cached image
+                Canvas {
+                    anchors.fill: parent
+                    opacity: 0.1
+                    renderTarget: Canvas.Image
+                    renderStrategy: Canvas.Immediate
+                    visible: governor.quality !== FrameGovernor.Minimal
+
+                    onPaint: {
+                        var ctx = getContext("2d");
+                        ctx.reset();
+
+                        ctx.strokeStyle = "rgba(255,255,255,0.05)";
+                        ctx.lineWidth = 1;
+
+                        // Vertical lines
+                        for (var x = 0; x < width; x += 50) {
+                            ctx.beginPath();
+                            ctx.moveTo(x, 0);
+                            ctx.lineTo(x, height);
+                            ctx.stroke();
+                        }
+
+                        // Horizontal lines
+                        for (var y = 0; y < height; y += 50) {
+                            ctx.beginPath();
+                            ctx.moveTo(0, y);
+                            ctx.lineTo(width, y);
+                            ctx.stroke();
+                        }
+                    }
                 }
             }
         }
@@ -140,11 +162,21 @@ ApplicationWindow {
                 }
 
                 Text {
-                    text: dashboardManager.currentGear
+                    text: DashboardManager.gearLabel
                     font.pixelSize: 48
                     color: "white"
                     Layout.alignment: Qt.AlignCenter
                 }
+
+                // Speed over the last five minutes
+                Sparkline {
+                    Layout.fillWidth: true
+                    Layout.preferredHeight: 60
+                    source: DashboardManager
+                    channel: Sparkline.Speed
+                    windowSeconds: DashboardManager.historySeconds
+                    lineColor: "#4CAF50"
+                }
             }
 
             // Center - Speedometer
@@ -163,7 +195,17 @@ ApplicationWindow {
                     Layout.preferredHeight: parent.height * 0.3
                 }
 
+                Sparkline {
+                    Layout.fillWidth: true
+                    Layout.preferredHeight: 40
+                    source: DashboardManager
+                    channel: Sparkline.FuelLevel
+                    windowSeconds: DashboardManager.historySeconds
+                    lineColor: "#FFC107"
+                }
+
                 NavigationDisplay {
+                    mapFile: appWindow.mapFile
                     Layout.fillWidth: true
                     Layout.fillHeight: true
                 }
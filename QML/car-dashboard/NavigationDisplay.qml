@@ -2,16 +2,136 @@ import QtQuick
 import QtQuick.Controls
 
 Item {
+    id: root
+
+    // Map file to show; empty shows a generated city
+    property string mapFile
+
     Rectangle {
         anchors.fill: parent
         color: "#333"
+        clip: true
+
+        MapView {
+            id: map
+            anchors.fill: parent
+            source: DashboardManager
+            mapFile: root.mapFile
+        }
+
+        DragHandler {
+            property vector2d previous
+
+            target: null
+            onActiveChanged: previous = Qt.vector2d(0, 0)
+            onActiveTranslationChanged: {
+                map.pan(activeTranslation.x - previous.x, activeTranslation.y - previous.y)
+                previous = activeTranslation
+            }
+        }
+
+        WheelHandler {
+            target: null
+            onWheel: (event) => map.zoomAt(event.angleDelta.y / 480, point.position)
+        }
+
+        // Hold on the map to route there
+        TapHandler {
+            onLongPressed: map.setDestinationAt(point.position)
+        }
+
+        PinchHandler {
+            target: null
+            onScaleChanged: (delta) => map.zoomAt(Math.log2(delta), centroid.position)
+        }
+
+        Rectangle {
+            visible: map.hasDestination
+            x: map.destinationPoint.x - width / 2
+            y: map.destinationPoint.y - height / 2
+            width: 12
+            height: 12
+            radius: 6
+            color: "#F44336"
+            border.color: "white"
+            border.width: 2
+        }
+
+        // Vehicle marker, pointing along the direction of travel
+        Text {
+            visible: map.status === MapView.Ready
+            x: map.vehiclePoint.x - width / 2
+            y: map.vehiclePoint.y - height / 2
+            rotation: map.vehicleHeading
+            text: "▲"
+            color: "#4FC3F7"
+            font.pixelSize: 18
+        }
 
         Text {
             anchors.centerIn: parent
-            text: "Navigation\nSystem"
+            visible: map.status !== MapView.Ready
+            text: map.status === MapView.Error ? map.errorString : "Loading map…"
             color: "white"
-            font.pixelSize: 24
+            font.pixelSize: 16
             horizontalAlignment: Text.AlignHCenter
+            wrapMode: Text.Wrap
+            width: parent.width - 20
+        }
+
+        Column {
+            anchors.left: parent.left
+            anchors.top: parent.top
+            anchors.margins: 6
+            visible: map.hasDestination
+
+            Text {
+                text: "%1 km · %2 min"
+                    .arg((map.routeDistance / 1000).toFixed(1))
+                    .arg(Math.ceil(map.routeTimeSeconds / 60))
+                color: "white"
+                font.pixelSize: 14
+            }
+
+            Text {
+                text: "route %1 ms (search %2 µs) · %3 reroutes"
+                    .arg(map.routeLatencyMs.toFixed(1))
+                    .arg(Math.round(map.routeQueryUs))
+                    .arg(map.reroutes)
+                color: "#80FFFFFF"
+                font.pixelSize: 9
+            }
+
+            Button {
+                text: "Cancel route"
+                onClicked: map.clearDestination()
+            }
+        }
+
+        Button {
+            anchors.right: parent.right
+            anchors.top: parent.top
+            anchors.margins: 6
+            visible: !map.followVehicle
+            text: "Recenter"
+            onClicked: map.recenter()
+        }
+
+        Text {
+            anchors.left: parent.left
+            anchors.bottom: parent.bottom
+            anchors.margins: 4
+            visible: map.status === MapView.Ready
+            text: "mem %1% · disk %2% · decode %3/%4 ms · render %5/%6 ms · %7 pending"
+                .arg(Math.round(map.memoryHitRate * 100))
+                .arg(Math.round(map.diskHitRate * 100))
+                .arg(map.decodeLatencyMs.toFixed(1))
+                .arg(map.decodeLatencyP95Ms.toFixed(1))
+                .arg(map.renderLatencyMs.toFixed(1))
+                .arg(map.renderLatencyP95Ms.toFixed(1))
+                .arg(map.pendingTiles)
+            color: "#80FFFFFF"
+            font.pixelSize: 9
         }
     }
 }
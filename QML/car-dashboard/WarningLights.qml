@@ -6,18 +6,32 @@ Item {
         anchors.fill: parent
         color: "#222"
 
-        Rectangle {
-            width: 50
-            height: 50
-            anchors.centerIn: parent
-            color: dashboardManager.engineWarning ? "red" : "gray"
-            radius: 25
+        // One lamp per indicator of the warning rules. Each delegate binds
+        // only its own row, so a change repaints just the lamps it affects.
+        Flow {
+            anchors.fill: parent
+            anchors.margins: 8
+            spacing: 8
 
-            Text {
-                anchors.centerIn: parent
-                text: "ENG"
-                color: "white"
-                font.pixelSize: 14
+            Repeater {
+                model: DashboardManager.warningIndicators
+
+                delegate: Rectangle {
+                    required property string name
+                    required property bool active
+
+                    width: 50
+                    height: 50
+                    color: active ? "red" : "gray"
+                    radius: 25
+
+                    Text {
+                        anchors.centerIn: parent
+                        text: parent.name.substring(0, 3).toUpperCase()
+                        color: "white"
+                        font.pixelSize: 14
+                    }
+                }
             }
         }
     }
@@ -0,0 +1,21 @@
+import QtQml
+import BindingBenchmark
+
+// The same values read from DashboardManager's C++ bindings, as
+// FuelGauge.qml and Speedometer.qml read them
+QtObject {
+    property EvaluationCounter counter: EvaluationCounter {}
+
+    property color fuelColor: {
+        counter.count();
+        return DashboardManager.lowFuel ? "red" : "green";
+    }
+    property real gaugeValue: {
+        counter.count();
+        return DashboardManager.speedRatio;
+    }
+    property string rangeText: {
+        counter.count();
+        return Math.round(DashboardManager.rangeKm) + " km";
+    }
+}
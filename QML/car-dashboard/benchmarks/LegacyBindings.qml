@@ -0,0 +1,28 @@
+import QtQml
+import BindingBenchmark
+
+// The derived gauge values as the dashboard computed them in JavaScript
+// before DashboardManager had bindable properties: the fuel color from
+// fuelLevel, the gauge from displaySpeed over the maximum speed, and the
+// range as FuelGauge.qml would have had to derive it
+QtObject {
+    property EvaluationCounter counter: EvaluationCounter {}
+
+    // DashboardManager's constants, set by the benchmark
+    required property int maxSpeed
+    required property int lowFuelThreshold
+    required property real fullTankRangeKm
+
+    property color fuelColor: {
+        counter.count();
+        return DashboardManager.fuelLevel < lowFuelThreshold ? "red" : "green";
+    }
+    property real gaugeValue: {
+        counter.count();
+        return DashboardManager.displaySpeed / maxSpeed;
+    }
+    property string rangeText: {
+        counter.count();
+        return Math.round(DashboardManager.displayFuelLevel / 100 * fullTankRangeKm) + " km";
+    }
+}
@@ -0,0 +1,14 @@
+import QtQuick
+
+Item {
+    property real speed: 0
+
+    width: 480
+    height: 480
+
+    SpeedometerGauge {
+        anchors.fill: parent
+        value: speed
+        maximumValue: 220
+    }
+}
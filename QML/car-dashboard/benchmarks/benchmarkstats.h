@@ -0,0 +1,48 @@
+#ifndef BENCHMARKSTATS_H
+#define BENCHMARKSTATS_H
+
+#include <QList>
+#include <QString>
+#include <algorithm>
+
+// Summary of a series of measurements, in the unit they were recorded in.
+struct BenchmarkStats {
+    qsizetype count = 0;
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double max = 0;
+
+    static BenchmarkStats from(QList<double> values)
+    {
+        BenchmarkStats stats;
+        stats.count = values.size();
+        if (values.isEmpty()) {
+            return stats;
+        }
+
+        std::sort(values.begin(), values.end());
+        double sum = 0;
+        for (double value : values) {
+            sum += value;
+        }
+        stats.mean = sum / values.size();
+        stats.p50 = values.at(values.size() / 2);
+        stats.p99 = values.at(qMin(values.size() - 1, values.size() * 99 / 100));
+        stats.max = values.constLast();
+        return stats;
+    }
+
+    QString toString(const char *unit) const
+    {
+        return QStringLiteral("n=%1 mean=%2%6 p50=%3%6 p99=%4%6 max=%5%6")
+            .arg(count)
+            .arg(mean, 0, 'f', 3)
+            .arg(p50, 0, 'f', 3)
+            .arg(p99, 0, 'f', 3)
+            .arg(max, 0, 'f', 3)
+            .arg(QLatin1String(unit));
+    }
+};
+
+#endif // BENCHMARKSTATS_H
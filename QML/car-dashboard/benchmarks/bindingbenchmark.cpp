@@ -0,0 +1,128 @@
+// QML binding cost of the dashboard's derived gauge values before and after
+// DashboardManager moved to bindable properties.
+//
+// Both variants bind the fuel color, gauge value and range text to the
+// DashboardManager singleton and are fed the same simulated 1 kHz drive
+// through DashboardManager::applySample(). Before, the bindings derive
+// the values in JavaScript from fuelLevel, displaySpeed and
+// displayFuelLevel and re-evaluate on every change of those; after, they
+// read speedRatio, rangeKm and lowFuel, which C++ bindings derive, and
+// only re-evaluate when the value they read has changed.
+//
+//   binding-benchmark [--samples <n>] [--repeat <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QRandomGenerator>
+#include <memory>
+#include "benchmarkstats.h"
+#include "dashboardmanager.h"
+#include "evaluationcounter.h"
+#include "vehiclesimulation.h"
+
+namespace {
+
+constexpr double SamplePeriodS = 0.001;
+
+struct Result {
+    QList<double> samplesPerSecond;
+    qint64 evaluations = 0;
+};
+
+Result run(QQmlEngine &engine, DashboardManager &manager, const char *file,
+           const QVariantMap &properties, const std::vector<TelemetrySample> &drive, int repeat) {
+    Result result;
+    for (int r = 0; r < repeat; ++r) {
+        // Every run starts from the same state
+        manager.applySample(TelemetrySample());
+
+        QQmlComponent component(&engine, QUrl(QStringLiteral("qrc:/qt/qml/BindingBenchmark/%1")
+                                                  .arg(QLatin1String(file))));
+        std::unique_ptr<QObject> root(component.createWithInitialProperties(properties));
+        if (!root) {
+            qFatal("Cannot load %s: %s", file, qPrintable(component.errorString()));
+        }
+        auto *counter = root->property("counter").value<EvaluationCounter *>();
+
+        const qint64 initialEvaluations = counter->evaluations();
+        QElapsedTimer timer;
+        timer.start();
+        for (const TelemetrySample &sample : drive) {
+            manager.applySample(sample);
+        }
+        result.samplesPerSecond.append(drive.size() * 1e9 / timer.nsecsElapsed());
+        result.evaluations = counter->evaluations() - initialEvaluations;
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption samplesOption("samples", "Samples fed per run.", "n", "100000");
+    QCommandLineOption repeatOption("repeat", "Runs per variant.", "n", "10");
+    parser.addOption(samplesOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    const int samples = qMax(1, parser.value(samplesOption).toInt());
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+
+    QRandomGenerator rng(42);
+    std::vector<TelemetrySample> drive;
+    drive.reserve(std::size_t(samples));
+    VehicleSimulation::ContinuousState state;
+    for (int i = 0; i < samples; ++i) {
+        VehicleSimulation::advance(state, SamplePeriodS, rng);
+        // Refuel when empty so the whole run is not spent at zero
+        if (state.fuelLevel <= 0) {
+            state.fuelLevel = 100;
+        }
+        TelemetrySample sample;
+        sample.speed = qint16(qRound(state.speed));
+        sample.fuelLevel = qint8(qRound(state.fuelLevel));
+        sample.gear = state.gear;
+        drive.push_back(sample);
+    }
+
+    QQmlEngine engine;
+    auto *manager = engine.singletonInstance<DashboardManager *>("BindingBenchmark", "DashboardManager");
+    if (!manager) {
+        qFatal("Cannot create the DashboardManager singleton");
+    }
+
+    const QVariantMap constants = {
+        { QStringLiteral("maxSpeed"), DashboardManager::MaxSpeed },
+        { QStringLiteral("lowFuelThreshold"), DashboardManager::LowFuelThreshold },
+        { QStringLiteral("fullTankRangeKm"), DashboardManager::FullTankRangeKm },
+    };
+    const struct {
+        const char *name;
+        const char *file;
+        QVariantMap properties;
+    } variants[] = {
+        { "JavaScript bindings on classic properties", "LegacyBindings.qml", constants },
+        { "Bindings on C++ bindable properties", "BindableBindings.qml", QVariantMap() },
+    };
+
+    for (const auto &variant : variants) {
+        const Result result = run(engine, *manager, variant.file, variant.properties, drive, repeat);
+        const BenchmarkStats stats = BenchmarkStats::from(result.samplesPerSecond);
+        qInfo("%s", variant.name);
+        qInfo("  %lld binding evaluations for %d samples (%.3f per sample)",
+              result.evaluations, samples, double(result.evaluations) / samples);
+        qInfo("  %.0f binding evaluations/s at %.0f samples/s",
+              stats.mean * result.evaluations / samples, stats.mean);
+        qInfo("  samples/s %s", qPrintable(stats.toString("")));
+    }
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef EVALUATIONCOUNTER_H
+#define EVALUATIONCOUNTER_H
+
+#include <QObject>
+#include <QtQml/qqmlregistration.h>
+
+// Bindings call count() so the benchmark can tell how often QML
+// re-evaluated them
+class EvaluationCounter : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    using QObject::QObject;
+
+    Q_INVOKABLE void count() { ++m_evaluations; }
+    qint64 evaluations() const { return m_evaluations; }
+
+private:
+    qint64 m_evaluations = 0;
+};
+
+#endif // EVALUATIONCOUNTER_H
@@ -0,0 +1,100 @@
+// Update throughput of the fleet telemetry store and model.
+//
+// For each scenario it measures how many vehicle updates per second the
+// store absorbs and what the once-per-frame flush costs, including the
+// number of dataChanged signals a connected view would receive.
+//
+//   fleet-benchmark [--vehicles <n>] [--ticks <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include "benchmarkstats.h"
+#include "fleetmodel.h"
+
+namespace {
+
+struct Scenario {
+    const char *name;
+    double updateFraction;  // share of the fleet updated per tick
+    int maxMergeGap;
+};
+
+void runScenario(const Scenario &scenario, int vehicles, int ticks) {
+    FleetModel model;
+    model.setVehicleCount(vehicles);
+    model.setMaxMergeGap(scenario.maxMergeGap);
+
+    // Stand-in for a view: count the notifications it would process
+    qint64 signalsReceived = 0;
+    QObject::connect(&model, &QAbstractItemModel::dataChanged, &model, [&signalsReceived] {
+        ++signalsReceived;
+    });
+
+    QRandomGenerator rng(42);
+    const int updatesPerTick = qMax(1, int(vehicles * scenario.updateFraction));
+    QList<double> updateUs;
+    QList<double> flushUs;
+    QElapsedTimer timer;
+
+    for (int tick = 0; tick < ticks; ++tick) {
+        timer.start();
+        if (updatesPerTick >= vehicles) {
+            model.simulateTick();
+        } else {
+            for (int i = 0; i < updatesPerTick; ++i) {
+                const int row = rng.bounded(vehicles);
+                TelemetrySample sample = model.store().sample(row);
+                sample.speed = qint16(rng.bounded(221));
+                model.updateVehicle(row, sample);
+            }
+        }
+        updateUs.append(timer.nsecsElapsed() / 1e3);
+
+        timer.start();
+        model.flushChanges();
+        flushUs.append(timer.nsecsElapsed() / 1e3);
+    }
+
+    const BenchmarkStats update = BenchmarkStats::from(updateUs);
+    const BenchmarkStats flush = BenchmarkStats::from(flushUs);
+    qInfo("%s", scenario.name);
+    qInfo("  update %s", qPrintable(update.toString("us")));
+    qInfo("  flush  %s", qPrintable(flush.toString("us")));
+    qInfo("  %.1f M vehicle updates/s, %.1f dataChanged per flush, %.0f rows per signal",
+          updatesPerTick / (update.mean + flush.mean),
+          double(signalsReceived) / ticks,
+          signalsReceived ? double(model.updatedRows()) / signalsReceived : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption vehiclesOption("vehicles", "Fleet size.", "n", "10000");
+    QCommandLineOption ticksOption("ticks", "Update/flush cycles per scenario.", "n", "1000");
+    parser.addOption(vehiclesOption);
+    parser.addOption(ticksOption);
+    parser.process(app);
+
+    const int vehicles = parser.value(vehiclesOption).toInt();
+    const int ticks = parser.value(ticksOption).toInt();
+    qInfo("%d vehicles, %d ticks per scenario", vehicles, ticks);
+
+    const Scenario scenarios[] = {
+        { "whole fleet per tick, merged ranges", 1.0, 16 },
+        { "10% of the fleet per tick, merged ranges", 0.1, 16 },
+        { "10% of the fleet per tick, one signal per run", 0.1, 0 },
+        { "1% of the fleet per tick, merged ranges", 0.01, 16 },
+    };
+    for (const Scenario &scenario : scenarios) {
+        runScenario(scenario, vehicles, ticks);
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Tick throughput of FleetSimulationEngine as worker threads are added.
+//
+// The same fleet is simulated from the same seed with 1, 2, 4, ... threads
+// up to the machine's thread count. Because every vehicle owns its random
+// stream, the final fleet state must be identical for every thread count;
+// the benchmark checks that as well.
+//
+//   fleet-simulation-benchmark [--vehicles <n>] [--ticks <n>] [--max-threads <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include "benchmarkstats.h"
+#include "fleetsimulationengine.h"
+
+namespace {
+
+constexpr quint64 Seed = 42;
+constexpr int WarmupTicks = 5;
+
+struct Result {
+    double ticksPerSecond;
+    BenchmarkStats tickUs;
+    quint64 stolenChunks;
+    quint64 checksum;
+};
+
+quint64 checksum(const FleetSnapshot &snapshot) {
+    quint64 sum = 0;
+    for (const TelemetrySample &vehicle : snapshot.vehicles) {
+        sum = sum * 31 + quint64(vehicle.speed) * 7 + quint64(vehicle.fuelLevel) * 3
+              + quint64(vehicle.gear) + (vehicle.engineWarning ? 1 : 0);
+    }
+    return sum;
+}
+
+Result run(int vehicles, int ticks, int threads) {
+    FleetSimulationEngine engine;
+    engine.setVehicleCount(vehicles);
+    engine.setThreadCount(threads);
+    engine.reset(Seed);
+
+    for (int i = 0; i < WarmupTicks; ++i) {
+        engine.tick();
+    }
+
+    const quint64 stolenBefore = engine.stolenChunks();
+    QList<double> tickUs;
+    tickUs.reserve(ticks);
+    QElapsedTimer total;
+    QElapsedTimer timer;
+    total.start();
+    for (int i = 0; i < ticks; ++i) {
+        timer.start();
+        engine.tick();
+        tickUs.append(timer.nsecsElapsed() / 1e3);
+    }
+    const qint64 elapsedNs = total.nsecsElapsed();
+
+    return {
+        ticks * 1e9 / double(elapsedNs),
+        BenchmarkStats::from(tickUs),
+        engine.stolenChunks() - stolenBefore,
+        checksum(*engine.latestSnapshot())
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption vehiclesOption("vehicles", "Fleet size.", "n", "100000");
+    QCommandLineOption ticksOption("ticks", "Measured ticks per thread count.", "n", "200");
+    QCommandLineOption maxThreadsOption("max-threads", "Largest worker count measured.", "n",
+                                        QString::number(QThread::idealThreadCount()));
+    parser.addOption(vehiclesOption);
+    parser.addOption(ticksOption);
+    parser.addOption(maxThreadsOption);
+    parser.process(app);
+
+    const int vehicles = parser.value(vehiclesOption).toInt();
+    const int ticks = parser.value(ticksOption).toInt();
+    const int maxThreads = qMax(1, parser.value(maxThreadsOption).toInt());
+    qInfo("%d vehicles, %d ticks per thread count", vehicles, ticks);
+
+    QList<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.append(threads);
+    }
+    threadCounts.append(maxThreads);
+
+    double baseline = 0;
+    quint64 expectedChecksum = 0;
+    bool deterministic = true;
+    for (int threads : threadCounts) {
+        const Result result = run(vehicles, ticks, threads);
+        if (threads == 1) {
+            baseline = result.ticksPerSecond;
+            expectedChecksum = result.checksum;
+        }
+        deterministic = deterministic && result.checksum == expectedChecksum;
+
+        const double speedup = result.ticksPerSecond / baseline;
+        qInfo("%3d threads: %8.1f ticks/s, %7.1f M vehicle steps/s, speedup %5.2fx, "
+              "efficiency %3.0f%%, %.1f steals/tick",
+              threads, result.ticksPerSecond, result.ticksPerSecond * vehicles / 1e6,
+              speedup, 100.0 * speedup / threads, double(result.stolenChunks) / ticks);
+        qInfo("             tick %s", qPrintable(result.tickUs.toString("us")));
+    }
+
+    if (!deterministic) {
+        qWarning("Fleet state differs between thread counts");
+        return 1;
+    }
+    qInfo("Fleet state identical for every thread count");
+    return 0;
+}
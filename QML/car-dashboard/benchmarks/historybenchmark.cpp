@@ -0,0 +1,83 @@
+// Query cost of the telemetry history behind the sparklines.
+//
+// Fills one signal with an hour of 1 kHz samples, then times the work a
+// Sparkline does per refresh (rolling statistics plus LTTB downsampling to
+// the chart width) for windows from a minute to the whole hour.
+//
+//   history-benchmark [--hours <n>] [--rate <hz>] [--width <px>] [--repeat <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+#include "benchmarkstats.h"
+#include "telemetryhistory.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption hoursOption("hours", "Hours of history to fill.", "n", "1");
+    QCommandLineOption rateOption("rate", "Sample rate of the history.", "hz", "1000");
+    QCommandLineOption widthOption("width", "Chart width in pixels.", "px", "800");
+    QCommandLineOption repeatOption("repeat", "Queries per window.", "n", "50");
+    parser.addOption(hoursOption);
+    parser.addOption(rateOption);
+    parser.addOption(widthOption);
+    parser.addOption(repeatOption);
+    parser.process(app);
+
+    const double hours = parser.value(hoursOption).toDouble();
+    const int rateHz = qMax(1, parser.value(rateOption).toInt());
+    const int width = parser.value(widthOption).toInt();
+    const int repeat = parser.value(repeatOption).toInt();
+    const int samples = int(hours * 3600 * rateHz);
+    const qint64 periodNs = 1000000000LL / rateHz;
+
+    SignalHistory history(samples);
+    QRandomGenerator rng(42);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < samples; ++i) {
+        const double speed = 110 + 90 * qSin(i * 1e-4) + rng.bounded(10.0);
+        history.append(i * periodNs, float(speed));
+    }
+    qInfo("%d samples appended in %.1f ms (%.1f M samples/s)", samples,
+          timer.nsecsElapsed() / 1e6, samples * 1e3 / timer.nsecsElapsed());
+
+    const qint64 endNs = history.timestampAt(history.size() - 1);
+    const struct {
+        const char *name;
+        double seconds;
+    } windows[] = {
+        { "1 min", 60 },
+        { "10 min", 600 },
+        { "whole history", hours * 3600 },
+    };
+
+    std::vector<SignalHistory::Point> points;
+    for (const auto &window : windows) {
+        const int first = history.lowerBound(endNs - qint64(window.seconds * 1e9));
+        QList<double> aggregateUs;
+        QList<double> downsampleUs;
+        for (int i = 0; i < repeat; ++i) {
+            timer.start();
+            const SignalHistory::WindowStats stats = history.aggregate(first, history.size());
+            aggregateUs.append(timer.nsecsElapsed() / 1e3);
+            Q_UNUSED(stats);
+
+            timer.start();
+            history.downsample(first, history.size(), width, points);
+            downsampleUs.append(timer.nsecsElapsed() / 1e3);
+        }
+
+        qInfo("%s (%d samples -> %d points)", window.name, history.size() - first, int(points.size()));
+        qInfo("  aggregate  %s", qPrintable(BenchmarkStats::from(aggregateUs).toString("us")));
+        qInfo("  downsample %s", qPrintable(BenchmarkStats::from(downsampleUs).toString("us")));
+    }
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+// Fastest-route queries on contraction hierarchies against plain Dijkstra.
+//
+// For each city size a map is generated and contracted, then random pairs
+// of intersections are routed. Dijkstra over the same travel times runs on
+// a share of the pairs, both as the baseline and to check that every
+// route found through the hierarchy is as fast as the true fastest one.
+//
+//   route-query-benchmark [--sizes <m,...>] [--queries <n>] [--map <file>]
+//
+// With --map the given map file is measured instead, together with its
+// <file>.route when route-preprocessor has written one.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <climits>
+#include <vector>
+#include "benchmarkstats.h"
+#include "mapdata.h"
+#include "routinggraph.h"
+#include "vehiclesimulation.h"
+
+namespace {
+
+// Every this many queries also runs Dijkstra
+constexpr int BaselineEvery = 20;
+
+quint32 dijkstra(const MapData &map, quint32 from, quint32 to, std::vector<quint32> &distances)
+{
+    using Entry = std::pair<quint32, quint32>;
+    std::vector<Entry> heap = { { 0, from } };
+    distances.assign(std::size_t(map.nodeCount()), UINT_MAX);
+    distances[from] = 0;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        const auto [distance, node] = heap.back();
+        heap.pop_back();
+        if (node == to) {
+            return distance;
+        }
+        if (distance > distances[node]) {
+            continue;
+        }
+        for (const MapData::Edge *edge = map.edgesBegin(node); edge != map.edgesEnd(node); ++edge) {
+            const quint32 next = distance + RoutingGraph::travelTimeMs(map, *edge);
+            if (next < distances[edge->to]) {
+                distances[edge->to] = next;
+                heap.push_back({ next, edge->to });
+                std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+            }
+        }
+    }
+    return UINT_MAX;
+}
+
+bool measure(const QString &label, const MapData &map, const RoutingGraph &graph, int queries)
+{
+    qInfo("%s: %d nodes, %d edges, %d shortcuts", qPrintable(label),
+          graph.nodeCount(), graph.edgeCount(), graph.shortcutCount());
+
+    VehicleSimulation::RandomStream rng(42);
+    RouteQuery query(graph);
+    std::vector<quint32> distances;
+    QList<double> queryUs;
+    QList<double> dijkstraUs;
+    qint64 settled = 0;
+    int mismatches = 0;
+    QElapsedTimer timer;
+
+    for (int i = 0; i < queries; ++i) {
+        const quint32 from = quint32(rng.bounded(map.nodeCount()));
+        const quint32 to = quint32(rng.bounded(map.nodeCount()));
+
+        timer.start();
+        const RoutingGraph::Route route = query.route(from, to);
+        queryUs.append(timer.nsecsElapsed() / 1000.0);
+        settled += query.settledNodes();
+
+        if (i % BaselineEvery == 0) {
+            timer.start();
+            const quint32 expected = dijkstra(map, from, to, distances);
+            dijkstraUs.append(timer.nsecsElapsed() / 1000.0);
+            const quint32 found = route.isEmpty() ? UINT_MAX : route.travelTimeMs;
+            if (found != expected) {
+                ++mismatches;
+            }
+        }
+    }
+
+    const BenchmarkStats contracted = BenchmarkStats::from(queryUs);
+    const BenchmarkStats baseline = BenchmarkStats::from(dijkstraUs);
+    qInfo("  contraction hierarchy %s, %.0f nodes settled on average",
+          qPrintable(contracted.toString("us")), double(settled) / qMax(1, queries));
+    qInfo("  dijkstra              %s", qPrintable(baseline.toString("us")));
+    qInfo("  speed-up %.0fx, %d of %lld routes slower than the fastest",
+          baseline.mean / qMax(1e-9, contracted.mean), mismatches, qint64(baseline.count));
+    return mismatches == 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes", "Comma-separated sizes of the generated cities (m).", "m,...",
+                                   "6000,20000,40000");
+    QCommandLineOption queriesOption("queries", "Routes queried per map.", "n", "10000");
+    QCommandLineOption mapOption("map", "Measure this map file instead of generated cities.", "file");
+    parser.addOption(sizesOption);
+    parser.addOption(queriesOption);
+    parser.addOption(mapOption);
+    parser.process(app);
+
+    const int queries = qMax(1, parser.value(queriesOption).toInt());
+    bool correct = true;
+
+    if (parser.isSet(mapOption)) {
+        const QString path = parser.value(mapOption);
+        MapData map;
+        QString error;
+        if (!map.load(path, &error)) {
+            qCritical("%s: %s", qPrintable(path), qPrintable(error));
+            return 1;
+        }
+
+        RoutingGraph graph;
+        QElapsedTimer timer;
+        timer.start();
+        if (QFile::exists(path + QStringLiteral(".route"))
+            && graph.load(path + QStringLiteral(".route"), map, &error)) {
+            qInfo("%s.route loaded in %lld ms", qPrintable(path), timer.elapsed());
+        } else {
+            graph = RoutingGraph::build(map);
+            qInfo("%s contracted in %lld ms", qPrintable(path), timer.elapsed());
+        }
+        correct = measure(path, map, graph, queries);
+        return correct ? 0 : 1;
+    }
+
+    for (const QString &size : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+        const double metres = qMax(500.0, size.toDouble());
+        const MapData map = MapData::generateCity(1, metres);
+
+        QElapsedTimer timer;
+        timer.start();
+        const RoutingGraph graph = RoutingGraph::build(map);
+        qInfo("%.0f m city contracted in %lld ms", metres, timer.elapsed());
+
+        correct = measure(QStringLiteral("%1 m city").arg(metres), map, graph, queries) && correct;
+    }
+    return correct ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// Latency from a producer publishing into shared memory to the
+// DashboardManager properties showing the sample.
+//
+// By default a producer thread publishes into a segment of its own at each
+// rate in turn, through a separate read-write mapping, so the handover is
+// the same as between processes. With --external the benchmark reads the
+// segment of a running telemetry-shm-producer instead. DashboardManager
+// runs without a window and therefore polls the segment every millisecond;
+// with a window it polls once per frame.
+//
+//   shm-latency-benchmark [--rates <hz,...>] [--duration <s>] [--name <name>] [--external]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QTimer>
+#include "benchmarkstats.h"
+#include "dashboardmanager.h"
+#include "sharedtelemetry.h"
+#include "telemetrypacer.h"
+#include "vehiclesimulation.h"
+
+namespace {
+
+// Publishes at rateHz until interrupted, like telemetry-shm-producer
+QThread *startProducer(SharedTelemetryChannel &channel, int rateHz)
+{
+    QThread *thread = QThread::create([&channel, rateHz] {
+        QRandomGenerator rng(1);
+        TelemetrySample sample;
+        TelemetryPacer pacer(rateHz);
+        while (!QThread::currentThread()->isInterruptionRequested()) {
+            pacer.publishDue([&](qint64) {
+                sample = VehicleSimulation::step(sample, rng);
+                sample.engineWarning = false;
+                sample.timestampNs = telemetryClockNs();
+                channel.publish(sample);
+            });
+            pacer.wait([] { return QThread::currentThread()->isInterruptionRequested(); });
+        }
+    });
+    thread->start();
+    return thread;
+}
+
+struct Result {
+    BenchmarkStats latencyUs;
+    qint64 received = 0;
+    qint64 dropped = 0;
+};
+
+// Runs the event loop for durationMs and collects the age of the newest
+// sample at every property update
+Result measure(DashboardManager &manager, int durationMs)
+{
+    QList<double> latencyUs;
+    const QMetaObject::Connection connection =
+        QObject::connect(&manager, &DashboardManager::telemetryStatsChanged, &manager, [&manager, &latencyUs] {
+            latencyUs.append((telemetryClockNs() - manager.lastSampleTimestampNs()) / 1000.0);
+        });
+
+    const qint64 receivedBefore = manager.receivedSamples();
+    const qint64 droppedBefore = manager.droppedSamples();
+    QTimer::singleShot(durationMs, QCoreApplication::instance(), &QCoreApplication::quit);
+    QCoreApplication::exec();
+    QObject::disconnect(connection);
+
+    Result result;
+    result.latencyUs = BenchmarkStats::from(latencyUs);
+    result.received = manager.receivedSamples() - receivedBefore;
+    result.dropped = manager.droppedSamples() - droppedBefore;
+    return result;
+}
+
+void report(const QString &label, const Result &result)
+{
+    qInfo("%s: %lld samples received, %lld dropped, %lld property updates",
+          qPrintable(label), result.received, result.dropped, qint64(result.latencyUs.count));
+    qInfo("  write-to-property %s", qPrintable(result.latencyUs.toString("us")));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption ratesOption("rates", "Comma-separated producer rates (Hz).", "hz,...",
+                                   "100,1000,10000,100000");
+    QCommandLineOption durationOption("duration", "Seconds measured per rate.", "s", "5");
+    QCommandLineOption nameOption("name", "Shared-memory segment name.", "name",
+                                  QStringLiteral("/car-dashboard-shm-latency-benchmark"));
+    QCommandLineOption externalOption("external", "Read a segment published by another process.");
+    parser.addOption(ratesOption);
+    parser.addOption(durationOption);
+    parser.addOption(nameOption);
+    parser.addOption(externalOption);
+    parser.process(app);
+
+    const int durationMs = qMax(1, parser.value(durationOption).toInt()) * 1000;
+    const QString name = parser.value(nameOption);
+    DashboardManager manager;
+
+    if (parser.isSet(externalOption)) {
+        if (!manager.startSharedMemoryInput(name)) {
+            return 1;
+        }
+        report(name, measure(manager, durationMs));
+        return 0;
+    }
+
+    for (const QString &rate : parser.value(ratesOption).split(',', Qt::SkipEmptyParts)) {
+        const int rateHz = qMax(1, rate.toInt());
+
+        SharedTelemetryChannel channel;
+        QString error;
+        if (!channel.create(name, &error)) {
+            qCritical("%s", qPrintable(error));
+            return 1;
+        }
+        if (!manager.startSharedMemoryInput(name)) {
+            return 1;
+        }
+
+        QThread *producer = startProducer(channel, rateHz);
+        const Result result = measure(manager, durationMs);
+        producer->requestInterruption();
+        producer->wait();
+        delete producer;
+        manager.stopSharedMemoryInput();
+
+        report(QStringLiteral("%1 Hz").arg(rateHz), result);
+    }
+    return 0;
+}
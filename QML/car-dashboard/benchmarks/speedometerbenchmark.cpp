@@ -0,0 +1,139 @@
+// Compares the Canvas speedometer with the scene-graph SpeedometerGauge.
+//
+// Each variant is shown in its own window and fed a new speed at 60 Hz. Per
+// frame it records the GUI-thread preparation time (animations, polish and
+// Canvas painting), the scene-graph sync time and the render time.
+//
+//   speedometer-benchmark [--duration <s>] [--software]
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QMutex>
+#include <QQuickItem>
+#include <QQuickView>
+#include <QTimer>
+#include <QtMath>
+#include <atomic>
+#include <ctime>
+#include "benchmarkstats.h"
+
+namespace {
+
+struct FrameTimes {
+    QList<double> prepareMs;
+    QList<double> syncMs;
+    QList<double> renderMs;
+};
+
+FrameTimes runVariant(const QUrl &source, int durationMs) {
+    QQuickView view;
+    view.setResizeMode(QQuickView::SizeRootObjectToView);
+    view.resize(480, 480);
+    view.setSource(source);
+    if (!view.rootObject()) {
+        qFatal("Cannot load %s", qPrintable(source.toString()));
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // Signals fire on the GUI and render threads, timestamps are exchanged
+    // through atomics and the per-frame results collected under a mutex.
+    std::atomic<qint64> animatedNs{0};
+    std::atomic<qint64> syncStartNs{0};
+    std::atomic<qint64> syncEndNs{0};
+    std::atomic<qint64> renderStartNs{0};
+    QMutex mutex;
+    FrameTimes times;
+
+    QObject::connect(&view, &QQuickWindow::afterAnimating, &view, [&] {
+        animatedNs = clock.nsecsElapsed();
+    }, Qt::DirectConnection);
+    QObject::connect(&view, &QQuickWindow::beforeSynchronizing, &view, [&] {
+        syncStartNs = clock.nsecsElapsed();
+    }, Qt::DirectConnection);
+    QObject::connect(&view, &QQuickWindow::afterSynchronizing, &view, [&] {
+        syncEndNs = clock.nsecsElapsed();
+    }, Qt::DirectConnection);
+    QObject::connect(&view, &QQuickWindow::beforeRendering, &view, [&] {
+        renderStartNs = clock.nsecsElapsed();
+    }, Qt::DirectConnection);
+    QObject::connect(&view, &QQuickWindow::afterRendering, &view, [&] {
+        const qint64 renderEndNs = clock.nsecsElapsed();
+        QMutexLocker locker(&mutex);
+        times.prepareMs.append((syncStartNs - animatedNs) / 1e6);
+        times.syncMs.append((syncEndNs - syncStartNs) / 1e6);
+        times.renderMs.append((renderEndNs - renderStartNs) / 1e6);
+    }, Qt::DirectConnection);
+
+    // 60 Hz input sweeping the whole range
+    QTimer input;
+    input.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&input, &QTimer::timeout, &view, [&] {
+        const double t = clock.elapsed() / 1000.0;
+        view.rootObject()->setProperty("speed", 110 + 110 * qSin(t));
+    });
+
+    view.show();
+    input.start(16);
+
+    QEventLoop loop;
+    QTimer::singleShot(durationMs, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    input.stop();
+    view.hide();
+
+    QMutexLocker locker(&mutex);
+    return times;
+}
+
+void report(const char *name, const FrameTimes &times, double cpuMs, int durationMs) {
+    qInfo("%s", name);
+    qInfo("  prepare %s", qPrintable(BenchmarkStats::from(times.prepareMs).toString("ms")));
+    qInfo("  sync    %s", qPrintable(BenchmarkStats::from(times.syncMs).toString("ms")));
+    qInfo("  render  %s", qPrintable(BenchmarkStats::from(times.renderMs).toString("ms")));
+    qInfo("  process CPU %.1f ms over %d ms (%.1f%%)", cpuMs, durationMs, 100.0 * cpuMs / durationMs);
+}
+
+double processCpuMs() {
+    return 1000.0 * double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption durationOption("duration", "Seconds to run each variant.", "s", "10");
+    QCommandLineOption softwareOption("software", "Use the software scene-graph backend.");
+    parser.addOption(durationOption);
+    parser.addOption(softwareOption);
+    parser.process(app);
+
+    if (parser.isSet(softwareOption)) {
+        QQuickWindow::setGraphicsApi(QSGRendererInterface::Software);
+    }
+    const int durationMs = parser.value(durationOption).toInt() * 1000;
+
+    const struct {
+        const char *name;
+        const char *source;
+    } variants[] = {
+        { "Canvas (JavaScript)", "qrc:/qt/qml/SpeedometerBenchmark/CanvasSpeedometer.qml" },
+        { "SpeedometerGauge (scene graph)", "qrc:/qt/qml/SpeedometerBenchmark/SceneGraphSpeedometer.qml" },
+    };
+
+    for (const auto &variant : variants) {
+        const double cpuStart = processCpuMs();
+        const FrameTimes times = runVariant(QUrl(variant.source), durationMs);
+        report(variant.name, times, processCpuMs() - cpuStart, durationMs);
+    }
+
+    return 0;
+}
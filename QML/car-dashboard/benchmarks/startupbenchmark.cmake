@@ -0,0 +1,49 @@
+# Runs appcar-dashboard --startup-benchmark several times and summarizes the
+# time to first frame. Invoked by the dashboard-startup-benchmark target:
+#
+#   cmake -DAPP=<path> -DRUNS=<n> -P startupbenchmark.cmake
+#
+# The first run is the coldest one the build can produce without dropping
+# the OS page cache, so it is reported separately.
+
+if(NOT APP)
+    message(FATAL_ERROR "APP is not set")
+endif()
+if(NOT RUNS)
+    set(RUNS 10)
+endif()
+
+set(ENV{QT_QPA_PLATFORM} offscreen)
+set(ENV{QT_QUICK_BACKEND} software)
+
+set(process_times "")
+foreach(run RANGE 1 ${RUNS})
+    execute_process(
+        COMMAND ${APP} --startup-benchmark
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+        RESULT_VARIABLE result
+    )
+    string(REGEX MATCH "first frame (-?[0-9]+) ms after process start, ([0-9]+) ms after main" line "${output}")
+    if(NOT result EQUAL 0 OR NOT line)
+        message(FATAL_ERROR "Run ${run} failed:\n${output}")
+    endif()
+    message(STATUS "run ${run}: ${CMAKE_MATCH_1} ms since process start, ${CMAKE_MATCH_2} ms since main()")
+    if(run EQUAL 1)
+        set(cold ${CMAKE_MATCH_1})
+    else()
+        list(APPEND process_times ${CMAKE_MATCH_1})
+    endif()
+endforeach()
+
+message(STATUS "cold start (first run): ${cold} ms")
+if(process_times)
+    list(SORT process_times COMPARE NATURAL)
+    list(LENGTH process_times count)
+    math(EXPR middle "${count} / 2")
+    math(EXPR last "${count} - 1")
+    list(GET process_times 0 fastest)
+    list(GET process_times ${middle} median)
+    list(GET process_times ${last} slowest)
+    message(STATUS "warm starts: min ${fastest} ms, median ${median} ms, max ${slowest} ms")
+endif()
@@ -0,0 +1,87 @@
+// Heap allocations and cost of one DashboardManager simulation tick.
+//
+// Runs simulateDriving() (simulation step, warning rules, history, property
+// setters and their NOTIFY signals) with a receiver on every signal, but
+// without a QML engine whose bindings would allocate on their own. Built
+// with -DQML_ALLOC_TRACER=ON, every tick after the warm-up must be
+// allocation-free or the benchmark fails.
+//
+//   tick-allocation-benchmark [--ticks <n>] [--warmup <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include "alloctracer.h"
+#include "benchmarkstats.h"
+#include "dashboardmanager.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption ticksOption("ticks", "Ticks measured.", "n", "100000");
+    QCommandLineOption warmupOption("warmup", "Ticks run before measuring.", "n", "1000");
+    parser.addOption(ticksOption);
+    parser.addOption(warmupOption);
+    parser.process(app);
+
+    const int ticks = qMax(1, parser.value(ticksOption).toInt());
+    const int warmup = qMax(0, parser.value(warmupOption).toInt());
+
+    if (!AllocTracer::isCompiledIn()) {
+        qWarning("Built without QML_ALLOC_TRACER: allocations are not counted");
+    }
+
+    DashboardManager manager;
+
+    // One receiver per signal, as QML would connect, doing no work itself
+    qint64 notifications = 0;
+    const auto count = [&notifications] { ++notifications; };
+    QObject::connect(&manager, &DashboardManager::speedChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::fuelLevelChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::engineWarningChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::gearChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::displaySpeedChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::displayFuelLevelChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::speedRatioChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::rangeKmChanged, &manager, count);
+    QObject::connect(&manager, &DashboardManager::lowFuelChanged, &manager, count);
+    QObject::connect(manager.warningIndicators(), &WarningIndicatorModel::indicatorsChanged, &manager, count);
+
+    // The first ticks set up lazily created state, e.g. the global random
+    // generator
+    for (int i = 0; i < warmup; ++i) {
+        manager.simulateDriving();
+    }
+    notifications = 0;
+
+    AllocTracer::Counts total;
+    quint64 allocatingTicks = 0;
+    QList<double> tickNs;
+    tickNs.reserve(ticks);
+    QElapsedTimer timer;
+    for (int i = 0; i < ticks; ++i) {
+        timer.start();
+        const AllocTracer::Counts counts = AllocTracer::measure([&manager] { manager.simulateDriving(); });
+        tickNs.append(double(timer.nsecsElapsed()));
+
+        total.allocations += counts.allocations;
+        total.deallocations += counts.deallocations;
+        total.bytes += counts.bytes;
+        if (counts.allocations) {
+            ++allocatingTicks;
+        }
+    }
+
+    qInfo("%d ticks, %lld notifications", ticks, notifications);
+    qInfo("  tick %s", qPrintable(BenchmarkStats::from(tickNs).toString("ns")));
+    if (!AllocTracer::isCompiledIn()) {
+        return 0;
+    }
+
+    qInfo("  %llu allocations (%llu bytes) in %llu ticks, %llu frees",
+          total.allocations, total.bytes, allocatingTicks, total.deallocations);
+    return AllocTracer::reportAllocations("DashboardManager::simulateDriving", total) ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+// Evaluation throughput of the compiled warning rules.
+//
+// Generates rule sets of growing size (thresholds, hysteresis, debounce and
+// combinations of earlier rules, in the proportions of warningrules.json),
+// then evaluates each against a simulated 1 kHz drive and reports rules
+// evaluated per second alongside the per-tick cost.
+//
+//   warning-rule-benchmark [--rules <n,...>] [--samples <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include "benchmarkstats.h"
+#include "vehiclesimulation.h"
+#include "warningruleengine.h"
+
+namespace {
+
+constexpr qint64 SamplePeriodNs = 1000000;     // 1 kHz
+constexpr int TicksPerMeasurement = 1000;
+
+QByteArray generateRules(int count, QRandomGenerator &rng) {
+    static const char *const indicators[] = { "engine", "transmission", "fuel", "brake" };
+    static const char gears[] = { 'P', 'R', 'N', 'D' };
+
+    QJsonArray rules;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject rule;
+        rule.insert("name", QStringLiteral("rule%1").arg(i));
+        rule.insert("indicator", QLatin1String(indicators[i % 4]));
+
+        const int speed = rng.bounded(20, 200);
+        switch (i % 4) {
+        case 0:
+            // Threshold with hysteresis
+            rule.insert("when", QStringLiteral("speed > %1").arg(speed));
+            rule.insert("clearWhen", QStringLiteral("speed < %1").arg(speed - 10));
+            rule.insert("onDelayMs", rng.bounded(100, 3000));
+            break;
+        case 1:
+            rule.insert("when", QStringLiteral("gear == '%1' && speed > %2")
+                                    .arg(QLatin1Char(gears[rng.bounded(4)])).arg(speed));
+            rule.insert("offDelayMs", rng.bounded(100, 2000));
+            break;
+        case 2:
+            rule.insert("when", QStringLiteral("fuelLevel < %1 || acceleration < -%2")
+                                    .arg(rng.bounded(5, 30)).arg(rng.bounded(2, 10)));
+            break;
+        default:
+            // Combines two earlier rules
+            rule.insert("when", QStringLiteral("rule%1 && !rule%2 && speed * 2 > %3")
+                                    .arg(i - 1).arg(i - 2).arg(speed));
+            rule.insert("onDelayMs", 500);
+            rule.insert("offDelayMs", 500);
+            break;
+        }
+        rules.append(rule);
+    }
+    return QJsonDocument(QJsonObject{ { "rules", rules } }).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption rulesOption("rules", "Comma-separated rule counts.", "n,...", "10,100,1000,10000");
+    QCommandLineOption samplesOption("samples", "Samples evaluated per rule count.", "n", "100000");
+    parser.addOption(rulesOption);
+    parser.addOption(samplesOption);
+    parser.process(app);
+
+    const int samples = qMax(TicksPerMeasurement, parser.value(samplesOption).toInt());
+
+    // The same drive for every rule count
+    QRandomGenerator rng(42);
+    std::vector<TelemetrySample> drive(std::size_t(samples));
+    VehicleSimulation::ContinuousState state;
+    for (int i = 0; i < samples; ++i) {
+        VehicleSimulation::advance(state, SamplePeriodNs / 1e9, rng);
+        TelemetrySample &sample = drive[std::size_t(i)];
+        sample.timestampNs = i * SamplePeriodNs;
+        sample.speed = qint16(qRound(state.speed));
+        sample.fuelLevel = qint8(qRound(state.fuelLevel));
+        sample.gear = state.gear;
+    }
+
+    const QStringList counts = parser.value(rulesOption).split(',', Qt::SkipEmptyParts);
+    for (const QString &countText : counts) {
+        const int count = countText.toInt();
+        const QByteArray json = generateRules(count, rng);
+
+        WarningRuleEngine engine;
+        QString error;
+        QElapsedTimer timer;
+        timer.start();
+        if (!engine.loadFromJson(json, &error)) {
+            qCritical("Cannot compile %d rules: %s", count, qPrintable(error));
+            return 1;
+        }
+        const double compileMs = timer.nsecsElapsed() / 1e6;
+
+        QList<double> tickUs;
+        quint64 raised = 0;
+        qint64 totalNs = 0;
+        for (int first = 0; first + TicksPerMeasurement <= samples; first += TicksPerMeasurement) {
+            timer.start();
+            for (int i = first; i < first + TicksPerMeasurement; ++i) {
+                raised += quint64(qPopulationCount(engine.evaluate(drive[std::size_t(i)])));
+            }
+            const qint64 elapsedNs = timer.nsecsElapsed();
+            totalNs += elapsedNs;
+            tickUs.append(elapsedNs / 1e3 / TicksPerMeasurement);
+        }
+
+        const int evaluated = int(tickUs.size()) * TicksPerMeasurement;
+        qInfo("%d rules (compiled in %.2f ms, %d indicator-ticks raised)", count, compileMs, int(raised));
+        qInfo("  %.1f M rules/s", double(count) * evaluated * 1e3 / totalNs);
+        qInfo("  tick %s", qPrintable(BenchmarkStats::from(tickUs).toString("us")));
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#ifndef CANLOG_H
+#define CANLOG_H
+
+#include <QtGlobal>
+#include <cstring>
+
+// One classic CAN frame
+struct CanFrame {
+    qint64 timestampNs = 0;     // from the log, not telemetryClockNs()
+    quint32 id = 0;
+    bool extended = false;
+    quint8 length = 0;
+    uchar data[8] = {};         // bytes past length are zero
+};
+
+// Reader for the log format of can-utils' candump -l:
+//
+//   (1436509052.249713) can0 123#DEADBEEF
+//   (1436509052.250112) can0 18FEF100#0102030405060708
+//
+// Three hex digits are a standard 11-bit ID, eight an extended 29-bit one.
+// Remote frames ("123#R") and CAN FD frames ("123##1...") carry no signal
+// data for the dashboard and are reported as not parsed.
+namespace CanLog {
+
+namespace detail {
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = char(c | 0x20);     // lower case
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+} // namespace detail
+
+// Parses the line [begin, end) into frame. Returns false for blank,
+// malformed or unsupported lines.
+inline bool parseLine(const char *begin, const char *end, CanFrame &frame)
+{
+    const char *p = begin;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    if (p == end || *p != '(') {
+        return false;
+    }
+
+    // (seconds.fraction)
+    ++p;
+    qint64 seconds = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        seconds = seconds * 10 + (*p++ - '0');
+    }
+    qint64 fractionNs = 0;
+    if (p < end && *p == '.') {
+        ++p;
+        qint64 scale = 100000000;
+        while (p < end && *p >= '0' && *p <= '9') {
+            fractionNs += (*p++ - '0') * scale;
+            scale /= 10;
+        }
+    }
+    if (p == end || *p != ')') {
+        return false;
+    }
+    ++p;
+    frame.timestampNs = seconds * 1000000000 + fractionNs;
+
+    // Interface name
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+    while (p < end && *p != ' ') {
+        ++p;
+    }
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+
+    // ID up to '#'
+    const char *idStart = p;
+    quint32 id = 0;
+    while (p < end && *p != '#') {
+        const int digit = detail::hexValue(*p++);
+        if (digit < 0) {
+            return false;
+        }
+        id = (id << 4) | quint32(digit);
+    }
+    const long idDigits = long(p - idStart);
+    if (p == end || (idDigits != 3 && idDigits != 8)) {
+        return false;
+    }
+    ++p;
+    if (p < end && (*p == '#' || *p == 'R' || *p == 'r')) {
+        return false;
+    }
+    frame.extended = idDigits == 8;
+    frame.id = frame.extended ? id & 0x1FFFFFFF : id & 0x7FF;
+
+    // Data: up to 8 bytes as pairs of hex digits, '.' separators allowed
+    std::memset(frame.data, 0, sizeof(frame.data));
+    int length = 0;
+    while (p < end && *p != '\r' && *p != '\n' && *p != ' ') {
+        if (*p == '.') {
+            ++p;
+            continue;
+        }
+        if (end - p < 2 || length == 8) {
+            return false;
+        }
+        const int high = detail::hexValue(p[0]);
+        const int low = detail::hexValue(p[1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        frame.data[length++] = uchar(high << 4 | low);
+        p += 2;
+    }
+    frame.length = quint8(length);
+    return true;
+}
+
+} // namespace CanLog
+
+#endif // CANLOG_H
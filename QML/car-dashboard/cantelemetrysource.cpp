@@ -0,0 +1,268 @@
+#include "cantelemetrysource.h"
+#include "vehiclesimulation.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+// Lines between reads of the clock for the frame rate in unpaced mode
+constexpr quint32 RateCheckLines = 1024;
+// Refresh framesPerSecond() this often
+constexpr qint64 RateIntervalNs = 250000000;
+// Sleep only when the log is this far ahead of the wall clock
+constexpr qint64 MinSleepNs = 1000000;
+// Longest single sleep, so stopping and speed changes take effect during
+// long gaps in the log
+constexpr qint64 MaxSleepSliceNs = 10000000;
+}
+
+CanTelemetrySource::CanTelemetrySource(TelemetryQueue &queue, QObject *parent)
+    : QThread(parent),
+    m_queue(queue)
+{
+}
+
+CanTelemetrySource::~CanTelemetrySource() {
+    requestInterruption();
+    wait();
+    close();
+}
+
+bool CanTelemetrySource::open(const QString &logPath, const QString &dbcPath,
+                              const SignalMapping &mapping, QString *errorString) {
+    close();
+
+    auto fail = [this, errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        close();
+        return false;
+    };
+
+    QString error;
+    if (!m_database.load(dbcPath, &error)) {
+        return fail(QStringLiteral("%1: %2").arg(dbcPath, error));
+    }
+
+    m_file.setFileName(logPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+    m_size = m_file.size();
+    if (m_size > 0) {
+        m_data = reinterpret_cast<const char *>(m_file.map(0, m_size));
+        if (!m_data) {
+            return fail(m_file.errorString());
+        }
+    }
+
+    m_messages.assign(std::size_t(m_database.messageCount()), MessageBindings());
+    const bool haveSpeed = bind(mapping.speed, SpeedField);
+    const bool haveFuelLevel = bind(mapping.fuelLevel, FuelLevelField);
+    const bool haveGear = bind(mapping.gear, GearField);
+    const bool haveEngineWarning = bind(mapping.engineWarning, EngineWarningField);
+    if (!haveSpeed && !haveFuelLevel && !haveGear && !haveEngineWarning) {
+        return fail(QStringLiteral("%1 has none of the dashboard signals").arg(dbcPath));
+    }
+
+    // Gear letters from the value table, e.g. 0 "Park" 1 "Reverse"
+    std::memset(m_gears, 0, sizeof(m_gears));
+    bool namedGears = false;
+    if (const DbcDatabase::Signal *gear = m_database.findSignal(mapping.gear)) {
+        for (auto it = gear->valueNames.cbegin(); it != gear->valueNames.cend(); ++it) {
+            const char letter = it.value().isEmpty() ? 0 : it.value().at(0).toUpper().toLatin1();
+            if (letter && it.key() >= 0 && it.key() < qint64(sizeof(m_gears))
+                && std::memchr(VehicleSimulation::Gears, letter, sizeof(VehicleSimulation::Gears))) {
+                m_gears[it.key()] = letter;
+                namedGears = true;
+            }
+        }
+    }
+    if (!namedGears) {
+        std::memcpy(m_gears, VehicleSimulation::Gears, sizeof(VehicleSimulation::Gears));
+    }
+
+    m_decoded.store(0, std::memory_order_relaxed);
+    m_ignored.store(0, std::memory_order_relaxed);
+    m_unparsed.store(0, std::memory_order_relaxed);
+    m_framesPerSecond.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void CanTelemetrySource::close() {
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_messages.clear();
+    m_database.clear();
+}
+
+bool CanTelemetrySource::bind(const QString &name, Field field) {
+    int messageIndex = -1;
+    const DbcDatabase::Signal *signal = m_database.findSignal(name, &messageIndex);
+    if (!signal) {
+        qWarning() << "CAN database has no signal" << name;
+        return false;
+    }
+
+    const DbcDatabase::Message &message = m_database.message(messageIndex);
+    MessageBindings &bindings = m_messages[std::size_t(messageIndex)];
+    if (message.multiplexer >= 0) {
+        bindings.multiplexer = &message.canSignals[std::size_t(message.multiplexer)];
+    }
+    bindings.bindings.push_back({ field, signal->multiplexValue, *signal });
+    return true;
+}
+
+double CanTelemetrySource::speed() const {
+    return m_speed.load(std::memory_order_relaxed);
+}
+
+void CanTelemetrySource::setSpeed(double speed) {
+    m_speed.store(qMax(0.0, speed), std::memory_order_relaxed);
+}
+
+quint64 CanTelemetrySource::decodedFrames() const {
+    return m_decoded.load(std::memory_order_relaxed);
+}
+
+quint64 CanTelemetrySource::ignoredFrames() const {
+    return m_ignored.load(std::memory_order_relaxed);
+}
+
+quint64 CanTelemetrySource::unparsedLines() const {
+    return m_unparsed.load(std::memory_order_relaxed);
+}
+
+double CanTelemetrySource::framesPerSecond() const {
+    return m_framesPerSecond.load(std::memory_order_relaxed);
+}
+
+bool CanTelemetrySource::applyFrame(const CanFrame &frame, TelemetrySample &sample) const {
+    const int index = m_database.messageIndex(frame.id, frame.extended);
+    if (index < 0) {
+        return false;
+    }
+    const MessageBindings &message = m_messages[std::size_t(index)];
+    if (message.bindings.empty()) {
+        return false;
+    }
+
+    const DbcDatabase::PayloadWords payload(frame.data);
+    const qint64 multiplexValue = message.multiplexer
+        ? DbcDatabase::rawValue(*message.multiplexer, payload)
+        : -1;
+
+    for (const Binding &binding : message.bindings) {
+        if (binding.multiplexValue >= 0 && binding.multiplexValue != multiplexValue) {
+            continue;
+        }
+        switch (binding.field) {
+        case SpeedField: {
+            const double speed = DbcDatabase::physicalValue(binding.layout, payload);
+            sample.speed = qint16(qRound(qBound(0.0, speed, double(VehicleSimulation::MaxSpeed))));
+            break;
+        }
+        case FuelLevelField: {
+            const double level = DbcDatabase::physicalValue(binding.layout, payload);
+            sample.fuelLevel = qint8(qRound(qBound(0.0, level, 100.0)));
+            break;
+        }
+        case GearField: {
+            const qint64 raw = DbcDatabase::rawValue(binding.layout, payload);
+            const char gear = raw >= 0 && raw < qint64(sizeof(m_gears)) ? m_gears[raw] : 0;
+            if (gear) {
+                sample.gear = gear;
+            }
+            break;
+        }
+        case EngineWarningField:
+            sample.engineWarning = DbcDatabase::rawValue(binding.layout, payload) != 0;
+            break;
+        }
+    }
+    return true;
+}
+
+void CanTelemetrySource::run() {
+    TelemetrySample sample;
+    const char *line = m_data;
+    const char *const end = m_data + m_size;
+
+    // anchorLogNs of log time plays at anchorNs of wall time; re-anchored
+    // on the first frame and whenever the speed changes
+    double anchoredSpeed = -1;
+    qint64 anchorLogNs = 0;
+    qint64 anchorNs = 0;
+
+    qint64 rateStartNs = telemetryClockNs();
+    quint64 rateStartFrames = 0;
+    quint32 linesSinceRateCheck = 0;
+    quint64 decoded = 0;
+
+    while (line < end && !isInterruptionRequested()) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(line, '\n', std::size_t(end - line)));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+
+        CanFrame frame;
+        if (!CanLog::parseLine(line, lineEnd, frame)) {
+            // Blank lines are not worth counting
+            if (lineEnd - line > 1) {
+                m_unparsed.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (!applyFrame(frame, sample)) {
+            m_ignored.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            // Wait for the frame in slices, re-reading the speed after each
+            while (!isInterruptionRequested()) {
+                const double speed = m_speed.load(std::memory_order_relaxed);
+                if (speed <= 0) {
+                    anchoredSpeed = -1;
+                    break;
+                }
+                const qint64 nowNs = telemetryClockNs();
+                if (anchoredSpeed < 0) {
+                    anchoredSpeed = speed;
+                    anchorLogNs = frame.timestampNs;
+                    anchorNs = nowNs;
+                } else if (speed != anchoredSpeed) {
+                    // Continue from the log time reached at the old speed
+                    anchorLogNs = qMin(frame.timestampNs,
+                                       anchorLogNs + qint64(double(nowNs - anchorNs) * anchoredSpeed));
+                    anchorNs = nowNs;
+                    anchoredSpeed = speed;
+                }
+                const qint64 dueNs = anchorNs + qint64(double(frame.timestampNs - anchorLogNs) / speed);
+                const qint64 aheadNs = dueNs - nowNs;
+                if (aheadNs < MinSleepNs) {
+                    break;
+                }
+                QThread::usleep(quint64(qMin(aheadNs, MaxSleepSliceNs) / 1000));
+            }
+
+            sample.timestampNs = telemetryClockNs();
+            m_queue.push(sample);
+            m_decoded.store(++decoded, std::memory_order_relaxed);
+        }
+
+        if (++linesSinceRateCheck == RateCheckLines || anchoredSpeed > 0) {
+            linesSinceRateCheck = 0;
+            const qint64 nowNs = telemetryClockNs();
+            if (nowNs - rateStartNs >= RateIntervalNs) {
+                m_framesPerSecond.store(double(decoded - rateStartFrames) * 1e9 / double(nowNs - rateStartNs),
+                                        std::memory_order_relaxed);
+                rateStartNs = nowNs;
+                rateStartFrames = decoded;
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+
+    m_framesPerSecond.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,101 @@
+#ifndef CANTELEMETRYSOURCE_H
+#define CANTELEMETRYSOURCE_H
+
+#include <QFile>
+#include <QThread>
+#include <atomic>
+#include <vector>
+#include "dbcdatabase.h"
+#include "telemetryproducer.h"
+
+// Worker thread that plays a candump log (see canlog.h) through a DBC
+// database and pushes the decoded vehicle state into a TelemetryQueue, as a
+// local stand-in for a live CAN bus. It is the only producer of that queue.
+//
+// The log is memory-mapped and read line by line. When the log is opened,
+// every message that carries one of the mapped signals gets the list of
+// those signals with their compiled layout, so a frame costs one table
+// lookup plus a shift and mask per mapped signal; frames of other messages
+// are skipped after the lookup.
+//
+// speed 1.0 follows the log timestamps in real time, N runs N times faster
+// and 0 decodes as fast as possible.
+class CanTelemetrySource : public QThread {
+    Q_OBJECT
+
+public:
+    // DBC signal names mapped onto the sample fields. The gear signal uses
+    // its value table when the first letter of a value name is P, R, N or D,
+    // and otherwise counts 0..3 as P, R, N, D.
+    struct SignalMapping {
+        QString speed = QStringLiteral("VehicleSpeed");
+        QString fuelLevel = QStringLiteral("FuelLevel");
+        QString gear = QStringLiteral("GearPosition");
+        QString engineWarning = QStringLiteral("EngineWarning");
+    };
+
+    CanTelemetrySource(TelemetryQueue &queue, QObject *parent = nullptr);
+    ~CanTelemetrySource();
+
+    // Loads the database and maps the log. Fails if the log cannot be read
+    // or none of the mapped signals exists; missing ones are warned about.
+    bool open(const QString &logPath, const QString &dbcPath,
+              const SignalMapping &mapping = SignalMapping(), QString *errorString = nullptr);
+
+    double speed() const;
+    void setSpeed(double speed);
+
+    // Statistics, readable from any thread
+    quint64 decodedFrames() const;      // frames of a message with mapped signals
+    quint64 ignoredFrames() const;      // frames of other messages
+    quint64 unparsedLines() const;      // malformed, remote and CAN FD frames
+    // Decoded frames per second of wall time, refreshed a few times a second
+    double framesPerSecond() const;
+
+protected:
+    void run() override;
+
+private:
+    enum Field : quint8 {
+        SpeedField,
+        FuelLevelField,
+        GearField,
+        EngineWarningField
+    };
+
+    // A mapped signal of one message, with its layout copied out of the
+    // database so decoding touches one small array
+    struct Binding {
+        Field field;
+        int multiplexValue;         // -1: always present
+        DbcDatabase::Signal layout;
+    };
+
+    struct MessageBindings {
+        std::vector<Binding> bindings;
+        const DbcDatabase::Signal *multiplexer = nullptr;
+    };
+
+    void close();
+    bool bind(const QString &name, Field field);
+    bool applyFrame(const CanFrame &frame, TelemetrySample &sample) const;
+
+    TelemetryQueue &m_queue;
+    DbcDatabase m_database;
+    QFile m_file;
+    const char *m_data = nullptr;
+    qint64 m_size = 0;
+
+    // Indexed by DbcDatabase message index
+    std::vector<MessageBindings> m_messages;
+    // Gear letter by raw value; 0 where the value means nothing
+    char m_gears[16] = {};
+
+    std::atomic<double> m_speed{1.0};
+    std::atomic<quint64> m_decoded{0};
+    std::atomic<quint64> m_ignored{0};
+    std::atomic<quint64> m_unparsed{0};
+    std::atomic<double> m_framesPerSecond{0};
+};
+
+#endif // CANTELEMETRYSOURCE_H
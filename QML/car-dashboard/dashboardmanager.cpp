@@ -1,82 +1,829 @@
 #include "dashboardmanager.h"
+#include "vehiclesimulation.h"
+#include <QDebug>
+#include <QQuickWindow>
 #include <QRandomGenerator>
 
+namespace {
+// Enough for ~8 frames of a 1 kHz feed, or a few frames at 100 kHz.
+constexpr std::size_t TelemetryQueueCapacity = 8192;
+// Scheduling statistics change every tick; refresh them a few times a second
+constexpr qint64 SimulationStatsIntervalNs = 250000000;
+const char DefaultWarningRules[] = ":/qt/qml/CarDashboard/warningrules.json";
+const char DefaultCanDatabase[] = ":/qt/qml/CarDashboard/vehicle.dbc";
+}
+
 DashboardManager::DashboardManager(QObject *parent)
     : QObject(parent),
-    m_currentSpeed(0),
-    m_fuelLevel(100),
-    m_engineWarning(false),
-    m_currentGear("P")
+    m_fixedStep(nullptr),
+    m_lastStatsReportNs(0),
+    m_telemetryQueue(TelemetryQueueCapacity),
+    m_producer(nullptr),
+    m_receivedSamples(0),
+    m_reportedDroppedSamples(0),
+    m_coalescing(false),
+    m_pendingSignals(0),
+    m_suppressedEmissions(0),
+    m_reportedSuppressedEmissions(0),
+    m_lastSampleTimestampNs(0),
+    m_replayer(nullptr),
+    m_canSource(nullptr),
+    m_sharedInputCursor(0),
+    m_sharedInputLostSamples(0),
+    m_historySeconds(DefaultHistorySeconds),
+    // One sample a second from the simulation timer
+    m_historyRateHz(1),
+    m_history(DefaultHistorySeconds),
+    m_reportedHistoryRevision(0),
+    m_engineIndicator(-1),
+    m_warningIndicators(new WarningIndicatorModel(this))
 {
+    m_speedRatio.setBinding([this] { return m_displaySpeed.value() / MaxSpeed; });
+    m_rangeKm.setBinding([this] { return m_displayFuelLevel.value() / 100 * FullTankRangeKm; });
+    m_lowFuel.setBinding([this] { return m_fuelLevel.value() < LowFuelThreshold; });
+
+    loadWarningRules(QString::fromLatin1(DefaultWarningRules));
+
+    // Appending to the history must not allocate on the tick path
+    m_history.reserve();
+
+    // Polls the shared-memory input when there is no frame to do it
+    m_sharedInputTimer.setTimerType(Qt::PreciseTimer);
+    m_sharedInputTimer.setInterval(1);
+    connect(&m_sharedInputTimer, &QTimer::timeout, this, &DashboardManager::pollSharedMemory);
+
     // Setup simulation timer
     connect(&m_simulationTimer, &QTimer::timeout, this, &DashboardManager::simulateDriving);
     m_simulationTimer.start(1000); // Update every second
 }
 
+DashboardManager::~DashboardManager() {
+    // The producer threads reference m_telemetryQueue, stop them first
+    stopTelemetryFeed();
+    stopCanLog();
+    stopFixedStepSimulation();
+    stopReplay();
+    stopSharedMemoryInput();
+    stopRecording();
+}
+
 int DashboardManager::currentSpeed() const {
     return m_currentSpeed;
 }
 
 void DashboardManager::setCurrentSpeed(int speed) {
-    if (m_currentSpeed != speed) {
-        m_currentSpeed = qBound(0, speed, 220);
-        emit speedChanged();
+    speed = qBound(0, speed, MaxSpeed);
+    if (m_latest.currentSpeed != speed) {
+        m_latest.currentSpeed = speed;
+        notifyChanged(SpeedPending);
     }
 }
 
+QBindable<int> DashboardManager::bindableCurrentSpeed() {
+    return &m_currentSpeed;
+}
+
 int DashboardManager::fuelLevel() const {
     return m_fuelLevel;
 }
 
 void DashboardManager::setFuelLevel(int level) {
-    if (m_fuelLevel != level) {
-        m_fuelLevel = qBound(0, level, 100);
-        emit fuelLevelChanged();
+    level = qBound(0, level, 100);
+    if (m_latest.fuelLevel != level) {
+        m_latest.fuelLevel = level;
+        notifyChanged(FuelLevelPending);
     }
 }
 
+QBindable<int> DashboardManager::bindableFuelLevel() {
+    return &m_fuelLevel;
+}
+
 bool DashboardManager::engineWarning() const {
     return m_engineWarning;
 }
 
 void DashboardManager::setEngineWarning(bool warning) {
-    if (m_engineWarning != warning) {
-        m_engineWarning = warning;
-        emit engineWarningChanged();
+    if (m_latest.engineWarning != warning) {
+        m_latest.engineWarning = warning;
+        notifyChanged(EngineWarningPending);
     }
 }
 
-QString DashboardManager::currentGear() const {
+QBindable<bool> DashboardManager::bindableEngineWarning() {
+    return &m_engineWarning;
+}
+
+DashboardManager::Gear DashboardManager::currentGear() const {
     return m_currentGear;
 }
 
-void DashboardManager::setCurrentGear(const QString &gear) {
-    if (m_currentGear != gear) {
-        m_currentGear = gear;
-        emit gearChanged();
+void DashboardManager::setCurrentGear(Gear gear) {
+    if (m_latest.currentGear != gear) {
+        m_latest.currentGear = gear;
+        notifyChanged(GearPending);
+    }
+}
+
+QBindable<DashboardManager::Gear> DashboardManager::bindableCurrentGear() {
+    return &m_currentGear;
+}
+
+QString DashboardManager::gearLabel() const {
+    // QStringLiteral data is static, so reading the label never allocates
+    switch (m_currentGear.value()) {
+    case Park:
+        return QStringLiteral("P");
+    case Reverse:
+        return QStringLiteral("R");
+    case Neutral:
+        return QStringLiteral("N");
+    case Drive:
+        return QStringLiteral("D");
+    }
+    return QString();
+}
+
+qreal DashboardManager::displaySpeed() const {
+    return m_displaySpeed;
+}
+
+QBindable<qreal> DashboardManager::bindableDisplaySpeed() {
+    return &m_displaySpeed;
+}
+
+qreal DashboardManager::displayFuelLevel() const {
+    return m_displayFuelLevel;
+}
+
+QBindable<qreal> DashboardManager::bindableDisplayFuelLevel() {
+    return &m_displayFuelLevel;
+}
+
+qreal DashboardManager::speedRatio() const {
+    return m_speedRatio;
+}
+
+QBindable<qreal> DashboardManager::bindableSpeedRatio() {
+    return &m_speedRatio;
+}
+
+qreal DashboardManager::rangeKm() const {
+    return m_rangeKm;
+}
+
+QBindable<qreal> DashboardManager::bindableRangeKm() {
+    return &m_rangeKm;
+}
+
+bool DashboardManager::lowFuel() const {
+    return m_lowFuel;
+}
+
+QBindable<bool> DashboardManager::bindableLowFuel() {
+    return &m_lowFuel;
+}
+
+bool DashboardManager::fixedStepActive() const {
+    return m_fixedStep != nullptr;
+}
+
+qint64 DashboardManager::simulationTicks() const {
+    return m_fixedStep ? qint64(m_fixedStep->ticks()) : 0;
+}
+
+qint64 DashboardManager::skippedSimulationTicks() const {
+    return m_fixedStep ? qint64(m_fixedStep->skippedTicks()) : 0;
+}
+
+qreal DashboardManager::maxTickLatenessUs() const {
+    return m_fixedStep ? m_fixedStep->maxLatenessNs() / 1000.0 : 0;
+}
+
+qreal DashboardManager::meanTickLatenessUs() const {
+    return m_fixedStep ? m_fixedStep->meanLatenessNs() / 1000.0 : 0;
+}
+
+bool DashboardManager::telemetryFeedActive() const {
+    return m_producer != nullptr;
+}
+
+qint64 DashboardManager::receivedSamples() const {
+    return m_receivedSamples;
+}
+
+qint64 DashboardManager::droppedSamples() const {
+    return qint64(m_telemetryQueue.droppedCount()) + m_sharedInputLostSamples;
+}
+
+bool DashboardManager::canLogActive() const {
+    return m_canSource != nullptr;
+}
+
+qint64 DashboardManager::canDecodedFrames() const {
+    return m_canSource ? qint64(m_canSource->decodedFrames()) : 0;
+}
+
+qreal DashboardManager::canFramesPerSecond() const {
+    return m_canSource ? m_canSource->framesPerSecond() : 0;
+}
+
+bool DashboardManager::sharedMemoryInputActive() const {
+    return m_sharedInput.isOpen();
+}
+
+bool DashboardManager::coalescing() const {
+    return m_coalescing;
+}
+
+void DashboardManager::setCoalescing(bool coalescing) {
+    if (m_coalescing != coalescing) {
+        m_coalescing = coalescing;
+        // Nothing may stay parked once changes are published immediately again
+        flushPendingSignals();
+        emit coalescingChanged();
+    }
+}
+
+qint64 DashboardManager::suppressedEmissions() const {
+    return m_suppressedEmissions;
+}
+
+qint64 DashboardManager::lastSampleTimestampNs() const {
+    return m_lastSampleTimestampNs;
+}
+
+const TelemetryHistory &DashboardManager::history() const {
+    return m_history;
+}
+
+int DashboardManager::historySeconds() const {
+    return m_historySeconds;
+}
+
+void DashboardManager::setHistorySeconds(int seconds) {
+    seconds = qMax(1, seconds);
+    if (m_historySeconds == seconds) {
+        return;
+    }
+
+    m_historySeconds = seconds;
+    m_history.setCapacity(historyCapacity());
+    m_history.reserve();
+    emit historySecondsChanged();
+}
+
+int DashboardManager::historyCapacity() const {
+    return int(qMin(qint64(m_historySeconds) * m_historyRateHz, qint64(TelemetryHistory::DefaultCapacity)));
+}
+
+void DashboardManager::sizeHistory(int rateHz) {
+    // The history only grows for a faster source, so switching to a slower
+    // one does not drop the window that is on the charts
+    m_historyRateHz = qMax(m_historyRateHz, rateHz);
+    if (historyCapacity() > m_history.capacity()) {
+        m_history.setCapacity(historyCapacity());
+    }
+    // Appending to the history must not allocate on the tick path
+    m_history.reserve();
+}
+
+bool DashboardManager::recording() const {
+    return m_recorder.isOpen();
+}
+
+bool DashboardManager::replayActive() const {
+    return m_replayer != nullptr;
+}
+
+bool DashboardManager::loadWarningRules(const QString &path) {
+    QString error;
+    if (!m_warningRules.load(path, &error)) {
+        qWarning() << "Cannot load warning rules from" << path << ":" << error;
+        m_engineIndicator = -1;
+        m_warningIndicators->setNames({});
+        return false;
+    }
+    m_engineIndicator = m_warningRules.indicatorIndex(QStringLiteral("engine"));
+    m_warningIndicators->setNames(m_warningRules.indicators());
+    return true;
+}
+
+const WarningRuleEngine &DashboardManager::warningRules() const {
+    return m_warningRules;
+}
+
+WarningIndicatorModel *DashboardManager::warningIndicators() const {
+    return m_warningIndicators;
+}
+
+void DashboardManager::attachToWindow(QQuickWindow *window) {
+    if (m_window) {
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = window;
+    if (m_window) {
+        // afterAnimating is emitted on the GUI thread once per frame, right
+        // before the scene graph is synchronized, so values applied here are
+        // picked up by the frame that is about to be rendered.
+        connect(m_window, &QQuickWindow::afterAnimating,
+                this, &DashboardManager::onFrame, Qt::DirectConnection);
+        if (m_sharedInputTimer.isActive()) {
+            m_sharedInputTimer.stop();
+            m_window->update();
+        }
+    } else {
+        flushPendingSignals();
+        if (m_sharedInput.isOpen()) {
+            m_sharedInputTimer.start();
+        }
     }
 }
 
 void DashboardManager::simulateDriving() {
-    // Simulate some random driving conditions
-    int speedChange = QRandomGenerator::global()->bounded(-10, 15);
-    int newSpeed = m_currentSpeed + speedChange;
-    setCurrentSpeed(newSpeed);
+    ALLOC_TRACE_SCOPE("DashboardManager::simulateDriving");
+    TelemetrySample sample = VehicleSimulation::step(currentSample(), *QRandomGenerator::global());
+    sample.timestampNs = telemetryClockNs();
+    // The simulated engine reports no faults of its own; engineWarning
+    // carries last tick's lamp and would feed back into the rules
+    sample.engineWarning = false;
+    ingestSample(sample);
+    applySample(sample);
+}
+
+void DashboardManager::startFixedStepSimulation(int rateHz) {
+    stopFixedStepSimulation();
+    stopTelemetryFeed();
+    stopReplay();
+    stopCanLog();
+    stopSharedMemoryInput();
 
-    // Simulate fuel consumption
-    if (newSpeed > 0) {
-        int fuelConsumption = newSpeed / 20;
-        setFuelLevel(m_fuelLevel - fuelConsumption);
+    // Continue from what is on screen
+    VehicleSimulation::ContinuousState initial;
+    initial.speed = m_latest.currentSpeed;
+    initial.fuelLevel = m_latest.fuelLevel;
+    initial.engineWarning = m_latest.engineWarning;
+    initial.gear = currentSample().gear;
+
+    m_simulationTimer.stop();
+    sizeHistory(MaxHistoryRateHz);
+    m_fixedStep = new FixedStepSimulation(rateHz, QRandomGenerator::global()->generate64(), initial, this);
+    m_fixedStep->start();
+    emit fixedStepActiveChanged();
+    emit simulationStatsChanged();
+
+    if (m_window) {
+        m_window->update();
     }
+}
 
-    // Random engine warning
-    if (QRandomGenerator::global()->bounded(100) < 5) {
-        setEngineWarning(true);
+void DashboardManager::stopFixedStepSimulation() {
+    if (!m_fixedStep) {
+        return;
     }
 
-    // Gear shifting simulation
-    QStringList gears = {"P", "R", "N", "D"};
-    if (QRandomGenerator::global()->bounded(100) < 10) {
-        setCurrentGear(gears[QRandomGenerator::global()->bounded(gears.size())]);
+    m_fixedStep->requestInterruption();
+    m_fixedStep->wait();
+    delete m_fixedStep;
+    m_fixedStep = nullptr;
+
+    // Settle on whole values again
+    setDisplayValues(m_latest.currentSpeed, m_latest.fuelLevel);
+    m_simulationTimer.start(1000);
+    emit fixedStepActiveChanged();
+    emit simulationStatsChanged();
+}
+
+void DashboardManager::startTelemetryFeed(int rateHz) {
+    stopTelemetryFeed();
+    stopFixedStepSimulation();
+    stopReplay();
+    stopCanLog();
+    stopSharedMemoryInput();
+
+    m_simulationTimer.stop();
+    sizeHistory(rateHz);
+    m_producer = new TelemetryProducer(m_telemetryQueue, rateHz,
+                                       QRandomGenerator::global()->generate64(), this);
+    m_producer->start();
+    emit telemetryFeedActiveChanged();
+
+    // Kick off the frame-driven drain loop
+    if (m_window) {
+        m_window->update();
+    }
+}
+
+void DashboardManager::stopTelemetryFeed() {
+    if (!m_producer) {
+        return;
+    }
+
+    m_producer->requestInterruption();
+    m_producer->wait();
+    delete m_producer;
+    m_producer = nullptr;
+
+    // Apply whatever the producer left behind before going back to the timer
+    drainTelemetry();
+    m_simulationTimer.start(1000);
+    emit telemetryFeedActiveChanged();
+}
+
+bool DashboardManager::startRecording(const QString &path) {
+    QString error;
+    const bool wasRecording = recording();
+    if (!m_recorder.open(path, &error)) {
+        qWarning() << "Cannot record telemetry to" << path << ":" << error;
+        if (wasRecording) {
+            emit recordingChanged();
+        }
+        return false;
+    }
+    if (!wasRecording) {
+        emit recordingChanged();
+    }
+    return true;
+}
+
+void DashboardManager::stopRecording() {
+    if (m_recorder.isOpen()) {
+        m_recorder.close();
+        emit recordingChanged();
+    }
+}
+
+bool DashboardManager::startReplay(const QString &path, double speed) {
+    stopTelemetryFeed();
+    stopFixedStepSimulation();
+    stopReplay();
+    stopCanLog();
+    stopSharedMemoryInput();
+
+    auto *replayer = new TelemetryReplayer(this);
+    QString error;
+    if (!replayer->open(path, &error)) {
+        qWarning() << "Cannot replay telemetry from" << path << ":" << error;
+        delete replayer;
+        return false;
+    }
+
+    // Replay must be the only source of data for runs to be reproducible.
+    // Its timestamps come from another run, so the history starts over.
+    m_simulationTimer.stop();
+    m_history.clear();
+    sizeHistory(MaxHistoryRateHz);
+    m_warningRules.reset();
+    m_warningIndicators->setBits(0);
+    m_replayer = replayer;
+    m_replayer->setSpeed(speed);
+    connect(m_replayer, &TelemetryReplayer::sampleReplayed, this, [this](TelemetrySample sample) {
+        ingestSample(sample);
+        applySample(sample);
+    });
+    m_replayer->play();
+    emit replayActiveChanged();
+    return true;
+}
+
+void DashboardManager::stopReplay() {
+    if (!m_replayer) {
+        return;
+    }
+
+    delete m_replayer;
+    m_replayer = nullptr;
+    m_simulationTimer.start(1000);
+    emit replayActiveChanged();
+}
+
+void DashboardManager::seekReplay(qint64 positionMs) {
+    if (m_replayer) {
+        // The history only holds non-decreasing timestamps
+        m_history.clear();
+        m_warningRules.reset();
+        m_warningIndicators->setBits(0);
+        m_replayer->seek(positionMs);
+    }
+}
+
+bool DashboardManager::startCanLog(const QString &logPath, const QString &dbcPath, double speed) {
+    stopTelemetryFeed();
+    stopFixedStepSimulation();
+    stopReplay();
+    stopCanLog();
+    stopSharedMemoryInput();
+
+    auto *source = new CanTelemetrySource(m_telemetryQueue, this);
+    const QString database = dbcPath.isEmpty() ? QString::fromLatin1(DefaultCanDatabase) : dbcPath;
+    QString error;
+    if (!source->open(logPath, database, CanTelemetrySource::SignalMapping(), &error)) {
+        qWarning() << "Cannot play CAN log" << logPath << ":" << error;
+        delete source;
+        return false;
+    }
+
+    m_simulationTimer.stop();
+    sizeHistory(MaxHistoryRateHz);
+    m_canSource = source;
+    m_canSource->setSpeed(speed);
+    // Back to the simulation at the end of the log. Queued from the worker
+    // thread, so it may arrive after this source was already replaced.
+    connect(m_canSource, &QThread::finished, this, [this, source] {
+        if (m_canSource == source) {
+            stopCanLog();
+        }
+    });
+    m_canSource->start();
+    emit canLogActiveChanged();
+
+    // Kick off the frame-driven drain loop
+    if (m_window) {
+        m_window->update();
+    }
+    return true;
+}
+
+void DashboardManager::stopCanLog() {
+    if (!m_canSource) {
+        return;
+    }
+
+    m_canSource->requestInterruption();
+    m_canSource->wait();
+    delete m_canSource;
+    m_canSource = nullptr;
+
+    drainTelemetry();
+    m_simulationTimer.start(1000);
+    emit canLogActiveChanged();
+    emit telemetryStatsChanged();
+}
+
+bool DashboardManager::startSharedMemoryInput(const QString &name) {
+    stopTelemetryFeed();
+    stopFixedStepSimulation();
+    stopReplay();
+    stopCanLog();
+    stopSharedMemoryInput();
+
+    const QString segmentName = name.isEmpty() ? QString::fromLatin1(SharedTelemetry::DefaultName) : name;
+    QString error;
+    if (!m_sharedInput.open(segmentName, &error)) {
+        qWarning() << "Cannot read shared-memory telemetry:" << error;
+        return false;
+    }
+
+    // Only what is published from now on; the ring may be hours old
+    TelemetrySample latest;
+    quint64 written = 0;
+    SharedTelemetry::readLatest(*m_sharedInput.segment(), latest, written);
+    m_sharedInputCursor = written;
+
+    m_simulationTimer.stop();
+    sizeHistory(MaxHistoryRateHz);
+    if (m_window) {
+        m_window->update();
+    } else {
+        m_sharedInputTimer.start();
+    }
+    emit sharedMemoryInputActiveChanged();
+    return true;
+}
+
+void DashboardManager::stopSharedMemoryInput() {
+    if (!m_sharedInput.isOpen()) {
+        return;
+    }
+
+    pollSharedMemory();
+    m_sharedInputTimer.stop();
+    m_sharedInput.close();
+    m_simulationTimer.start(1000);
+    emit sharedMemoryInputActiveChanged();
+}
+
+void DashboardManager::pollSharedMemory() {
+    ALLOC_TRACE_SCOPE("DashboardManager::pollSharedMemory");
+    if (!m_sharedInput.isOpen()) {
+        return;
+    }
+
+    const SharedTelemetry::Segment &segment = *m_sharedInput.segment();
+    TelemetrySample latest;
+    quint64 written = 0;
+    if (!SharedTelemetry::readLatest(segment, latest, written) || written == m_sharedInputCursor) {
+        return;
+    }
+    if (written < m_sharedInputCursor) {
+        // The producer started over in a segment of the same name
+        m_sharedInputCursor = 0;
+    }
+
+    // Every sample before the latest comes from the ring, as far back as it
+    // still holds them, so the rules and the history see the whole stream
+    quint64 first = m_sharedInputCursor;
+    qint64 lost = 0;
+    if (written - first > SharedTelemetry::HistoryCapacity) {
+        lost += qint64(written - SharedTelemetry::HistoryCapacity - first);
+        first = written - SharedTelemetry::HistoryCapacity;
+    }
+    qint64 count = 0;
+    for (quint64 index = first; index + 1 < written; ++index) {
+        TelemetrySample sample;
+        if (SharedTelemetry::readHistory(segment, index, sample)) {
+            ingestSample(sample);
+            ++count;
+        } else {
+            ++lost;
+        }
+    }
+    ingestSample(latest);
+    ++count;
+    m_sharedInputCursor = written;
+
+    m_receivedSamples += count;
+    m_sharedInputLostSamples += lost;
+    applySample(latest);
+    emit telemetryStatsChanged();
+}
+
+void DashboardManager::ingestSample(TelemetrySample &sample) {
+    const quint64 indicators = m_warningRules.evaluate(sample);
+    // Published by onFrame(), or right away without a window
+    m_warningIndicators->storeBits(indicators);
+    if (!m_window) {
+        m_warningIndicators->publishChanges();
+    }
+    sample.engineWarning = m_engineIndicator >= 0 && (indicators >> m_engineIndicator) & 1;
+
+    m_recorder.append(sample);
+    m_history.append(sample);
+
+    // Make sure a frame comes to announce the new history
+    if (m_window && m_history.revision() == m_reportedHistoryRevision + 1) {
+        m_window->update();
+    }
+}
+
+TelemetrySample DashboardManager::currentSample() const {
+    TelemetrySample sample;
+    sample.speed = qint16(m_latest.currentSpeed);
+    sample.fuelLevel = qint8(m_latest.fuelLevel);
+    sample.engineWarning = m_latest.engineWarning;
+    sample.gear = char(m_latest.currentGear);
+    return sample;
+}
+
+void DashboardManager::applySample(const TelemetrySample &sample) {
+    m_lastSampleTimestampNs = sample.timestampNs;
+    setCurrentSpeed(sample.speed);
+    setFuelLevel(sample.fuelLevel);
+    setEngineWarning(sample.engineWarning);
+    setCurrentGear(Gear(sample.gear));
+    setDisplayValues(m_latest.currentSpeed, m_latest.fuelLevel);
+}
+
+void DashboardManager::setDisplayValues(qreal speed, qreal fuelLevel) {
+    if (m_latest.displaySpeed != speed || m_latest.displayFuelLevel != fuelLevel) {
+        m_latest.displaySpeed = speed;
+        m_latest.displayFuelLevel = fuelLevel;
+        notifyChanged(DisplayPending);
+    }
+}
+
+void DashboardManager::applyFixedStepFrame() {
+    ALLOC_TRACE_SCOPE("DashboardManager::applyFixedStepFrame");
+    // Both bracketing ticks exist for a point one step in the past, so
+    // the gauges trail the simulation by one step and never extrapolate.
+    const qint64 frameNs = telemetryClockNs();
+    const FixedStepSimulation::Frame frame = m_fixedStep->latestFrame();
+    const VehicleSimulation::ContinuousState state =
+        FixedStepSimulation::interpolate(frame, frameNs - m_fixedStep->stepNs());
+
+    TelemetrySample sample;
+    sample.timestampNs = frame.currentTickNs;
+    sample.speed = qint16(qRound(state.speed));
+    sample.fuelLevel = qint8(qRound(state.fuelLevel));
+    sample.gear = state.gear;
+    ingestSample(sample);
+
+    // As applySample(), but the gauges get the unrounded values
+    m_lastSampleTimestampNs = sample.timestampNs;
+    setCurrentSpeed(sample.speed);
+    setFuelLevel(sample.fuelLevel);
+    setEngineWarning(sample.engineWarning);
+    setCurrentGear(Gear(sample.gear));
+    setDisplayValues(state.speed, state.fuelLevel);
+
+    if (frameNs - m_lastStatsReportNs >= SimulationStatsIntervalNs) {
+        m_lastStatsReportNs = frameNs;
+        emit simulationStatsChanged();
+    }
+}
+
+void DashboardManager::onFrame() {
+    if (m_fixedStep) {
+        applyFixedStepFrame();
+    }
+    drainTelemetry();
+    pollSharedMemory();
+    flushPendingSignals();
+    // Lamps change with the gauges instead of one event loop pass later
+    m_warningIndicators->publishChanges();
+
+    // Charts redraw at most once per frame, however many samples arrived
+    if (m_history.revision() != m_reportedHistoryRevision) {
+        m_reportedHistoryRevision = m_history.revision();
+        emit historyChanged();
+    }
+
+    if (m_suppressedEmissions != m_reportedSuppressedEmissions) {
+        m_reportedSuppressedEmissions = m_suppressedEmissions;
+        emit coalescingStatsChanged();
+    }
+
+    // Keep frames coming while a producer thread or the fixed-step
+    // simulation is running; without a scheduled frame there would be no
+    // afterAnimating to drain the queue or interpolate.
+    if ((m_producer || m_canSource || m_fixedStep || m_sharedInput.isOpen()) && m_window) {
+        m_window->update();
+    }
+}
+
+void DashboardManager::drainTelemetry() {
+    ALLOC_TRACE_SCOPE("DashboardManager::drainTelemetry");
+    // Only the newest sample can be seen on screen, so the properties are
+    // updated once per frame no matter how many samples arrived.
+    TelemetrySample latest;
+    const std::size_t count = m_telemetryQueue.drain([this, &latest](const TelemetrySample &sample) {
+        latest = sample;
+        ingestSample(latest);
+    });
+
+    if (count > 0) {
+        m_receivedSamples += qint64(count);
+        applySample(latest);
+    }
+
+    const qint64 dropped = droppedSamples();
+    if (count > 0 || dropped != m_reportedDroppedSamples) {
+        m_reportedDroppedSamples = dropped;
+        emit telemetryStatsChanged();
+    }
+}
+
+void DashboardManager::notifyChanged(PendingSignal which) {
+    // Without a window there is no frame to wait for
+    if (!m_coalescing || !m_window) {
+        publishProperty(which);
+        return;
+    }
+
+    if (m_pendingSignals & which) {
+        // Already scheduled for this frame: the latest value wins
+        ++m_suppressedEmissions;
+        return;
+    }
+
+    if (!m_pendingSignals) {
+        m_window->update();
+    }
+    m_pendingSignals |= which;
+}
+
+void DashboardManager::publishProperty(PendingSignal which) {
+    // The properties emit their NOTIFY signals and update dependent
+    // bindings themselves when the value differs
+    switch (which) {
+    case SpeedPending:
+        m_currentSpeed = m_latest.currentSpeed;
+        break;
+    case FuelLevelPending:
+        m_fuelLevel = m_latest.fuelLevel;
+        break;
+    case EngineWarningPending:
+        m_engineWarning = m_latest.engineWarning;
+        break;
+    case GearPending:
+        m_currentGear = m_latest.currentGear;
+        break;
+    case DisplayPending:
+        m_displaySpeed = m_latest.displaySpeed;
+        m_displayFuelLevel = m_latest.displayFuelLevel;
+        break;
+    }
+}
+
+void DashboardManager::flushPendingSignals() {
+    const quint8 pending = m_pendingSignals;
+    m_pendingSignals = 0;
+
+    // No property update group: each derived property has a single input,
+    // and opening a group allocates
+    for (PendingSignal which : {SpeedPending, FuelLevelPending, EngineWarningPending, GearPending, DisplayPending}) {
+        if (pending & which) {
+            publishProperty(which);
+        }
     }
 }
@@ -2,44 +2,342 @@
 #define DASHBOARDMANAGER_H
 
 #include <QObject>
+#include <QProperty>
+#include <QPointer>
 #include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include "alloctracer.h"
+#include "cantelemetrysource.h"
+#include "fixedstepsimulation.h"
+#include "sharedtelemetry.h"
+#include "telemetryhistory.h"
+#include "telemetryproducer.h"
+#include "telemetryrecorder.h"
+#include "telemetryreplayer.h"
+#include "warningindicatormodel.h"
+#include "warningruleengine.h"
 
+class QQuickWindow;
+
+// Exposed to QML as a typed singleton so bindings against it can be
+// compiled ahead of time; the engine creates and owns the instance.
+//
+// The vehicle properties are bindable, and the values derived from them
+// (speedRatio, rangeKm, lowFuel) are C++ bindings on those. A derived value
+// is only recomputed when one of its inputs changes, and QML is only
+// notified when the result differs, so a gauge color does not re-evaluate
+// on every fuel sample.
 class DashboardManager : public QObject {
     Q_OBJECT
-    Q_PROPERTY(int currentSpeed READ currentSpeed WRITE setCurrentSpeed NOTIFY speedChanged)
-    Q_PROPERTY(int fuelLevel READ fuelLevel WRITE setFuelLevel NOTIFY fuelLevelChanged)
-    Q_PROPERTY(bool engineWarning READ engineWarning WRITE setEngineWarning NOTIFY engineWarningChanged)
-    Q_PROPERTY(QString currentGear READ currentGear WRITE setCurrentGear NOTIFY gearChanged)
+    QML_ELEMENT
+    QML_SINGLETON
+    Q_PROPERTY(int currentSpeed READ currentSpeed WRITE setCurrentSpeed NOTIFY speedChanged
+               BINDABLE bindableCurrentSpeed)
+    Q_PROPERTY(int fuelLevel READ fuelLevel WRITE setFuelLevel NOTIFY fuelLevelChanged
+               BINDABLE bindableFuelLevel)
+    Q_PROPERTY(bool engineWarning READ engineWarning WRITE setEngineWarning NOTIFY engineWarningChanged
+               BINDABLE bindableEngineWarning)
+    Q_PROPERTY(Gear currentGear READ currentGear WRITE setCurrentGear NOTIFY gearChanged
+               BINDABLE bindableCurrentGear)
+    Q_PROPERTY(QString gearLabel READ gearLabel NOTIFY gearChanged)
+
+    // Speed and fuel level as drawn this frame. Fractional while the
+    // fixed-timestep simulation interpolates between its ticks.
+    Q_PROPERTY(qreal displaySpeed READ displaySpeed NOTIFY displaySpeedChanged
+               BINDABLE bindableDisplaySpeed)
+    Q_PROPERTY(qreal displayFuelLevel READ displayFuelLevel NOTIFY displayFuelLevelChanged
+               BINDABLE bindableDisplayFuelLevel)
+
+    // Derived from the properties above
+    Q_PROPERTY(qreal speedRatio READ speedRatio NOTIFY speedRatioChanged BINDABLE bindableSpeedRatio)
+    Q_PROPERTY(qreal rangeKm READ rangeKm NOTIFY rangeKmChanged BINDABLE bindableRangeKm)
+    Q_PROPERTY(bool lowFuel READ lowFuel NOTIFY lowFuelChanged BINDABLE bindableLowFuel)
+
+    // Fixed-timestep simulation and its scheduling statistics
+    Q_PROPERTY(bool fixedStepActive READ fixedStepActive NOTIFY fixedStepActiveChanged)
+    Q_PROPERTY(qint64 simulationTicks READ simulationTicks NOTIFY simulationStatsChanged)
+    Q_PROPERTY(qint64 skippedSimulationTicks READ skippedSimulationTicks NOTIFY simulationStatsChanged)
+    Q_PROPERTY(qreal maxTickLatenessUs READ maxTickLatenessUs NOTIFY simulationStatsChanged)
+    Q_PROPERTY(qreal meanTickLatenessUs READ meanTickLatenessUs NOTIFY simulationStatsChanged)
+
+    // Background telemetry feed statistics
+    Q_PROPERTY(bool telemetryFeedActive READ telemetryFeedActive NOTIFY telemetryFeedActiveChanged)
+    Q_PROPERTY(qint64 receivedSamples READ receivedSamples NOTIFY telemetryStatsChanged)
+    Q_PROPERTY(qint64 droppedSamples READ droppedSamples NOTIFY telemetryStatsChanged)
+
+    // CAN log playback and its decoding rate
+    Q_PROPERTY(bool canLogActive READ canLogActive NOTIFY canLogActiveChanged)
+    Q_PROPERTY(qint64 canDecodedFrames READ canDecodedFrames NOTIFY telemetryStatsChanged)
+    Q_PROPERTY(qreal canFramesPerSecond READ canFramesPerSecond NOTIFY telemetryStatsChanged)
+
+    // Telemetry published by another process in shared memory
+    Q_PROPERTY(bool sharedMemoryInputActive READ sharedMemoryInputActive
+               NOTIFY sharedMemoryInputActiveChanged)
+
+    // Publish property changes once per frame instead of on every setter call
+    Q_PROPERTY(bool coalescing READ coalescing WRITE setCoalescing NOTIFY coalescingChanged)
+    Q_PROPERTY(qint64 suppressedEmissions READ suppressedEmissions NOTIFY coalescingStatsChanged)
+
+    // Record-and-replay of telemetry logs
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(bool replayActive READ replayActive NOTIFY replayActiveChanged)
+
+    // How far back the history reaches at the rate of the current source;
+    // the charts show this window
+    Q_PROPERTY(int historySeconds READ historySeconds WRITE setHistorySeconds NOTIFY historySecondsChanged)
+
+    // Every lamp named by the warning rules, driven by their indicator mask
+    Q_PROPERTY(WarningIndicatorModel *warningIndicators READ warningIndicators CONSTANT)
 
 public:
+    // Values are the letters TelemetrySample::gear uses
+    enum Gear : quint8 {
+        Park = 'P',
+        Reverse = 'R',
+        Neutral = 'N',
+        Drive = 'D'
+    };
+    Q_ENUM(Gear)
+
+    static constexpr int MaxSpeed = 220;
+    // fuelLevel below this percentage raises lowFuel
+    static constexpr int LowFuelThreshold = 20;
+    // Distance a full tank lasts at average consumption
+    static constexpr qreal FullTankRangeKm = 600;
+
+    static constexpr int DefaultHistorySeconds = 300;
+    // Sample rate the history is sized for when a source has no fixed one:
+    // frames, replays, CAN logs and shared memory
+    static constexpr int MaxHistoryRateHz = 1000;
+
     explicit DashboardManager(QObject *parent = nullptr);
+    ~DashboardManager();
 
     int currentSpeed() const;
     void setCurrentSpeed(int speed);
+    QBindable<int> bindableCurrentSpeed();
 
     int fuelLevel() const;
     void setFuelLevel(int level);
+    QBindable<int> bindableFuelLevel();
 
     bool engineWarning() const;
     void setEngineWarning(bool warning);
+    QBindable<bool> bindableEngineWarning();
+
+    Gear currentGear() const;
+    void setCurrentGear(Gear gear);
+    QBindable<Gear> bindableCurrentGear();
+    // "P", "R", "N" or "D", from static data
+    QString gearLabel() const;
+
+    qreal displaySpeed() const;
+    QBindable<qreal> bindableDisplaySpeed();
+    qreal displayFuelLevel() const;
+    QBindable<qreal> bindableDisplayFuelLevel();
+
+    // displaySpeed as a fraction of MaxSpeed
+    qreal speedRatio() const;
+    QBindable<qreal> bindableSpeedRatio();
+    // Distance left on displayFuelLevel
+    qreal rangeKm() const;
+    QBindable<qreal> bindableRangeKm();
+    bool lowFuel() const;
+    QBindable<bool> bindableLowFuel();
+
+    bool fixedStepActive() const;
+    qint64 simulationTicks() const;
+    qint64 skippedSimulationTicks() const;
+    qreal maxTickLatenessUs() const;
+    qreal meanTickLatenessUs() const;
+
+    bool telemetryFeedActive() const;
+    qint64 receivedSamples() const;
+    qint64 droppedSamples() const;
+
+    bool canLogActive() const;
+    qint64 canDecodedFrames() const;
+    qreal canFramesPerSecond() const;
+
+    bool sharedMemoryInputActive() const;
+
+    bool coalescing() const;
+    void setCoalescing(bool coalescing);
+    qint64 suppressedEmissions() const;
+
+    bool recording() const;
+    bool replayActive() const;
 
-    QString currentGear() const;
-    void setCurrentGear(const QString &gear);
+    // Every sample received, for charts. Announced by historyChanged() at
+    // most once per frame.
+    const TelemetryHistory &history() const;
+    int historySeconds() const;
+    void setHistorySeconds(int seconds);
+
+    // Capture time of the newest sample applied to the properties
+    qint64 lastSampleTimestampNs() const;
+
+    // Rules that drive the warning lamps and engineWarning, evaluated on
+    // every received sample. The rules shipped with the application are
+    // loaded on construction.
+    Q_INVOKABLE bool loadWarningRules(const QString &path);
+    const WarningRuleEngine &warningRules() const;
+    WarningIndicatorModel *warningIndicators() const;
+
+    // Drain the telemetry queue and publish coalesced changes once per frame of this window.
+    void attachToWindow(QQuickWindow *window);
 
     Q_INVOKABLE void simulateDriving();
 
+    // Show a sample on the gauges, the last step of every telemetry source.
+    // The sample is not recorded, added to the history or checked by the
+    // warning rules.
+    void applySample(const TelemetrySample &sample);
+
+    // Replace the 1 s GUI-thread simulation with fixed-timestep physics on a
+    // worker thread at rateHz (up to 1 kHz), interpolated once per frame.
+    Q_INVOKABLE void startFixedStepSimulation(int rateHz);
+    Q_INVOKABLE void stopFixedStepSimulation();
+
+    // Replace the 1 s GUI-thread simulation with a producer thread running at rateHz.
+    Q_INVOKABLE void startTelemetryFeed(int rateHz);
+    Q_INVOKABLE void stopTelemetryFeed();
+
+    // Append every sample the dashboard receives to a binary telemetry log.
+    Q_INVOKABLE bool startRecording(const QString &path);
+    Q_INVOKABLE void stopRecording();
+
+    // Drive the dashboard from a recorded log instead of live data.
+    // speed 1 is real time, N is N times faster, 0 is as fast as possible.
+    Q_INVOKABLE bool startReplay(const QString &path, double speed = 1.0);
+    Q_INVOKABLE void stopReplay();
+    Q_INVOKABLE void seekReplay(qint64 positionMs);
+
+    // Drive the dashboard from a candump log decoded with a DBC database
+    // (the built-in vehicle.dbc if empty). speed as for startReplay().
+    Q_INVOKABLE bool startCanLog(const QString &logPath, const QString &dbcPath = QString(),
+                                 double speed = 1.0);
+    Q_INVOKABLE void stopCanLog();
+
+    // Read telemetry from the shared-memory segment of an out-of-process
+    // producer (SharedTelemetry::DefaultName if empty), polled once per
+    // frame, or every millisecond without a window. Samples the producer
+    // overwrote before they were read count as dropped.
+    Q_INVOKABLE bool startSharedMemoryInput(const QString &name = QString());
+    Q_INVOKABLE void stopSharedMemoryInput();
+
 signals:
     void speedChanged();
     void fuelLevelChanged();
     void engineWarningChanged();
     void gearChanged();
+    void displaySpeedChanged();
+    void displayFuelLevelChanged();
+    void speedRatioChanged();
+    void rangeKmChanged();
+    void lowFuelChanged();
+    void fixedStepActiveChanged();
+    void simulationStatsChanged();
+    void telemetryFeedActiveChanged();
+    void telemetryStatsChanged();
+    void coalescingChanged();
+    void coalescingStatsChanged();
+    void recordingChanged();
+    void replayActiveChanged();
+    void canLogActiveChanged();
+    void sharedMemoryInputActiveChanged();
+    void historyChanged();
+    void historySecondsChanged();
 
 private:
-    int m_currentSpeed;
-    int m_fuelLevel;
-    bool m_engineWarning;
-    QString m_currentGear;
+    // Properties waiting to be published at the next frame in coalescing mode
+    enum PendingSignal : quint8 {
+        SpeedPending = 0x1,
+        FuelLevelPending = 0x2,
+        EngineWarningPending = 0x4,
+        GearPending = 0x8,
+        DisplayPending = 0x10
+    };
+
+    void ingestSample(TelemetrySample &sample);
+    TelemetrySample currentSample() const;
+    void setDisplayValues(qreal speed, qreal fuelLevel);
+    void applyFixedStepFrame();
+    void onFrame();
+    void drainTelemetry();
+    void pollSharedMemory();
+    void notifyChanged(PendingSignal which);
+    void publishProperty(PendingSignal which);
+    void flushPendingSignals();
+    int historyCapacity() const;
+    void sizeHistory(int rateHz);
+
+    // Values most recently set, which in coalescing mode may not have been
+    // published to the properties yet
+    struct PropertyValues {
+        int currentSpeed = 0;
+        int fuelLevel = 100;
+        bool engineWarning = false;
+        Gear currentGear = Park;
+        qreal displaySpeed = 0;
+        qreal displayFuelLevel = 100;
+    };
+    PropertyValues m_latest;
+
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, int, m_currentSpeed, 0,
+                                         &DashboardManager::speedChanged)
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, int, m_fuelLevel, 100,
+                                         &DashboardManager::fuelLevelChanged)
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, bool, m_engineWarning, false,
+                                         &DashboardManager::engineWarningChanged)
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, Gear, m_currentGear, Park,
+                                         &DashboardManager::gearChanged)
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, qreal, m_displaySpeed, 0,
+                                         &DashboardManager::displaySpeedChanged)
+    Q_OBJECT_BINDABLE_PROPERTY_WITH_ARGS(DashboardManager, qreal, m_displayFuelLevel, 100,
+                                         &DashboardManager::displayFuelLevelChanged)
+    Q_OBJECT_BINDABLE_PROPERTY(DashboardManager, qreal, m_speedRatio,
+                               &DashboardManager::speedRatioChanged)
+    Q_OBJECT_BINDABLE_PROPERTY(DashboardManager, qreal, m_rangeKm,
+                               &DashboardManager::rangeKmChanged)
+    Q_OBJECT_BINDABLE_PROPERTY(DashboardManager, bool, m_lowFuel,
+                               &DashboardManager::lowFuelChanged)
+
     QTimer m_simulationTimer;
+
+    FixedStepSimulation *m_fixedStep;
+    qint64 m_lastStatsReportNs;
+
+    TelemetryQueue m_telemetryQueue;
+    TelemetryProducer *m_producer;
+    QPointer<QQuickWindow> m_window;
+    qint64 m_receivedSamples;
+    qint64 m_reportedDroppedSamples;
+
+    bool m_coalescing;
+    quint8 m_pendingSignals;
+    qint64 m_suppressedEmissions;
+    qint64 m_reportedSuppressedEmissions;
+
+    qint64 m_lastSampleTimestampNs;
+
+    TelemetryRecorder m_recorder;
+    TelemetryReplayer *m_replayer;
+    CanTelemetrySource *m_canSource;
+
+    SharedTelemetryChannel m_sharedInput;
+    quint64 m_sharedInputCursor;        // samples of the segment already read
+    qint64 m_sharedInputLostSamples;
+    QTimer m_sharedInputTimer;
+
+    int m_historySeconds;
+    int m_historyRateHz;
+    TelemetryHistory m_history;
+    quint64 m_reportedHistoryRevision;
+
+    WarningRuleEngine m_warningRules;
+    int m_engineIndicator;
+    WarningIndicatorModel *m_warningIndicators;
 };
 
 #endif // DASHBOARDMANAGER_H
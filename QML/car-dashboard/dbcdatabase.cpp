@@ -0,0 +1,223 @@
+#include "dbcdatabase.h"
+#include <QFile>
+#include <QRegularExpression>
+
+namespace {
+
+constexpr int StandardIdCount = 2048;
+// Bit 31 of a DBC message ID marks an extended frame
+constexpr quint32 ExtendedIdFlag = 0x80000000u;
+
+} // namespace
+
+DbcDatabase::DbcDatabase()
+    : m_standardIds(StandardIdCount, -1)
+{
+}
+
+bool DbcDatabase::load(const QString &path, QString *errorString) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return parse(file.readAll(), errorString);
+}
+
+bool DbcDatabase::parse(const QByteArray &text, QString *errorString) {
+    clear();
+
+    static const QRegularExpression messagePattern(
+        QStringLiteral(R"(^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+))"));
+    static const QRegularExpression signalPattern(
+        QStringLiteral(R"(^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*)"
+                       R"(\(\s*([^,\s]+)\s*,\s*([^)\s]+)\s*\)\s*\[\s*([^|\s]*)\s*\|\s*([^\]\s]*)\s*\]\s*"([^"]*)")"));
+    static const QRegularExpression valuesPattern(
+        QStringLiteral(R"(^VAL_\s+(\d+)\s+(\w+)\s+(.*);)"));
+    static const QRegularExpression valuePattern(
+        QStringLiteral(R"((-?\d+)\s+"([^"]*)")"));
+
+    auto fail = [this, errorString](int line, const QString &message) {
+        if (errorString) {
+            *errorString = QStringLiteral("Line %1: %2").arg(line).arg(message);
+        }
+        clear();
+        return false;
+    };
+
+    int lineNumber = 0;
+    for (const QByteArray &rawLine : text.split('\n')) {
+        ++lineNumber;
+        const QString line = QString::fromUtf8(rawLine).trimmed();
+
+        if (line.startsWith(QLatin1String("BO_ "))) {
+            const QRegularExpressionMatch match = messagePattern.match(line);
+            if (!match.hasMatch()) {
+                return fail(lineNumber, QStringLiteral("malformed message"));
+            }
+            const quint32 rawId = match.captured(1).toUInt();
+            Message message;
+            message.extended = (rawId & ExtendedIdFlag) != 0;
+            message.id = message.extended ? rawId & 0x1FFFFFFF : rawId;
+            message.name = match.captured(2);
+            message.length = match.captured(3).toInt();
+            if (!message.extended && message.id >= StandardIdCount) {
+                return fail(lineNumber, QStringLiteral("standard ID %1 out of range").arg(message.id));
+            }
+            if (messageIndex(message.id, message.extended) >= 0) {
+                return fail(lineNumber, QStringLiteral("duplicate message %1").arg(message.id));
+            }
+
+            const int index = int(m_messages.size());
+            if (message.extended) {
+                m_extendedIds.insert(message.id, index);
+            } else {
+                m_standardIds[message.id] = index;
+            }
+            m_messages.push_back(message);
+        } else if (line.startsWith(QLatin1String("SG_ "))) {
+            if (m_messages.empty()) {
+                return fail(lineNumber, QStringLiteral("signal outside a message"));
+            }
+            const QRegularExpressionMatch match = signalPattern.match(line);
+            if (!match.hasMatch()) {
+                return fail(lineNumber, QStringLiteral("malformed signal"));
+            }
+
+            Signal signal;
+            signal.name = match.captured(1);
+            const QString multiplex = match.captured(2);
+            signal.multiplexer = multiplex == QLatin1String("M");
+            if (multiplex.startsWith(QLatin1Char('m'))) {
+                signal.multiplexValue = multiplex.mid(1).toInt();
+            }
+            signal.startBit = match.captured(3).toInt();
+            signal.length = match.captured(4).toInt();
+            signal.bigEndian = match.captured(5) == QLatin1String("0");
+            signal.isSigned = match.captured(6) == QLatin1String("-");
+            signal.factor = match.captured(7).toDouble();
+            signal.offset = match.captured(8).toDouble();
+            signal.minimum = match.captured(9).toDouble();
+            signal.maximum = match.captured(10).toDouble();
+            signal.unit = match.captured(11);
+
+            QString error;
+            if (!compile(signal, &error)) {
+                return fail(lineNumber, QStringLiteral("signal %1: %2").arg(signal.name, error));
+            }
+
+            Message &message = m_messages.back();
+            if (signal.multiplexer) {
+                message.multiplexer = int(message.canSignals.size());
+            }
+            message.canSignals.push_back(signal);
+        } else if (line.startsWith(QLatin1String("VAL_ "))) {
+            const QRegularExpressionMatch match = valuesPattern.match(line);
+            if (!match.hasMatch()) {
+                continue;
+            }
+            // Value tables may refer to messages of either kind by raw ID
+            const quint32 rawId = match.captured(1).toUInt();
+            const bool extended = (rawId & ExtendedIdFlag) != 0;
+            const int index = messageIndex(extended ? rawId & 0x1FFFFFFF : rawId, extended);
+            if (index < 0) {
+                continue;
+            }
+            for (Signal &signal : m_messages[std::size_t(index)].canSignals) {
+                if (signal.name != match.captured(2)) {
+                    continue;
+                }
+                QRegularExpressionMatchIterator values = valuePattern.globalMatch(match.captured(3));
+                while (values.hasNext()) {
+                    const QRegularExpressionMatch value = values.next();
+                    signal.valueNames.insert(value.captured(1).toLongLong(), value.captured(2));
+                }
+            }
+        }
+        // Everything else (nodes, comments, attributes) does not affect decoding
+    }
+
+    return true;
+}
+
+bool DbcDatabase::compile(Signal &signal, QString *errorString) const {
+    if (signal.length < 1 || signal.length > 64) {
+        *errorString = QStringLiteral("length must be 1 to 64 bits");
+        return false;
+    }
+
+    // Bit positions counted from the least significant bit of the word
+    int lsb;
+    if (signal.bigEndian) {
+        // Motorola start bits name the most significant bit, numbered
+        // within its byte; byte 0 is the top of the big-endian word
+        const int msb = (7 - signal.startBit / 8) * 8 + signal.startBit % 8;
+        lsb = msb - (signal.length - 1);
+        signal.wordIndex = 1;
+    } else {
+        lsb = signal.startBit;
+        signal.wordIndex = 0;
+    }
+    if (lsb < 0 || lsb + signal.length > 64) {
+        *errorString = QStringLiteral("does not fit in 8 bytes");
+        return false;
+    }
+
+    signal.shift = quint8(lsb);
+    signal.mask = signal.length == 64 ? ~quint64(0) : (quint64(1) << signal.length) - 1;
+    signal.signBit = signal.isSigned ? quint64(1) << (signal.length - 1) : 0;
+    return true;
+}
+
+void DbcDatabase::clear() {
+    m_messages.clear();
+    m_standardIds.assign(StandardIdCount, -1);
+    m_extendedIds.clear();
+}
+
+int DbcDatabase::messageCount() const {
+    return int(m_messages.size());
+}
+
+const DbcDatabase::Message &DbcDatabase::message(int index) const {
+    return m_messages[std::size_t(index)];
+}
+
+const DbcDatabase::Signal *DbcDatabase::findSignal(const QString &name, int *messageIndex) const {
+    for (std::size_t m = 0; m < m_messages.size(); ++m) {
+        for (const Signal &signal : m_messages[m].canSignals) {
+            if (signal.name == name) {
+                if (messageIndex) {
+                    *messageIndex = int(m);
+                }
+                return &signal;
+            }
+        }
+    }
+    return nullptr;
+}
+
+int DbcDatabase::decode(const CanFrame &frame, double *values) const {
+    const int index = messageIndex(frame.id, frame.extended);
+    if (index < 0) {
+        return -1;
+    }
+
+    const Message &message = m_messages[std::size_t(index)];
+    const PayloadWords payload(frame.data);
+    const qint64 multiplexValue = message.multiplexer >= 0
+        ? rawValue(message.canSignals[std::size_t(message.multiplexer)], payload)
+        : -1;
+
+    const std::size_t count = message.canSignals.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        const Signal &signal = message.canSignals[i];
+        if (signal.multiplexValue >= 0 && signal.multiplexValue != multiplexValue) {
+            continue;
+        }
+        values[i] = physicalValue(signal, payload);
+    }
+    return index;
+}
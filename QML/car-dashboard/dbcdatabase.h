@@ -0,0 +1,110 @@
+#ifndef DBCDATABASE_H
+#define DBCDATABASE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QtEndian>
+#include <vector>
+#include "canlog.h"
+
+// CAN signal database read from a DBC file.
+//
+// Only what decoding needs is kept: messages (BO_), their signals (SG_,
+// including simple multiplexing) and value tables (VAL_). Every signal is
+// compiled on load into a shift, a mask and a sign bit over the frame
+// payload read as one 64-bit word, little-endian for Intel signals and
+// big-endian for Motorola ones, so decoding a signal is two loads, a
+// shift, a mask and a multiply-add without branches on its layout.
+//
+// Messages are found through a direct table for the 2048 standard IDs and
+// a hash for extended ones.
+class DbcDatabase {
+public:
+    struct Signal {
+        QString name;
+        QString unit;
+        int startBit = 0;           // as written in the DBC
+        int length = 0;
+        bool bigEndian = false;     // Motorola byte order (@0)
+        bool isSigned = false;
+        double factor = 1;
+        double offset = 0;
+        double minimum = 0;
+        double maximum = 0;
+        bool multiplexer = false;   // the M signal of its message
+        int multiplexValue = -1;    // mN: only present when the multiplexer is N
+        QHash<qint64, QString> valueNames;
+
+        // Compiled layout
+        quint8 wordIndex = 0;       // 0: little-endian word, 1: big-endian word
+        quint8 shift = 0;
+        quint64 mask = 0;
+        quint64 signBit = 0;        // 0 for unsigned signals
+    };
+
+    struct Message {
+        quint32 id = 0;
+        bool extended = false;
+        QString name;
+        int length = 0;
+        std::vector<Signal> canSignals;
+        int multiplexer = -1;       // index into canSignals
+    };
+
+    // The frame payload read both ways, as every signal of a frame uses one
+    struct PayloadWords {
+        quint64 word[2];
+
+        explicit PayloadWords(const uchar *data)
+        {
+            word[0] = qFromLittleEndian<quint64>(data);
+            word[1] = qFromBigEndian<quint64>(data);
+        }
+    };
+
+    DbcDatabase();
+
+    bool load(const QString &path, QString *errorString = nullptr);
+    bool parse(const QByteArray &text, QString *errorString = nullptr);
+    void clear();
+
+    int messageCount() const;
+    const Message &message(int index) const;
+    // -1 if the database has no such message
+    int messageIndex(quint32 id, bool extended) const
+    {
+        if (!extended) {
+            return m_standardIds[id & 0x7FF];
+        }
+        return m_extendedIds.value(id, -1);
+    }
+
+    // First signal of that name; messageIndex receives its message
+    const Signal *findSignal(const QString &name, int *messageIndex = nullptr) const;
+
+    static qint64 rawValue(const Signal &signal, const PayloadWords &payload)
+    {
+        const quint64 value = (payload.word[signal.wordIndex] >> signal.shift) & signal.mask;
+        return qint64((value ^ signal.signBit) - signal.signBit);
+    }
+
+    static double physicalValue(const Signal &signal, const PayloadWords &payload)
+    {
+        return double(rawValue(signal, payload)) * signal.factor + signal.offset;
+    }
+
+    // Decodes every signal of the frame's message into values, indexed like
+    // Message::canSignals; multiplexed signals that are not present are
+    // left alone. Returns the message index, or -1 for an unknown ID.
+    int decode(const CanFrame &frame, double *values) const;
+
+private:
+    bool compile(Signal &signal, QString *errorString) const;
+
+    std::vector<Message> m_messages;
+    std::vector<qint32> m_standardIds;
+    QHash<quint32, int> m_extendedIds;
+};
+
+#endif // DBCDATABASE_H
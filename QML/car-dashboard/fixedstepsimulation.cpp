@@ -0,0 +1,106 @@
+#include "fixedstepsimulation.h"
+
+FixedStepSimulation::FixedStepSimulation(int rateHz, quint64 seed,
+                                         const VehicleSimulation::ContinuousState &initial, QObject *parent)
+    : QThread(parent),
+    m_rateHz(qBound(1, rateHz, MaxRateHz)),
+    m_seed(seed)
+{
+    m_frame.previous = m_frame.current = initial;
+    m_frame.previousTickNs = m_frame.currentTickNs = telemetryClockNs();
+}
+
+int FixedStepSimulation::rateHz() const {
+    return m_rateHz;
+}
+
+qint64 FixedStepSimulation::stepNs() const {
+    return 1000000000LL / m_rateHz;
+}
+
+FixedStepSimulation::Frame FixedStepSimulation::latestFrame() const {
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    return m_frame;
+}
+
+VehicleSimulation::ContinuousState FixedStepSimulation::interpolate(const Frame &frame, qint64 timeNs) {
+    VehicleSimulation::ContinuousState state = frame.current;
+    const qint64 spanNs = frame.currentTickNs - frame.previousTickNs;
+    if (spanNs <= 0) {
+        return state;
+    }
+
+    const double alpha = qBound(0.0, double(timeNs - frame.previousTickNs) / double(spanNs), 1.0);
+    state.speed = frame.previous.speed + (frame.current.speed - frame.previous.speed) * alpha;
+    state.fuelLevel = frame.previous.fuelLevel + (frame.current.fuelLevel - frame.previous.fuelLevel) * alpha;
+    return state;
+}
+
+quint64 FixedStepSimulation::ticks() const {
+    return m_ticks.load(std::memory_order_relaxed);
+}
+
+quint64 FixedStepSimulation::skippedTicks() const {
+    return m_skippedTicks.load(std::memory_order_relaxed);
+}
+
+qint64 FixedStepSimulation::maxLatenessNs() const {
+    return m_maxLatenessNs.load(std::memory_order_relaxed);
+}
+
+qint64 FixedStepSimulation::meanLatenessNs() const {
+    const quint64 count = ticks();
+    return count ? m_totalLatenessNs.load(std::memory_order_relaxed) / qint64(count) : 0;
+}
+
+void FixedStepSimulation::run() {
+    VehicleSimulation::RandomStream rng(m_seed);
+    const qint64 stepNs = this->stepNs();
+    const double dt = double(stepNs) / 1e9;
+    const qint64 maxBacklogNs = qint64(MaxCatchUpMs) * 1000000;
+
+    Frame frame = latestFrame();
+    frame.previousTickNs = frame.currentTickNs = telemetryClockNs();
+    publish(frame);
+
+    while (!isInterruptionRequested()) {
+        const qint64 nowNs = telemetryClockNs();
+
+        // Drop whatever backlog exceeds the catch-up budget
+        const qint64 backlogNs = nowNs - frame.currentTickNs - stepNs;
+        if (backlogNs > maxBacklogNs) {
+            const qint64 dropped = (backlogNs - maxBacklogNs) / stepNs;
+            frame.currentTickNs += dropped * stepNs;
+            m_skippedTicks.fetch_add(quint64(dropped), std::memory_order_relaxed);
+        }
+
+        bool advanced = false;
+        while (frame.currentTickNs + stepNs <= nowNs) {
+            const qint64 latenessNs = nowNs - (frame.currentTickNs + stepNs);
+            m_totalLatenessNs.fetch_add(latenessNs, std::memory_order_relaxed);
+            if (latenessNs > m_maxLatenessNs.load(std::memory_order_relaxed)) {
+                m_maxLatenessNs.store(latenessNs, std::memory_order_relaxed);
+            }
+
+            frame.previous = frame.current;
+            frame.previousTickNs = frame.currentTickNs;
+            VehicleSimulation::advance(frame.current, dt, rng);
+            frame.currentTickNs += stepNs;
+            m_ticks.fetch_add(1, std::memory_order_relaxed);
+            advanced = true;
+        }
+        if (advanced) {
+            publish(frame);
+        }
+
+        const qint64 waitUs = (frame.currentTickNs + stepNs - telemetryClockNs()) / 1000;
+        if (waitUs > 0) {
+            QThread::usleep(quint64(waitUs));
+        }
+    }
+}
+
+void FixedStepSimulation::publish(const Frame &frame) {
+    std::lock_guard<std::mutex> lock(m_frameMutex);
+    m_frame = frame;
+}
@@ -0,0 +1,69 @@
+#ifndef FIXEDSTEPSIMULATION_H
+#define FIXEDSTEPSIMULATION_H
+
+#include <QThread>
+#include <atomic>
+#include <mutex>
+#include "vehiclesimulation.h"
+
+// Worker thread that advances the vehicle physics at a fixed rate, decoupled
+// from the frame rate.
+//
+// The two most recent ticks are published together so the GUI thread can
+// interpolate between them for whatever time a frame is rendered at. After a
+// stall the loop runs the missed ticks back to back, but never more than
+// MaxCatchUpMs worth: older backlog is dropped and counted, so a slow tick
+// cannot snowball into ever longer catch-up bursts.
+class FixedStepSimulation : public QThread {
+    Q_OBJECT
+
+public:
+    static constexpr int MaxRateHz = 1000;
+    static constexpr int MaxCatchUpMs = 250;
+
+    // Two consecutive ticks, stamped with telemetryClockNs()
+    struct Frame {
+        VehicleSimulation::ContinuousState previous;
+        VehicleSimulation::ContinuousState current;
+        qint64 previousTickNs = 0;
+        qint64 currentTickNs = 0;
+    };
+
+    FixedStepSimulation(int rateHz, quint64 seed, const VehicleSimulation::ContinuousState &initial,
+                        QObject *parent = nullptr);
+
+    int rateHz() const;
+    qint64 stepNs() const;
+
+    // Safe to call from any thread
+    Frame latestFrame() const;
+
+    // Linear interpolation of the published ticks at timeNs. Discrete
+    // signals (gear, warnings) are taken from the newer tick.
+    static VehicleSimulation::ContinuousState interpolate(const Frame &frame, qint64 timeNs);
+
+    quint64 ticks() const;
+    quint64 skippedTicks() const;
+    // How late a tick ran compared to its scheduled time
+    qint64 maxLatenessNs() const;
+    qint64 meanLatenessNs() const;
+
+protected:
+    void run() override;
+
+private:
+    void publish(const Frame &frame);
+
+    const int m_rateHz;
+    const quint64 m_seed;
+
+    mutable std::mutex m_frameMutex;
+    Frame m_frame;
+
+    std::atomic<quint64> m_ticks{0};
+    std::atomic<quint64> m_skippedTicks{0};
+    std::atomic<qint64> m_maxLatenessNs{0};
+    std::atomic<qint64> m_totalLatenessNs{0};
+};
+
+#endif // FIXEDSTEPSIMULATION_H
@@ -0,0 +1,145 @@
+#include "fleetmodel.h"
+#include "vehiclesimulation.h"
+#include <QRandomGenerator>
+
+FleetModel::FleetModel(QObject *parent)
+    : QAbstractListModel(parent),
+    m_appliedTick(0),
+    m_maxMergeGap(16),
+    m_updatedRows(0),
+    m_emittedRanges(0)
+{
+}
+
+int FleetModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_store.size();
+}
+
+QVariant FleetModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_store.size()) {
+        return QVariant();
+    }
+
+    const int row = index.row();
+    switch (role) {
+    case VehicleIdRole:
+        return row;
+    case SpeedRole:
+        return int(m_store.speed(row));
+    case FuelLevelRole:
+        return int(m_store.fuelLevel(row));
+    case GearRole:
+        return QString(QLatin1Char(m_store.gear(row)));
+    case EngineWarningRole:
+        return (m_store.warningFlags(row) & FleetTelemetryStore::EngineWarning) != 0;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> FleetModel::roleNames() const {
+    return {
+        { VehicleIdRole, "vehicleId" },
+        { SpeedRole, "speed" },
+        { FuelLevelRole, "fuelLevel" },
+        { GearRole, "gear" },
+        { EngineWarningRole, "engineWarning" }
+    };
+}
+
+int FleetModel::vehicleCount() const {
+    return m_store.size();
+}
+
+void FleetModel::setVehicleCount(int count) {
+    count = qMax(0, count);
+    if (count == m_store.size()) {
+        return;
+    }
+
+    beginResetModel();
+    m_store.resize(count);
+    endResetModel();
+    emit vehicleCountChanged();
+}
+
+FleetSimulationEngine *FleetModel::engine() const {
+    return m_engine;
+}
+
+void FleetModel::setEngine(FleetSimulationEngine *engine) {
+    if (m_engine != engine) {
+        m_engine = engine;
+        m_appliedTick = 0;
+        emit engineChanged();
+    }
+}
+
+int FleetModel::maxMergeGap() const {
+    return m_maxMergeGap;
+}
+
+void FleetModel::setMaxMergeGap(int gap) {
+    gap = qMax(0, gap);
+    if (m_maxMergeGap != gap) {
+        m_maxMergeGap = gap;
+        emit maxMergeGapChanged();
+    }
+}
+
+qint64 FleetModel::updatedRows() const {
+    return m_updatedRows;
+}
+
+qint64 FleetModel::emittedRanges() const {
+    return m_emittedRanges;
+}
+
+const FleetTelemetryStore &FleetModel::store() const {
+    return m_store;
+}
+
+void FleetModel::updateVehicle(int row, const TelemetrySample &sample) {
+    if (row >= 0 && row < m_store.size()) {
+        m_store.setSample(row, sample);
+    }
+}
+
+void FleetModel::flushChanges() {
+    applyEngineSnapshot();
+    if (!m_store.hasChanges()) {
+        return;
+    }
+
+    static const QList<int> roles = { SpeedRole, FuelLevelRole, GearRole, EngineWarningRole };
+    m_store.takeChangedRanges(m_maxMergeGap, [this](int first, int last) {
+        m_updatedRows += last - first + 1;
+        ++m_emittedRanges;
+        emit dataChanged(index(first), index(last), roles);
+    });
+    emit statsChanged();
+}
+
+void FleetModel::simulateTick() {
+    QRandomGenerator *rng = QRandomGenerator::global();
+    for (int row = 0; row < m_store.size(); ++row) {
+        m_store.setSample(row, VehicleSimulation::step(m_store.sample(row), *rng));
+    }
+}
+
+void FleetModel::applyEngineSnapshot() {
+    if (!m_engine) {
+        return;
+    }
+
+    const std::shared_ptr<const FleetSnapshot> snapshot = m_engine->latestSnapshot();
+    if (!snapshot || snapshot->tick == m_appliedTick) {
+        return;
+    }
+
+    m_appliedTick = snapshot->tick;
+    const int rows = qMin(m_store.size(), int(snapshot->vehicles.size()));
+    for (int row = 0; row < rows; ++row) {
+        m_store.setSample(row, snapshot->vehicles[std::size_t(row)]);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef FLEETMODEL_H
+#define FLEETMODEL_H
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QtQml/qqmlregistration.h>
+#include "fleetsimulationengine.h"
+#include "fleettelemetrystore.h"
+
+// List model over a FleetTelemetryStore, one row per vehicle.
+//
+// Updates are written to the store without notifying views; flushChanges()
+// (called once per frame) then emits one dataChanged per merged range of
+// changed rows. With an engine set, flushChanges() first copies in the
+// engine's latest snapshot if it has not been applied yet.
+class FleetModel : public QAbstractListModel {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(int vehicleCount READ vehicleCount WRITE setVehicleCount NOTIFY vehicleCountChanged)
+    Q_PROPERTY(FleetSimulationEngine *engine READ engine WRITE setEngine NOTIFY engineChanged)
+    Q_PROPERTY(int maxMergeGap READ maxMergeGap WRITE setMaxMergeGap NOTIFY maxMergeGapChanged)
+    Q_PROPERTY(qint64 updatedRows READ updatedRows NOTIFY statsChanged)
+    Q_PROPERTY(qint64 emittedRanges READ emittedRanges NOTIFY statsChanged)
+
+public:
+    enum Roles {
+        VehicleIdRole = Qt::UserRole + 1,
+        SpeedRole,
+        FuelLevelRole,
+        GearRole,
+        EngineWarningRole
+    };
+    Q_ENUM(Roles)
+
+    explicit FleetModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int vehicleCount() const;
+    void setVehicleCount(int count);
+
+    FleetSimulationEngine *engine() const;
+    void setEngine(FleetSimulationEngine *engine);
+
+    int maxMergeGap() const;
+    void setMaxMergeGap(int gap);
+
+    qint64 updatedRows() const;
+    qint64 emittedRanges() const;
+
+    const FleetTelemetryStore &store() const;
+
+    // Records a new sample for one vehicle; views see it on flushChanges().
+    void updateVehicle(int row, const TelemetrySample &sample);
+
+    // Emits dataChanged for everything updated since the last flush.
+    Q_INVOKABLE void flushChanges();
+
+    // Advances every vehicle by one step of the driving rules.
+    Q_INVOKABLE void simulateTick();
+
+signals:
+    void vehicleCountChanged();
+    void engineChanged();
+    void maxMergeGapChanged();
+    void statsChanged();
+
+private:
+    void applyEngineSnapshot();
+
+    FleetTelemetryStore m_store;
+    QPointer<FleetSimulationEngine> m_engine;
+    quint64 m_appliedTick;
+    int m_maxMergeGap;
+    qint64 m_updatedRows;
+    qint64 m_emittedRanges;
+};
+
+#endif // FLEETMODEL_H
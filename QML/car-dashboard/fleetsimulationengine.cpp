@@ -0,0 +1,239 @@
+#include "fleetsimulationengine.h"
+#include <QThread>
+#include <atomic>
+#include <chrono>
+
+namespace {
+// Vehicles per scheduled chunk: large enough to amortize the deque locking,
+// small enough to leave plenty of chunks to steal
+constexpr int ChunkSize = 1024;
+}
+
+FleetSimulationEngine::FleetSimulationEngine(QObject *parent)
+    : QObject(parent),
+    m_vehicleCount(0),
+    m_threadCount(0),
+    m_tickRateHz(10),
+    m_seed(0x5EED),
+    m_driver(nullptr),
+    m_stopRequested(false)
+{
+    reset(m_seed);
+}
+
+FleetSimulationEngine::~FleetSimulationEngine() {
+    stop();
+}
+
+int FleetSimulationEngine::vehicleCount() const {
+    return m_vehicleCount;
+}
+
+void FleetSimulationEngine::setVehicleCount(int count) {
+    count = qMax(0, count);
+    if (m_vehicleCount == count) {
+        return;
+    }
+
+    const bool wasRunning = isRunning();
+    stop();
+    m_vehicleCount = count;
+    reset(m_seed);
+    if (wasRunning) {
+        start();
+    }
+    emit vehicleCountChanged();
+}
+
+int FleetSimulationEngine::threadCount() const {
+    return m_threadCount;
+}
+
+void FleetSimulationEngine::setThreadCount(int count) {
+    count = qMax(0, count);
+    if (m_threadCount == count) {
+        return;
+    }
+
+    const bool wasRunning = isRunning();
+    stop();
+    m_threadCount = count;
+    m_pool.reset();
+    if (wasRunning) {
+        start();
+    }
+    emit threadCountChanged();
+}
+
+int FleetSimulationEngine::tickRateHz() const {
+    return m_tickRateHz;
+}
+
+void FleetSimulationEngine::setTickRateHz(int rateHz) {
+    rateHz = qMax(0, rateHz);
+    if (m_tickRateHz == rateHz) {
+        return;
+    }
+
+    const bool wasRunning = isRunning();
+    stop();
+    m_tickRateHz = rateHz;
+    if (wasRunning) {
+        start();
+    }
+    emit tickRateHzChanged();
+}
+
+bool FleetSimulationEngine::isRunning() const {
+    return m_driver != nullptr;
+}
+
+void FleetSimulationEngine::setRunning(bool running) {
+    if (running == isRunning()) {
+        return;
+    }
+
+    if (running) {
+        start();
+    } else {
+        stop();
+    }
+    emit runningChanged();
+}
+
+void FleetSimulationEngine::reset(quint64 seed) {
+    Q_ASSERT(!isRunning());
+    m_seed = seed;
+
+    // Derive the per-vehicle seeds from one stream so neighbouring vehicles
+    // do not start at neighbouring points of the same sequence
+    VehicleSimulation::RandomStream seeder(seed);
+    m_streams.clear();
+    m_streams.reserve(std::size_t(m_vehicleCount));
+    for (int i = 0; i < m_vehicleCount; ++i) {
+        m_streams.emplace_back(seeder.next());
+    }
+
+    auto initial = std::make_shared<FleetSnapshot>();
+    initial->timestampNs = telemetryClockNs();
+    initial->vehicles.resize(std::size_t(m_vehicleCount));
+    m_spare.reset();
+    m_completedTicks.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_latestMutex);
+    m_latest = std::move(initial);
+}
+
+void FleetSimulationEngine::tick() {
+    ensurePool();
+
+    const std::shared_ptr<const FleetSnapshot> previous = latestSnapshot();
+    const std::shared_ptr<FleetSnapshot> next = takeSpareSnapshot();
+    next->vehicles.resize(previous->vehicles.size());
+
+    // Each vehicle is read, stepped and written by exactly one worker
+    const TelemetrySample *in = previous->vehicles.data();
+    TelemetrySample *out = next->vehicles.data();
+    VehicleSimulation::RandomStream *streams = m_streams.data();
+    m_pool->parallelFor(int(previous->vehicles.size()), ChunkSize, [in, out, streams](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            out[i] = VehicleSimulation::step(in[i], streams[i]);
+        }
+    });
+
+    next->tick = previous->tick + 1;
+    next->timestampNs = telemetryClockNs();
+    {
+        std::lock_guard<std::mutex> lock(m_latestMutex);
+        m_latest = next;
+    }
+    m_completedTicks.fetch_add(1, std::memory_order_relaxed);
+
+    // Once unpublished, nobody can pick up the previous snapshot any more.
+    // If no reader still holds it, its buffer becomes the next tick's target.
+    // use_count() is a relaxed load, so the fence orders the writes of the
+    // next tick after the last reads of the reader that let go of it.
+    if (previous.use_count() == 1) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        m_spare = std::const_pointer_cast<FleetSnapshot>(previous);
+    }
+}
+
+std::shared_ptr<const FleetSnapshot> FleetSimulationEngine::latestSnapshot() const {
+    std::lock_guard<std::mutex> lock(m_latestMutex);
+    return m_latest;
+}
+
+quint64 FleetSimulationEngine::completedTicks() const {
+    return m_completedTicks.load(std::memory_order_relaxed);
+}
+
+quint64 FleetSimulationEngine::stolenChunks() const {
+    return m_pool ? m_pool->stolenChunks() : 0;
+}
+
+void FleetSimulationEngine::start() {
+    if (m_driver) {
+        return;
+    }
+
+    ensurePool();
+    m_stopRequested = false;
+    m_driver = QThread::create([this] { runLoop(); });
+    m_driver->setObjectName("FleetSimulationEngine");
+    m_driver->start();
+}
+
+void FleetSimulationEngine::stop() {
+    if (!m_driver) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_driverMutex);
+        m_stopRequested = true;
+    }
+    m_driverWake.notify_all();
+    m_driver->wait();
+    delete m_driver;
+    m_driver = nullptr;
+}
+
+void FleetSimulationEngine::runLoop() {
+    using Clock = std::chrono::steady_clock;
+    const auto interval = m_tickRateHz > 0
+        ? std::chrono::nanoseconds(1000000000LL / m_tickRateHz)
+        : std::chrono::nanoseconds::zero();
+    auto deadline = Clock::now();
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_driverMutex);
+            if (interval.count() > 0) {
+                m_driverWake.wait_until(lock, deadline, [this] { return m_stopRequested; });
+            }
+            if (m_stopRequested) {
+                return;
+            }
+        }
+
+        tick();
+
+        // A tick that overran its slot starts the next one right away rather
+        // than queueing up a burst of catch-up ticks
+        deadline = qMax(deadline + interval, Clock::now());
+    }
+}
+
+void FleetSimulationEngine::ensurePool() {
+    if (!m_pool) {
+        m_pool = std::make_unique<WorkStealingPool>(m_threadCount);
+    }
+}
+
+std::shared_ptr<FleetSnapshot> FleetSimulationEngine::takeSpareSnapshot() {
+    if (m_spare) {
+        return std::move(m_spare);
+    }
+    return std::make_shared<FleetSnapshot>();
+}
@@ -0,0 +1,103 @@
+#ifndef FLEETSIMULATIONENGINE_H
+#define FLEETSIMULATIONENGINE_H
+
+#include <QObject>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "telemetrysample.h"
+#include "vehiclesimulation.h"
+#include "workstealingpool.h"
+
+class QThread;
+
+// State of every vehicle after one simulation tick. Never modified once
+// published, so readers can hold on to it for as long as they like.
+struct FleetSnapshot {
+    quint64 tick = 0;
+    qint64 timestampNs = 0;
+    std::vector<TelemetrySample> vehicles;
+};
+
+// Simulates a whole fleet with the VehicleSimulation driving rules, spreading
+// each tick across a WorkStealingPool.
+//
+// Every vehicle has its own random stream, so a tick's result does not
+// depend on how the vehicles were split between threads. Completed ticks are
+// published as a FleetSnapshot; consumers poll latestSnapshot() (FleetModel
+// does so once per frame) instead of receiving a signal per tick.
+class FleetSimulationEngine : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(int vehicleCount READ vehicleCount WRITE setVehicleCount NOTIFY vehicleCountChanged)
+    Q_PROPERTY(int threadCount READ threadCount WRITE setThreadCount NOTIFY threadCountChanged)
+    Q_PROPERTY(int tickRateHz READ tickRateHz WRITE setTickRateHz NOTIFY tickRateHzChanged)
+    Q_PROPERTY(bool running READ isRunning WRITE setRunning NOTIFY runningChanged)
+
+public:
+    explicit FleetSimulationEngine(QObject *parent = nullptr);
+    ~FleetSimulationEngine() override;
+
+    int vehicleCount() const;
+    void setVehicleCount(int count);
+
+    // 0 uses one worker per hardware thread
+    int threadCount() const;
+    void setThreadCount(int count);
+
+    // 0 runs ticks back to back
+    int tickRateHz() const;
+    void setTickRateHz(int rateHz);
+
+    bool isRunning() const;
+    void setRunning(bool running);
+
+    // Restarts every vehicle from a parked state with streams derived from seed
+    void reset(quint64 seed);
+
+    // Advances the fleet by one tick on the calling thread's behalf.
+    // Only for use while the engine is not running (benchmarks, tests).
+    void tick();
+
+    // Safe to call from any thread
+    std::shared_ptr<const FleetSnapshot> latestSnapshot() const;
+
+    quint64 completedTicks() const;
+    quint64 stolenChunks() const;
+
+signals:
+    void vehicleCountChanged();
+    void threadCountChanged();
+    void tickRateHzChanged();
+    void runningChanged();
+
+private:
+    void start();
+    void stop();
+    void runLoop();
+    void ensurePool();
+    std::shared_ptr<FleetSnapshot> takeSpareSnapshot();
+
+    int m_vehicleCount;
+    int m_threadCount;
+    int m_tickRateHz;
+    quint64 m_seed;
+
+    std::unique_ptr<WorkStealingPool> m_pool;
+    std::vector<VehicleSimulation::RandomStream> m_streams;
+    std::shared_ptr<FleetSnapshot> m_spare;
+
+    mutable std::mutex m_latestMutex;
+    std::shared_ptr<const FleetSnapshot> m_latest;
+
+    QThread *m_driver;
+    std::mutex m_driverMutex;
+    std::condition_variable m_driverWake;
+    bool m_stopRequested;
+    std::atomic<quint64> m_completedTicks{0};
+};
+
+#endif // FLEETSIMULATIONENGINE_H
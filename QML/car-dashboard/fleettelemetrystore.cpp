@@ -0,0 +1,45 @@
+#include "fleettelemetrystore.h"
+
+void FleetTelemetryStore::resize(int vehicleCount) {
+    const std::size_t count = std::size_t(qMax(0, vehicleCount));
+    const TelemetrySample initial;
+
+    m_speed.assign(count, initial.speed);
+    m_fuelLevel.assign(count, initial.fuelLevel);
+    m_gear.assign(count, initial.gear);
+    m_warningFlags.assign(count, 0);
+    m_changed.assign((count + 63) / 64, 0);
+    m_hasChanges = false;
+}
+
+int FleetTelemetryStore::size() const {
+    return int(m_speed.size());
+}
+
+TelemetrySample FleetTelemetryStore::sample(int row) const {
+    TelemetrySample sample;
+    sample.speed = m_speed[row];
+    sample.fuelLevel = m_fuelLevel[row];
+    sample.gear = m_gear[row];
+    sample.engineWarning = (m_warningFlags[row] & EngineWarning) != 0;
+    return sample;
+}
+
+void FleetTelemetryStore::setSample(int row, const TelemetrySample &sample) {
+    const quint8 flags = sample.engineWarning ? EngineWarning : 0;
+    if (m_speed[row] == sample.speed && m_fuelLevel[row] == sample.fuelLevel
+        && m_gear[row] == sample.gear && m_warningFlags[row] == flags) {
+        return;
+    }
+
+    m_speed[row] = sample.speed;
+    m_fuelLevel[row] = sample.fuelLevel;
+    m_gear[row] = sample.gear;
+    m_warningFlags[row] = flags;
+    m_changed[std::size_t(row) / 64] |= quint64(1) << (row % 64);
+    m_hasChanges = true;
+}
+
+bool FleetTelemetryStore::hasChanges() const {
+    return m_hasChanges;
+}
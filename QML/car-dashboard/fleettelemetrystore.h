@@ -0,0 +1,89 @@
+#ifndef FLEETTELEMETRYSTORE_H
+#define FLEETTELEMETRYSTORE_H
+
+#include <QtGlobal>
+#include <vector>
+#include "telemetrysample.h"
+
+// Telemetry of many vehicles in struct-of-arrays form: one contiguous array
+// per signal, indexed by vehicle row. A pass over one signal (e.g. all
+// speeds) touches only that signal's memory, and a 10k-vehicle fleet fits in
+// about 50 KB.
+//
+// Changed rows are tracked in a bitmap so they can be reported as a few
+// merged ranges instead of one notification per vehicle.
+class FleetTelemetryStore {
+public:
+    enum WarningFlag : quint8 {
+        EngineWarning = 0x1
+    };
+
+    void resize(int vehicleCount);
+    int size() const;
+
+    qint16 speed(int row) const { return m_speed[row]; }
+    qint8 fuelLevel(int row) const { return m_fuelLevel[row]; }
+    char gear(int row) const { return m_gear[row]; }
+    quint8 warningFlags(int row) const { return m_warningFlags[row]; }
+
+    const qint16 *speedData() const { return m_speed.data(); }
+    const qint8 *fuelLevelData() const { return m_fuelLevel.data(); }
+    const char *gearData() const { return m_gear.data(); }
+    const quint8 *warningFlagsData() const { return m_warningFlags.data(); }
+
+    TelemetrySample sample(int row) const;
+
+    // Stores the sample and marks the row changed if any field differs.
+    void setSample(int row, const TelemetrySample &sample);
+
+    bool hasChanges() const;
+
+    // Calls fn(firstRow, lastRow) for each run of changed rows and clears
+    // the change set. Runs separated by at most maxGap unchanged rows are
+    // merged into one.
+    template <typename Fn>
+    void takeChangedRanges(int maxGap, Fn &&fn);
+
+private:
+    std::vector<qint16> m_speed;
+    std::vector<qint8> m_fuelLevel;
+    std::vector<char> m_gear;
+    std::vector<quint8> m_warningFlags;
+
+    std::vector<quint64> m_changed;     // one bit per row
+    bool m_hasChanges = false;
+};
+
+template <typename Fn>
+void FleetTelemetryStore::takeChangedRanges(int maxGap, Fn &&fn)
+{
+    if (!m_hasChanges) {
+        return;
+    }
+
+    int first = -1;
+    int last = -1;
+    for (std::size_t word = 0; word < m_changed.size(); ++word) {
+        quint64 bits = m_changed[word];
+        m_changed[word] = 0;
+        while (bits) {
+            const int row = int(word * 64) + qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+
+            if (first < 0) {
+                first = last = row;
+            } else if (row - last - 1 <= maxGap) {
+                last = row;
+            } else {
+                fn(first, last);
+                first = last = row;
+            }
+        }
+    }
+    if (first >= 0) {
+        fn(first, last);
+    }
+    m_hasChanges = false;
+}
+
+#endif // FLEETTELEMETRYSTORE_H
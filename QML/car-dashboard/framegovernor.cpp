@@ -0,0 +1,109 @@
+#include "framegovernor.h"
+
+namespace {
+// Weight of the newest frame in the smoothed frame time
+constexpr qreal Smoothing = 0.1;
+// Give a quality change this long to show its effect before the next one
+constexpr qint64 SettleMs = 500;
+// Frames must stay under Headroom * budget this long before stepping up
+constexpr qreal Headroom = 0.6;
+constexpr qint64 RecoveryMs = 3000;
+}
+
+FrameGovernor::FrameGovernor(QObject *parent)
+    : QObject(parent),
+    m_budgetMs(12.0),   // leaves a margin inside a 60 Hz frame
+    m_quality(Full),
+    m_frameTimeMs(0),
+    m_frameStartNs(-1),
+    m_lastFrameCostNs(-1)
+{
+    m_clock.start();
+    m_sinceLastChange.start();
+    m_sinceOverBudget.start();
+}
+
+QQuickWindow *FrameGovernor::window() const {
+    return m_window;
+}
+
+void FrameGovernor::setWindow(QQuickWindow *window) {
+    if (m_window == window) {
+        return;
+    }
+
+    if (m_window) {
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = window;
+    if (m_window) {
+        connect(m_window, &QQuickWindow::afterAnimating,
+                this, &FrameGovernor::onAfterAnimating, Qt::DirectConnection);
+        // Emitted on the render thread with the threaded render loop
+        connect(m_window, &QQuickWindow::afterRendering,
+                this, &FrameGovernor::onAfterRendering, Qt::DirectConnection);
+    }
+    emit windowChanged();
+}
+
+qreal FrameGovernor::budgetMs() const {
+    return m_budgetMs;
+}
+
+void FrameGovernor::setBudgetMs(qreal budgetMs) {
+    if (!qFuzzyCompare(m_budgetMs, budgetMs)) {
+        m_budgetMs = budgetMs;
+        emit budgetMsChanged();
+    }
+}
+
+FrameGovernor::Quality FrameGovernor::quality() const {
+    return m_quality;
+}
+
+qreal FrameGovernor::frameTimeMs() const {
+    return m_frameTimeMs;
+}
+
+void FrameGovernor::onAfterAnimating() {
+    // Evaluate the frame that finished rendering since the last call
+    const qint64 costNs = m_lastFrameCostNs.exchange(-1, std::memory_order_acq_rel);
+    m_frameStartNs.store(m_clock.nsecsElapsed(), std::memory_order_release);
+    if (costNs < 0) {
+        return;
+    }
+
+    const qreal costMs = costNs / 1e6;
+    m_frameTimeMs = m_frameTimeMs <= 0 ? costMs : m_frameTimeMs + Smoothing * (costMs - m_frameTimeMs);
+    emit frameTimeMsChanged();
+
+    if (costMs > m_budgetMs * Headroom) {
+        m_sinceOverBudget.restart();
+    }
+
+    if (m_sinceLastChange.elapsed() < SettleMs) {
+        return;
+    }
+
+    if (m_frameTimeMs > m_budgetMs && m_quality > Minimal) {
+        setQuality(Quality(m_quality - 1));
+    } else if (m_quality < Full && m_sinceOverBudget.elapsed() >= RecoveryMs) {
+        setQuality(Quality(m_quality + 1));
+    }
+}
+
+void FrameGovernor::onAfterRendering() {
+    const qint64 startNs = m_frameStartNs.load(std::memory_order_acquire);
+    if (startNs >= 0) {
+        m_lastFrameCostNs.store(m_clock.nsecsElapsed() - startNs, std::memory_order_release);
+    }
+}
+
+void FrameGovernor::setQuality(Quality quality) {
+    if (m_quality != quality) {
+        m_quality = quality;
+        m_sinceLastChange.restart();
+        m_sinceOverBudget.restart();
+        emit qualityChanged();
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef FRAMEGOVERNOR_H
+#define FRAMEGOVERNOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QQuickWindow>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+
+// Watches how long each frame of a window takes to prepare and render and
+// lowers the quality of purely decorative content when frames exceed the
+// budget, then raises it again once there is sustained headroom.
+//
+// QML binds its decorative layers to `quality`; the gauges never do, so they
+// keep their frame rate at the expense of the eye candy.
+class FrameGovernor : public QObject {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(QQuickWindow *window READ window WRITE setWindow NOTIFY windowChanged)
+    Q_PROPERTY(qreal budgetMs READ budgetMs WRITE setBudgetMs NOTIFY budgetMsChanged)
+    Q_PROPERTY(Quality quality READ quality NOTIFY qualityChanged)
+    Q_PROPERTY(qreal frameTimeMs READ frameTimeMs NOTIFY frameTimeMsChanged)
+
+public:
+    enum Quality {
+        Minimal,    // decorations off
+        Reduced,    // decorations frozen or thinned out
+        Full
+    };
+    Q_ENUM(Quality)
+
+    explicit FrameGovernor(QObject *parent = nullptr);
+
+    QQuickWindow *window() const;
+    void setWindow(QQuickWindow *window);
+
+    qreal budgetMs() const;
+    void setBudgetMs(qreal budgetMs);
+
+    Quality quality() const;
+
+    // Smoothed cost of recent frames
+    qreal frameTimeMs() const;
+
+signals:
+    void windowChanged();
+    void budgetMsChanged();
+    void qualityChanged();
+    void frameTimeMsChanged();
+
+private:
+    void onAfterAnimating();
+    void onAfterRendering();
+    void setQuality(Quality quality);
+
+    QPointer<QQuickWindow> m_window;
+    qreal m_budgetMs;
+    Quality m_quality;
+    qreal m_frameTimeMs;
+
+    // Shared between the GUI thread (afterAnimating) and the render thread
+    // (afterRendering); the clock itself is monotonic and thread-safe to read.
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_frameStartNs;
+    std::atomic<qint64> m_lastFrameCostNs;
+
+    // GUI thread only
+    QElapsedTimer m_sinceLastChange;
+    QElapsedTimer m_sinceOverBudget;
+};
+
+#endif // FRAMEGOVERNOR_H
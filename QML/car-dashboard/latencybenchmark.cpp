@@ -0,0 +1,167 @@
+#include "latencybenchmark.h"
+#include "dashboardmanager.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQuickWindow>
+#include <QTimer>
+
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif
+
+namespace {
+// Let queues and caches settle before measuring each rate
+constexpr int WarmUpMs = 500;
+
+// CPU time consumed by the calling thread, -1 when unsupported
+qint64 threadCpuTimeNs() {
+#ifdef Q_OS_UNIX
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+        return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+#endif
+    return -1;
+}
+
+QJsonObject histogramToJson(const LatencyHistogram &histogram) {
+    QJsonObject stats;
+    stats["count"] = qint64(histogram.count());
+    stats["meanUs"] = histogram.meanUs();
+    stats["p50Us"] = qint64(histogram.percentileUs(50));
+    stats["p99Us"] = qint64(histogram.percentileUs(99));
+    stats["maxUs"] = qint64(histogram.maxUs());
+    return stats;
+}
+}
+
+LatencyBenchmark::LatencyBenchmark(DashboardManager *manager, QQuickWindow *window,
+                                   const QList<int> &ratesHz, int durationMs, QObject *parent)
+    : QObject(parent),
+    m_manager(manager),
+    m_window(window),
+    m_ratesHz(ratesHz),
+    m_durationMs(durationMs),
+    m_runIndex(0),
+    m_measuring(false),
+    m_pendingSampleNs(-1),
+    m_lastAppliedSampleNs(0),
+    m_lastSwapNs(-1),
+    m_guiCpuStartNs(0),
+    m_droppedAtStart(0),
+    m_receivedAtStart(0)
+{
+    // Connected after DashboardManager::attachToWindow(), so the manager has
+    // already applied this frame's sample when onAfterAnimating runs.
+    connect(m_window, &QQuickWindow::afterAnimating,
+            this, &LatencyBenchmark::onAfterAnimating, Qt::DirectConnection);
+    connect(m_window, &QQuickWindow::frameSwapped,
+            this, &LatencyBenchmark::onFrameSwapped, Qt::DirectConnection);
+}
+
+void LatencyBenchmark::start() {
+    m_runIndex = 0;
+    m_results = QJsonArray();
+    startRun();
+}
+
+QJsonArray LatencyBenchmark::results() const {
+    return m_results;
+}
+
+bool LatencyBenchmark::writeReport(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Cannot write %s: %s", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+    file.write(QJsonDocument(m_results).toJson());
+    return true;
+}
+
+void LatencyBenchmark::startRun() {
+    if (m_runIndex >= m_ratesHz.size() || !m_manager || !m_window) {
+        emit finished();
+        return;
+    }
+
+    m_manager->startTelemetryFeed(m_ratesHz.at(m_runIndex));
+    QTimer::singleShot(WarmUpMs, this, &LatencyBenchmark::beginMeasuring);
+}
+
+void LatencyBenchmark::beginMeasuring() {
+    m_latency.reset();
+    m_frameInterval.reset();
+    m_lastAppliedSampleNs = m_manager->lastSampleTimestampNs();
+    m_droppedAtStart = m_manager->droppedSamples();
+    m_receivedAtStart = m_manager->receivedSamples();
+    m_guiCpuStartNs = threadCpuTimeNs();
+    m_wallClock.start();
+    m_measuring = true;
+
+    QTimer::singleShot(m_durationMs, this, &LatencyBenchmark::finishRun);
+}
+
+void LatencyBenchmark::finishRun() {
+    m_measuring = false;
+    const qint64 wallNs = m_wallClock.nsecsElapsed();
+    const qint64 cpuEndNs = threadCpuTimeNs();
+    m_manager->stopTelemetryFeed();
+
+    const int rateHz = m_ratesHz.at(m_runIndex);
+    const double guiCpuMs = m_guiCpuStartNs >= 0 ? (cpuEndNs - m_guiCpuStartNs) / 1e6 : -1;
+
+    QJsonObject result;
+    result["rateHz"] = rateHz;
+    result["durationMs"] = wallNs / 1000000;
+    result["samplesReceived"] = m_manager->receivedSamples() - m_receivedAtStart;
+    result["samplesDropped"] = m_manager->droppedSamples() - m_droppedAtStart;
+    result["sampleToPixel"] = histogramToJson(m_latency);
+    result["frameInterval"] = histogramToJson(m_frameInterval);
+    result["guiThreadCpuMs"] = guiCpuMs;
+    result["guiThreadCpuPercent"] = guiCpuMs >= 0 ? 100.0 * guiCpuMs * 1e6 / wallNs : -1;
+    m_results.append(result);
+
+    qInfo("%7d Hz | latency p50 %6llu us p99 %6llu us max %6llu us | frame p50 %6llu us p99 %6llu us"
+          " | GUI CPU %5.1f%% | dropped %lld",
+          rateHz,
+          m_latency.percentileUs(50), m_latency.percentileUs(99), m_latency.maxUs(),
+          m_frameInterval.percentileUs(50), m_frameInterval.percentileUs(99),
+          result["guiThreadCpuPercent"].toDouble(),
+          result["samplesDropped"].toInteger());
+
+    ++m_runIndex;
+    startRun();
+}
+
+void LatencyBenchmark::onAfterAnimating() {
+    if (!m_measuring || !m_manager) {
+        return;
+    }
+
+    // Only frames that show a new sample contribute a latency measurement
+    const qint64 sampleNs = m_manager->lastSampleTimestampNs();
+    if (sampleNs != m_lastAppliedSampleNs) {
+        m_lastAppliedSampleNs = sampleNs;
+        m_pendingSampleNs.store(sampleNs, std::memory_order_release);
+    }
+}
+
+void LatencyBenchmark::onFrameSwapped() {
+    if (!m_measuring) {
+        m_lastSwapNs = -1;
+        return;
+    }
+
+    const qint64 nowNs = telemetryClockNs();
+    if (m_lastSwapNs >= 0) {
+        m_frameInterval.record(quint64(nowNs - m_lastSwapNs) / 1000);
+    }
+    m_lastSwapNs = nowNs;
+
+    const qint64 sampleNs = m_pendingSampleNs.exchange(-1, std::memory_order_acq_rel);
+    if (sampleNs >= 0 && nowNs > sampleNs) {
+        m_latency.record(quint64(nowNs - sampleNs) / 1000);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef LATENCYBENCHMARK_H
+#define LATENCYBENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include "latencyhistogram.h"
+
+class DashboardManager;
+class QQuickWindow;
+
+// Drives DashboardManager with the background telemetry feed at a series of
+// rates and measures, for each rate:
+//   - sample-to-pixel latency: capture time of the newest sample applied in
+//     a frame until that frame has been swapped
+//   - the interval between swapped frames
+//   - CPU time spent on the GUI thread
+//
+// Used by the --latency-benchmark option of appcar-dashboard, normally run
+// headless through the dashboard-latency-benchmark target.
+class LatencyBenchmark : public QObject {
+    Q_OBJECT
+
+public:
+    LatencyBenchmark(DashboardManager *manager, QQuickWindow *window,
+                     const QList<int> &ratesHz, int durationMs, QObject *parent = nullptr);
+
+    void start();
+
+    QJsonArray results() const;
+    bool writeReport(const QString &path) const;
+
+signals:
+    void finished();
+
+private:
+    void startRun();
+    void beginMeasuring();
+    void finishRun();
+    void onAfterAnimating();
+    void onFrameSwapped();
+
+    QPointer<DashboardManager> m_manager;
+    QPointer<QQuickWindow> m_window;
+    const QList<int> m_ratesHz;
+    const int m_durationMs;
+    qsizetype m_runIndex;
+
+    // Written on the GUI thread, read on the render thread
+    std::atomic<bool> m_measuring;
+    std::atomic<qint64> m_pendingSampleNs;
+    qint64 m_lastAppliedSampleNs;
+
+    // Render thread only
+    qint64 m_lastSwapNs;
+
+    LatencyHistogram m_latency;
+    LatencyHistogram m_frameInterval;
+    qint64 m_guiCpuStartNs;
+    QElapsedTimer m_wallClock;
+    qint64 m_droppedAtStart;
+    qint64 m_receivedAtStart;
+    QJsonArray m_results;
+};
+
+#endif // LATENCYBENCHMARK_H
@@ -1,36 +1,228 @@
 #include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QQmlApplicationEngine>
-#include <QQmlContext>
+#include <QQuickWindow>
 #include "dashboardmanager.h"
+#include "frameprofiler.h"
+#include "latencybenchmark.h"
+#include "sharedtelemetry.h"
+
+#ifdef Q_OS_LINUX
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Milliseconds since the process was created, including dynamic linking and
+// static initialization before main(); -1 where this is not available.
+static qint64 msSinceProcessStart()
+{
+#ifdef Q_OS_LINUX
+    QFile stat("/proc/self/stat");
+    timespec now;
+    if (!stat.open(QIODevice::ReadOnly) || clock_gettime(CLOCK_BOOTTIME, &now) != 0) {
+        return -1;
+    }
+    // starttime is field 22, counted in clock ticks since boot; the command
+    // name in field 2 may contain spaces, so count from its closing ')'.
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20) {
+        return -1;
+    }
+    const qint64 startMs = fields.at(19).toLongLong() * 1000 / sysconf(_SC_CLK_TCK);
+    return qint64(now.tv_sec) * 1000 + now.tv_nsec / 1000000 - startMs;
+#else
+    return -1;
+#endif
+}
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer sinceMain;
+    sinceMain.start();
+
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption telemetryRateOption(
+        "telemetry-rate",
+        "Generate telemetry on a worker thread at <hz> instead of once per second.",
+        "hz");
+    parser.addOption(telemetryRateOption);
+    QCommandLineOption simulationRateOption(
+        "simulation-rate",
+        "Run the vehicle physics at a fixed <hz> (up to 1000) on a worker thread, interpolated per frame.",
+        "hz");
+    parser.addOption(simulationRateOption);
+    QCommandLineOption coalesceOption(
+        "coalesce",
+        "Publish property changes once per frame instead of on every update.");
+    parser.addOption(coalesceOption);
+    QCommandLineOption recordOption(
+        "record",
+        "Record every telemetry sample to a binary log <file>.",
+        "file");
+    parser.addOption(recordOption);
+    QCommandLineOption replayOption(
+        "replay",
+        "Drive the dashboard from a recorded telemetry log <file>.",
+        "file");
+    parser.addOption(replayOption);
+    QCommandLineOption canLogOption(
+        "can-log",
+        "Drive the dashboard from a candump log <file> of CAN frames.",
+        "file");
+    parser.addOption(canLogOption);
+    QCommandLineOption dbcOption(
+        "dbc",
+        "Decode the CAN log with the DBC <file> instead of the built-in database.",
+        "file");
+    parser.addOption(dbcOption);
+    QCommandLineOption shmInputOption(
+        "shm-input",
+        "Read telemetry published in shared memory by another process, e.g. telemetry-shm-producer.");
+    parser.addOption(shmInputOption);
+    QCommandLineOption shmNameOption(
+        "shm-name",
+        "Shared-memory segment <name> for --shm-input.",
+        "name",
+        QString::fromLatin1(SharedTelemetry::DefaultName));
+    parser.addOption(shmNameOption);
+    QCommandLineOption replaySpeedOption(
+        "replay-speed",
+        "Replay and CAN log speed <factor>: 1 is real time, 0 is as fast as possible.",
+        "factor",
+        "1");
+    parser.addOption(replaySpeedOption);
+    QCommandLineOption warningRulesOption(
+        "warning-rules",
+        "Load the warning rules from a JSON <file> instead of the built-in set.",
+        "file");
+    parser.addOption(warningRulesOption);
+    QCommandLineOption latencyBenchmarkOption(
+        "latency-benchmark",
+        "Measure sample-to-pixel latency at each comma-separated feed <rates> (Hz), then quit.",
+        "rates");
+    parser.addOption(latencyBenchmarkOption);
+    QCommandLineOption benchmarkDurationOption(
+        "benchmark-duration",
+        "Seconds to measure each benchmark rate.",
+        "s",
+        "5");
+    parser.addOption(benchmarkDurationOption);
+    QCommandLineOption benchmarkReportOption(
+        "benchmark-report",
+        "Write the benchmark results as JSON to <file>.",
+        "file");
+    parser.addOption(benchmarkReportOption);
+    QCommandLineOption startupBenchmarkOption(
+        "startup-benchmark",
+        "Print the time until the first frame has been presented, then quit.");
+    parser.addOption(startupBenchmarkOption);
+    QCommandLineOption mapOption(
+        "map",
+        "Show the map <file> on the navigation display instead of a generated city.",
+        "file");
+    parser.addOption(mapOption);
+    QCommandLineOption fleetOption(
+        "fleet",
+        "Show the fleet view with <count> simulated vehicles instead of the dashboard.",
+        "count");
+    parser.addOption(fleetOption);
+    parser.process(app);
+
     QQmlApplicationEngine engine;
-    // QObject::connect(
-    //     &engine,
-    //     &QQmlApplicationEngine::objectCreationFailed,
-    //     &app,
-    //     []() { QCoreApplication::exit(-1); },
-    //     Qt::QueuedConnection);
-    // engine.loadFromModule("car-dashboard", "Main");
-
-    DashboardManager dashboardManager;
-    engine.rootContext()->setContextProperty("dashboardManager", &dashboardManager);
-
-    engine.load(QUrl("qrc:/CarDashboard/qml/Main.qml"));
     QObject::connect(
         &engine,
         &QQmlApplicationEngine::objectCreationFailed,
         &app,
         []() { QCoreApplication::exit(-1); },
         Qt::QueuedConnection);
-    engine.loadFromModule("car-dashboard", "Main");
+
+    if (parser.isSet(fleetOption)) {
+        engine.setInitialProperties({ { "vehicleCount", parser.value(fleetOption).toInt() } });
+        engine.loadFromModule("CarDashboard", "FleetView");
+        FrameProfiler::installIfEnabled(engine);
+        return engine.rootObjects().isEmpty() ? -1 : app.exec();
+    }
+
+    // Created by the engine on first use, owned by the engine
+    auto *dashboardManager = engine.singletonInstance<DashboardManager *>("CarDashboard", "DashboardManager");
+    if (parser.isSet(mapOption)) {
+        engine.setInitialProperties({ { "mapFile", parser.value(mapOption) } });
+    }
+    engine.loadFromModule("CarDashboard", "Main");
 
     if (engine.rootObjects().isEmpty()) {
         return -1;
     }
 
+    auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst());
+    dashboardManager->attachToWindow(window);
+    FrameProfiler::installIfEnabled(engine);
+
+    dashboardManager->setCoalescing(parser.isSet(coalesceOption));
+    if (parser.isSet(warningRulesOption)
+        && !dashboardManager->loadWarningRules(parser.value(warningRulesOption))) {
+        return -1;
+    }
+    if (parser.isSet(recordOption)) {
+        dashboardManager->startRecording(parser.value(recordOption));
+    }
+    if (parser.isSet(replayOption)) {
+        if (!dashboardManager->startReplay(parser.value(replayOption),
+                                          parser.value(replaySpeedOption).toDouble())) {
+            return -1;
+        }
+    } else if (parser.isSet(canLogOption)) {
+        if (!dashboardManager->startCanLog(parser.value(canLogOption), parser.value(dbcOption),
+                                          parser.value(replaySpeedOption).toDouble())) {
+            return -1;
+        }
+    } else if (parser.isSet(shmInputOption)) {
+        if (!dashboardManager->startSharedMemoryInput(parser.value(shmNameOption))) {
+            return -1;
+        }
+    } else if (parser.isSet(telemetryRateOption)) {
+        dashboardManager->startTelemetryFeed(parser.value(telemetryRateOption).toInt());
+    } else if (parser.isSet(simulationRateOption)) {
+        dashboardManager->startFixedStepSimulation(parser.value(simulationRateOption).toInt());
+    }
+
+    if (parser.isSet(latencyBenchmarkOption)) {
+        QList<int> rates;
+        for (const QString &rate : parser.value(latencyBenchmarkOption).split(',', Qt::SkipEmptyParts)) {
+            rates.append(rate.toInt());
+        }
+
+        auto *benchmark = new LatencyBenchmark(
+            dashboardManager, window,
+            rates, parser.value(benchmarkDurationOption).toInt() * 1000, &app);
+        QObject::connect(benchmark, &LatencyBenchmark::finished, &app, [&parser, &benchmarkReportOption, benchmark] {
+            if (parser.isSet(benchmarkReportOption)) {
+                benchmark->writeReport(parser.value(benchmarkReportOption));
+            }
+            QCoreApplication::quit();
+        });
+        benchmark->start();
+    }
+
+    if (parser.isSet(startupBenchmarkOption)) {
+        // frameSwapped comes from the render thread; take the time there and
+        // report from the GUI thread.
+        QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&app, &sinceMain] {
+            const qint64 mainMs = sinceMain.elapsed();
+            const qint64 processMs = msSinceProcessStart();
+            QMetaObject::invokeMethod(&app, [mainMs, processMs] {
+                qInfo("startup: first frame %lld ms after process start, %lld ms after main()",
+                      processMs, mainMs);
+                QCoreApplication::quit();
+            }, Qt::QueuedConnection);
+        }, Qt::ConnectionType(Qt::DirectConnection | Qt::SingleShotConnection));
+    }
+
     return app.exec();
 }
@@ -0,0 +1,457 @@
+#include "mapdata.h"
+#include "vehiclesimulation.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int NodeSize = 8;
+constexpr int WaySize = 12;
+
+QByteArray serialize(const std::vector<float> &nodes, const std::vector<MapData::Way> &ways,
+                     const std::vector<quint32> &wayNodes, const QByteArray &names) {
+    const quint32 nodeCount = quint32(nodes.size() / 2);
+    QByteArray data(MapData::HeaderSize + qsizetype(nodeCount) * NodeSize
+                        + qsizetype(ways.size()) * WaySize + qsizetype(wayNodes.size()) * 4 + names.size(),
+                    Qt::Uninitialized);
+    auto *out = reinterpret_cast<uchar *>(data.data());
+
+    std::memset(out, 0, MapData::HeaderSize);
+    std::memcpy(out, MapData::Magic, sizeof(MapData::Magic));
+    qToLittleEndian<quint32>(MapData::Version, out + 8);
+    qToLittleEndian<quint32>(nodeCount, out + 12);
+    qToLittleEndian<quint32>(quint32(ways.size()), out + 16);
+    qToLittleEndian<quint32>(quint32(wayNodes.size()), out + 20);
+    qToLittleEndian<quint32>(quint32(names.size()), out + 24);
+    out += MapData::HeaderSize;
+
+    for (float value : nodes) {
+        qToLittleEndian<float>(value, out);
+        out += 4;
+    }
+    for (const MapData::Way &way : ways) {
+        qToLittleEndian<quint32>(way.firstWayNode, out);
+        qToLittleEndian<quint16>(way.nodeCount, out + 4);
+        out[6] = way.roadClass;
+        out[7] = way.flags;
+        qToLittleEndian<quint32>(way.nameOffset, out + 8);
+        out += WaySize;
+    }
+    for (quint32 node : wayNodes) {
+        qToLittleEndian<quint32>(node, out);
+        out += 4;
+    }
+    std::memcpy(out, names.constData(), std::size_t(names.size()));
+    return data;
+}
+
+QString ordinal(int n) {
+    const int lastTwo = n % 100;
+    const char *suffix = "th";
+    if (lastTwo < 11 || lastTwo > 13) {
+        switch (n % 10) {
+        case 1: suffix = "st"; break;
+        case 2: suffix = "nd"; break;
+        case 3: suffix = "rd"; break;
+        default: break;
+        }
+    }
+    return QString::number(n) + QLatin1String(suffix);
+}
+
+} // namespace
+
+bool MapData::load(const QString &path, QString *errorString) {
+    auto fail = [this, errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        *this = MapData();
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < HeaderSize || std::memcmp(data.constData(), Magic, sizeof(Magic)) != 0) {
+        return fail(QStringLiteral("Not a map file"));
+    }
+
+    const auto *in = reinterpret_cast<const uchar *>(data.constData());
+    if (qFromLittleEndian<quint32>(in + 8) != Version) {
+        return fail(QStringLiteral("Unsupported map file version"));
+    }
+    const quint64 nodeCount = qFromLittleEndian<quint32>(in + 12);
+    const quint64 wayCount = qFromLittleEndian<quint32>(in + 16);
+    const quint64 wayNodeCount = qFromLittleEndian<quint32>(in + 20);
+    const quint64 namesSize = qFromLittleEndian<quint32>(in + 24);
+    if (quint64(data.size()) != HeaderSize + nodeCount * NodeSize + wayCount * WaySize
+                                    + wayNodeCount * 4 + namesSize) {
+        return fail(QStringLiteral("Map file is truncated or corrupt"));
+    }
+    in += HeaderSize;
+
+    m_nodes.resize(std::size_t(nodeCount * 2));
+    for (float &value : m_nodes) {
+        value = qFromLittleEndian<float>(in);
+        in += 4;
+        if (!std::isfinite(value)) {
+            return fail(QStringLiteral("Map file has an invalid node"));
+        }
+    }
+
+    m_ways.resize(std::size_t(wayCount));
+    for (Way &way : m_ways) {
+        way.firstWayNode = qFromLittleEndian<quint32>(in);
+        way.nodeCount = qFromLittleEndian<quint16>(in + 4);
+        way.roadClass = RoadClass(in[6]);
+        way.flags = in[7];
+        way.nameOffset = qFromLittleEndian<quint32>(in + 8);
+        in += WaySize;
+        if (way.roadClass >= RoadClassCount || way.nodeCount < 2
+            || quint64(way.firstWayNode) + way.nodeCount > wayNodeCount
+            || (namesSize > 0 && way.nameOffset >= namesSize)) {
+            return fail(QStringLiteral("Map file has an invalid way"));
+        }
+    }
+
+    m_wayNodes.resize(std::size_t(wayNodeCount));
+    for (quint32 &node : m_wayNodes) {
+        node = qFromLittleEndian<quint32>(in);
+        in += 4;
+        if (node >= nodeCount) {
+            return fail(QStringLiteral("Map file refers to a missing node"));
+        }
+    }
+
+    m_names = QByteArray(reinterpret_cast<const char *>(in), qsizetype(namesSize));
+    if (!m_names.isEmpty() && !m_names.endsWith('\0')) {
+        return fail(QStringLiteral("Map file has an unterminated name"));
+    }
+
+    m_fingerprint = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().left(16);
+    buildIndex();
+    return true;
+}
+
+bool MapData::save(const QString &path, QString *errorString) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(serialize(m_nodes, m_ways, m_wayNodes, m_names)) < 0
+        || !file.commit()) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+MapData MapData::generateCity(quint64 seed, double size) {
+    constexpr double Spacing = 120;
+    constexpr double Jitter = 15;
+    // Residential segments left out, for dead ends and detours
+    constexpr int GapPercent = 7;
+
+    VehicleSimulation::RandomStream rng(seed);
+    const int lines = qMax(2, int(size / Spacing) + 1);
+    const double half = (lines - 1) * Spacing / 2;
+
+    MapData map;
+    auto addNode = [&map](double x, double y) {
+        map.m_nodes.push_back(float(x));
+        map.m_nodes.push_back(float(y));
+        return quint32(map.m_nodes.size() / 2 - 1);
+    };
+    auto addName = [&map](const QString &name) {
+        const quint32 offset = quint32(map.m_names.size());
+        map.m_names.append(name.toUtf8());
+        map.m_names.append('\0');
+        return offset;
+    };
+    auto addWay = [&map](const std::vector<quint32> &nodes, RoadClass roadClass, quint32 name) {
+        if (nodes.size() < 2) {
+            return;
+        }
+        Way way;
+        way.firstWayNode = quint32(map.m_wayNodes.size());
+        way.nodeCount = quint16(nodes.size());
+        way.roadClass = roadClass;
+        way.nameOffset = name;
+        map.m_ways.push_back(way);
+        map.m_wayNodes.insert(map.m_wayNodes.end(), nodes.begin(), nodes.end());
+    };
+    auto classOf = [](int line) {
+        return line % 15 == 0 ? Primary : line % 5 == 0 ? Secondary : Residential;
+    };
+
+    // Intersections, row-major from the north-west corner
+    for (int row = 0; row < lines; ++row) {
+        for (int column = 0; column < lines; ++column) {
+            addNode(column * Spacing - half + rng.bounded(-int(Jitter), int(Jitter) + 1),
+                    half - row * Spacing + rng.bounded(-int(Jitter), int(Jitter) + 1));
+        }
+    }
+    auto grid = [lines](int row, int column) { return quint32(row * lines + column); };
+
+    std::vector<quint32> nodes;
+    for (int direction = 0; direction < 2; ++direction) {
+        for (int line = 0; line < lines; ++line) {
+            const RoadClass roadClass = classOf(line);
+            const QString name = direction == 0
+                ? ordinal(line + 1) + (roadClass == Primary ? QLatin1String(" Boulevard") : QLatin1String(" Street"))
+                : ordinal(line + 1) + QLatin1String(" Avenue");
+            const quint32 nameOffset = addName(name);
+
+            nodes.clear();
+            for (int i = 0; i < lines; ++i) {
+                nodes.push_back(direction == 0 ? grid(line, i) : grid(i, line));
+                if (roadClass == Residential && i + 1 < lines && rng.bounded(100) < GapPercent) {
+                    addWay(nodes, roadClass, nameOffset);
+                    nodes.clear();
+                }
+            }
+            addWay(nodes, roadClass, nameOffset);
+        }
+    }
+
+    // Motorway ring two blocks outside the grid, with a ramp from the end
+    // of every primary road
+    const double ring = half + 2 * Spacing;
+    const int ringSteps = qMax(4, int(2 * ring / (4 * Spacing)));
+    std::vector<quint32> ringNodes;
+    for (int side = 0; side < 4; ++side) {
+        for (int step = 0; step < ringSteps; ++step) {
+            const double t = -ring + 2 * ring * step / ringSteps;
+            switch (side) {
+            case 0: ringNodes.push_back(addNode(t, ring)); break;      // north, west to east
+            case 1: ringNodes.push_back(addNode(ring, -t)); break;     // east, north to south
+            case 2: ringNodes.push_back(addNode(-t, -ring)); break;    // south, east to west
+            default: ringNodes.push_back(addNode(-ring, t)); break;    // west, south to north
+            }
+        }
+    }
+    ringNodes.push_back(ringNodes.front());
+    addWay(ringNodes, Motorway, addName(QStringLiteral("Ring Motorway")));
+    ringNodes.pop_back();
+
+    auto nearestRingNode = [&map, &ringNodes](quint32 node) {
+        const QPointF p = map.node(node);
+        quint32 best = ringNodes.front();
+        double bestDistance = HUGE_VAL;
+        for (quint32 candidate : ringNodes) {
+            const QPointF d = map.node(candidate) - p;
+            const double distance = QPointF::dotProduct(d, d);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = candidate;
+            }
+        }
+        return best;
+    };
+    const quint32 rampName = addName(QStringLiteral("Ring Access"));
+    for (int line = 0; line < lines; line += 15) {
+        for (quint32 end : { grid(line, 0), grid(line, lines - 1), grid(0, line), grid(lines - 1, line) }) {
+            addWay({ end, nearestRingNode(end) }, Primary, rampName);
+        }
+    }
+
+    map.m_fingerprint = QCryptographicHash::hash(serialize(map.m_nodes, map.m_ways, map.m_wayNodes, map.m_names),
+                                                 QCryptographicHash::Sha1).toHex().left(16);
+    map.buildIndex();
+    return map;
+}
+
+bool MapData::isEmpty() const {
+    return m_ways.empty();
+}
+
+QByteArray MapData::fingerprint() const {
+    return m_fingerprint;
+}
+
+QRectF MapData::bounds() const {
+    return m_bounds;
+}
+
+int MapData::nodeCount() const {
+    return int(m_nodes.size() / 2);
+}
+
+QPointF MapData::node(quint32 index) const {
+    return QPointF(m_nodes[2 * std::size_t(index)], m_nodes[2 * std::size_t(index) + 1]);
+}
+
+int MapData::wayCount() const {
+    return int(m_ways.size());
+}
+
+const MapData::Way &MapData::way(quint32 index) const {
+    return m_ways[index];
+}
+
+quint32 MapData::wayNode(const Way &way, int i) const {
+    return m_wayNodes[way.firstWayNode + quint32(i)];
+}
+
+QString MapData::wayName(quint32 index) const {
+    if (m_names.isEmpty()) {
+        return QString();
+    }
+    return QString::fromUtf8(m_names.constData() + m_ways[index].nameOffset);
+}
+
+int MapData::cellIndex(int cx, int cy) const {
+    return cy * m_gridWidth + cx;
+}
+
+void MapData::buildIndex() {
+    m_cellOffsets.clear();
+    m_cellWays.clear();
+    m_edgeOffsets.clear();
+    m_edges.clear();
+    m_gridWidth = m_gridHeight = 0;
+    m_bounds = QRectF();
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+    for (std::size_t i = 0; i < m_nodes.size(); i += 2) {
+        minX = qMin(minX, double(m_nodes[i]));
+        maxX = qMax(maxX, double(m_nodes[i]));
+        minY = qMin(minY, double(m_nodes[i + 1]));
+        maxY = qMax(maxY, double(m_nodes[i + 1]));
+    }
+    m_bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    m_gridWidth = int(m_bounds.width() / m_cellSize) + 1;
+    m_gridHeight = int(m_bounds.height() / m_cellSize) + 1;
+
+    // Cells covered by the bounding box of each way, counted then filled
+    const auto cellRange = [this](const Way &way, int &x0, int &y0, int &x1, int &y1) {
+        double wx0 = HUGE_VAL, wy0 = HUGE_VAL, wx1 = -HUGE_VAL, wy1 = -HUGE_VAL;
+        for (int i = 0; i < way.nodeCount; ++i) {
+            const QPointF p = node(wayNode(way, i));
+            wx0 = qMin(wx0, p.x());
+            wx1 = qMax(wx1, p.x());
+            wy0 = qMin(wy0, p.y());
+            wy1 = qMax(wy1, p.y());
+        }
+        x0 = int((wx0 - m_bounds.left()) / m_cellSize);
+        x1 = int((wx1 - m_bounds.left()) / m_cellSize);
+        y0 = int((wy0 - m_bounds.top()) / m_cellSize);
+        y1 = int((wy1 - m_bounds.top()) / m_cellSize);
+    };
+
+    m_cellOffsets.assign(std::size_t(m_gridWidth) * m_gridHeight + 1, 0);
+    for (const Way &way : m_ways) {
+        int x0, y0, x1, y1;
+        cellRange(way, x0, y0, x1, y1);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                ++m_cellOffsets[std::size_t(cellIndex(cx, cy)) + 1];
+            }
+        }
+    }
+    for (std::size_t i = 1; i < m_cellOffsets.size(); ++i) {
+        m_cellOffsets[i] += m_cellOffsets[i - 1];
+    }
+    m_cellWays.resize(m_cellOffsets.back());
+    std::vector<quint32> fill(m_cellOffsets.begin(), m_cellOffsets.end() - 1);
+    for (quint32 w = 0; w < m_ways.size(); ++w) {
+        int x0, y0, x1, y1;
+        cellRange(m_ways[w], x0, y0, x1, y1);
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                m_cellWays[fill[std::size_t(cellIndex(cx, cy))]++] = w;
+            }
+        }
+    }
+
+    // One edge per direction a segment can be driven
+    const std::size_t nodeCount = m_nodes.size() / 2;
+    m_edgeOffsets.assign(nodeCount + 1, 0);
+    for (const Way &way : m_ways) {
+        for (int i = 0; i + 1 < way.nodeCount; ++i) {
+            ++m_edgeOffsets[wayNode(way, i) + 1];
+            if (!(way.flags & OneWay)) {
+                ++m_edgeOffsets[wayNode(way, i + 1) + 1];
+            }
+        }
+    }
+    for (std::size_t i = 1; i < m_edgeOffsets.size(); ++i) {
+        m_edgeOffsets[i] += m_edgeOffsets[i - 1];
+    }
+    m_edges.resize(m_edgeOffsets.back());
+    fill.assign(m_edgeOffsets.begin(), m_edgeOffsets.end() - 1);
+    for (quint32 w = 0; w < m_ways.size(); ++w) {
+        const Way &way = m_ways[w];
+        for (int i = 0; i + 1 < way.nodeCount; ++i) {
+            const quint32 a = wayNode(way, i);
+            const quint32 b = wayNode(way, i + 1);
+            const QPointF d = node(b) - node(a);
+            const float length = float(std::hypot(d.x(), d.y()));
+            m_edges[fill[a]++] = { b, w, length };
+            if (!(way.flags & OneWay)) {
+                m_edges[fill[b]++] = { a, w, length };
+            }
+        }
+    }
+}
+
+void MapData::waysIn(const QRectF &rect, std::vector<quint32> &ways) const {
+    ways.clear();
+    if (m_gridWidth == 0 || !rect.intersects(m_bounds.adjusted(-1, -1, 1, 1))) {
+        return;
+    }
+
+    const int x0 = qBound(0, int((rect.left() - m_bounds.left()) / m_cellSize), m_gridWidth - 1);
+    const int x1 = qBound(0, int((rect.right() - m_bounds.left()) / m_cellSize), m_gridWidth - 1);
+    const int y0 = qBound(0, int((rect.top() - m_bounds.top()) / m_cellSize), m_gridHeight - 1);
+    const int y1 = qBound(0, int((rect.bottom() - m_bounds.top()) / m_cellSize), m_gridHeight - 1);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            const int cell = cellIndex(cx, cy);
+            ways.insert(ways.end(), m_cellWays.begin() + m_cellOffsets[std::size_t(cell)],
+                        m_cellWays.begin() + m_cellOffsets[std::size_t(cell) + 1]);
+        }
+    }
+
+    // Minor roads first; ties by index to drop duplicates
+    std::sort(ways.begin(), ways.end(), [this](quint32 a, quint32 b) {
+        const RoadClass ca = m_ways[a].roadClass;
+        const RoadClass cb = m_ways[b].roadClass;
+        return ca != cb ? ca > cb : a < b;
+    });
+    ways.erase(std::unique(ways.begin(), ways.end()), ways.end());
+}
+
+const MapData::Edge *MapData::edgesBegin(quint32 node) const {
+    return m_edges.data() + m_edgeOffsets[node];
+}
+
+const MapData::Edge *MapData::edgesEnd(quint32 node) const {
+    return m_edges.data() + m_edgeOffsets[std::size_t(node) + 1];
+}
+
+qint64 MapData::nearestNode(const QPointF &point) const {
+    qint64 best = -1;
+    double bestDistance = HUGE_VAL;
+    for (std::size_t i = 0; i < m_nodes.size(); i += 2) {
+        const double dx = m_nodes[i] - point.x();
+        const double dy = m_nodes[i + 1] - point.y();
+        const double distance = dx * dx + dy * dy;
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            best = qint64(i / 2);
+        }
+    }
+    return best;
+}
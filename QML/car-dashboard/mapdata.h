@@ -0,0 +1,120 @@
+#ifndef MAPDATA_H
+#define MAPDATA_H
+
+#include <QByteArray>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <vector>
+
+// Road network for the navigation display, read from a local map file.
+//
+// Positions are planar metres, x east and y north, around an arbitrary
+// origin. A way is a polyline of nodes with a road class; ways that cross
+// share the node at the crossing, which makes the ways a routable graph.
+//
+// File layout, all little-endian:
+//
+//   header: magic[8] "DASHMAP\0" | quint32 version | quint32 nodeCount
+//           | quint32 wayCount | quint32 wayNodeCount | quint32 namesSize
+//           | quint32 reserved
+//   nodes:    nodeCount x (float x | float y)
+//   ways:     wayCount x (quint32 firstWayNode | quint16 nodeCount
+//             | quint8 roadClass | quint8 flags | quint32 nameOffset)
+//   wayNodes: wayNodeCount x quint32 node index
+//   names:    namesSize bytes of NUL-terminated UTF-8
+//
+// After loading, ways are bucketed in a uniform grid so the tiles of a
+// viewport only look at the ways near them, and every way segment becomes
+// an edge of a compressed adjacency list.
+class MapData {
+public:
+    enum RoadClass : quint8 {
+        Motorway,
+        Primary,
+        Secondary,
+        Residential,
+        RoadClassCount
+    };
+
+    enum WayFlag : quint8 {
+        OneWay = 0x1        // only in node order
+    };
+
+    struct Way {
+        quint32 firstWayNode = 0;
+        quint16 nodeCount = 0;
+        RoadClass roadClass = Residential;
+        quint8 flags = 0;
+        quint32 nameOffset = 0;
+    };
+
+    // Directed edge between two consecutive nodes of a way
+    struct Edge {
+        quint32 to;
+        quint32 way;
+        float length;       // metres
+    };
+
+    static constexpr char Magic[8] = {'D', 'A', 'S', 'H', 'M', 'A', 'P', '\0'};
+    static constexpr quint32 Version = 1;
+    static constexpr int HeaderSize = 32;
+
+    MapData() = default;
+
+    bool load(const QString &path, QString *errorString = nullptr);
+    bool save(const QString &path, QString *errorString = nullptr) const;
+
+    // A grid city of about size x size metres: residential streets around
+    // secondary and primary avenues, a motorway ring, and jittered
+    // intersections so streets are not perfectly straight.
+    static MapData generateCity(quint64 seed, double size = 6000);
+
+    bool isEmpty() const;
+    // Changes with the content, for keying caches of rendered tiles
+    QByteArray fingerprint() const;
+    QRectF bounds() const;
+
+    int nodeCount() const;
+    QPointF node(quint32 index) const;
+    int wayCount() const;
+    const Way &way(quint32 index) const;
+    quint32 wayNode(const Way &way, int i) const;
+    QString wayName(quint32 index) const;
+
+    // Ways whose bounding box may intersect rect, each once, in class order
+    // (motorways last so they are drawn on top)
+    void waysIn(const QRectF &rect, std::vector<quint32> &ways) const;
+
+    // Edges leaving node
+    const Edge *edgesBegin(quint32 node) const;
+    const Edge *edgesEnd(quint32 node) const;
+
+    // Node closest to point, or -1 for an empty map
+    qint64 nearestNode(const QPointF &point) const;
+
+private:
+    void buildIndex();
+    int cellIndex(int cx, int cy) const;
+
+    std::vector<float> m_nodes;         // x, y pairs
+    std::vector<Way> m_ways;
+    std::vector<quint32> m_wayNodes;
+    QByteArray m_names;
+
+    QRectF m_bounds;
+    QByteArray m_fingerprint;
+
+    // Uniform grid over m_bounds, cell -> ways touching it
+    double m_cellSize = 250;
+    int m_gridWidth = 0;
+    int m_gridHeight = 0;
+    std::vector<quint32> m_cellOffsets;     // gridWidth * gridHeight + 1
+    std::vector<quint32> m_cellWays;
+
+    // Compressed adjacency: edges of node n are [m_edgeOffsets[n], m_edgeOffsets[n + 1])
+    std::vector<quint32> m_edgeOffsets;
+    std::vector<Edge> m_edges;
+};
+
+#endif // MAPDATA_H
@@ -0,0 +1,210 @@
+#include "maptiles.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QPolygonF>
+
+namespace {
+
+struct RoadStyle {
+    QRgb color;
+    double widthMetres;
+    double minimumWidthPixels;
+};
+
+// Indexed by MapData::RoadClass
+const RoadStyle RoadStyles[] = {
+    { qRgb(0xE6, 0x7E, 0x22), 24, 3 },      // Motorway
+    { qRgb(0xF4, 0xD0, 0x3F), 16, 2 },      // Primary
+    { qRgb(0xAB, 0xB2, 0xB9), 11, 1.5 },    // Secondary
+    { qRgb(0x5D, 0x6D, 0x7E), 7, 1 },       // Residential
+};
+static_assert(sizeof(RoadStyles) / sizeof(RoadStyles[0]) == MapData::RoadClassCount,
+              "every road class needs a style");
+
+const QRgb Background = qRgb(0x1B, 0x26, 0x31);
+
+QString tilePath(const QString &directory, quint64 key) {
+    return QStringLiteral("%1/%2/%3_%4.png")
+        .arg(directory)
+        .arg(MapTiles::zoomOf(key))
+        .arg(MapTiles::xOf(key))
+        .arg(MapTiles::yOf(key));
+}
+
+} // namespace
+
+namespace MapTiles {
+
+QRectF tileRect(quint64 key) {
+    const double span = tileSpan(zoomOf(key));
+    const double north = -yOf(key) * span;
+    return QRectF(xOf(key) * span, north - span, span, span);
+}
+
+quint64 tileAt(int zoom, const QPointF &position) {
+    const double span = tileSpan(zoom);
+    return key(zoom, int(std::floor(position.x() / span)), int(std::floor(-position.y() / span)));
+}
+
+QImage render(const MapData &map, quint64 key) {
+    const int zoom = zoomOf(key);
+    const double metresPerPixel = MapTiles::metresPerPixel(zoom);
+    const QRectF area = tileRect(key);
+
+    QImage image(TileSize, TileSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Background);
+
+    // Roads that overlap the tile edge must still be drawn to it
+    thread_local std::vector<quint32> ways;
+    const double margin = RoadStyles[MapData::Motorway].widthMetres
+                          + RoadStyles[MapData::Motorway].minimumWidthPixels * metresPerPixel;
+    map.waysIn(area.adjusted(-margin, -margin, margin, margin), ways);
+    if (ways.empty()) {
+        return image;
+    }
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    // Map metres to tile pixels, north up
+    painter.setTransform(QTransform(1 / metresPerPixel, 0, 0, -1 / metresPerPixel,
+                                    -area.left() / metresPerPixel, area.bottom() / metresPerPixel));
+
+    thread_local QPolygonF line;
+    for (quint32 index : ways) {
+        const MapData::Way &way = map.way(index);
+        const RoadStyle &style = RoadStyles[way.roadClass];
+
+        line.resize(way.nodeCount);
+        for (int i = 0; i < way.nodeCount; ++i) {
+            line[i] = map.node(map.wayNode(way, i));
+        }
+        const double width = qMax(style.widthMetres, style.minimumWidthPixels * metresPerPixel);
+        painter.setPen(QPen(QColor(style.color), width, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
+        painter.drawPolyline(line);
+    }
+    return image;
+}
+
+} // namespace MapTiles
+
+TileLoader::TileLoader(int threadCount, QObject *parent)
+    : QObject(parent)
+{
+    if (threadCount <= 0) {
+        threadCount = qMax(1, int(std::thread::hardware_concurrency()) / 2);
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        m_threads.emplace_back(&TileLoader::workerLoop, this);
+    }
+}
+
+TileLoader::~TileLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.clear();
+        m_queued.clear();
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void TileLoader::setMap(std::shared_ptr<const MapData> map, const QString &cacheDirectory) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_map = std::move(map);
+    m_cacheDirectory = cacheDirectory;
+    ++m_generation;
+    m_queue.clear();
+    m_queued.clear();
+    // Tiles in flight belong to the old map and are reported as such
+    m_inFlight.clear();
+}
+
+quint64 TileLoader::mapGeneration() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+void TileLoader::request(quint64 key, int priority) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_map || m_inFlight.contains(key)) {
+            return;
+        }
+        const auto queued = m_queued.constFind(key);
+        if (queued != m_queued.cend()) {
+            if (queued.value()->first.first <= priority) {
+                return;
+            }
+            m_queue.erase(queued.value());
+        }
+        m_queued.insert(key, m_queue.emplace(std::make_pair(priority, m_order++), key).first);
+    }
+    m_wake.notify_one();
+}
+
+void TileLoader::retain(const QSet<quint64> &keys) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_queued.begin(); it != m_queued.end();) {
+        if (keys.contains(it.key())) {
+            ++it;
+        } else {
+            m_queue.erase(it.value());
+            it = m_queued.erase(it);
+        }
+    }
+}
+
+int TileLoader::pendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return int(m_queue.size() + std::size_t(m_inFlight.size()));
+}
+
+void TileLoader::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+        if (m_stopping) {
+            return;
+        }
+
+        const quint64 key = m_queue.begin()->second;
+        m_queue.erase(m_queue.begin());
+        m_queued.remove(key);
+        m_inFlight.insert(key);
+        const std::shared_ptr<const MapData> map = m_map;
+        const QString directory = m_cacheDirectory;
+        const quint64 generation = m_generation;
+        lock.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        QImage image;
+        bool fromDisk = false;
+        const QString path = directory.isEmpty() ? QString() : tilePath(directory, key);
+        if (!path.isEmpty() && QFile::exists(path) && image.load(path, "PNG")) {
+            image.convertTo(QImage::Format_ARGB32_Premultiplied);
+            fromDisk = true;
+        } else {
+            image = MapTiles::render(*map, key);
+            if (!path.isEmpty()) {
+                // A failed write only costs a render next time
+                QDir().mkpath(QFileInfo(path).absolutePath());
+                image.save(path, "PNG");
+            }
+        }
+        const qint64 latencyNs = timer.nsecsElapsed();
+
+        emit tileReady(key, image, fromDisk, latencyNs, generation);
+
+        lock.lock();
+        if (generation == m_generation) {
+            m_inFlight.remove(key);
+        }
+    }
+}
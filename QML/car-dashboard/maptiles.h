@@ -0,0 +1,122 @@
+#ifndef MAPTILES_H
+#define MAPTILES_H
+
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QRectF>
+#include <QSet>
+#include <cmath>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mapdata.h"
+
+// Square raster tiles of a MapData, in a pyramid of zoom levels.
+//
+// Level 0 draws 32 m per pixel and every level halves that. Tile (x, y)
+// of a level spans [x, x + 1) tile widths east of the origin and [y, y + 1)
+// tile heights south of it, so rows grow downwards like the screen. A tile
+// is identified by one 64-bit key.
+namespace MapTiles {
+
+inline constexpr int TileSize = 256;
+inline constexpr int MaxZoom = 7;
+inline constexpr double BaseMetresPerPixel = 32;
+
+inline double metresPerPixel(double zoom)
+{
+    return BaseMetresPerPixel / std::exp2(zoom);
+}
+
+inline double tileSpan(int zoom)
+{
+    return TileSize * metresPerPixel(zoom);
+}
+
+inline quint64 key(int zoom, int x, int y)
+{
+    return quint64(zoom) << 56 | quint64(quint32(x) & 0xfffffff) << 28 | (quint32(y) & 0xfffffff);
+}
+
+inline int zoomOf(quint64 key)
+{
+    return int(key >> 56);
+}
+
+// x and y are stored as 28-bit two's complement
+inline int xOf(quint64 key)
+{
+    return qint32(quint32(key >> 28) << 4) >> 4;
+}
+
+inline int yOf(quint64 key)
+{
+    return qint32(quint32(key) << 4) >> 4;
+}
+
+// Map area of the tile in metres, top() being its southern edge
+QRectF tileRect(quint64 key);
+
+// Tile containing a map position
+quint64 tileAt(int zoom, const QPointF &position);
+
+// Rasterizes one tile; safe to call from several threads at once
+QImage render(const MapData &map, quint64 key);
+
+} // namespace MapTiles
+
+// Loads tiles on background threads, from the on-disk cache of rasterized
+// tiles when it has them and by rendering them from the map otherwise.
+// Rendered tiles are written to the disk cache for the next time.
+//
+// Requests are served by priority, lowest first, and a request for a tile
+// that is already queued only moves it up. retain() drops the queued
+// requests the caller has lost interest in, so panning across the map
+// does not leave a backlog of tiles that are no longer on screen.
+class TileLoader : public QObject {
+    Q_OBJECT
+
+public:
+    // threadCount <= 0 uses half the hardware threads, at least one
+    explicit TileLoader(int threadCount = 0, QObject *parent = nullptr);
+    ~TileLoader();
+
+    // Forgets every queued request. Tiles of the previous map still being
+    // loaded are reported with the previous generation.
+    void setMap(std::shared_ptr<const MapData> map, const QString &cacheDirectory);
+    quint64 mapGeneration() const;
+
+    void request(quint64 key, int priority);
+    void retain(const QSet<quint64> &keys);
+    int pendingCount() const;
+
+signals:
+    // Emitted from a loader thread. latencyNs is the time spent decoding
+    // or rendering, without the time the request waited in the queue.
+    void tileReady(quint64 key, const QImage &image, bool fromDisk, qint64 latencyNs, quint64 mapGeneration);
+
+private:
+    using Queue = std::map<std::pair<int, quint64>, quint64>;   // (priority, order) -> key
+
+    void workerLoop();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    Queue m_queue;
+    QHash<quint64, Queue::iterator> m_queued;
+    QSet<quint64> m_inFlight;
+    quint64 m_order = 0;
+
+    std::shared_ptr<const MapData> m_map;
+    QString m_cacheDirectory;
+    quint64 m_generation = 0;
+
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+};
+
+#endif // MAPTILES_H
@@ -0,0 +1,764 @@
+#include "mapview.h"
+#include "dashboardmanager.h"
+#include <QDebug>
+#include <QFile>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGSimpleRectNode>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Seed of the city shown without a map file, and of the route the vehicle
+// takes through it
+constexpr quint64 GeneratedCitySeed = 0x6d6170;
+constexpr quint64 TrackerSeed = 1;
+
+constexpr int TickIntervalMs = 33;
+constexpr int MetricsIntervalMs = 250;
+constexpr int LatencyWindowSize = 256;
+
+// A missing tile is drawn from an ancestor at most this many levels up
+constexpr int FallbackLevels = 3;
+// Beyond this the viewport is not worth drawing tile by tile
+constexpr int MaxVisibleTiles = 400;
+
+// Prefetch the road covered in this many seconds at the current speed, at
+// most MaxPrefetchMetres, using at most half of the memory cache
+constexpr double PrefetchSeconds = 30;
+constexpr double MaxPrefetchMetres = 3000;
+constexpr int AdjacentLevelPriority = 4;
+
+const QColor BackgroundColor(0x1B, 0x26, 0x31);
+const QColor RouteColor(0x4F, 0xC3, 0xF7);
+constexpr float RouteHalfWidth = 3;
+
+// Preprocessed routing graph next to a map file, see route-preprocessor
+const QLatin1String RoutingGraphSuffix(".route");
+
+int tileCost(const QImage &image) {
+    return qMax(1, int(image.sizeInBytes() / 1024));
+}
+
+} // namespace
+
+void MapView::LatencyWindow::add(double ms) {
+    if (values.size() < LatencyWindowSize) {
+        values.push_back(ms);
+    } else {
+        values[next] = ms;
+        next = (next + 1) % values.size();
+    }
+}
+
+double MapView::LatencyWindow::mean() const {
+    if (values.empty()) {
+        return 0;
+    }
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    return sum / values.size();
+}
+
+double MapView::LatencyWindow::p95() const {
+    if (values.empty()) {
+        return 0;
+    }
+    std::vector<double> sorted = values;
+    const auto nth = sorted.begin() + std::ptrdiff_t((sorted.size() - 1) * 95 / 100);
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return *nth;
+}
+
+MapView::MapView(QQuickItem *parent)
+    : QQuickItem(parent),
+    m_loader(std::make_unique<TileLoader>()),
+    m_planner(std::make_unique<RoutePlanner>())
+{
+    setFlag(ItemHasContents);
+    m_cache.setMaxCost(48 * 1024);
+    m_tickTimer.setInterval(TickIntervalMs);
+    connect(&m_tickTimer, &QTimer::timeout, this, &MapView::tick);
+    connect(m_loader.get(), &TileLoader::tileReady, this, &MapView::onTileReady, Qt::QueuedConnection);
+    connect(m_planner.get(), &RoutePlanner::routeReady, this, &MapView::onRouteReady, Qt::QueuedConnection);
+    m_sinceMetrics.start();
+}
+
+MapView::~MapView() {
+    // Join the worker threads before the state they report to goes away
+    m_loader.reset();
+    m_planner.reset();
+}
+
+DashboardManager *MapView::source() const {
+    return m_source;
+}
+
+void MapView::setSource(DashboardManager *source) {
+    if (m_source != source) {
+        m_source = source;
+        emit sourceChanged();
+    }
+}
+
+QString MapView::mapFile() const {
+    return m_mapFile;
+}
+
+void MapView::setMapFile(const QString &path) {
+    if (m_mapFile == path) {
+        return;
+    }
+
+    m_mapFile = path;
+    if (isComponentComplete()) {
+        loadMap();
+    }
+    emit mapFileChanged();
+}
+
+MapView::Status MapView::status() const {
+    return m_status;
+}
+
+QString MapView::errorString() const {
+    return m_errorString;
+}
+
+qreal MapView::zoom() const {
+    return m_zoom;
+}
+
+void MapView::setZoom(qreal zoom) {
+    zoom = qBound<qreal>(0, zoom, MapTiles::MaxZoom);
+    if (m_zoom != zoom) {
+        m_zoom = zoom;
+        updateTiles();
+        update();
+        emit zoomChanged();
+        emit vehicleChanged();
+    }
+}
+
+QPointF MapView::center() const {
+    return m_center;
+}
+
+void MapView::setCenter(const QPointF &center) {
+    setFollowVehicle(false);
+    moveCenter(center);
+}
+
+void MapView::moveCenter(const QPointF &center) {
+    if (m_center != center) {
+        m_center = center;
+        updateTiles();
+        update();
+        emit centerChanged();
+        emit vehicleChanged();
+    }
+}
+
+bool MapView::followVehicle() const {
+    return m_followVehicle;
+}
+
+void MapView::setFollowVehicle(bool follow) {
+    if (m_followVehicle == follow) {
+        return;
+    }
+
+    m_followVehicle = follow;
+    if (m_followVehicle && m_tracker.isValid()) {
+        moveCenter(m_tracker.position());
+    }
+    emit followVehicleChanged();
+}
+
+int MapView::memoryCacheMB() const {
+    return int(m_cache.maxCost() / 1024);
+}
+
+void MapView::setMemoryCacheMB(int megabytes) {
+    megabytes = qMax(1, megabytes);
+    if (memoryCacheMB() != megabytes) {
+        m_cache.setMaxCost(qsizetype(megabytes) * 1024);
+        m_prefetchPlan = 0;
+        emit memoryCacheMBChanged();
+    }
+}
+
+QPointF MapView::vehiclePoint() const {
+    return m_tracker.isValid() ? toItem(m_tracker.position()) : QPointF(-1, -1);
+}
+
+qreal MapView::vehicleHeading() const {
+    return m_tracker.heading();
+}
+
+bool MapView::hasDestination() const {
+    return m_destinationNode >= 0;
+}
+
+QPointF MapView::destinationPoint() const {
+    return m_map && m_destinationNode >= 0 ? toItem(m_map->node(quint32(m_destinationNode))) : QPointF(-1, -1);
+}
+
+qreal MapView::routeDistance() const {
+    return m_tracker.remainingRouteMetres();
+}
+
+qreal MapView::routeTimeSeconds() const {
+    // The planned time, scaled down as the route is driven
+    return m_routeMetres > 0 ? m_routeTravelTimeMs / 1000.0 * routeDistance() / m_routeMetres : 0;
+}
+
+int MapView::reroutes() const {
+    return m_reroutes;
+}
+
+qreal MapView::routeLatencyMs() const {
+    return m_routeLatencyMs;
+}
+
+qreal MapView::routeQueryUs() const {
+    return m_routeQueryUs;
+}
+
+qreal MapView::memoryHitRate() const {
+    return m_lookups > 0 ? qreal(m_memoryHits) / m_lookups : 0;
+}
+
+qreal MapView::diskHitRate() const {
+    const qint64 loads = m_diskLoads + m_renders;
+    return loads > 0 ? qreal(m_diskLoads) / loads : 0;
+}
+
+int MapView::tilesInMemory() const {
+    return int(m_cache.count());
+}
+
+int MapView::pendingTiles() const {
+    return m_pendingTiles;
+}
+
+qreal MapView::decodeLatencyMs() const {
+    return m_decodeLatency.mean();
+}
+
+qreal MapView::decodeLatencyP95Ms() const {
+    return m_decodeLatency.p95();
+}
+
+qreal MapView::renderLatencyMs() const {
+    return m_renderLatency.mean();
+}
+
+qreal MapView::renderLatencyP95Ms() const {
+    return m_renderLatency.p95();
+}
+
+void MapView::pan(qreal dx, qreal dy) {
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    setCenter(m_center + QPointF(-dx * metresPerPixel, dy * metresPerPixel));
+}
+
+void MapView::zoomAt(qreal delta, const QPointF &point) {
+    // While following, zoom around the vehicle
+    if (m_followVehicle) {
+        setZoom(m_zoom + delta);
+        return;
+    }
+
+    const QPointF anchor = toMap(point);
+    setZoom(m_zoom + delta);
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    moveCenter(anchor - QPointF((point.x() - width() / 2) * metresPerPixel,
+                                -(point.y() - height() / 2) * metresPerPixel));
+}
+
+void MapView::recenter() {
+    setFollowVehicle(true);
+}
+
+void MapView::setDestinationAt(const QPointF &point) {
+    if (!m_map || !m_routing || !m_tracker.isValid()) {
+        return;
+    }
+
+    const qint64 node = m_map->nearestNode(toMap(point));
+    if (node < 0) {
+        return;
+    }
+    m_destinationNode = node;
+    m_reroutes = 0;
+    m_tracker.clearRoute();
+    requestRoute();
+    emit routeChanged();
+    emit vehicleChanged();
+}
+
+void MapView::clearDestination() {
+    m_destinationNode = -1;
+    m_routeRequest = 0;
+    m_routeMetres = 0;
+    m_tracker.clearRoute();
+    update();
+    emit routeChanged();
+    emit vehicleChanged();
+}
+
+void MapView::requestRoute() {
+    m_routeRequest = m_planner->request(m_tracker.nextNode(), quint32(m_destinationNode));
+    m_sinceRouteRequest.start();
+}
+
+void MapView::onRouteReady(quint64 requestId, const RoutingGraph::Route &route, qint64 queryNs) {
+    // Superseded, or the destination was cleared meanwhile
+    if (requestId != m_routeRequest) {
+        return;
+    }
+
+    m_routeRequest = 0;
+    m_routeLatencyMs = m_sinceRouteRequest.nsecsElapsed() / 1e6;
+    m_routeQueryUs = queryNs / 1e3;
+    if (route.isEmpty()) {
+        qWarning() << "MapView: no route to the destination";
+        clearDestination();
+        return;
+    }
+    // The vehicle has left the start of the route while it was planned
+    if (!m_tracker.setRoute(route.nodes)) {
+        requestRoute();
+        return;
+    }
+
+    m_routeTravelTimeMs = route.travelTimeMs;
+    m_routeMetres = m_tracker.remainingRouteMetres();
+    update();
+    emit routeChanged();
+}
+
+void MapView::componentComplete() {
+    QQuickItem::componentComplete();
+    loadMap();
+}
+
+void MapView::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        updateTiles();
+        update();
+        emit vehicleChanged();
+    }
+}
+
+void MapView::loadMap() {
+    struct Result {
+        std::shared_ptr<MapData> map;
+        std::shared_ptr<RoutingGraph> routing;
+        QString error;
+    };
+
+    const quint64 generation = ++m_loadGeneration;
+    m_tickTimer.stop();
+    m_status = Loading;
+    m_errorString.clear();
+    emit statusChanged();
+
+    // Parsing a map and preparing it for routing take too long for the GUI
+    // thread
+    auto result = std::make_shared<Result>();
+    QThread *thread = QThread::create([result, path = m_mapFile] {
+        auto map = std::make_shared<MapData>();
+        if (path.isEmpty()) {
+            *map = MapData::generateCity(GeneratedCitySeed);
+        } else if (!map->load(path, &result->error)) {
+            return;
+        }
+
+        // Contracting a large map takes seconds; use the preprocessed
+        // graph when there is one
+        auto routing = std::make_shared<RoutingGraph>();
+        const QString routingPath = path + RoutingGraphSuffix;
+        QString routingError;
+        if (path.isEmpty() || !QFile::exists(routingPath) || !routing->load(routingPath, *map, &routingError)) {
+            if (!routingError.isEmpty()) {
+                qWarning() << "MapView:" << routingPath << routingError;
+            }
+            *routing = RoutingGraph::build(*map);
+        }
+        result->map = std::move(map);
+        result->routing = std::move(routing);
+    });
+    thread->setObjectName("MapLoader");
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    connect(thread, &QThread::finished, this, [this, result, generation] {
+        // A newer mapFile has been set meanwhile
+        if (generation != m_loadGeneration) {
+            return;
+        }
+        if (!result->map) {
+            qWarning() << "MapView:" << result->error;
+            m_errorString = result->error;
+            m_status = Error;
+            emit statusChanged();
+            return;
+        }
+        setMap(std::move(result->map), std::move(result->routing));
+    });
+    thread->start();
+}
+
+void MapView::setMap(std::shared_ptr<const MapData> map, std::shared_ptr<const RoutingGraph> routing) {
+    m_map = std::move(map);
+    m_routing = std::move(routing);
+    m_planner->setGraph(m_routing);
+    m_destinationNode = -1;
+    m_routeRequest = 0;
+    m_routeMetres = 0;
+    m_cache.clear();
+    m_visible.clear();
+    m_visibleSet.clear();
+    m_prefetched.clear();
+    m_prefetchPlan = 0;
+    m_nodesStale = true;
+
+    // Keyed by the content, so an edited map never shows stale tiles
+    const QString cacheRoot = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    m_loader->setMap(m_map, cacheRoot.isEmpty()
+                                ? QString()
+                                : cacheRoot + QStringLiteral("/map-tiles/") + QString::fromLatin1(m_map->fingerprint()));
+
+    m_tracker.reset(m_map.get(), m_map->bounds().center(), TrackerSeed);
+    m_center = m_followVehicle && m_tracker.isValid() ? m_tracker.position() : m_map->bounds().center();
+
+    m_status = Ready;
+    emit statusChanged();
+    emit routeChanged();
+    emit centerChanged();
+    emit vehicleChanged();
+
+    updateTiles();
+    update();
+    m_sinceTick.start();
+    m_tickTimer.start();
+}
+
+void MapView::tick() {
+    const double seconds = m_sinceTick.restart() / 1000.0;
+    if (m_source && m_tracker.isValid()) {
+        m_tracker.advance(m_source->displaySpeed() / 3.6 * seconds);
+        if (m_followVehicle) {
+            moveCenter(m_tracker.position());
+        }
+        emit vehicleChanged();
+
+        if (m_destinationNode >= 0) {
+            if (m_tracker.arrived()) {
+                clearDestination();
+            } else if (m_tracker.leftRoute() && m_routeRequest == 0) {
+                // Missed a turn: plan again from the next intersection
+                ++m_reroutes;
+                m_tracker.clearRoute();
+                requestRoute();
+                emit routeChanged();
+            }
+            // The route line starts at the vehicle
+            update();
+        }
+    }
+    updateTiles();
+
+    if (m_sinceMetrics.elapsed() >= MetricsIntervalMs) {
+        publishMetrics();
+    }
+}
+
+int MapView::displayLevel() const {
+    return qBound(0, qRound(m_zoom), MapTiles::MaxZoom);
+}
+
+QPointF MapView::toItem(const QPointF &position) const {
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    return QPointF(width() / 2 + (position.x() - m_center.x()) / metresPerPixel,
+                   height() / 2 - (position.y() - m_center.y()) / metresPerPixel);
+}
+
+QPointF MapView::toMap(const QPointF &point) const {
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    return QPointF(m_center.x() + (point.x() - width() / 2) * metresPerPixel,
+                   m_center.y() - (point.y() - height() / 2) * metresPerPixel);
+}
+
+QRectF MapView::viewport(double margin) const {
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    const double halfWidth = width() / 2 * metresPerPixel + margin;
+    const double halfHeight = height() / 2 * metresPerPixel + margin;
+    return QRectF(m_center.x() - halfWidth, m_center.y() - halfHeight, 2 * halfWidth, 2 * halfHeight);
+}
+
+void MapView::updateTiles() {
+    if (!m_map || width() <= 0 || height() <= 0) {
+        return;
+    }
+
+    const int level = displayLevel();
+    const double span = MapTiles::tileSpan(level);
+    const QRectF view = viewport();
+    const QRectF bounds = m_map->bounds();
+    const int west = int(std::floor(view.left() / span));
+    const int east = int(std::floor(view.right() / span));
+    const int north = int(std::floor(-view.bottom() / span));
+    const int south = int(std::floor(-view.top() / span));
+    if ((east - west + 1) * (south - north + 1) > MaxVisibleTiles) {
+        return;
+    }
+
+    std::vector<quint64> visible;
+    QSet<quint64> visibleSet;
+    for (int y = north; y <= south; ++y) {
+        for (int x = west; x <= east; ++x) {
+            const quint64 key = MapTiles::key(level, x, y);
+            // Off the map there is only background
+            if (MapTiles::tileRect(key).intersects(bounds)) {
+                visible.push_back(key);
+                visibleSet.insert(key);
+            }
+        }
+    }
+
+    for (quint64 key : visible) {
+        // object() also marks the tile as recently used
+        const bool cached = m_cache.object(key) != nullptr;
+        if (!m_visibleSet.contains(key)) {
+            ++m_lookups;
+            m_memoryHits += cached ? 1 : 0;
+        }
+        if (!cached) {
+            m_loader->request(key, 0);
+        }
+    }
+    m_visible = std::move(visible);
+    m_visibleSet = std::move(visibleSet);
+
+    updatePrefetch(level);
+    m_loader->retain(m_visibleSet + m_prefetched);
+}
+
+void MapView::updatePrefetch(int level) {
+    const double span = MapTiles::tileSpan(level);
+    const double speedMps = m_source ? m_source->displaySpeed() / 3.6 : 0;
+    const double lookahead = qMin(speedMps * PrefetchSeconds, MaxPrefetchMetres);
+    const QPointF origin = m_tracker.position();
+
+    // Only plan again once the vehicle, its heading or the view changed
+    // enough to need other tiles
+    const size_t plan = qHashMulti(0, m_tracker.isValid(), level, MapTiles::tileAt(level, origin),
+                                   qRound(m_tracker.heading() / 15), int(lookahead / span),
+                                   int(width()), int(height()));
+    if (plan == m_prefetchPlan) {
+        return;
+    }
+    m_prefetchPlan = plan;
+    m_prefetched.clear();
+    if (!m_tracker.isValid()) {
+        return;
+    }
+
+    const int tilesPerMemoryCache = int(m_cache.maxCost() / tileCost(QImage(MapTiles::TileSize, MapTiles::TileSize,
+                                                                              QImage::Format_ARGB32_Premultiplied)));
+    int budget = tilesPerMemoryCache / 2 - int(m_visible.size());
+    const QRectF bounds = m_map->bounds();
+    const double metresPerPixel = MapTiles::metresPerPixel(m_zoom);
+    const QSizeF halfView(width() / 2 * metresPerPixel, height() / 2 * metresPerPixel);
+
+    auto want = [&](int zoom, const QPointF &point, int priority) {
+        const double tileSpan = MapTiles::tileSpan(zoom);
+        const int west = int(std::floor((point.x() - halfView.width()) / tileSpan));
+        const int east = int(std::floor((point.x() + halfView.width()) / tileSpan));
+        const int north = int(std::floor(-(point.y() + halfView.height()) / tileSpan));
+        const int south = int(std::floor(-(point.y() - halfView.height()) / tileSpan));
+        for (int y = north; y <= south && budget > 0; ++y) {
+            for (int x = west; x <= east && budget > 0; ++x) {
+                const quint64 key = MapTiles::key(zoom, x, y);
+                if (m_visibleSet.contains(key) || m_prefetched.contains(key)
+                    || !MapTiles::tileRect(key).intersects(bounds)) {
+                    continue;
+                }
+                m_prefetched.insert(key);
+                --budget;
+                if (!m_cache.contains(key)) {
+                    m_loader->request(key, priority);
+                }
+            }
+        }
+    };
+
+    // The viewport as it will be further down the road, nearest first
+    const double heading = qDegreesToRadians(m_tracker.heading());
+    const QPointF direction(std::sin(heading), std::cos(heading));
+    for (double distance = span / 2; distance <= lookahead && budget > 0; distance += span / 2) {
+        want(level, origin + direction * distance, 1 + int(distance / span));
+    }
+
+    // Zooming in or out around the vehicle
+    if (level > 0) {
+        want(level - 1, origin, AdjacentLevelPriority);
+    }
+    if (level < MapTiles::MaxZoom) {
+        want(level + 1, origin, AdjacentLevelPriority);
+    }
+}
+
+void MapView::onTileReady(quint64 key, const QImage &image, bool fromDisk, qint64 latencyNs, quint64 generation) {
+    // A tile of the map shown before
+    if (generation != m_loader->mapGeneration()) {
+        return;
+    }
+
+    if (fromDisk) {
+        ++m_diskLoads;
+        m_decodeLatency.add(latencyNs / 1e6);
+    } else {
+        ++m_renders;
+        m_renderLatency.add(latencyNs / 1e6);
+    }
+    if (image.isNull()) {
+        return;
+    }
+
+    m_cache.insert(key, new QImage(image), tileCost(image));
+    if (m_visibleSet.contains(key)) {
+        update();
+    }
+}
+
+void MapView::publishMetrics() {
+    m_sinceMetrics.restart();
+    m_pendingTiles = m_loader->pendingCount();
+    emit metricsChanged();
+    if (m_destinationNode >= 0) {
+        // Distance and time left
+        emit routeChanged();
+    }
+}
+
+QSGNode *MapView::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) {
+    // Background, with the tiles in a layer below the route line
+    auto *root = static_cast<QSGSimpleRectNode *>(oldNode);
+    if (!root) {
+        root = new QSGSimpleRectNode(boundingRect(), BackgroundColor);
+        root->appendChildNode(new QSGNode);
+
+        auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        auto *material = new QSGFlatColorMaterial;
+        material->setColor(RouteColor);
+        auto *routeNode = new QSGGeometryNode;
+        routeNode->setGeometry(geometry);
+        routeNode->setFlag(QSGNode::OwnsGeometry);
+        routeNode->setMaterial(material);
+        routeNode->setFlag(QSGNode::OwnsMaterial);
+        root->appendChildNode(routeNode);
+
+        // The previous tile nodes went with the previous root
+        m_nodes.clear();
+        m_nodesStale = false;
+    }
+    root->setRect(boundingRect());
+    QSGNode *tiles = root->firstChild();
+    auto *routeNode = static_cast<QSGGeometryNode *>(root->lastChild());
+
+    if (m_nodesStale) {
+        for (const TileNode &tile : std::as_const(m_nodes)) {
+            delete tile.node;
+        }
+        m_nodes.clear();
+        m_nodesStale = false;
+    }
+
+    const double screenSpan = MapTiles::tileSpan(displayLevel()) / MapTiles::metresPerPixel(m_zoom);
+    for (quint64 key : m_visible) {
+        const int zoom = MapTiles::zoomOf(key);
+        const int x = MapTiles::xOf(key);
+        const int y = MapTiles::yOf(key);
+
+        // Stand in with the nearest ancestor until the tile is loaded
+        int depth = 0;
+        quint64 imageKey = key;
+        const QImage *image = m_cache.object(key);
+        while (!image && depth < FallbackLevels && zoom - depth > 0) {
+            ++depth;
+            imageKey = MapTiles::key(zoom - depth, x >> depth, y >> depth);
+            image = m_cache.object(imageKey);
+        }
+
+        auto tile = m_nodes.find(key);
+        if (tile != m_nodes.end() && (!image || tile->imageKey != imageKey)) {
+            delete tile->node;
+            m_nodes.erase(tile);
+            tile = m_nodes.end();
+        }
+        if (!image) {
+            continue;
+        }
+        if (tile == m_nodes.end()) {
+            QSGImageNode *node = window()->createImageNode();
+            node->setTexture(window()->createTextureFromImage(*image));
+            node->setOwnsTexture(true);
+            node->setFiltering(QSGTexture::Linear);
+            const int size = MapTiles::TileSize >> depth;
+            const int mask = (1 << depth) - 1;
+            node->setSourceRect(QRectF((x & mask) * size, (y & mask) * size, size, size));
+            tiles->appendChildNode(node);
+            tile = m_nodes.insert(key, { node, imageKey });
+        }
+
+        // Rounded edges so neighbouring tiles neither overlap nor leave gaps
+        const QRectF area = MapTiles::tileRect(key);
+        const QPointF topLeft = toItem(QPointF(area.left(), area.bottom()));
+        const qreal left = qRound(topLeft.x());
+        const qreal top = qRound(topLeft.y());
+        tile->node->setRect(QRectF(left, top, qRound(topLeft.x() + screenSpan) - left,
+                                   qRound(topLeft.y() + screenSpan) - top));
+    }
+
+    for (auto it = m_nodes.begin(); it != m_nodes.end();) {
+        if (m_visibleSet.contains(it.key())) {
+            ++it;
+        } else {
+            delete it->node;
+            it = m_nodes.erase(it);
+        }
+    }
+
+    // Route ahead as one quad per segment, from the vehicle on
+    int count = 0;
+    const quint32 *ahead = m_tracker.routeAhead(&count);
+    QSGGeometry *geometry = routeNode->geometry();
+    geometry->allocate(count * 6);
+    QSGGeometry::Point2D *v = geometry->vertexDataAsPoint2D();
+    QPointF from = toItem(m_tracker.position());
+    for (int i = 0; i < count; ++i) {
+        const QPointF to = toItem(m_map->node(ahead[i]));
+        const QPointF d = to - from;
+        const qreal length = std::hypot(d.x(), d.y());
+        const QPointF normal = length > 0 ? QPointF(-d.y(), d.x()) * (RouteHalfWidth / length) : QPointF();
+        const QPointF corners[4] = { from + normal, from - normal, to + normal, to - normal };
+        for (int corner : { 0, 1, 2, 2, 1, 3 }) {
+            (v++)->set(float(corners[corner].x()), float(corners[corner].y()));
+        }
+        from = to;
+    }
+    routeNode->markDirty(QSGNode::DirtyGeometry);
+    return root;
+}
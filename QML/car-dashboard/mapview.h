@@ -0,0 +1,237 @@
+#ifndef MAPVIEW_H
+#define MAPVIEW_H
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include <QSet>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <memory>
+#include <vector>
+#include "mapdata.h"
+#include "maptiles.h"
+#include "routeplanner.h"
+#include "routinggraph.h"
+#include "vehicletracker.h"
+
+class DashboardManager;
+class QSGImageNode;
+
+// Moving map of a local map file for the navigation display.
+//
+// Tiles come from three tiers: decoded images in a memory LRU, PNGs in the
+// on-disk tile cache, and rendering from the map. Everything below the
+// memory cache runs on TileLoader threads, so panning and zooming only
+// look up the cache and queue requests; a missing tile is drawn from a
+// scaled-up ancestor until it arrives.
+//
+// The vehicle is dead-reckoned along the roads at the speed of the source
+// and the tiles ahead of it are prefetched, further ahead the faster it
+// drives. With a destination set it follows the fastest route there, and
+// is re-routed from the next intersection when it misses a turn.
+class MapView : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_MOC_INCLUDE("dashboardmanager.h")
+    Q_PROPERTY(DashboardManager *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(QString mapFile READ mapFile WRITE setMapFile NOTIFY mapFileChanged)
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(QString errorString READ errorString NOTIFY statusChanged)
+    Q_PROPERTY(qreal zoom READ zoom WRITE setZoom NOTIFY zoomChanged)
+    Q_PROPERTY(QPointF center READ center WRITE setCenter NOTIFY centerChanged)
+    Q_PROPERTY(bool followVehicle READ followVehicle WRITE setFollowVehicle NOTIFY followVehicleChanged)
+    Q_PROPERTY(int memoryCacheMB READ memoryCacheMB WRITE setMemoryCacheMB NOTIFY memoryCacheMBChanged)
+
+    Q_PROPERTY(QPointF vehiclePoint READ vehiclePoint NOTIFY vehicleChanged)
+    Q_PROPERTY(qreal vehicleHeading READ vehicleHeading NOTIFY vehicleChanged)
+
+    Q_PROPERTY(bool hasDestination READ hasDestination NOTIFY routeChanged)
+    Q_PROPERTY(QPointF destinationPoint READ destinationPoint NOTIFY vehicleChanged)
+    Q_PROPERTY(qreal routeDistance READ routeDistance NOTIFY routeChanged)
+    Q_PROPERTY(qreal routeTimeSeconds READ routeTimeSeconds NOTIFY routeChanged)
+    Q_PROPERTY(int reroutes READ reroutes NOTIFY routeChanged)
+    Q_PROPERTY(qreal routeLatencyMs READ routeLatencyMs NOTIFY routeChanged)
+    Q_PROPERTY(qreal routeQueryUs READ routeQueryUs NOTIFY routeChanged)
+
+    Q_PROPERTY(qreal memoryHitRate READ memoryHitRate NOTIFY metricsChanged)
+    Q_PROPERTY(qreal diskHitRate READ diskHitRate NOTIFY metricsChanged)
+    Q_PROPERTY(int tilesInMemory READ tilesInMemory NOTIFY metricsChanged)
+    Q_PROPERTY(int pendingTiles READ pendingTiles NOTIFY metricsChanged)
+    Q_PROPERTY(qreal decodeLatencyMs READ decodeLatencyMs NOTIFY metricsChanged)
+    Q_PROPERTY(qreal decodeLatencyP95Ms READ decodeLatencyP95Ms NOTIFY metricsChanged)
+    Q_PROPERTY(qreal renderLatencyMs READ renderLatencyMs NOTIFY metricsChanged)
+    Q_PROPERTY(qreal renderLatencyP95Ms READ renderLatencyP95Ms NOTIFY metricsChanged)
+
+public:
+    enum Status {
+        Null,
+        Loading,
+        Ready,
+        Error
+    };
+    Q_ENUM(Status)
+
+    explicit MapView(QQuickItem *parent = nullptr);
+    ~MapView();
+
+    DashboardManager *source() const;
+    void setSource(DashboardManager *source);
+
+    // Empty shows a generated city
+    QString mapFile() const;
+    void setMapFile(const QString &path);
+
+    Status status() const;
+    QString errorString() const;
+
+    // 0 to MapTiles::MaxZoom, fractional values scale the nearest level
+    qreal zoom() const;
+    void setZoom(qreal zoom);
+
+    // Map position in metres shown in the middle of the item
+    QPointF center() const;
+    void setCenter(const QPointF &center);
+
+    bool followVehicle() const;
+    void setFollowVehicle(bool follow);
+
+    int memoryCacheMB() const;
+    void setMemoryCacheMB(int megabytes);
+
+    // Item coordinates of the vehicle and its compass heading in degrees
+    QPointF vehiclePoint() const;
+    qreal vehicleHeading() const;
+
+    bool hasDestination() const;
+    QPointF destinationPoint() const;
+    // Left to drive on the route, in metres and estimated seconds
+    qreal routeDistance() const;
+    qreal routeTimeSeconds() const;
+    // Routes planned again after a missed turn, since the destination was set
+    int reroutes() const;
+    // Time from asking for the last route to receiving it, and the part of
+    // it spent searching
+    qreal routeLatencyMs() const;
+    qreal routeQueryUs() const;
+
+    // Share of the tiles coming into view that were in memory, and of the
+    // loaded ones that came from the disk cache rather than being rendered
+    qreal memoryHitRate() const;
+    qreal diskHitRate() const;
+    int tilesInMemory() const;
+    int pendingTiles() const;
+    qreal decodeLatencyMs() const;
+    qreal decodeLatencyP95Ms() const;
+    qreal renderLatencyMs() const;
+    qreal renderLatencyP95Ms() const;
+
+    // Moves the map by a drag of (dx, dy) pixels and stops following
+    Q_INVOKABLE void pan(qreal dx, qreal dy);
+    // Zooms by delta levels keeping the map under point in place
+    Q_INVOKABLE void zoomAt(qreal delta, const QPointF &point);
+    Q_INVOKABLE void recenter();
+    // Routes to the road nearest to an item position
+    Q_INVOKABLE void setDestinationAt(const QPointF &point);
+    Q_INVOKABLE void clearDestination();
+
+signals:
+    void sourceChanged();
+    void mapFileChanged();
+    void statusChanged();
+    void zoomChanged();
+    void centerChanged();
+    void followVehicleChanged();
+    void memoryCacheMBChanged();
+    void vehicleChanged();
+    void routeChanged();
+    void metricsChanged();
+
+protected:
+    void componentComplete() override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override;
+
+private:
+    // Rolling window of the latest latencies
+    struct LatencyWindow {
+        void add(double ms);
+        double mean() const;
+        double p95() const;
+
+        std::vector<double> values;
+        std::size_t next = 0;
+    };
+
+    struct TileNode {
+        QSGImageNode *node;
+        quint64 imageKey;       // the tile itself or the ancestor standing in for it
+    };
+
+    void loadMap();
+    void setMap(std::shared_ptr<const MapData> map, std::shared_ptr<const RoutingGraph> routing);
+    void moveCenter(const QPointF &center);
+    void tick();
+    void updateTiles();
+    void updatePrefetch(int level);
+    void onTileReady(quint64 key, const QImage &image, bool fromDisk, qint64 latencyNs, quint64 generation);
+    void requestRoute();
+    void onRouteReady(quint64 requestId, const RoutingGraph::Route &route, qint64 queryNs);
+    void publishMetrics();
+
+    int displayLevel() const;
+    QPointF toItem(const QPointF &position) const;
+    QPointF toMap(const QPointF &point) const;
+    QRectF viewport(double margin = 0) const;
+
+    QPointer<DashboardManager> m_source;
+    QString m_mapFile;
+    Status m_status = Null;
+    QString m_errorString;
+    qreal m_zoom = 5;
+    QPointF m_center;
+    bool m_followVehicle = true;
+
+    std::shared_ptr<const MapData> m_map;
+    quint64 m_loadGeneration = 0;
+    VehicleTracker m_tracker;
+
+    std::shared_ptr<const RoutingGraph> m_routing;
+    std::unique_ptr<RoutePlanner> m_planner;
+    qint64 m_destinationNode = -1;
+    quint64 m_routeRequest = 0;     // 0 when none is outstanding
+    QElapsedTimer m_sinceRouteRequest;
+    quint32 m_routeTravelTimeMs = 0;
+    double m_routeMetres = 0;
+    int m_reroutes = 0;
+    qreal m_routeLatencyMs = 0;
+    qreal m_routeQueryUs = 0;
+
+    std::unique_ptr<TileLoader> m_loader;
+    QCache<quint64, QImage> m_cache;    // cost in KiB
+    std::vector<quint64> m_visible;
+    QSet<quint64> m_visibleSet;
+    QSet<quint64> m_prefetched;
+    size_t m_prefetchPlan = 0;
+
+    QTimer m_tickTimer;
+    QElapsedTimer m_sinceTick;
+    QElapsedTimer m_sinceMetrics;
+
+    qint64 m_lookups = 0;
+    qint64 m_memoryHits = 0;
+    qint64 m_diskLoads = 0;
+    qint64 m_renders = 0;
+    int m_pendingTiles = 0;
+    LatencyWindow m_decodeLatency;
+    LatencyWindow m_renderLatency;
+
+    // Scene graph state, only touched in updatePaintNode()
+    QHash<quint64, TileNode> m_nodes;
+    bool m_nodesStale = false;
+};
+
+#endif // MAPVIEW_H
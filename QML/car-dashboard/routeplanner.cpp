@@ -0,0 +1,64 @@
+#include "routeplanner.h"
+#include <QElapsedTimer>
+
+RoutePlanner::RoutePlanner(QObject *parent)
+    : QObject(parent),
+    m_thread(&RoutePlanner::workerLoop, this)
+{
+}
+
+RoutePlanner::~RoutePlanner() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_pending.reset();
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void RoutePlanner::setGraph(std::shared_ptr<const RoutingGraph> graph) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_graph = std::move(graph);
+    m_pending.reset();
+}
+
+quint64 RoutePlanner::request(quint32 from, quint32 to) {
+    quint64 id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        id = m_nextId++;
+        m_pending = Request{ id, from, to };
+    }
+    m_wake.notify_one();
+    return id;
+}
+
+void RoutePlanner::workerLoop() {
+    std::shared_ptr<const RoutingGraph> graph;
+    std::unique_ptr<RouteQuery> query;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_stopping || m_pending.has_value(); });
+        if (m_stopping) {
+            return;
+        }
+
+        const Request request = *m_pending;
+        m_pending.reset();
+        if (graph != m_graph) {
+            // The search state is sized for one graph
+            graph = m_graph;
+            query = graph ? std::make_unique<RouteQuery>(*graph) : nullptr;
+        }
+        lock.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        const RoutingGraph::Route route = query ? query->route(request.from, request.to) : RoutingGraph::Route();
+        emit routeReady(request.id, route, timer.nsecsElapsed());
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef ROUTEPLANNER_H
+#define ROUTEPLANNER_H
+
+#include <QObject>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "routinggraph.h"
+
+// Answers route requests on a thread of its own, so re-routing never
+// stalls the GUI thread.
+//
+// Only the latest request matters: one that has not started yet when the
+// next arrives is dropped, so a vehicle leaving its route repeatedly does
+// not build up a queue of routes from places it has already passed.
+class RoutePlanner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit RoutePlanner(QObject *parent = nullptr);
+    ~RoutePlanner();
+
+    // Drops a request not started yet
+    void setGraph(std::shared_ptr<const RoutingGraph> graph);
+
+    // Returns the id routeReady() reports the route with
+    quint64 request(quint32 from, quint32 to);
+
+signals:
+    // Emitted from the planner thread; an empty route means the
+    // destination cannot be reached
+    void routeReady(quint64 requestId, const RoutingGraph::Route &route, qint64 queryNs);
+
+private:
+    struct Request {
+        quint64 id;
+        quint32 from;
+        quint32 to;
+    };
+
+    void workerLoop();
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<Request> m_pending;
+    std::shared_ptr<const RoutingGraph> m_graph;
+    quint64 m_nextId = 1;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+#endif // ROUTEPLANNER_H
@@ -0,0 +1,600 @@
+#include "routinggraph.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace {
+
+constexpr quint32 Unreached = UINT_MAX;
+constexpr int EdgeSize = 12;
+
+// Usual speed per MapData::RoadClass, km/h
+const double RoadSpeedsKmh[] = { 100, 60, 50, 30 };
+static_assert(sizeof(RoadSpeedsKmh) / sizeof(RoadSpeedsKmh[0]) == MapData::RoadClassCount,
+              "every road class needs a speed");
+
+// Witness searches give up after this many nodes and then add the shortcut
+// anyway; that only costs an unneeded edge, never a wrong route. Ordering
+// only estimates the shortcuts and gets away with a shorter search.
+constexpr int WitnessSettleLimit = 500;
+constexpr int EstimateSettleLimit = 40;
+
+// Road between two nodes of the graph still being contracted
+struct Arc {
+    quint32 node;
+    quint32 weight;
+    quint32 middle;
+};
+
+class Contraction {
+public:
+    explicit Contraction(const MapData &map);
+
+    // Contraction order: ranks[node]
+    std::vector<quint32> run(std::vector<std::vector<Arc>> &upward,
+                             std::vector<std::vector<Arc>> &downward, int &shortcutCount);
+
+private:
+    struct Shortcut {
+        quint32 from;
+        quint32 to;
+        quint32 weight;
+    };
+
+    void addArc(quint32 from, quint32 to, quint32 weight, quint32 middle);
+    // Shortcuts contracting node would need
+    void shortcutsFor(quint32 node, int settleLimit, std::vector<Shortcut> &shortcuts);
+    int priority(quint32 node);
+    void witnessSearch(quint32 source, quint32 skipped, quint32 limit, int settleLimit);
+    quint32 witnessDistance(quint32 node) const;
+
+    std::vector<std::vector<Arc>> m_out;
+    std::vector<std::vector<Arc>> m_in;
+    std::vector<int> m_contractedNeighbours;
+
+    std::vector<quint32> m_witnessDistance;
+    std::vector<quint32> m_witnessSearchOf;
+    std::vector<std::pair<quint32, quint32>> m_witnessHeap;
+    quint32 m_witnessSearch = 0;
+    std::vector<Shortcut> m_shortcuts;
+};
+
+Contraction::Contraction(const MapData &map)
+    : m_out(std::size_t(map.nodeCount())),
+    m_in(std::size_t(map.nodeCount())),
+    m_contractedNeighbours(std::size_t(map.nodeCount()), 0),
+    m_witnessDistance(std::size_t(map.nodeCount()), Unreached),
+    m_witnessSearchOf(std::size_t(map.nodeCount()), 0)
+{
+    for (quint32 node = 0; node < quint32(map.nodeCount()); ++node) {
+        for (const MapData::Edge *edge = map.edgesBegin(node); edge != map.edgesEnd(node); ++edge) {
+            if (edge->to != node) {
+                addArc(node, edge->to, RoutingGraph::travelTimeMs(map, *edge), UINT_MAX);
+            }
+        }
+    }
+}
+
+void Contraction::addArc(quint32 from, quint32 to, quint32 weight, quint32 middle) {
+    // Parallel roads keep only the fastest
+    for (Arc &arc : m_out[from]) {
+        if (arc.node == to) {
+            if (weight < arc.weight) {
+                arc.weight = weight;
+                arc.middle = middle;
+                for (Arc &reverse : m_in[to]) {
+                    if (reverse.node == from) {
+                        reverse.weight = weight;
+                        reverse.middle = middle;
+                    }
+                }
+            }
+            return;
+        }
+    }
+    m_out[from].push_back({ to, weight, middle });
+    m_in[to].push_back({ from, weight, middle });
+}
+
+quint32 Contraction::witnessDistance(quint32 node) const {
+    return m_witnessSearchOf[node] == m_witnessSearch ? m_witnessDistance[node] : Unreached;
+}
+
+void Contraction::witnessSearch(quint32 source, quint32 skipped, quint32 limit, int settleLimit) {
+    ++m_witnessSearch;
+    m_witnessHeap.clear();
+    m_witnessDistance[source] = 0;
+    m_witnessSearchOf[source] = m_witnessSearch;
+    m_witnessHeap.push_back({ 0, source });
+
+    const auto later = std::greater<std::pair<quint32, quint32>>();
+    int settled = 0;
+    while (!m_witnessHeap.empty() && settled < settleLimit) {
+        std::pop_heap(m_witnessHeap.begin(), m_witnessHeap.end(), later);
+        const auto [distance, node] = m_witnessHeap.back();
+        m_witnessHeap.pop_back();
+        if (distance > witnessDistance(node)) {
+            continue;
+        }
+        if (distance > limit) {
+            break;
+        }
+        ++settled;
+
+        for (const Arc &arc : m_out[node]) {
+            if (arc.node == skipped) {
+                continue;
+            }
+            const quint32 next = distance + arc.weight;
+            if (next < witnessDistance(arc.node)) {
+                m_witnessDistance[arc.node] = next;
+                m_witnessSearchOf[arc.node] = m_witnessSearch;
+                m_witnessHeap.push_back({ next, arc.node });
+                std::push_heap(m_witnessHeap.begin(), m_witnessHeap.end(), later);
+            }
+        }
+    }
+}
+
+void Contraction::shortcutsFor(quint32 node, int settleLimit, std::vector<Shortcut> &shortcuts) {
+    shortcuts.clear();
+    quint32 longestOut = 0;
+    for (const Arc &out : m_out[node]) {
+        longestOut = qMax(longestOut, out.weight);
+    }
+
+    for (const Arc &in : m_in[node]) {
+        witnessSearch(in.node, node, in.weight + longestOut, settleLimit);
+        for (const Arc &out : m_out[node]) {
+            if (out.node == in.node) {
+                continue;
+            }
+            // A path of equal length elsewhere is as good as the one through node
+            const quint32 via = in.weight + out.weight;
+            if (witnessDistance(out.node) > via) {
+                shortcuts.push_back({ in.node, out.node, via });
+            }
+        }
+    }
+}
+
+int Contraction::priority(quint32 node) {
+    // Edge difference, plus the contracted neighbours so that contraction
+    // spreads evenly over the map
+    shortcutsFor(node, EstimateSettleLimit, m_shortcuts);
+    return int(m_shortcuts.size()) - int(m_out[node].size() + m_in[node].size())
+           + m_contractedNeighbours[node];
+}
+
+std::vector<quint32> Contraction::run(std::vector<std::vector<Arc>> &upward,
+                                      std::vector<std::vector<Arc>> &downward, int &shortcutCount) {
+    const std::size_t nodeCount = m_out.size();
+    std::vector<quint32> ranks(nodeCount, Unreached);
+    std::vector<int> priorities(nodeCount);
+    upward.assign(nodeCount, {});
+    downward.assign(nodeCount, {});
+    shortcutCount = 0;
+
+    using Entry = std::pair<int, quint32>;
+    std::vector<Entry> queue;
+    queue.reserve(nodeCount);
+    for (quint32 node = 0; node < nodeCount; ++node) {
+        priorities[node] = priority(node);
+        queue.push_back({ priorities[node], node });
+    }
+    const auto later = std::greater<Entry>();
+    std::make_heap(queue.begin(), queue.end(), later);
+
+    quint32 rank = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), later);
+        const auto [queuedPriority, node] = queue.back();
+        queue.pop_back();
+        if (ranks[node] != Unreached || queuedPriority != priorities[node]) {
+            continue;
+        }
+
+        // Priorities of nodes that were not neighbours of recent
+        // contractions can be out of date too; check before contracting
+        const int current = priority(node);
+        if (!queue.empty() && current > queue.front().first) {
+            priorities[node] = current;
+            queue.push_back({ current, node });
+            std::push_heap(queue.begin(), queue.end(), later);
+            continue;
+        }
+
+        ranks[node] = rank++;
+        upward[node] = m_out[node];
+        downward[node] = m_in[node];
+
+        std::vector<quint32> neighbours;
+        for (const Arc &out : m_out[node]) {
+            auto &in = m_in[out.node];
+            in.erase(std::remove_if(in.begin(), in.end(), [node](const Arc &arc) { return arc.node == node; }),
+                     in.end());
+            neighbours.push_back(out.node);
+        }
+        for (const Arc &in : m_in[node]) {
+            auto &out = m_out[in.node];
+            out.erase(std::remove_if(out.begin(), out.end(), [node](const Arc &arc) { return arc.node == node; }),
+                      out.end());
+            neighbours.push_back(in.node);
+        }
+        shortcutsFor(node, WitnessSettleLimit, m_shortcuts);
+        for (const Shortcut &shortcut : m_shortcuts) {
+            addArc(shortcut.from, shortcut.to, shortcut.weight, node);
+        }
+        shortcutCount += int(m_shortcuts.size());
+        m_out[node] = {};
+        m_in[node] = {};
+
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (quint32 neighbour : neighbours) {
+            ++m_contractedNeighbours[neighbour];
+            priorities[neighbour] = priority(neighbour);
+            queue.push_back({ priorities[neighbour], neighbour });
+            std::push_heap(queue.begin(), queue.end(), later);
+        }
+    }
+    return ranks;
+}
+
+} // namespace
+
+RoutingGraph RoutingGraph::build(const MapData &map) {
+    RoutingGraph graph;
+    graph.m_mapFingerprint = map.fingerprint();
+
+    std::vector<std::vector<Arc>> upward;
+    std::vector<std::vector<Arc>> downward;
+    Contraction contraction(map);
+    graph.m_rankOf = contraction.run(upward, downward, graph.m_shortcutCount);
+
+    const std::size_t nodeCount = graph.m_rankOf.size();
+    graph.m_nodeAt.resize(nodeCount);
+    for (quint32 node = 0; node < nodeCount; ++node) {
+        graph.m_nodeAt[graph.m_rankOf[node]] = node;
+    }
+
+    auto rankOf = [&graph](quint32 node) {
+        return node == UINT_MAX ? NoMiddle : graph.m_rankOf[node];
+    };
+    graph.m_offsets.assign(nodeCount + 1, 0);
+    for (quint32 rank = 0; rank < nodeCount; ++rank) {
+        const quint32 node = graph.m_nodeAt[rank];
+        graph.m_offsets[rank] = quint32(graph.m_edges.size());
+        for (const Arc &arc : upward[node]) {
+            graph.m_edges.push_back({ rankOf(arc.node), arc.weight | Forward, rankOf(arc.middle) });
+        }
+        // A road both ways with the same time and shortcut becomes one edge
+        for (const Arc &arc : downward[node]) {
+            const Edge reverse = { rankOf(arc.node), arc.weight | Backward, rankOf(arc.middle) };
+            auto same = std::find_if(graph.m_edges.begin() + graph.m_offsets[rank], graph.m_edges.end(),
+                                     [&reverse](const Edge &edge) {
+                                         return edge.target == reverse.target && edge.middle == reverse.middle
+                                                && (edge.weight & WeightMask) == (reverse.weight & WeightMask);
+                                     });
+            if (same != graph.m_edges.end()) {
+                same->weight |= Backward;
+            } else {
+                graph.m_edges.push_back(reverse);
+            }
+        }
+    }
+    graph.m_offsets[nodeCount] = quint32(graph.m_edges.size());
+    return graph;
+}
+
+bool RoutingGraph::load(const QString &path, const MapData &map, QString *errorString) {
+    auto fail = [this, errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        *this = RoutingGraph();
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < HeaderSize || std::memcmp(data.constData(), Magic, sizeof(Magic)) != 0) {
+        return fail(QStringLiteral("Not a routing graph file"));
+    }
+
+    const auto *in = reinterpret_cast<const uchar *>(data.constData());
+    if (qFromLittleEndian<quint32>(in + 8) != Version) {
+        return fail(QStringLiteral("Unsupported routing graph version"));
+    }
+    const quint64 nodeCount = qFromLittleEndian<quint32>(in + 12);
+    const quint64 edgeCount = qFromLittleEndian<quint32>(in + 16);
+    const int shortcutCount = int(qFromLittleEndian<quint32>(in + 20));
+    const QByteArray fingerprint(data.constData() + 24, 16);
+    if (fingerprint != map.fingerprint() || nodeCount != quint64(map.nodeCount())) {
+        return fail(QStringLiteral("Routing graph was preprocessed from a different map"));
+    }
+    if (quint64(data.size()) != HeaderSize + nodeCount * 4 + (nodeCount + 1) * 4 + edgeCount * EdgeSize) {
+        return fail(QStringLiteral("Routing graph file is truncated or corrupt"));
+    }
+    in += HeaderSize;
+
+    m_rankOf.resize(std::size_t(nodeCount));
+    m_nodeAt.assign(std::size_t(nodeCount), Unreached);
+    for (quint32 node = 0; node < nodeCount; ++node) {
+        const quint32 rank = qFromLittleEndian<quint32>(in);
+        in += 4;
+        if (rank >= nodeCount || m_nodeAt[rank] != Unreached) {
+            return fail(QStringLiteral("Routing graph has an invalid node order"));
+        }
+        m_rankOf[node] = rank;
+        m_nodeAt[rank] = node;
+    }
+
+    m_offsets.resize(std::size_t(nodeCount + 1));
+    for (quint32 &offset : m_offsets) {
+        offset = qFromLittleEndian<quint32>(in);
+        in += 4;
+    }
+    if (m_offsets.front() != 0 || m_offsets.back() != edgeCount
+        || !std::is_sorted(m_offsets.begin(), m_offsets.end())) {
+        return fail(QStringLiteral("Routing graph has invalid edge offsets"));
+    }
+
+    m_edges.resize(std::size_t(edgeCount));
+    for (quint32 rank = 0; rank < nodeCount; ++rank) {
+        for (quint32 i = m_offsets[rank]; i < m_offsets[rank + 1]; ++i) {
+            Edge &edge = m_edges[i];
+            edge.target = qFromLittleEndian<quint32>(in);
+            edge.weight = qFromLittleEndian<quint32>(in + 4);
+            edge.middle = qFromLittleEndian<quint32>(in + 8);
+            in += EdgeSize;
+            // Edges only lead upwards, and shortcuts bypass a lower node
+            if (edge.target >= nodeCount || edge.target <= rank || !(edge.weight & (Forward | Backward))
+                || (edge.middle != NoMiddle && edge.middle >= rank)) {
+                return fail(QStringLiteral("Routing graph has an invalid edge"));
+            }
+        }
+    }
+
+    m_shortcutCount = shortcutCount;
+    m_mapFingerprint = fingerprint;
+    return true;
+}
+
+bool RoutingGraph::save(const QString &path, QString *errorString) const {
+    const std::size_t nodeCount = m_rankOf.size();
+    QByteArray data(HeaderSize + qsizetype(nodeCount) * 8 + 4 + qsizetype(m_edges.size()) * EdgeSize,
+                    Qt::Uninitialized);
+    auto *out = reinterpret_cast<uchar *>(data.data());
+
+    std::memset(out, 0, HeaderSize);
+    std::memcpy(out, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(Version, out + 8);
+    qToLittleEndian<quint32>(quint32(nodeCount), out + 12);
+    qToLittleEndian<quint32>(quint32(m_edges.size()), out + 16);
+    qToLittleEndian<quint32>(quint32(m_shortcutCount), out + 20);
+    std::memcpy(out + 24, m_mapFingerprint.constData(), std::size_t(qMin<qsizetype>(16, m_mapFingerprint.size())));
+    out += HeaderSize;
+
+    for (quint32 rank : m_rankOf) {
+        qToLittleEndian<quint32>(rank, out);
+        out += 4;
+    }
+    for (quint32 offset : m_offsets) {
+        qToLittleEndian<quint32>(offset, out);
+        out += 4;
+    }
+    for (const Edge &edge : m_edges) {
+        qToLittleEndian<quint32>(edge.target, out);
+        qToLittleEndian<quint32>(edge.weight, out + 4);
+        qToLittleEndian<quint32>(edge.middle, out + 8);
+        out += EdgeSize;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) < 0 || !file.commit()) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+quint32 RoutingGraph::travelTimeMs(const MapData &map, const MapData::Edge &edge) {
+    const double speedMps = RoadSpeedsKmh[map.way(edge.way).roadClass] / 3.6;
+    return qBound<quint32>(1, quint32(edge.length / speedMps * 1000), WeightMask / 1024);
+}
+
+bool RoutingGraph::isEmpty() const {
+    return m_rankOf.empty();
+}
+
+int RoutingGraph::nodeCount() const {
+    return int(m_rankOf.size());
+}
+
+int RoutingGraph::edgeCount() const {
+    return int(m_edges.size());
+}
+
+int RoutingGraph::shortcutCount() const {
+    return m_shortcutCount;
+}
+
+QByteArray RoutingGraph::mapFingerprint() const {
+    return m_mapFingerprint;
+}
+
+const RoutingGraph::Edge *RoutingGraph::arc(quint32 from, quint32 to) const {
+    // Edges are stored at their lower end
+    const bool up = from < to;
+    const quint32 lower = up ? from : to;
+    const quint32 upper = up ? to : from;
+    const quint32 direction = up ? Forward : Backward;
+
+    const Edge *best = nullptr;
+    for (quint32 i = m_offsets[lower]; i < m_offsets[lower + 1]; ++i) {
+        const Edge &edge = m_edges[i];
+        if (edge.target == upper && (edge.weight & direction)
+            && (!best || (edge.weight & WeightMask) < (best->weight & WeightMask))) {
+            best = &edge;
+        }
+    }
+    return best;
+}
+
+void RoutingGraph::unpack(quint32 from, quint32 to, std::vector<quint32> &ranks) const {
+    // Appends the ranks after from up to and including to
+    std::vector<std::pair<quint32, quint32>> stack = { { from, to } };
+    while (!stack.empty()) {
+        const auto [a, b] = stack.back();
+        stack.pop_back();
+        const Edge *edge = arc(a, b);
+        if (!edge || edge->middle == NoMiddle) {
+            ranks.push_back(b);
+        } else {
+            stack.push_back({ edge->middle, b });
+            stack.push_back({ a, edge->middle });
+        }
+    }
+}
+
+RouteQuery::RouteQuery(const RoutingGraph &graph)
+    : m_graph(graph)
+{
+    for (std::vector<Label> &labels : m_labels) {
+        labels.assign(graph.m_rankOf.size(), { Unreached, 0, 0 });
+    }
+}
+
+quint32 RouteQuery::distance(int direction, quint32 rank) const {
+    const Label &label = m_labels[direction][rank];
+    return label.search == m_search ? label.distance : Unreached;
+}
+
+bool RouteQuery::stalled(int direction, quint32 rank, quint32 distance) const {
+    // Reached faster from above through an edge of the other direction:
+    // this label is not the fastest, so nothing found from it can be
+    const quint32 opposite = direction == 0 ? RoutingGraph::Backward : RoutingGraph::Forward;
+    for (quint32 i = m_graph.m_offsets[rank]; i < m_graph.m_offsets[rank + 1]; ++i) {
+        const RoutingGraph::Edge &edge = m_graph.m_edges[i];
+        if ((edge.weight & opposite) != 0) {
+            const quint32 above = this->distance(direction, edge.target);
+            if (above != Unreached && above + (edge.weight & RoutingGraph::WeightMask) < distance) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+RoutingGraph::Route RouteQuery::route(quint32 from, quint32 to) {
+    RoutingGraph::Route route;
+    m_settledNodes = 0;
+    const std::size_t nodeCount = m_graph.m_rankOf.size();
+    if (from >= nodeCount || to >= nodeCount) {
+        return route;
+    }
+    if (from == to) {
+        route.nodes.push_back(from);
+        return route;
+    }
+
+    if (++m_search == 0) {
+        // Wrapped around: old labels could pass for current ones
+        for (std::vector<Label> &labels : m_labels) {
+            std::fill(labels.begin(), labels.end(), Label{ Unreached, 0, 0 });
+        }
+        m_search = 1;
+    }
+
+    const quint32 ends[2] = { m_graph.m_rankOf[from], m_graph.m_rankOf[to] };
+    const auto later = std::greater<HeapEntry>();
+    for (int direction = 0; direction < 2; ++direction) {
+        m_labels[direction][ends[direction]] = { 0, ends[direction], m_search };
+        m_heaps[direction].assign(1, { 0, ends[direction] });
+    }
+
+    quint32 best = Unreached;
+    quint32 meeting = 0;
+    while (!m_heaps[0].empty() || !m_heaps[1].empty()) {
+        // Alternate by advancing the direction that is further behind
+        const int direction = m_heaps[0].empty() ? 1
+                              : m_heaps[1].empty() ? 0
+                              : m_heaps[0].front().first <= m_heaps[1].front().first ? 0 : 1;
+        std::vector<HeapEntry> &heap = m_heaps[direction];
+        if (heap.front().first >= best) {
+            heap.clear();
+            continue;
+        }
+
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const auto [distance, rank] = heap.back();
+        heap.pop_back();
+        if (distance > this->distance(direction, rank)) {
+            continue;
+        }
+        ++m_settledNodes;
+
+        const quint32 other = this->distance(1 - direction, rank);
+        if (other != Unreached && distance + other < best) {
+            best = distance + other;
+            meeting = rank;
+        }
+        if (stalled(direction, rank, distance)) {
+            continue;
+        }
+
+        const quint32 along = direction == 0 ? RoutingGraph::Forward : RoutingGraph::Backward;
+        for (quint32 i = m_graph.m_offsets[rank]; i < m_graph.m_offsets[rank + 1]; ++i) {
+            const RoutingGraph::Edge &edge = m_graph.m_edges[i];
+            if ((edge.weight & along) == 0) {
+                continue;
+            }
+            const quint32 next = distance + (edge.weight & RoutingGraph::WeightMask);
+            if (next < this->distance(direction, edge.target)) {
+                m_labels[direction][edge.target] = { next, rank, m_search };
+                heap.push_back({ next, edge.target });
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+        }
+    }
+    if (best == Unreached) {
+        return route;
+    }
+
+    // Upward path from the start to the meeting node, then down to the
+    // destination, each step unpacked into road segments
+    std::vector<quint32> path;
+    for (quint32 rank = meeting; rank != ends[0]; rank = m_labels[0][rank].parent) {
+        path.push_back(rank);
+    }
+    path.push_back(ends[0]);
+    std::reverse(path.begin(), path.end());
+    for (quint32 rank = meeting; rank != ends[1];) {
+        rank = m_labels[1][rank].parent;
+        path.push_back(rank);
+    }
+
+    std::vector<quint32> ranks = { path.front() };
+    for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+        m_graph.unpack(path[i], path[i + 1], ranks);
+    }
+    route.nodes.reserve(ranks.size());
+    for (quint32 rank : ranks) {
+        route.nodes.push_back(m_graph.m_nodeAt[rank]);
+    }
+    route.travelTimeMs = best;
+    return route;
+}
+
+int RouteQuery::settledNodes() const {
+    return m_settledNodes;
+}
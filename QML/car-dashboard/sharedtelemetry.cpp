@@ -0,0 +1,148 @@
+#include "sharedtelemetry.h"
+#include <new>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedTelemetryChannel::~SharedTelemetryChannel() {
+    close();
+}
+
+bool SharedTelemetryChannel::create(const QString &name, QString *errorString) {
+    return map(name, true, errorString);
+}
+
+bool SharedTelemetryChannel::open(const QString &name, QString *errorString) {
+    return map(name, false, errorString);
+}
+
+#ifdef Q_OS_UNIX
+
+bool SharedTelemetryChannel::map(const QString &name, bool create, QString *errorString) {
+    close();
+
+    const QByteArray nativeName = name.toLocal8Bit();
+    auto fail = [errorString, &nativeName, create](const char *what) {
+        if (errorString) {
+            *errorString = QStringLiteral("%1 %2: %3")
+                               .arg(QLatin1String(what), QString::fromLocal8Bit(nativeName),
+                                    QString::fromLocal8Bit(strerror(errno)));
+        }
+        if (create) {
+            shm_unlink(nativeName.constData());
+        }
+        return false;
+    };
+
+    int fd;
+    if (create) {
+        fd = shm_open(nativeName.constData(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0 && errno == EEXIST) {
+            // Left behind by a producer that crashed. Readers still mapping
+            // it keep the old segment; they must reopen to see this one.
+            shm_unlink(nativeName.constData());
+            fd = shm_open(nativeName.constData(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        }
+    } else {
+        fd = shm_open(nativeName.constData(), O_RDONLY, 0);
+    }
+    if (fd < 0) {
+        return fail(create ? "Cannot create" : "Cannot open");
+    }
+
+    constexpr off_t size = sizeof(SharedTelemetry::Segment);
+    if (create) {
+        if (ftruncate(fd, size) != 0) {
+            ::close(fd);
+            return fail("Cannot size");
+        }
+    } else {
+        struct stat status;
+        if (fstat(fd, &status) != 0 || status.st_size < size) {
+            ::close(fd);
+            errno = EINVAL;
+            return fail("Cannot use");
+        }
+    }
+
+    void *address = mmap(nullptr, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        return fail("Cannot map");
+    }
+
+    auto *segment = static_cast<SharedTelemetry::Segment *>(address);
+    if (create) {
+        // The new mapping is zero-filled, which is a valid empty segment
+        new (segment) SharedTelemetry::Segment;
+        segment->magic = SharedTelemetry::Magic;
+        segment->version = SharedTelemetry::Version;
+        segment->historyCapacity = SharedTelemetry::HistoryCapacity;
+        segment->sampleSize = sizeof(TelemetrySample);
+    } else if (segment->magic != SharedTelemetry::Magic
+               || segment->version != SharedTelemetry::Version
+               || segment->historyCapacity != SharedTelemetry::HistoryCapacity
+               || segment->sampleSize != sizeof(TelemetrySample)) {
+        munmap(address, size);
+        if (errorString) {
+            *errorString = QStringLiteral("%1 is not a compatible telemetry segment").arg(name);
+        }
+        return false;
+    }
+
+    m_segment = segment;
+    m_name = name;
+    m_owner = create;
+    return true;
+}
+
+void SharedTelemetryChannel::close() {
+    if (!m_segment) {
+        return;
+    }
+    munmap(m_segment, sizeof(SharedTelemetry::Segment));
+    if (m_owner) {
+        shm_unlink(m_name.toLocal8Bit().constData());
+    }
+    m_segment = nullptr;
+    m_name.clear();
+    m_owner = false;
+}
+
+#else
+
+bool SharedTelemetryChannel::map(const QString &name, bool create, QString *errorString) {
+    Q_UNUSED(name);
+    Q_UNUSED(create);
+    if (errorString) {
+        *errorString = QStringLiteral("Shared-memory telemetry needs POSIX shared memory");
+    }
+    return false;
+}
+
+void SharedTelemetryChannel::close() {
+}
+
+#endif
+
+bool SharedTelemetryChannel::isOpen() const {
+    return m_segment != nullptr;
+}
+
+QString SharedTelemetryChannel::name() const {
+    return m_name;
+}
+
+void SharedTelemetryChannel::publish(const TelemetrySample &sample) {
+    Q_ASSERT(m_owner);
+    SharedTelemetry::publish(*m_segment, sample);
+}
+
+const SharedTelemetry::Segment *SharedTelemetryChannel::segment() const {
+    return m_segment;
+}
@@ -0,0 +1,158 @@
+#ifndef SHAREDTELEMETRY_H
+#define SHAREDTELEMETRY_H
+
+#include <QString>
+#include <atomic>
+#include <cstring>
+#include "telemetrysample.h"
+
+// Telemetry handed over from another process through a POSIX shared-memory
+// segment, e.g. by the vehicle-interface daemon that owns the sensors.
+//
+// The segment holds the latest sample behind a seqlock and a ring of the
+// most recent samples, each slot tagged with the index of the sample it
+// holds. There is one producer; it never blocks and makes no system calls
+// per sample, and readers never write to the segment, so any number of
+// dashboards can map it read-only. A reader that falls more than a ring
+// behind loses the oldest samples but still sees the latest one.
+namespace SharedTelemetry {
+
+inline constexpr char DefaultName[] = "/car-dashboard-telemetry";
+inline constexpr quint32 Magic = 0x4d544443;       // "CDTM"
+inline constexpr quint32 Version = 1;
+inline constexpr quint32 HistoryCapacity = 4096;
+
+static_assert(std::atomic<quint64>::is_always_lock_free,
+              "shared memory needs address-free 64-bit atomics");
+static_assert(sizeof(TelemetrySample) == 2 * sizeof(quint64),
+              "a sample is copied as two words");
+
+// A sample as two words, so readers copy it with atomic loads while the
+// producer may be writing it
+struct SampleWords {
+    std::atomic<quint64> word[2];
+
+    void store(const TelemetrySample &sample)
+    {
+        quint64 words[2];
+        std::memcpy(words, &sample, sizeof(words));
+        word[0].store(words[0], std::memory_order_relaxed);
+        word[1].store(words[1], std::memory_order_relaxed);
+    }
+
+    TelemetrySample load() const
+    {
+        const quint64 words[2] = { word[0].load(std::memory_order_relaxed),
+                                   word[1].load(std::memory_order_relaxed) };
+        TelemetrySample sample;
+        std::memcpy(&sample, words, sizeof(words));
+        return sample;
+    }
+};
+
+struct HistorySlot {
+    std::atomic<quint64> tag;       // index + 1 of the sample held, 0 while written
+    SampleWords sample;
+};
+
+struct Segment {
+    // Written once by the producer before anything else
+    quint32 magic;
+    quint32 version;
+    quint32 historyCapacity;
+    quint32 sampleSize;
+
+    // Odd while the latest block is being written
+    alignas(64) std::atomic<quint32> latestSequence;
+    std::atomic<quint64> written;   // samples published so far
+    SampleWords latest;
+
+    alignas(64) HistorySlot history[HistoryCapacity];
+};
+
+// Producer side; only one thread of one process may publish
+inline void publish(Segment &segment, const TelemetrySample &sample)
+{
+    const quint64 index = segment.written.load(std::memory_order_relaxed);
+
+    HistorySlot &slot = segment.history[index % HistoryCapacity];
+    slot.tag.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.sample.store(sample);
+    slot.tag.store(index + 1, std::memory_order_release);
+
+    const quint32 sequence = segment.latestSequence.load(std::memory_order_relaxed);
+    segment.latestSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    segment.latest.store(sample);
+    segment.written.store(index + 1, std::memory_order_relaxed);
+    segment.latestSequence.store(sequence + 2, std::memory_order_release);
+}
+
+// The newest sample and the number of samples published up to and
+// including it. Fails only if the producer kept rewriting the block.
+inline bool readLatest(const Segment &segment, TelemetrySample &sample, quint64 &written)
+{
+    for (int attempt = 0; attempt < 64; ++attempt) {
+        const quint32 before = segment.latestSequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        sample = segment.latest.load();
+        written = segment.written.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment.latestSequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sample number index from the ring; fails once it has been overwritten
+inline bool readHistory(const Segment &segment, quint64 index, TelemetrySample &sample)
+{
+    const HistorySlot &slot = segment.history[index % HistoryCapacity];
+    if (slot.tag.load(std::memory_order_acquire) != index + 1) {
+        return false;
+    }
+    sample = slot.sample.load();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.tag.load(std::memory_order_relaxed) == index + 1;
+}
+
+} // namespace SharedTelemetry
+
+// A mapping of the shared telemetry segment: created read-write by the
+// producer, which removes the name again when it closes, or opened
+// read-only by a dashboard.
+class SharedTelemetryChannel {
+public:
+    SharedTelemetryChannel() = default;
+    ~SharedTelemetryChannel();
+
+    SharedTelemetryChannel(const SharedTelemetryChannel &) = delete;
+    SharedTelemetryChannel &operator=(const SharedTelemetryChannel &) = delete;
+
+    // name is a POSIX shared-memory name such as SharedTelemetry::DefaultName
+    bool create(const QString &name, QString *errorString = nullptr);
+    bool open(const QString &name, QString *errorString = nullptr);
+    void close();
+
+    bool isOpen() const;
+    QString name() const;
+
+    // Producer side, after create()
+    void publish(const TelemetrySample &sample);
+
+    // Reader side
+    const SharedTelemetry::Segment *segment() const;
+
+private:
+    bool map(const QString &name, bool create, QString *errorString);
+
+    SharedTelemetry::Segment *m_segment = nullptr;
+    QString m_name;
+    bool m_owner = false;
+};
+
+#endif // SHAREDTELEMETRY_H
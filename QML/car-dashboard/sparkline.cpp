@@ -0,0 +1,181 @@
+#include "sparkline.h"
+#include "dashboardmanager.h"
+#include <QPainter>
+#include <QPolygonF>
+#include <QQuickWindow>
+#include <QtMath>
+
+Sparkline::Sparkline(QQuickItem *parent)
+    : QQuickPaintedItem(parent),
+    m_channel(Speed),
+    m_windowSeconds(60),
+    m_lineColor(Qt::white),
+    m_refreshInterval(100),
+    m_windowEndNs(0)
+{
+    setAntialiasing(true);
+    m_refreshTimer.setSingleShot(true);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &Sparkline::refresh);
+}
+
+DashboardManager *Sparkline::source() const {
+    return m_source;
+}
+
+void Sparkline::setSource(DashboardManager *source) {
+    if (m_source == source) {
+        return;
+    }
+
+    if (m_source) {
+        disconnect(m_source, nullptr, this, nullptr);
+    }
+    m_source = source;
+    if (m_source) {
+        connect(m_source, &DashboardManager::historyChanged, this, &Sparkline::scheduleRefresh);
+    }
+    scheduleRefresh();
+    emit sourceChanged();
+}
+
+Sparkline::Channel Sparkline::channel() const {
+    return m_channel;
+}
+
+void Sparkline::setChannel(Channel channel) {
+    if (m_channel != channel) {
+        m_channel = channel;
+        scheduleRefresh();
+        emit channelChanged();
+    }
+}
+
+qreal Sparkline::windowSeconds() const {
+    return m_windowSeconds;
+}
+
+void Sparkline::setWindowSeconds(qreal seconds) {
+    seconds = qMax<qreal>(0.001, seconds);
+    if (m_windowSeconds != seconds) {
+        m_windowSeconds = seconds;
+        scheduleRefresh();
+        emit windowSecondsChanged();
+    }
+}
+
+QColor Sparkline::lineColor() const {
+    return m_lineColor;
+}
+
+void Sparkline::setLineColor(const QColor &color) {
+    if (m_lineColor != color) {
+        m_lineColor = color;
+        update();
+        emit lineColorChanged();
+    }
+}
+
+int Sparkline::refreshInterval() const {
+    return m_refreshInterval;
+}
+
+void Sparkline::setRefreshInterval(int interval) {
+    interval = qMax(0, interval);
+    if (m_refreshInterval != interval) {
+        m_refreshInterval = interval;
+        emit refreshIntervalChanged();
+    }
+}
+
+int Sparkline::sampleCount() const {
+    return m_stats.count;
+}
+
+qreal Sparkline::minimum() const {
+    return m_stats.minimum;
+}
+
+qreal Sparkline::maximum() const {
+    return m_stats.maximum;
+}
+
+qreal Sparkline::mean() const {
+    return m_stats.mean;
+}
+
+qreal Sparkline::p50() const {
+    return m_stats.p50;
+}
+
+qreal Sparkline::p95() const {
+    return m_stats.p95;
+}
+
+qreal Sparkline::p99() const {
+    return m_stats.p99;
+}
+
+void Sparkline::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickPaintedItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.width() != oldGeometry.width()) {
+        scheduleRefresh();
+    }
+}
+
+void Sparkline::scheduleRefresh() {
+    if (m_refreshTimer.isActive()) {
+        return;
+    }
+
+    // Coalesce history updates into at most one recomputation per interval
+    const qint64 sinceLast = m_sinceRefresh.isValid() ? m_sinceRefresh.elapsed() : m_refreshInterval;
+    m_refreshTimer.start(int(qMax<qint64>(0, m_refreshInterval - sinceLast)));
+}
+
+void Sparkline::refresh() {
+    m_sinceRefresh.start();
+    m_points.clear();
+    m_stats = SignalHistory::WindowStats();
+
+    if (m_source) {
+        const SignalHistory &history =
+            m_source->history().series(TelemetryHistory::Signal(m_channel));
+        if (history.size() > 0) {
+            // The window ends at the newest sample, so replays chart their own time
+            m_windowEndNs = history.timestampAt(history.size() - 1);
+            const int first = history.lowerBound(m_windowEndNs - qint64(m_windowSeconds * 1e9));
+            m_stats = history.aggregate(first, history.size());
+
+            const qreal devicePixelRatio = window() ? window()->effectiveDevicePixelRatio() : 1;
+            const int threshold = qMax(3, qCeil(width() * devicePixelRatio));
+            history.downsample(first, history.size(), threshold, m_points);
+        }
+    }
+
+    update();
+    emit statsChanged();
+}
+
+void Sparkline::paint(QPainter *painter) {
+    if (m_points.size() < 2 || width() <= 0 || height() <= 0) {
+        return;
+    }
+
+    // Scale to the window's range, with a flat line in the middle for a constant signal
+    const qreal low = m_stats.minimum;
+    const qreal span = m_stats.maximum - m_stats.minimum;
+    const qreal windowNs = m_windowSeconds * 1e9;
+    const qreal startNs = qreal(m_windowEndNs) - windowNs;
+
+    QPolygonF line;
+    line.reserve(qsizetype(m_points.size()));
+    for (const SignalHistory::Point &point : m_points) {
+        const qreal x = (qreal(point.timestampNs) - startNs) / windowNs * width();
+        const qreal y = span > 0 ? height() * (1 - (point.value - low) / span) : height() / 2;
+        line.append(QPointF(x, y));
+    }
+
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setPen(QPen(m_lineColor, 1.5));
+    painter->drawPolyline(line);
+}
@@ -0,0 +1,102 @@
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <QColor>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QQuickPaintedItem>
+#include <QTimer>
+#include <QtQml/qqmlregistration.h>
+#include <vector>
+#include "telemetryhistory.h"
+
+class DashboardManager;
+
+// Small line chart of the recent history of one dashboard signal.
+//
+// The window is downsampled with LTTB to one point per device pixel of
+// width, so drawing costs the same for a minute or an hour of data. The
+// rolling statistics of the window are exposed for labels.
+class Sparkline : public QQuickPaintedItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_MOC_INCLUDE("dashboardmanager.h")
+    Q_PROPERTY(DashboardManager *source READ source WRITE setSource NOTIFY sourceChanged)
+    Q_PROPERTY(Channel channel READ channel WRITE setChannel NOTIFY channelChanged)
+    Q_PROPERTY(qreal windowSeconds READ windowSeconds WRITE setWindowSeconds NOTIFY windowSecondsChanged)
+    Q_PROPERTY(QColor lineColor READ lineColor WRITE setLineColor NOTIFY lineColorChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+
+    Q_PROPERTY(int sampleCount READ sampleCount NOTIFY statsChanged)
+    Q_PROPERTY(qreal minimum READ minimum NOTIFY statsChanged)
+    Q_PROPERTY(qreal maximum READ maximum NOTIFY statsChanged)
+    Q_PROPERTY(qreal mean READ mean NOTIFY statsChanged)
+    Q_PROPERTY(qreal p50 READ p50 NOTIFY statsChanged)
+    Q_PROPERTY(qreal p95 READ p95 NOTIFY statsChanged)
+    Q_PROPERTY(qreal p99 READ p99 NOTIFY statsChanged)
+
+public:
+    enum Channel {
+        Speed = TelemetryHistory::Speed,
+        FuelLevel = TelemetryHistory::FuelLevel
+    };
+    Q_ENUM(Channel)
+
+    explicit Sparkline(QQuickItem *parent = nullptr);
+
+    DashboardManager *source() const;
+    void setSource(DashboardManager *source);
+
+    Channel channel() const;
+    void setChannel(Channel channel);
+
+    qreal windowSeconds() const;
+    void setWindowSeconds(qreal seconds);
+
+    QColor lineColor() const;
+    void setLineColor(const QColor &color);
+
+    // Minimum time between two recomputations, in milliseconds
+    int refreshInterval() const;
+    void setRefreshInterval(int interval);
+
+    int sampleCount() const;
+    qreal minimum() const;
+    qreal maximum() const;
+    qreal mean() const;
+    qreal p50() const;
+    qreal p95() const;
+    qreal p99() const;
+
+    void paint(QPainter *painter) override;
+
+signals:
+    void sourceChanged();
+    void channelChanged();
+    void windowSecondsChanged();
+    void lineColorChanged();
+    void refreshIntervalChanged();
+    void statsChanged();
+
+protected:
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    void scheduleRefresh();
+    void refresh();
+
+    QPointer<DashboardManager> m_source;
+    Channel m_channel;
+    qreal m_windowSeconds;
+    QColor m_lineColor;
+    int m_refreshInterval;
+
+    QTimer m_refreshTimer;
+    QElapsedTimer m_sinceRefresh;
+
+    SignalHistory::WindowStats m_stats;
+    qint64 m_windowEndNs;
+    std::vector<SignalHistory::Point> m_points;
+};
+
+#endif // SPARKLINE_H
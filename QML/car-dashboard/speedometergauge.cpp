@@ -0,0 +1,360 @@
+#include "speedometergauge.h"
+#include <QImage>
+#include <QPainter>
+#include <QQuickWindow>
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <QSGImageNode>
+#include <QSGRenderNode>
+#include <QSGRendererInterface>
+#include <QtMath>
+
+namespace {
+
+// Same proportions as the original Canvas gauge
+constexpr qreal DialInset = 10;
+constexpr qreal ArcInset = 50;
+constexpr qreal ArcWidth = 30;
+constexpr qreal StartAngle = M_PI * 0.7;    // clockwise from 3 o'clock
+constexpr qreal SweepAngle = M_PI * 1.6;    // ends at 0.3 * PI
+constexpr int DialSegments = 96;
+constexpr int ArcSegments = 128;
+
+struct GaugeLayout {
+    QPointF center;
+    qreal dialRadius;
+    qreal arcRadius;
+};
+
+GaugeLayout layoutFor(const QSizeF &size) {
+    const qreal half = qMin(size.width(), size.height()) / 2;
+    return { QPointF(size.width() / 2, size.height() / 2),
+             qMax<qreal>(0, half - DialInset),
+             qMax<qreal>(0, half - ArcInset) };
+}
+
+QSGGeometryNode *createFlatColorNode(QSGGeometry::DrawingMode mode, int vertexCount) {
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), vertexCount);
+    geometry->setDrawingMode(mode);
+
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setFlag(QSGNode::OwnsGeometry);
+    node->setMaterial(new QSGFlatColorMaterial);
+    node->setFlag(QSGNode::OwnsMaterial);
+    return node;
+}
+
+void setNodeColor(QSGGeometryNode *node, const QColor &color) {
+    auto *material = static_cast<QSGFlatColorMaterial *>(node->material());
+    if (material->color() != color) {
+        material->setColor(color);
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+}
+
+void fillDisk(QSGGeometryNode *node, const GaugeLayout &layout) {
+    QSGGeometry::Point2D *v = node->geometry()->vertexDataAsPoint2D();
+    const float cx = float(layout.center.x());
+    const float cy = float(layout.center.y());
+    const qreal r = layout.dialRadius;
+
+    for (int i = 0; i < DialSegments; ++i) {
+        const qreal a0 = 2 * M_PI * i / DialSegments;
+        const qreal a1 = 2 * M_PI * (i + 1) / DialSegments;
+        v[3 * i].set(cx, cy);
+        v[3 * i + 1].set(cx + float(r * qCos(a0)), cy + float(r * qSin(a0)));
+        v[3 * i + 2].set(cx + float(r * qCos(a1)), cy + float(r * qSin(a1)));
+    }
+    node->markDirty(QSGNode::DirtyGeometry);
+}
+
+// Thick arc as a triangle strip of outer/inner vertex pairs
+void fillArc(QSGGeometryNode *node, const GaugeLayout &layout, qreal sweep) {
+    QSGGeometry::Point2D *v = node->geometry()->vertexDataAsPoint2D();
+    const float cx = float(layout.center.x());
+    const float cy = float(layout.center.y());
+    const qreal outer = layout.arcRadius + ArcWidth / 2;
+    const qreal inner = qMax<qreal>(0, layout.arcRadius - ArcWidth / 2);
+
+    for (int i = 0; i <= ArcSegments; ++i) {
+        const qreal a = StartAngle + sweep * i / ArcSegments;
+        const qreal c = qCos(a);
+        const qreal s = qSin(a);
+        v[2 * i].set(cx + float(outer * c), cy + float(outer * s));
+        v[2 * i + 1].set(cx + float(inner * c), cy + float(inner * s));
+    }
+    node->markDirty(QSGNode::DirtyGeometry);
+}
+
+class HardwareGaugeNode : public QSGNode {
+public:
+    HardwareGaugeNode()
+        : dial(createFlatColorNode(QSGGeometry::DrawTriangles, 3 * DialSegments)),
+        track(createFlatColorNode(QSGGeometry::DrawTriangleStrip, 2 * (ArcSegments + 1))),
+        active(createFlatColorNode(QSGGeometry::DrawTriangleStrip, 2 * (ArcSegments + 1)))
+    {
+        appendChildNode(dial);
+        appendChildNode(track);
+        appendChildNode(active);
+    }
+
+    QSGGeometryNode *dial;
+    QSGGeometryNode *track;
+    QSGGeometryNode *active;
+};
+
+// Draws the active arc with the software backend's QPainter
+class SoftwareArcNode : public QSGRenderNode {
+public:
+    explicit SoftwareArcNode(QQuickWindow *window)
+        : m_window(window)
+    {
+    }
+
+    void setArc(const GaugeLayout &layout, qreal sweep, const QColor &color) {
+        const qreal r = layout.arcRadius;
+        m_circle = QRectF(layout.center.x() - r, layout.center.y() - r, 2 * r, 2 * r);
+        m_bounds = m_circle.adjusted(-ArcWidth, -ArcWidth, ArcWidth, ArcWidth);
+        m_sweep = sweep;
+        m_color = color;
+        markDirty(QSGNode::DirtyMaterial);
+    }
+
+    void render(const RenderState *state) override {
+        QSGRendererInterface *rif = m_window->rendererInterface();
+        auto *painter = static_cast<QPainter *>(
+            rif->getResource(m_window, QSGRendererInterface::PainterResource));
+        if (!painter || m_sweep <= 0) {
+            return;
+        }
+
+        const QRegion *clipRegion = state->clipRegion();
+        if (clipRegion && !clipRegion->isEmpty()) {
+            painter->setClipRegion(*clipRegion, Qt::ReplaceClip);
+        }
+        painter->setTransform(matrix()->toTransform());
+        painter->setOpacity(inheritedOpacity());
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(QPen(m_color, ArcWidth, Qt::SolidLine, Qt::FlatCap));
+
+        // QPainter angles are counter-clockwise in 1/16th of a degree
+        painter->drawArc(m_circle, qRound(-qRadiansToDegrees(StartAngle) * 16),
+                         qRound(-qRadiansToDegrees(m_sweep) * 16));
+    }
+
+    RenderingFlags flags() const override {
+        return BoundedRectRendering;
+    }
+
+    QRectF rect() const override {
+        return m_bounds;
+    }
+
+private:
+    QQuickWindow *m_window;
+    QRectF m_circle;
+    QRectF m_bounds;
+    qreal m_sweep = 0;
+    QColor m_color;
+};
+
+class SoftwareGaugeNode : public QSGNode {
+public:
+    explicit SoftwareGaugeNode(QQuickWindow *window)
+        : active(new SoftwareArcNode(window))
+    {
+        appendChildNode(active);
+    }
+
+    // Swap in a new texture by replacing the image node that owns it
+    void setStaticLayers(QSGImageNode *node) {
+        if (staticLayers) {
+            removeChildNode(staticLayers);
+            delete staticLayers;
+        }
+        staticLayers = node;
+        prependChildNode(staticLayers);
+    }
+
+    QSGImageNode *staticLayers = nullptr;
+    SoftwareArcNode *active;
+};
+
+} // namespace
+
+SpeedometerGauge::SpeedometerGauge(QQuickItem *parent)
+    : QQuickItem(parent),
+    m_value(0),
+    m_maximumValue(220),
+    m_dialColor("#333"),
+    m_trackColor("#555"),
+    m_activeColor("#00ff00"),
+    m_staticLayersDirty(true),
+    m_activeArcDirty(true)
+{
+    setFlag(ItemHasContents, true);
+}
+
+qreal SpeedometerGauge::value() const {
+    return m_value;
+}
+
+void SpeedometerGauge::setValue(qreal value) {
+    if (!qFuzzyCompare(m_value, value)) {
+        m_value = value;
+        m_activeArcDirty = true;
+        update();
+        emit valueChanged();
+    }
+}
+
+qreal SpeedometerGauge::maximumValue() const {
+    return m_maximumValue;
+}
+
+void SpeedometerGauge::setMaximumValue(qreal maximumValue) {
+    if (!qFuzzyCompare(m_maximumValue, maximumValue)) {
+        m_maximumValue = maximumValue;
+        m_activeArcDirty = true;
+        update();
+        emit maximumValueChanged();
+    }
+}
+
+QColor SpeedometerGauge::dialColor() const {
+    return m_dialColor;
+}
+
+void SpeedometerGauge::setDialColor(const QColor &color) {
+    if (m_dialColor != color) {
+        m_dialColor = color;
+        markStaticLayersDirty();
+        emit dialColorChanged();
+    }
+}
+
+QColor SpeedometerGauge::trackColor() const {
+    return m_trackColor;
+}
+
+void SpeedometerGauge::setTrackColor(const QColor &color) {
+    if (m_trackColor != color) {
+        m_trackColor = color;
+        markStaticLayersDirty();
+        emit trackColorChanged();
+    }
+}
+
+QColor SpeedometerGauge::activeColor() const {
+    return m_activeColor;
+}
+
+void SpeedometerGauge::setActiveColor(const QColor &color) {
+    if (m_activeColor != color) {
+        m_activeColor = color;
+        m_activeArcDirty = true;
+        update();
+        emit activeColorChanged();
+    }
+}
+
+void SpeedometerGauge::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        markStaticLayersDirty();
+    }
+}
+
+qreal SpeedometerGauge::ratio() const {
+    if (m_maximumValue <= 0) {
+        return 0;
+    }
+    return qBound<qreal>(0, m_value / m_maximumValue, 1);
+}
+
+void SpeedometerGauge::markStaticLayersDirty() {
+    m_staticLayersDirty = true;
+    m_activeArcDirty = true;
+    update();
+}
+
+QSGNode *SpeedometerGauge::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) {
+    if (width() <= 0 || height() <= 0) {
+        delete oldNode;
+        m_staticLayersDirty = true;
+        m_activeArcDirty = true;
+        return nullptr;
+    }
+
+    const GaugeLayout layout = layoutFor(size());
+    const qreal sweep = SweepAngle * ratio();
+    const bool software =
+        window()->rendererInterface()->graphicsApi() == QSGRendererInterface::Software;
+
+    if (software) {
+        auto *node = static_cast<SoftwareGaugeNode *>(oldNode);
+        if (!node) {
+            node = new SoftwareGaugeNode(window());
+            m_staticLayersDirty = true;
+            m_activeArcDirty = true;
+        }
+
+        if (m_staticLayersDirty) {
+            // Rasterize dial and track once per size/color change
+            const qreal dpr = window()->effectiveDevicePixelRatio();
+            QImage image((size() * dpr).toSize(), QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(dpr);
+            image.fill(Qt::transparent);
+
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(m_dialColor);
+            painter.drawEllipse(layout.center, layout.dialRadius, layout.dialRadius);
+            painter.setBrush(Qt::NoBrush);
+            painter.setPen(QPen(m_trackColor, ArcWidth, Qt::SolidLine, Qt::FlatCap));
+            const qreal r = layout.arcRadius;
+            painter.drawArc(QRectF(layout.center.x() - r, layout.center.y() - r, 2 * r, 2 * r),
+                            qRound(-qRadiansToDegrees(StartAngle) * 16),
+                            qRound(-qRadiansToDegrees(SweepAngle) * 16));
+            painter.end();
+
+            QSGImageNode *imageNode = window()->createImageNode();
+            imageNode->setTexture(window()->createTextureFromImage(image));
+            imageNode->setOwnsTexture(true);
+            imageNode->setRect(boundingRect());
+            node->setStaticLayers(imageNode);
+        }
+        if (m_activeArcDirty) {
+            node->active->setArc(layout, sweep, m_activeColor);
+        }
+
+        m_staticLayersDirty = false;
+        m_activeArcDirty = false;
+        return node;
+    }
+
+    auto *node = static_cast<HardwareGaugeNode *>(oldNode);
+    if (!node) {
+        node = new HardwareGaugeNode;
+        m_staticLayersDirty = true;
+        m_activeArcDirty = true;
+    }
+
+    if (m_staticLayersDirty) {
+        fillDisk(node->dial, layout);
+        fillArc(node->track, layout, SweepAngle);
+        setNodeColor(node->dial, m_dialColor);
+        setNodeColor(node->track, m_trackColor);
+    }
+    if (m_activeArcDirty) {
+        // The only per-value work: rewrite the active arc's vertices
+        fillArc(node->active, layout, sweep);
+        setNodeColor(node->active, m_activeColor);
+    }
+
+    m_staticLayersDirty = false;
+    m_activeArcDirty = false;
+    return node;
+}
@@ -0,0 +1,68 @@
+#ifndef SPEEDOMETERGAUGE_H
+#define SPEEDOMETERGAUGE_H
+
+#include <QColor>
+#include <QQuickItem>
+#include <QtQml/qqmlregistration.h>
+
+// Scene-graph replacement for the JavaScript Canvas gauge.
+//
+// The dial and the track depend only on the item size and colors and are
+// built once; a value change rewrites the vertices of the active arc and
+// nothing else. With the software backend, which does not draw custom
+// geometry, the static layers are cached in a texture and the active arc is
+// drawn by a small QPainter render node.
+class SpeedometerGauge : public QQuickItem {
+    Q_OBJECT
+    QML_ELEMENT
+    Q_PROPERTY(qreal value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(qreal maximumValue READ maximumValue WRITE setMaximumValue NOTIFY maximumValueChanged)
+    Q_PROPERTY(QColor dialColor READ dialColor WRITE setDialColor NOTIFY dialColorChanged)
+    Q_PROPERTY(QColor trackColor READ trackColor WRITE setTrackColor NOTIFY trackColorChanged)
+    Q_PROPERTY(QColor activeColor READ activeColor WRITE setActiveColor NOTIFY activeColorChanged)
+
+public:
+    explicit SpeedometerGauge(QQuickItem *parent = nullptr);
+
+    qreal value() const;
+    void setValue(qreal value);
+
+    qreal maximumValue() const;
+    void setMaximumValue(qreal maximumValue);
+
+    QColor dialColor() const;
+    void setDialColor(const QColor &color);
+
+    QColor trackColor() const;
+    void setTrackColor(const QColor &color);
+
+    QColor activeColor() const;
+    void setActiveColor(const QColor &color);
+
+signals:
+    void valueChanged();
+    void maximumValueChanged();
+    void dialColorChanged();
+    void trackColorChanged();
+    void activeColorChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    qreal ratio() const;
+    void markStaticLayersDirty();
+
+    qreal m_value;
+    qreal m_maximumValue;
+    QColor m_dialColor;
+    QColor m_trackColor;
+    QColor m_activeColor;
+
+    // Set on the GUI thread, consumed in updatePaintNode() during sync
+    bool m_staticLayersDirty;
+    bool m_activeArcDirty;
+};
+
+#endif // SPEEDOMETERGAUGE_H
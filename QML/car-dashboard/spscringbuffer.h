@@ -0,0 +1,108 @@
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+// Bounded single-producer/single-consumer queue.
+// push() may only be called from one thread and pop() from one other thread;
+// neither side ever blocks or takes a lock. When the queue is full the new
+// element is dropped and counted, so a slow consumer never stalls the producer.
+template <typename T>
+class SpscRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRingBuffer stores plain values");
+
+public:
+    // capacity is rounded up to the next power of two
+    explicit SpscRingBuffer(std::size_t capacity)
+        : m_mask(roundUpToPowerOfTwo(capacity) - 1),
+        m_slots(new T[m_mask + 1])
+    {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer &) = delete;
+    SpscRingBuffer &operator=(const SpscRingBuffer &) = delete;
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    // Producer side. Returns false (and counts an overflow) when full.
+    bool push(const T &value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == capacity()) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == capacity()) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when empty.
+    bool pop(T &value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Hands every queued element to fn and returns how many.
+    template <typename Fn>
+    std::size_t drain(Fn &&fn)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        for (std::size_t i = head; i != tail; ++i) {
+            fn(m_slots[i & m_mask]);
+        }
+        m_head.store(tail, std::memory_order_release);
+        m_cachedTail = tail;
+        return tail - head;
+    }
+
+    // Approximate, may be called from either side.
+    std::size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    // Number of elements rejected by push() because the queue was full.
+    quint64 droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static std::size_t roundUpToPowerOfTwo(std::size_t n)
+    {
+        std::size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const std::size_t m_mask;
+    const std::unique_ptr<T[]> m_slots;
+
+    // Producer and consumer indices live on separate cache lines so the two
+    // threads do not invalidate each other on every operation.
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    std::size_t m_cachedHead = 0;   // producer's last view of m_head
+    std::atomic<quint64> m_dropped{0};
+
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    std::size_t m_cachedTail = 0;   // consumer's last view of m_tail
+};
+
+#endif // SPSCRINGBUFFER_H
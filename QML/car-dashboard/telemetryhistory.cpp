@@ -0,0 +1,436 @@
+#include "telemetryhistory.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TELEMETRYHISTORY_SSE2
+#endif
+
+namespace {
+
+struct Summary {
+    float minimum = std::numeric_limits<float>::infinity();
+    float maximum = -std::numeric_limits<float>::infinity();
+    double sum = 0;
+};
+
+// Min, max and sum of a run of values, four lanes at a time. The sum is
+// accumulated in double so hours of samples do not lose precision.
+void summarize(const float *values, std::size_t count, Summary &summary) {
+    std::size_t i = 0;
+#ifdef TELEMETRYHISTORY_SSE2
+    if (count >= 8) {
+        __m128 minimum = _mm_set1_ps(summary.minimum);
+        __m128 maximum = _mm_set1_ps(summary.maximum);
+        __m128d sumA = _mm_setzero_pd();
+        __m128d sumB = _mm_setzero_pd();
+        __m128d sumC = _mm_setzero_pd();
+        __m128d sumD = _mm_setzero_pd();
+        for (; i + 8 <= count; i += 8) {
+            const __m128 a = _mm_loadu_ps(values + i);
+            const __m128 b = _mm_loadu_ps(values + i + 4);
+            minimum = _mm_min_ps(minimum, _mm_min_ps(a, b));
+            maximum = _mm_max_ps(maximum, _mm_max_ps(a, b));
+            sumA = _mm_add_pd(sumA, _mm_cvtps_pd(a));
+            sumB = _mm_add_pd(sumB, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+            sumC = _mm_add_pd(sumC, _mm_cvtps_pd(b));
+            sumD = _mm_add_pd(sumD, _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+        }
+
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, minimum);
+        summary.minimum = std::min({ lanes[0], lanes[1], lanes[2], lanes[3] });
+        _mm_store_ps(lanes, maximum);
+        summary.maximum = std::max({ lanes[0], lanes[1], lanes[2], lanes[3] });
+
+        alignas(16) double sums[2];
+        _mm_store_pd(sums, _mm_add_pd(_mm_add_pd(sumA, sumB), _mm_add_pd(sumC, sumD)));
+        summary.sum += sums[0] + sums[1];
+    }
+#endif
+    for (; i < count; ++i) {
+        summary.minimum = std::min(summary.minimum, values[i]);
+        summary.maximum = std::max(summary.maximum, values[i]);
+        summary.sum += values[i];
+    }
+}
+
+// Largest-Triangle-Three-Buckets over a contiguous series
+void largestTriangleThreeBuckets(const std::vector<SignalHistory::Point> &points, int threshold,
+                                 std::vector<SignalHistory::Point> &out) {
+    const int count = int(points.size());
+    out.reserve(std::size_t(threshold));
+    out.push_back(points.front());
+
+    // x is time in seconds from the first point, in double so hours of
+    // nanosecond timestamps keep their resolution
+    const qint64 originNs = points.front().timestampNs;
+    auto x = [originNs](qint64 timestampNs) {
+        return double(timestampNs - originNs) * 1e-9;
+    };
+
+    // The first and last points are kept; the rest is split into equal buckets
+    const double bucketSize = double(count - 2) / (threshold - 2);
+    int selected = 0;
+    for (int bucket = 0; bucket < threshold - 2; ++bucket) {
+        const int bucketStart = 1 + int(bucket * bucketSize);
+        const int bucketEnd = 1 + int((bucket + 1) * bucketSize);
+        const int nextEnd = qMin(count - 1, 1 + int((bucket + 2) * bucketSize));
+
+        // Average of the next bucket, or the final point after the last bucket
+        double nextX = x(points.back().timestampNs);
+        double nextY = points.back().value;
+        if (nextEnd > bucketEnd) {
+            double sumX = 0;
+            double sumY = 0;
+            for (int i = bucketEnd; i < nextEnd; ++i) {
+                sumX += x(points[std::size_t(i)].timestampNs);
+                sumY += points[std::size_t(i)].value;
+            }
+            nextX = sumX / (nextEnd - bucketEnd);
+            nextY = sumY / (nextEnd - bucketEnd);
+        }
+
+        // Keep the point forming the largest triangle with the previous
+        // selection and the next bucket's average
+        const double ax = x(points[std::size_t(selected)].timestampNs);
+        const double ay = points[std::size_t(selected)].value;
+        double largestArea = -1;
+        for (int i = bucketStart; i < bucketEnd; ++i) {
+            const SignalHistory::Point &point = points[std::size_t(i)];
+            const double area = std::abs((ax - nextX) * (point.value - ay)
+                                         - (ax - x(point.timestampNs)) * (nextY - ay));
+            if (area > largestArea) {
+                largestArea = area;
+                selected = i;
+            }
+        }
+        out.push_back(points[std::size_t(selected)]);
+    }
+
+    out.push_back(points.back());
+}
+
+} // namespace
+
+SignalHistory::SignalHistory(int capacity)
+    : m_capacity((qMax(1, capacity) + BlockSize - 1) / BlockSize * BlockSize),
+    m_blockCount(m_capacity / BlockSize + 1),
+    m_appended(0)
+{
+}
+
+int SignalHistory::capacity() const {
+    return m_capacity;
+}
+
+int SignalHistory::size() const {
+    return int(m_values.size());
+}
+
+void SignalHistory::clear() {
+    m_timestamps.clear();
+    m_values.clear();
+    m_blocks.clear();
+    m_appended = 0;
+}
+
+void SignalHistory::setCapacity(int capacity) {
+    SignalHistory resized(capacity);
+    for (int index = qMax(0, size() - resized.capacity()); index < size(); ++index) {
+        resized.append(timestampAt(index), valueAt(index));
+    }
+    *this = std::move(resized);
+}
+
+void SignalHistory::reserve() {
+    m_timestamps.reserve(std::size_t(m_capacity));
+    m_values.reserve(std::size_t(m_capacity));
+    m_blocks.reserve(std::size_t(m_blockCount));
+}
+
+void SignalHistory::append(qint64 timestampNs, float value) {
+    const qint64 absolute = m_appended++;
+    const std::size_t index = slot(absolute);
+    if (index == m_values.size()) {
+        m_timestamps.push_back(timestampNs);
+        m_values.push_back(value);
+    } else {
+        m_timestamps[index] = timestampNs;
+        m_values[index] = value;
+    }
+
+    const qint64 number = absolute / BlockSize;
+    const std::size_t blockIndex = std::size_t(number % m_blockCount);
+    if (absolute % BlockSize == 0) {
+        const Block fresh = { value, value, value, absolute, absolute, timestampNs, timestampNs };
+        if (blockIndex == m_blocks.size()) {
+            m_blocks.push_back(fresh);
+        } else {
+            m_blocks[blockIndex] = fresh;
+        }
+        return;
+    }
+
+    Block &current = m_blocks[blockIndex];
+    current.sum += value;
+    if (value < current.minimum) {
+        current.minimum = value;
+        current.minimumIndex = absolute;
+        current.minimumTimestampNs = timestampNs;
+    }
+    if (value > current.maximum) {
+        current.maximum = value;
+        current.maximumIndex = absolute;
+        current.maximumTimestampNs = timestampNs;
+    }
+}
+
+qint64 SignalHistory::timestampAt(int index) const {
+    return m_timestamps[physicalIndex(index)];
+}
+
+float SignalHistory::valueAt(int index) const {
+    return m_values[physicalIndex(index)];
+}
+
+int SignalHistory::lowerBound(qint64 timestampNs) const {
+    int low = 0;
+    int high = size();
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+        if (timestampAt(middle) < timestampNs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+qint64 SignalHistory::baseIndex() const {
+    return m_appended - size();
+}
+
+std::size_t SignalHistory::slot(qint64 absolute) const {
+    return std::size_t(absolute % m_capacity);
+}
+
+std::size_t SignalHistory::physicalIndex(int index) const {
+    // Until the buffer wraps the oldest sample sits in slot 0, afterwards
+    // in the slot that is about to be overwritten next
+    const int oldest = size() < m_capacity ? 0 : int(m_appended % m_capacity);
+    const int physical = oldest + index;
+    return std::size_t(physical >= m_capacity ? physical - m_capacity : physical);
+}
+
+template <typename Fn>
+void SignalHistory::forEachRun(int first, int last, Fn fn) const {
+    if (first >= last) {
+        return;
+    }
+
+    const int start = int(physicalIndex(first));
+    const int count = last - first;
+    const int firstRun = qMin(count, size() - start);
+    fn(m_timestamps.data() + start, m_values.data() + start, firstRun);
+    if (firstRun < count) {
+        fn(m_timestamps.data(), m_values.data(), count - firstRun);
+    }
+}
+
+bool SignalHistory::wholeBlocks(int first, int last, qint64 &firstBlock, qint64 &endBlock) const {
+    const qint64 base = baseIndex();
+    firstBlock = (base + first + BlockSize - 1) / BlockSize;
+    endBlock = (base + last) / BlockSize;
+    return firstBlock < endBlock;
+}
+
+const SignalHistory::Block &SignalHistory::block(qint64 number) const {
+    return m_blocks[std::size_t(number % m_blockCount)];
+}
+
+SignalHistory::WindowStats SignalHistory::aggregate(int first, int last) const {
+    first = qBound(0, first, size());
+    last = qBound(first, last, size());
+
+    WindowStats stats;
+    stats.count = last - first;
+    if (stats.count == 0) {
+        return stats;
+    }
+
+    Summary summary;
+    auto summarizeRuns = [this, &summary](int runFirst, int runLast) {
+        forEachRun(runFirst, runLast, [&summary](const qint64 *, const float *values, int count) {
+            summarize(values, std::size_t(count), summary);
+        });
+    };
+
+    qint64 firstBlock;
+    qint64 endBlock;
+    if (wholeBlocks(first, last, firstBlock, endBlock)) {
+        const qint64 base = baseIndex();
+        summarizeRuns(first, int(firstBlock * BlockSize - base));
+        for (qint64 number = firstBlock; number < endBlock; ++number) {
+            const Block &summaryBlock = block(number);
+            summary.minimum = std::min(summary.minimum, summaryBlock.minimum);
+            summary.maximum = std::max(summary.maximum, summaryBlock.maximum);
+            summary.sum += summaryBlock.sum;
+        }
+        summarizeRuns(int(endBlock * BlockSize - base), last);
+    } else {
+        summarizeRuns(first, last);
+    }
+
+    stats.minimum = summary.minimum;
+    stats.maximum = summary.maximum;
+    stats.mean = summary.sum / stats.count;
+
+    static const double ranks[] = { 0.50, 0.95, 0.99 };
+    float results[3];
+    percentiles(first, last, ranks, results, 3);
+    stats.p50 = results[0];
+    stats.p95 = results[1];
+    stats.p99 = results[2];
+    return stats;
+}
+
+void SignalHistory::percentiles(int first, int last, const double *ranks, float *results, int rankCount) const {
+    const int count = last - first;
+
+    m_scratch.clear();
+    if (count <= ExactPercentileLimit) {
+        forEachRun(first, last, [this](const qint64 *, const float *values, int runCount) {
+            m_scratch.insert(m_scratch.end(), values, values + runCount);
+        });
+    } else {
+        const double stride = double(count) / ExactPercentileLimit;
+        m_scratch.reserve(ExactPercentileLimit);
+        for (int i = 0; i < ExactPercentileLimit; ++i) {
+            m_scratch.push_back(valueAt(first + int(i * stride)));
+        }
+    }
+
+    // Ranks ascend, so each selection only needs to search above the last
+    const int selected = int(m_scratch.size());
+    auto begin = m_scratch.begin();
+    for (int r = 0; r < rankCount; ++r) {
+        const auto nth = m_scratch.begin() + std::ptrdiff_t(ranks[r] * (selected - 1));
+        std::nth_element(begin, nth, m_scratch.end());
+        results[r] = *nth;
+        begin = nth;
+    }
+}
+
+void SignalHistory::downsample(int first, int last, int threshold, std::vector<Point> &out) const {
+    out.clear();
+    first = qBound(0, first, size());
+    last = qBound(first, last, size());
+
+    m_candidates.clear();
+    auto appendRuns = [this](int runFirst, int runLast) {
+        forEachRun(runFirst, runLast, [this](const qint64 *timestamps, const float *values, int count) {
+            for (int i = 0; i < count; ++i) {
+                m_candidates.push_back({ timestamps[i], values[i] });
+            }
+        });
+    };
+
+    // With at least two blocks per output point, the extremes of each block
+    // are all LTTB needs to find the visually important points
+    qint64 firstBlock;
+    qint64 endBlock;
+    if (wholeBlocks(first, last, firstBlock, endBlock) && endBlock - firstBlock >= 2 * qint64(threshold)) {
+        const qint64 base = baseIndex();
+        m_candidates.reserve(std::size_t(2 * (endBlock - firstBlock) + 2 * BlockSize));
+
+        // The range's own first and last samples always anchor the series,
+        // even when they fall inside a whole block
+        const int headEnd = qMax(int(firstBlock * BlockSize - base), first + 1);
+        const int tailStart = qMin(int(endBlock * BlockSize - base), last - 1);
+        auto appendExtreme = [&](qint64 index, qint64 timestampNs, float value) {
+            if (index >= base + headEnd && index < base + tailStart) {
+                m_candidates.push_back({ timestampNs, value });
+            }
+        };
+
+        appendRuns(first, headEnd);
+        for (qint64 number = firstBlock; number < endBlock; ++number) {
+            const Block &extremes = block(number);
+            if (extremes.minimumIndex == extremes.maximumIndex) {
+                appendExtreme(extremes.minimumIndex, extremes.minimumTimestampNs, extremes.minimum);
+            } else if (extremes.minimumIndex < extremes.maximumIndex) {
+                appendExtreme(extremes.minimumIndex, extremes.minimumTimestampNs, extremes.minimum);
+                appendExtreme(extremes.maximumIndex, extremes.maximumTimestampNs, extremes.maximum);
+            } else {
+                appendExtreme(extremes.maximumIndex, extremes.maximumTimestampNs, extremes.maximum);
+                appendExtreme(extremes.minimumIndex, extremes.minimumTimestampNs, extremes.minimum);
+            }
+        }
+        appendRuns(tailStart, last);
+    } else {
+        m_candidates.reserve(std::size_t(last - first));
+        appendRuns(first, last);
+    }
+
+    if (int(m_candidates.size()) <= threshold) {
+        out = m_candidates;
+        return;
+    }
+    if (threshold < 3) {
+        // No bucket between the ends to pick from
+        if (threshold == 2) {
+            out.push_back(m_candidates.front());
+        }
+        if (threshold >= 1) {
+            out.push_back(m_candidates.back());
+        }
+        return;
+    }
+    largestTriangleThreeBuckets(m_candidates, threshold, out);
+}
+
+TelemetryHistory::TelemetryHistory(int capacity)
+    : m_speed(capacity),
+    m_fuelLevel(capacity),
+    m_revision(0)
+{
+}
+
+int TelemetryHistory::capacity() const {
+    return m_speed.capacity();
+}
+
+void TelemetryHistory::setCapacity(int capacity) {
+    m_speed.setCapacity(capacity);
+    m_fuelLevel.setCapacity(capacity);
+    ++m_revision;
+}
+
+void TelemetryHistory::append(const TelemetrySample &sample) {
+    m_speed.append(sample.timestampNs, sample.speed);
+    m_fuelLevel.append(sample.timestampNs, sample.fuelLevel);
+    ++m_revision;
+}
+
+void TelemetryHistory::clear() {
+    m_speed.clear();
+    m_fuelLevel.clear();
+    ++m_revision;
+}
+
+void TelemetryHistory::reserve() {
+    m_speed.reserve();
+    m_fuelLevel.reserve();
+}
+
+const SignalHistory &TelemetryHistory::series(Signal which) const {
+    return which == FuelLevel ? m_fuelLevel : m_speed;
+}
+
+quint64 TelemetryHistory::revision() const {
+    return m_revision;
+}
@@ -0,0 +1,148 @@
+#ifndef TELEMETRYHISTORY_H
+#define TELEMETRYHISTORY_H
+
+#include <QtGlobal>
+#include <vector>
+#include "telemetrysample.h"
+
+// Time-stamped history of one signal in a fixed-capacity ring buffer.
+//
+// Samples are addressed by logical index, 0 being the oldest one still held.
+// Timestamps must not decrease, so a time window maps to an index range
+// through lowerBound(). Storage grows with the data up to the capacity and
+// then the oldest samples are overwritten.
+//
+// Every BlockSize samples also get a min/max/sum summary, kept up to date
+// on append, so queries over long windows scan the summaries and only the
+// partial blocks at either end.
+class SignalHistory {
+public:
+    struct Point {
+        qint64 timestampNs;
+        float value;
+    };
+
+    struct WindowStats {
+        int count = 0;
+        float minimum = 0;
+        float maximum = 0;
+        double mean = 0;
+        float p50 = 0;
+        float p95 = 0;
+        float p99 = 0;
+    };
+
+    static constexpr int BlockSize = 64;
+
+    // capacity is rounded up to a multiple of BlockSize
+    explicit SignalHistory(int capacity);
+
+    int capacity() const;
+    int size() const;
+    void clear();
+
+    // Changes the capacity, keeping the newest samples that still fit
+    void setCapacity(int capacity);
+
+    // Allocates storage for the whole capacity so append() never does.
+    // Pages are only committed as samples are written to them.
+    void reserve();
+
+    void append(qint64 timestampNs, float value);
+
+    qint64 timestampAt(int index) const;
+    float valueAt(int index) const;
+
+    // First logical index whose timestamp is >= timestampNs
+    int lowerBound(qint64 timestampNs) const;
+
+    // Min, max, mean and percentiles of the samples in [first, last).
+    // Percentiles are exact up to ExactPercentileLimit samples and taken
+    // from an evenly spaced subset of that size beyond.
+    WindowStats aggregate(int first, int last) const;
+
+    // Largest-Triangle-Three-Buckets reduction of [first, last) to at most
+    // threshold points, keeping the visual shape of the series. Long ranges
+    // first narrow the candidates down to the minimum and maximum of each
+    // block (MinMaxLTTB), so the cost follows the block count. Below three
+    // points only the ends of the range are kept: both for two, the newest
+    // for one.
+    void downsample(int first, int last, int threshold, std::vector<Point> &out) const;
+
+private:
+    static constexpr int ExactPercentileLimit = 1 << 14;
+
+    // The extremes carry their timestamps so downsampling never has to
+    // touch the samples of a whole block
+    struct Block {
+        float minimum;
+        float maximum;
+        double sum;
+        qint64 minimumIndex;    // absolute sample numbers
+        qint64 maximumIndex;
+        qint64 minimumTimestampNs;
+        qint64 maximumTimestampNs;
+    };
+
+    // Number of the oldest sample held, counting every sample ever appended
+    qint64 baseIndex() const;
+    std::size_t slot(qint64 absolute) const;
+    std::size_t physicalIndex(int index) const;
+
+    // Calls fn(timestamps, values, count) for the one or two contiguous
+    // runs of storage that hold the logical range [first, last)
+    template <typename Fn>
+    void forEachRun(int first, int last, Fn fn) const;
+
+    // Splits [first, last) into whole blocks [firstBlock, endBlock) and the
+    // partial runs before and after them. Returns false if no whole block fits.
+    bool wholeBlocks(int first, int last, qint64 &firstBlock, qint64 &endBlock) const;
+    const Block &block(qint64 number) const;
+
+    void percentiles(int first, int last, const double *ranks, float *results, int rankCount) const;
+
+    int m_capacity;
+    // One block more than the samples need, so the block being filled never
+    // shares a slot with the oldest, partly overwritten one
+    int m_blockCount;
+    qint64 m_appended;
+    std::vector<qint64> m_timestamps;
+    std::vector<float> m_values;
+    std::vector<Block> m_blocks;
+    mutable std::vector<float> m_scratch;
+    mutable std::vector<Point> m_candidates;
+};
+
+// History of the dashboard signals that can be charted
+class TelemetryHistory {
+public:
+    enum Signal {
+        Speed,
+        FuelLevel,
+        SignalCount
+    };
+
+    // About 70 minutes of a 1 kHz feed
+    static constexpr int DefaultCapacity = 1 << 22;
+
+    explicit TelemetryHistory(int capacity = DefaultCapacity);
+
+    int capacity() const;
+    void setCapacity(int capacity);
+
+    void append(const TelemetrySample &sample);
+    void clear();
+    void reserve();
+
+    const SignalHistory &series(Signal which) const;
+
+    // Incremented on every change
+    quint64 revision() const;
+
+private:
+    SignalHistory m_speed;
+    SignalHistory m_fuelLevel;
+    quint64 m_revision;
+};
+
+#endif // TELEMETRYHISTORY_H
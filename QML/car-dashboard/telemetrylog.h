@@ -0,0 +1,66 @@
+#ifndef TELEMETRYLOG_H
+#define TELEMETRYLOG_H
+
+#include <QtEndian>
+#include <cstring>
+#include "telemetrysample.h"
+
+// On-disk layout shared by TelemetryRecorder and TelemetryReplayer.
+//
+// A log is a 32-byte header followed by fixed-size 16-byte records, all
+// little-endian. Fixed records keep the file seekable by binary search on the
+// timestamp, which is what makes seeking in multi-hour captures cheap.
+//
+//   header: magic[8] "DASHTLM\0" | quint32 version | quint32 recordSize
+//           | qint64 startTimestampNs | qint64 reserved
+//   record: qint64 offsetNs (from startTimestampNs) | qint16 speed
+//           | qint8 fuelLevel | quint8 flags | char gear | 3 bytes reserved
+namespace TelemetryLog {
+
+inline constexpr char Magic[8] = {'D', 'A', 'S', 'H', 'T', 'L', 'M', '\0'};
+inline constexpr quint32 Version = 1;
+inline constexpr int HeaderSize = 32;
+inline constexpr int RecordSize = 16;
+
+enum RecordFlag : quint8 {
+    EngineWarningFlag = 0x1
+};
+
+inline void writeHeader(uchar *out, qint64 startTimestampNs)
+{
+    std::memset(out, 0, HeaderSize);
+    std::memcpy(out, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(Version, out + 8);
+    qToLittleEndian<quint32>(RecordSize, out + 12);
+    qToLittleEndian<qint64>(startTimestampNs, out + 16);
+}
+
+inline void writeRecord(uchar *out, const TelemetrySample &sample, qint64 startTimestampNs)
+{
+    std::memset(out, 0, RecordSize);
+    qToLittleEndian<qint64>(sample.timestampNs - startTimestampNs, out);
+    qToLittleEndian<qint16>(sample.speed, out + 8);
+    out[10] = uchar(sample.fuelLevel);
+    out[11] = sample.engineWarning ? EngineWarningFlag : 0;
+    out[12] = uchar(sample.gear);
+}
+
+inline qint64 readRecordOffsetNs(const uchar *in)
+{
+    return qFromLittleEndian<qint64>(in);
+}
+
+inline TelemetrySample readRecord(const uchar *in, qint64 startTimestampNs)
+{
+    TelemetrySample sample;
+    sample.timestampNs = startTimestampNs + readRecordOffsetNs(in);
+    sample.speed = qFromLittleEndian<qint16>(in + 8);
+    sample.fuelLevel = qint8(in[10]);
+    sample.engineWarning = (in[11] & EngineWarningFlag) != 0;
+    sample.gear = char(in[12]);
+    return sample;
+}
+
+} // namespace TelemetryLog
+
+#endif // TELEMETRYLOG_H
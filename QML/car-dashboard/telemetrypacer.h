@@ -0,0 +1,62 @@
+#ifndef TELEMETRYPACER_H
+#define TELEMETRYPACER_H
+
+#include <QThread>
+#include "telemetrysample.h"
+
+// Deadline pacing for telemetry publishers. Samples fall due every period
+// from the start; publishDue() hands out every sample that has come due since
+// the last wake-up and wait() sleeps until the next one. At rates above the
+// sleep granularity this produces small bursts instead of falling behind.
+class TelemetryPacer {
+public:
+    // Samples further behind than this after a stall are skipped instead of
+    // being published in one burst
+    static constexpr qint64 MaxCatchUpNs = 50000000;
+    // Longest single sleep, so a stop request is seen even at 1 Hz
+    static constexpr qint64 MaxSleepSliceNs = 10000000;
+
+    explicit TelemetryPacer(int rateHz)
+        : m_periodNs(1000000000LL / qMax(1, rateHz)),
+        m_nextDueNs(telemetryClockNs())
+    {
+    }
+
+    // Calls publish(dueNs) for every sample due by now, in order, and
+    // returns the number of samples skipped because they were overdue
+    template <typename Publish>
+    qint64 publishDue(Publish &&publish)
+    {
+        const qint64 nowNs = telemetryClockNs();
+        qint64 skipped = 0;
+        if (nowNs - m_nextDueNs > MaxCatchUpNs) {
+            skipped = (nowNs - MaxCatchUpNs - m_nextDueNs) / m_periodNs + 1;
+            m_nextDueNs += skipped * m_periodNs;
+        }
+        while (m_nextDueNs <= nowNs) {
+            publish(m_nextDueNs);
+            m_nextDueNs += m_periodNs;
+        }
+        return skipped;
+    }
+
+    // Sleeps until the next sample is due or stopRequested() returns true,
+    // checking it at least every MaxSleepSliceNs
+    template <typename StopRequested>
+    void wait(StopRequested &&stopRequested) const
+    {
+        for (;;) {
+            const qint64 aheadNs = m_nextDueNs - telemetryClockNs();
+            if (aheadNs <= 0 || stopRequested()) {
+                return;
+            }
+            QThread::usleep(quint64((qMin(aheadNs, MaxSleepSliceNs) + 999) / 1000));
+        }
+    }
+
+private:
+    qint64 m_periodNs;
+    qint64 m_nextDueNs;
+};
+
+#endif // TELEMETRYPACER_H
@@ -0,0 +1,39 @@
+#include "telemetryproducer.h"
+#include "telemetrypacer.h"
+#include "vehiclesimulation.h"
+#include <QRandomGenerator>
+
+TelemetryProducer::TelemetryProducer(TelemetryQueue &queue, int rateHz, quint64 seed, QObject *parent)
+    : QThread(parent),
+    m_queue(queue),
+    m_rateHz(qMax(1, rateHz)),
+    m_seed(seed)
+{
+}
+
+int TelemetryProducer::rateHz() const {
+    return m_rateHz;
+}
+
+quint64 TelemetryProducer::producedSamples() const {
+    return m_produced.load(std::memory_order_relaxed);
+}
+
+void TelemetryProducer::run() {
+    QRandomGenerator rng(m_seed);
+    TelemetrySample sample;
+
+    TelemetryPacer pacer(m_rateHz);
+
+    while (!isInterruptionRequested()) {
+        pacer.publishDue([&](qint64 dueNs) {
+            sample = VehicleSimulation::step(sample, rng);
+            sample.timestampNs = dueNs;
+            // No simulated engine faults, the warning rules raise the lamp
+            sample.engineWarning = false;
+            m_queue.push(sample);
+            m_produced.fetch_add(1, std::memory_order_relaxed);
+        });
+        pacer.wait([this] { return isInterruptionRequested(); });
+    }
+}
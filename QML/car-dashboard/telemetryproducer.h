@@ -0,0 +1,32 @@
+#ifndef TELEMETRYPRODUCER_H
+#define TELEMETRYPRODUCER_H
+
+#include <QThread>
+#include <atomic>
+#include "spscringbuffer.h"
+#include "telemetrysample.h"
+
+using TelemetryQueue = SpscRingBuffer<TelemetrySample>;
+
+// Worker thread that generates simulated telemetry at a fixed rate and pushes
+// it into a TelemetryQueue. It is the only producer of that queue.
+class TelemetryProducer : public QThread {
+    Q_OBJECT
+
+public:
+    TelemetryProducer(TelemetryQueue &queue, int rateHz, quint64 seed, QObject *parent = nullptr);
+
+    int rateHz() const;
+    quint64 producedSamples() const;
+
+protected:
+    void run() override;
+
+private:
+    TelemetryQueue &m_queue;
+    const int m_rateHz;
+    const quint64 m_seed;
+    std::atomic<quint64> m_produced{0};
+};
+
+#endif // TELEMETRYPRODUCER_H
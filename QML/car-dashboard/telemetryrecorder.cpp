@@ -0,0 +1,83 @@
+#include "telemetryrecorder.h"
+#include "telemetrylog.h"
+
+namespace {
+constexpr qsizetype FlushThreshold = 64 * 1024;
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    close();
+}
+
+bool TelemetryRecorder::open(const QString &path, QString *errorString) {
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorString) {
+            *errorString = m_file.errorString();
+        }
+        return false;
+    }
+
+    m_buffer.clear();
+    m_buffer.reserve(FlushThreshold + TelemetryLog::RecordSize);
+    m_recordedSamples = 0;
+    m_headerWritten = false;
+    return true;
+}
+
+void TelemetryRecorder::close() {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    // An empty capture still gets a valid header
+    if (!m_headerWritten) {
+        m_startTimestampNs = telemetryClockNs();
+        m_buffer.prepend(QByteArray(TelemetryLog::HeaderSize, '\0'));
+        TelemetryLog::writeHeader(reinterpret_cast<uchar *>(m_buffer.data()), m_startTimestampNs);
+        m_headerWritten = true;
+    }
+    flush();
+    m_file.close();
+}
+
+bool TelemetryRecorder::isOpen() const {
+    return m_file.isOpen();
+}
+
+void TelemetryRecorder::append(const TelemetrySample &sample) {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    // The first sample defines the time origin of the log
+    if (!m_headerWritten) {
+        m_startTimestampNs = sample.timestampNs;
+        m_buffer.resize(TelemetryLog::HeaderSize);
+        TelemetryLog::writeHeader(reinterpret_cast<uchar *>(m_buffer.data()), m_startTimestampNs);
+        m_headerWritten = true;
+    }
+
+    const qsizetype offset = m_buffer.size();
+    m_buffer.resize(offset + TelemetryLog::RecordSize);
+    TelemetryLog::writeRecord(reinterpret_cast<uchar *>(m_buffer.data() + offset),
+                              sample, m_startTimestampNs);
+    ++m_recordedSamples;
+
+    if (m_buffer.size() >= FlushThreshold) {
+        flush();
+    }
+}
+
+qint64 TelemetryRecorder::recordedSamples() const {
+    return m_recordedSamples;
+}
+
+void TelemetryRecorder::flush() {
+    if (!m_buffer.isEmpty()) {
+        m_file.write(m_buffer);
+        m_buffer.resize(0);
+    }
+}
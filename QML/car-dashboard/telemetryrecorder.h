@@ -0,0 +1,36 @@
+#ifndef TELEMETRYRECORDER_H
+#define TELEMETRYRECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include "telemetrysample.h"
+
+// Appends timestamped samples to a binary telemetry log (see telemetrylog.h).
+// Records are batched in memory and written in large chunks, so append() is
+// cheap enough to call for every sample of a kHz feed on the GUI thread.
+class TelemetryRecorder {
+public:
+    TelemetryRecorder() = default;
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder &) = delete;
+    TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+    bool open(const QString &path, QString *errorString = nullptr);
+    void close();
+    bool isOpen() const;
+
+    void append(const TelemetrySample &sample);
+    qint64 recordedSamples() const;
+
+private:
+    void flush();
+
+    QFile m_file;
+    QByteArray m_buffer;
+    qint64 m_startTimestampNs = 0;
+    qint64 m_recordedSamples = 0;
+    bool m_headerWritten = false;
+};
+
+#endif // TELEMETRYRECORDER_H
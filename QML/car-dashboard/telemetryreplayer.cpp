@@ -0,0 +1,200 @@
+#include "telemetryreplayer.h"
+#include "telemetrylog.h"
+#include <cmath>
+
+namespace {
+// Timed replay tick, comfortably above the display refresh rate
+constexpr int ReplayTickMs = 4;
+// Records emitted per event-loop pass in as-fast-as-possible mode
+constexpr qint64 UnthrottledBatch = 4096;
+}
+
+TelemetryReplayer::TelemetryReplayer(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &TelemetryReplayer::advance);
+}
+
+TelemetryReplayer::~TelemetryReplayer() {
+    close();
+}
+
+bool TelemetryReplayer::open(const QString &path, QString *errorString) {
+    close();
+
+    auto fail = [this, errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        close();
+        return false;
+    };
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+    if (m_file.size() < TelemetryLog::HeaderSize) {
+        return fail(QStringLiteral("File is too small to be a telemetry log"));
+    }
+
+    const uchar *data = m_file.map(0, m_file.size());
+    if (!data) {
+        return fail(m_file.errorString());
+    }
+
+    if (std::memcmp(data, TelemetryLog::Magic, sizeof(TelemetryLog::Magic)) != 0) {
+        return fail(QStringLiteral("Not a telemetry log"));
+    }
+    if (qFromLittleEndian<quint32>(data + 8) != TelemetryLog::Version
+        || qFromLittleEndian<quint32>(data + 12) != quint32(TelemetryLog::RecordSize)) {
+        return fail(QStringLiteral("Unsupported telemetry log version"));
+    }
+
+    m_startTimestampNs = qFromLittleEndian<qint64>(data + 16);
+    m_records = data + TelemetryLog::HeaderSize;
+    // A partially written last record (e.g. after a crash) is ignored
+    m_sampleCount = (m_file.size() - TelemetryLog::HeaderSize) / TelemetryLog::RecordSize;
+    m_nextIndex = 0;
+    m_playStartOffsetNs = m_sampleCount > 0 ? offsetNsAt(0) : 0;
+    return true;
+}
+
+void TelemetryReplayer::close() {
+    m_timer.stop();
+    if (m_records) {
+        m_file.unmap(const_cast<uchar *>(m_records - TelemetryLog::HeaderSize));
+    }
+    m_file.close();
+    m_records = nullptr;
+    m_sampleCount = 0;
+    m_nextIndex = 0;
+}
+
+bool TelemetryReplayer::isOpen() const {
+    return m_records != nullptr;
+}
+
+qint64 TelemetryReplayer::sampleCount() const {
+    return m_sampleCount;
+}
+
+qint64 TelemetryReplayer::durationMs() const {
+    if (m_sampleCount == 0) {
+        return 0;
+    }
+    return (offsetNsAt(m_sampleCount - 1) - offsetNsAt(0)) / 1000000;
+}
+
+qint64 TelemetryReplayer::positionMs() const {
+    if (m_sampleCount == 0) {
+        return 0;
+    }
+    const qint64 index = qMin(m_nextIndex, m_sampleCount - 1);
+    return (offsetNsAt(index) - offsetNsAt(0)) / 1000000;
+}
+
+bool TelemetryReplayer::isPlaying() const {
+    return m_timer.isActive();
+}
+
+double TelemetryReplayer::speed() const {
+    return m_speed;
+}
+
+void TelemetryReplayer::setSpeed(double speed) {
+    speed = qMax(0.0, speed);
+    if (qFuzzyCompare(m_speed + 1.0, speed + 1.0)) {
+        return;
+    }
+
+    const bool playing = isPlaying();
+    if (playing) {
+        pause();
+    }
+    m_speed = speed;
+    if (playing) {
+        play();
+    }
+}
+
+TelemetrySample TelemetryReplayer::sampleAt(qint64 index) const {
+    Q_ASSERT(index >= 0 && index < m_sampleCount);
+    return TelemetryLog::readRecord(m_records + index * TelemetryLog::RecordSize, m_startTimestampNs);
+}
+
+void TelemetryReplayer::play() {
+    if (!isOpen() || isPlaying() || m_nextIndex >= m_sampleCount) {
+        return;
+    }
+
+    m_playStartOffsetNs = offsetNsAt(m_nextIndex);
+    m_playClock.start();
+    m_timer.start(m_speed > 0.0 ? ReplayTickMs : 0);
+}
+
+void TelemetryReplayer::pause() {
+    m_timer.stop();
+}
+
+void TelemetryReplayer::seek(qint64 positionMs) {
+    if (!isOpen() || m_sampleCount == 0) {
+        return;
+    }
+
+    const bool playing = isPlaying();
+    m_timer.stop();
+
+    m_nextIndex = indexAtOrAfter(offsetNsAt(0) + qMax<qint64>(0, positionMs) * 1000000);
+    if (m_nextIndex < m_sampleCount) {
+        // Show the state at the new position right away, even when paused
+        emit sampleReplayed(sampleAt(m_nextIndex));
+    }
+
+    if (playing) {
+        play();
+    }
+}
+
+void TelemetryReplayer::advance() {
+    if (m_speed <= 0.0) {
+        const qint64 end = qMin(m_nextIndex + UnthrottledBatch, m_sampleCount);
+        for (; m_nextIndex < end; ++m_nextIndex) {
+            emit sampleReplayed(sampleAt(m_nextIndex));
+        }
+    } else {
+        // Everything up to the current replay time is due; only the newest
+        // due record is visible, so that is the one that gets emitted.
+        const qint64 elapsedNs = qint64(std::llround(double(m_playClock.nsecsElapsed()) * m_speed));
+        const qint64 due = indexAtOrAfter(m_playStartOffsetNs + elapsedNs + 1);
+        if (due > m_nextIndex) {
+            m_nextIndex = due;
+            emit sampleReplayed(sampleAt(due - 1));
+        }
+    }
+
+    if (m_nextIndex >= m_sampleCount) {
+        m_timer.stop();
+        emit finished();
+    }
+}
+
+qint64 TelemetryReplayer::offsetNsAt(qint64 index) const {
+    return TelemetryLog::readRecordOffsetNs(m_records + index * TelemetryLog::RecordSize);
+}
+
+qint64 TelemetryReplayer::indexAtOrAfter(qint64 offsetNs) const {
+    // First record whose offset is >= offsetNs, records are in time order
+    qint64 low = 0;
+    qint64 high = m_sampleCount;
+    while (low < high) {
+        const qint64 mid = low + (high - low) / 2;
+        if (offsetNsAt(mid) < offsetNs) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
@@ -0,0 +1,64 @@
+#ifndef TELEMETRYREPLAYER_H
+#define TELEMETRYREPLAYER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QObject>
+#include <QTimer>
+#include "telemetrysample.h"
+
+// Plays back a binary telemetry log (see telemetrylog.h) from a memory
+// mapping, so opening a multi-hour capture costs nothing up front and seeking
+// is a binary search over the fixed-size records.
+//
+// speed 1.0 replays in real time, N replays N times faster and 0 replays as
+// fast as possible, emitting every record in order.
+class TelemetryReplayer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TelemetryReplayer(QObject *parent = nullptr);
+    ~TelemetryReplayer();
+
+    bool open(const QString &path, QString *errorString = nullptr);
+    void close();
+    bool isOpen() const;
+
+    qint64 sampleCount() const;
+    qint64 durationMs() const;
+    qint64 positionMs() const;
+    bool isPlaying() const;
+
+    double speed() const;
+    void setSpeed(double speed);
+
+    TelemetrySample sampleAt(qint64 index) const;
+
+public slots:
+    void play();
+    void pause();
+    void seek(qint64 positionMs);
+
+signals:
+    // In timed modes only the newest due record of each tick is emitted.
+    void sampleReplayed(const TelemetrySample &sample);
+    void finished();
+
+private:
+    void advance();
+    qint64 offsetNsAt(qint64 index) const;
+    qint64 indexAtOrAfter(qint64 offsetNs) const;
+
+    QFile m_file;
+    const uchar *m_records = nullptr;
+    qint64 m_sampleCount = 0;
+    qint64 m_startTimestampNs = 0;
+
+    double m_speed = 1.0;
+    qint64 m_nextIndex = 0;
+    qint64 m_playStartOffsetNs = 0;   // log position when m_playClock started
+    QElapsedTimer m_playClock;
+    QTimer m_timer;
+};
+
+#endif // TELEMETRYREPLAYER_H
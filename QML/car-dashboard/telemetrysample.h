@@ -0,0 +1,24 @@
+#ifndef TELEMETRYSAMPLE_H
+#define TELEMETRYSAMPLE_H
+
+#include <QtGlobal>
+#include <chrono>
+
+// One snapshot of the vehicle signals the dashboard displays.
+// Kept trivially copyable so it can travel through lock-free queues.
+struct TelemetrySample {
+    qint64 timestampNs = 0;     // telemetryClockNs() at the time of capture
+    qint16 speed = 0;           // km/h, 0..220
+    qint8 fuelLevel = 100;      // percent, 0..100
+    bool engineWarning = false;
+    char gear = 'P';            // one of 'P', 'R', 'N', 'D'
+};
+
+// Monotonic clock shared by every thread that stamps samples.
+inline qint64 telemetryClockNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif // TELEMETRYSAMPLE_H
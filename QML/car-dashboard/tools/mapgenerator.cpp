@@ -0,0 +1,38 @@
+// Writes a generated city in the map file format of the navigation
+// display, for `appcar-dashboard --map` and for trying map sizes.
+//
+//   map-generator [--seed <n>] [--size <m>] <file>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "mapdata.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption seedOption("seed", "Seed of the generated city.", "n", "1");
+    QCommandLineOption sizeOption("size", "Width and height of the city in metres.", "m", "6000");
+    parser.addOption(seedOption);
+    parser.addOption(sizeOption);
+    parser.addPositionalArgument("file", "Map file to write.");
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+
+    const MapData map = MapData::generateCity(parser.value(seedOption).toULongLong(),
+                                              qMax(500.0, parser.value(sizeOption).toDouble()));
+    QString error;
+    if (!map.save(parser.positionalArguments().constFirst(), &error)) {
+        qCritical("%s", qPrintable(error));
+        return 1;
+    }
+
+    qInfo("%d nodes, %d ways, fingerprint %s",
+          map.nodeCount(), map.wayCount(), map.fingerprint().constData());
+    return 0;
+}
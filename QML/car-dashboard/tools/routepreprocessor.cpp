@@ -0,0 +1,51 @@
+// Contracts the road graph of a map file into the routing graph the
+// navigation display loads with it, so opening a large map does not wait
+// for the contraction.
+//
+//   route-preprocessor <map> [<output>]
+//
+// The output defaults to <map>.route, which is where the dashboard looks.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include "mapdata.h"
+#include "routinggraph.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("map", "Map file to preprocess.");
+    parser.addPositionalArgument("output", "Routing graph to write, <map>.route by default.", "[output]");
+    parser.process(app);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty() || arguments.size() > 2) {
+        parser.showHelp(1);
+    }
+    const QString mapPath = arguments.constFirst();
+    const QString outputPath = arguments.size() > 1 ? arguments.at(1) : mapPath + QStringLiteral(".route");
+
+    MapData map;
+    QString error;
+    if (!map.load(mapPath, &error)) {
+        qCritical("%s: %s", qPrintable(mapPath), qPrintable(error));
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const RoutingGraph graph = RoutingGraph::build(map);
+    const qint64 buildMs = timer.elapsed();
+
+    if (!graph.save(outputPath, &error)) {
+        qCritical("%s: %s", qPrintable(outputPath), qPrintable(error));
+        return 1;
+    }
+    qInfo("%d nodes, %d edges, %d shortcuts added, contracted in %lld ms",
+          graph.nodeCount(), graph.edgeCount(), graph.shortcutCount(), buildMs);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Stand-in for the vehicle-interface daemon: publishes simulated telemetry
+// into the shared-memory segment that `appcar-dashboard --shm-input` reads.
+//
+//   telemetry-shm-producer [--rate <hz>] [--name <name>] [--duration <s>]
+//
+// The segment is removed again on exit, including Ctrl+C.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <atomic>
+#include <csignal>
+#include "sharedtelemetry.h"
+#include "telemetrypacer.h"
+#include "vehiclesimulation.h"
+
+namespace {
+
+std::atomic<bool> stopRequested{false};
+
+void requestStop(int)
+{
+    stopRequested.store(true, std::memory_order_relaxed);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption rateOption("rate", "Samples published per second.", "hz", "1000");
+    QCommandLineOption nameOption("name", "Shared-memory segment name.", "name",
+                                  QString::fromLatin1(SharedTelemetry::DefaultName));
+    QCommandLineOption durationOption("duration", "Seconds to run, 0 to run until interrupted.", "s", "0");
+    parser.addOption(rateOption);
+    parser.addOption(nameOption);
+    parser.addOption(durationOption);
+    parser.process(app);
+
+    const int rateHz = qMax(1, parser.value(rateOption).toInt());
+    const qint64 durationNs = qMax(0LL, parser.value(durationOption).toLongLong()) * 1000000000;
+
+    SharedTelemetryChannel channel;
+    QString error;
+    if (!channel.create(parser.value(nameOption), &error)) {
+        qCritical("%s", qPrintable(error));
+        return 1;
+    }
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    qInfo("Publishing %d samples/s to %s", rateHz, qPrintable(channel.name()));
+
+    // Paced like TelemetryProducer
+    QRandomGenerator rng(QRandomGenerator::global()->generate64());
+    TelemetrySample sample;
+    const qint64 startNs = telemetryClockNs();
+    TelemetryPacer pacer(rateHz);
+    quint64 published = 0;
+    qint64 skipped = 0;
+
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        if (durationNs > 0 && telemetryClockNs() - startNs >= durationNs) {
+            break;
+        }
+        skipped += pacer.publishDue([&](qint64) {
+            sample = VehicleSimulation::step(sample, rng);
+            // No simulated engine faults, the dashboard's rules raise the lamp
+            sample.engineWarning = false;
+            // Stamped at publication, so readers measure the handover alone
+            sample.timestampNs = telemetryClockNs();
+            channel.publish(sample);
+            ++published;
+        });
+        pacer.wait([] { return stopRequested.load(std::memory_order_relaxed); });
+    }
+
+    qInfo("Published %llu samples, skipped %lld after stalls", published, skipped);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#ifndef VEHICLESIMULATION_H
+#define VEHICLESIMULATION_H
+
+#include "telemetrysample.h"
+
+// The driving rules used by DashboardManager::simulateDriving(), shared with
+// the background telemetry producer so both generate the same kind of data.
+namespace VehicleSimulation {
+
+inline constexpr int MaxSpeed = 220;
+inline constexpr char Gears[] = {'P', 'R', 'N', 'D'};
+
+// Small random stream for simulating many vehicles independently: 8 bytes of
+// state instead of QRandomGenerator's ~2.5 KB, with the same bounded() API.
+// SplitMix64 output, reduced to a range with Lemire's multiply-shift.
+class RandomStream {
+public:
+    explicit RandomStream(quint64 seed = 0) : m_state(seed) {}
+
+    quint64 next()
+    {
+        quint64 z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // [0, highest)
+    int bounded(int highest)
+    {
+        return int((quint64(quint32(next())) * quint64(highest)) >> 32);
+    }
+
+    // [lowest, highest)
+    int bounded(int lowest, int highest)
+    {
+        return lowest + bounded(highest - lowest);
+    }
+
+private:
+    quint64 m_state;
+};
+
+// Rng needs QRandomGenerator's bounded(lowest, highest) and bounded(highest).
+template <typename Rng>
+TelemetrySample step(const TelemetrySample &previous, Rng &rng)
+{
+    TelemetrySample next = previous;
+
+    // Simulate some random driving conditions
+    const int newSpeed = previous.speed + rng.bounded(-10, 15);
+    next.speed = qint16(qBound(0, newSpeed, MaxSpeed));
+
+    // Simulate fuel consumption
+    if (newSpeed > 0) {
+        next.fuelLevel = qint8(qBound(0, previous.fuelLevel - newSpeed / 20, 100));
+    }
+
+    // Random engine warning
+    if (rng.bounded(100) < 5) {
+        next.engineWarning = true;
+    }
+
+    // Gear shifting simulation
+    if (rng.bounded(100) < 10) {
+        next.gear = Gears[rng.bounded(int(sizeof(Gears)))];
+    }
+
+    return next;
+}
+
+// Continuous vehicle state for fixed-timestep simulation
+struct ContinuousState {
+    double speed = 0;           // km/h
+    double fuelLevel = 100;     // percent
+    double acceleration = 0;    // km/h per second
+    double untilDecision = 0;   // seconds until the next random decision
+    bool engineWarning = false;
+    char gear = 'P';
+};
+
+// Advances state by dt seconds. The random decisions of step() are still
+// taken once per simulated second; speed and fuel change smoothly in between
+// instead of jumping, so the rules give the same rates at any tick rate.
+template <typename Rng>
+void advance(ContinuousState &state, double dt, Rng &rng)
+{
+    state.untilDecision -= dt;
+    if (state.untilDecision <= 0) {
+        state.untilDecision += 1.0;
+        state.acceleration = rng.bounded(-10, 15);
+
+        if (rng.bounded(100) < 5) {
+            state.engineWarning = true;
+        }
+        if (rng.bounded(100) < 10) {
+            state.gear = Gears[rng.bounded(int(sizeof(Gears)))];
+        }
+    }
+
+    state.speed = qBound(0.0, state.speed + state.acceleration * dt, double(MaxSpeed));
+    if (state.speed > 0) {
+        state.fuelLevel = qBound(0.0, state.fuelLevel - state.speed / 20 * dt, 100.0);
+    }
+}
+
+} // namespace VehicleSimulation
+
+#endif // VEHICLESIMULATION_H
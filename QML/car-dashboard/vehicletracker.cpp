@@ -0,0 +1,201 @@
+#include "vehicletracker.h"
+#include <QtMath>
+#include <cmath>
+
+namespace {
+// Chance to keep the straightest way on at an intersection
+constexpr int StraightOnPercent = 70;
+// Chance to drive straight on where the route turns
+constexpr int MissedTurnPercent = 10;
+}
+
+void VehicleTracker::reset(const MapData *map, const QPointF &start, quint64 seed) {
+    m_map = nullptr;
+    clearRoute();
+    m_rng = VehicleSimulation::RandomStream(seed);
+    if (!map) {
+        return;
+    }
+
+    const qint64 node = map->nearestNode(start);
+    if (node < 0 || map->edgesBegin(quint32(node)) == map->edgesEnd(quint32(node))) {
+        return;
+    }
+    m_map = map;
+    enterEdge(quint32(node), *map->edgesBegin(quint32(node)));
+}
+
+bool VehicleTracker::isValid() const {
+    return m_map != nullptr;
+}
+
+void VehicleTracker::enterEdge(quint32 from, const MapData::Edge &edge) {
+    m_from = from;
+    m_to = edge.to;
+    m_along = 0;
+    m_length = edge.length;
+}
+
+const MapData::Edge *VehicleTracker::chooseNext() const {
+    const MapData::Edge *begin = m_map->edgesBegin(m_to);
+    const MapData::Edge *end = m_map->edgesEnd(m_to);
+    const int count = int(end - begin);
+    if (count == 0) {
+        return nullptr;
+    }
+
+    const QPointF here = m_map->node(m_to);
+    const QPointF incoming = here - m_map->node(m_from);
+    const MapData::Edge *straightest = nullptr;
+    double bestCosine = -2;
+    int forward = 0;
+    for (const MapData::Edge *edge = begin; edge != end; ++edge) {
+        if (edge->to == m_from || edge->length <= 0) {
+            continue;
+        }
+        ++forward;
+        const QPointF outgoing = m_map->node(edge->to) - here;
+        const double cosine = QPointF::dotProduct(incoming, outgoing)
+            / (std::hypot(incoming.x(), incoming.y()) * edge->length + 1e-9);
+        if (cosine > bestCosine) {
+            bestCosine = cosine;
+            straightest = edge;
+        }
+    }
+    if (!m_route.empty() && m_routeIndex + 1 < m_route.size()) {
+        const quint32 planned = m_route[m_routeIndex + 1];
+        for (const MapData::Edge *edge = begin; edge != end; ++edge) {
+            if (edge->to == planned) {
+                return edge == straightest || !straightest || m_rng.bounded(100) >= MissedTurnPercent
+                    ? edge
+                    : straightest;
+            }
+        }
+    }
+    if (forward == 0) {
+        // Dead end: turn around
+        for (const MapData::Edge *edge = begin; edge != end; ++edge) {
+            if (edge->length > 0) {
+                return edge;
+            }
+        }
+        return nullptr;
+    }
+    if (m_rng.bounded(100) < StraightOnPercent) {
+        return straightest;
+    }
+
+    int pick = m_rng.bounded(forward);
+    for (const MapData::Edge *edge = begin; edge != end; ++edge) {
+        if (edge->to != m_from && edge->length > 0 && pick-- == 0) {
+            return edge;
+        }
+    }
+    return straightest;
+}
+
+void VehicleTracker::advance(double metres) {
+    if (!m_map || metres <= 0) {
+        return;
+    }
+
+    m_along += metres;
+    // Bounded, so a huge step cannot spin here
+    for (int edges = 0; m_along >= m_length && edges < 1000; ++edges) {
+        const MapData::Edge *next = chooseNext();
+        if (!next) {
+            m_along = m_length;
+            return;
+        }
+        const double remaining = m_along - m_length;
+        if (!m_route.empty()) {
+            if (m_routeIndex + 1 >= m_route.size()) {
+                m_arrived = true;
+                m_route.clear();
+            } else if (next->to == m_route[m_routeIndex + 1]) {
+                ++m_routeIndex;
+            } else {
+                m_leftRoute = true;
+                m_route.clear();
+            }
+        }
+        enterEdge(m_to, *next);
+        m_along = remaining;
+    }
+}
+
+QPointF VehicleTracker::position() const {
+    if (!m_map) {
+        return QPointF();
+    }
+    const QPointF from = m_map->node(m_from);
+    const QPointF to = m_map->node(m_to);
+    const double t = m_length > 0 ? qBound(0.0, m_along / m_length, 1.0) : 0;
+    return from + (to - from) * t;
+}
+
+double VehicleTracker::heading() const {
+    if (!m_map) {
+        return 0;
+    }
+    const QPointF d = m_map->node(m_to) - m_map->node(m_from);
+    const double degrees = qRadiansToDegrees(std::atan2(d.x(), d.y()));
+    return degrees < 0 ? degrees + 360 : degrees;
+}
+
+quint32 VehicleTracker::nextNode() const {
+    return m_to;
+}
+
+bool VehicleTracker::setRoute(const std::vector<quint32> &route) {
+    clearRoute();
+    if (!m_map) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < route.size(); ++i) {
+        if (route[i] == m_to && (i == 0 || route[i - 1] == m_from)) {
+            m_route = route;
+            m_routeIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VehicleTracker::clearRoute() {
+    m_route.clear();
+    m_routeIndex = 0;
+    m_arrived = false;
+    m_leftRoute = false;
+}
+
+bool VehicleTracker::hasRoute() const {
+    return !m_route.empty();
+}
+
+const quint32 *VehicleTracker::routeAhead(int *count) const {
+    *count = m_route.empty() ? 0 : int(m_route.size() - m_routeIndex);
+    return m_route.empty() ? nullptr : m_route.data() + m_routeIndex;
+}
+
+double VehicleTracker::remainingRouteMetres() const {
+    if (m_route.empty()) {
+        return 0;
+    }
+
+    double metres = qMax(0.0, m_length - m_along);
+    for (std::size_t i = m_routeIndex; i + 1 < m_route.size(); ++i) {
+        const QPointF d = m_map->node(m_route[i + 1]) - m_map->node(m_route[i]);
+        metres += std::hypot(d.x(), d.y());
+    }
+    return metres;
+}
+
+bool VehicleTracker::arrived() const {
+    return m_arrived;
+}
+
+bool VehicleTracker::leftRoute() const {
+    return m_leftRoute;
+}
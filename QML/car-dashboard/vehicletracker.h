@@ -0,0 +1,67 @@
+#ifndef VEHICLETRACKER_H
+#define VEHICLETRACKER_H
+
+#include <QPointF>
+#include <vector>
+#include "mapdata.h"
+#include "vehiclesimulation.h"
+
+// Dead-reckons the vehicle along the road network of a MapData.
+//
+// The telemetry carries speed but no position, so the vehicle is placed on
+// the road nearest to a start point and moved along the edges by the
+// distance it covers. At an intersection it mostly keeps straight on and
+// otherwise turns onto a random road, avoiding U-turns unless the road
+// ends.
+//
+// Given a route it follows the route instead, except that now and then it
+// misses a turn the way a driver does; the route is then dropped and
+// leftRoute() tells the caller to plan a new one.
+class VehicleTracker {
+public:
+    VehicleTracker() = default;
+
+    // map must outlive the tracker or the next reset()
+    void reset(const MapData *map, const QPointF &start, quint64 seed);
+    bool isValid() const;
+
+    void advance(double metres);
+
+    QPointF position() const;
+    // Compass heading of travel in degrees, 0 north and 90 east
+    double heading() const;
+    // Node at the end of the road the vehicle is on, where a new route
+    // has to start
+    quint32 nextNode() const;
+
+    // route runs through nextNode(), or through the road the vehicle is on;
+    // false if it does neither
+    bool setRoute(const std::vector<quint32> &route);
+    void clearRoute();
+    bool hasRoute() const;
+    // Route ahead of the vehicle, starting with nextNode()
+    const quint32 *routeAhead(int *count) const;
+    double remainingRouteMetres() const;
+    // Set when the vehicle reaches the end of the route or turns off it,
+    // until the next setRoute() or clearRoute()
+    bool arrived() const;
+    bool leftRoute() const;
+
+private:
+    void enterEdge(quint32 from, const MapData::Edge &edge);
+    const MapData::Edge *chooseNext() const;
+
+    const MapData *m_map = nullptr;
+    quint32 m_from = 0;
+    quint32 m_to = 0;
+    double m_along = 0;
+    double m_length = 0;
+
+    std::vector<quint32> m_route;
+    std::size_t m_routeIndex = 0;     // of m_to
+    bool m_arrived = false;
+    bool m_leftRoute = false;
+    mutable VehicleSimulation::RandomStream m_rng;
+};
+
+#endif // VEHICLETRACKER_H
@@ -0,0 +1,127 @@
+#include "warningindicatormodel.h"
+#include <QMetaObject>
+
+WarningIndicatorModel::WarningIndicatorModel(QObject *parent)
+    : QAbstractListModel(parent),
+    m_bits(0),
+    m_publishPending(false),
+    m_publishedBits(0)
+{
+}
+
+int WarningIndicatorModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : int(m_names.size());
+}
+
+QVariant WarningIndicatorModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_names.size()) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case NameRole:
+        return m_names.at(index.row());
+    case ActiveRole:
+        return isActive(index.row());
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> WarningIndicatorModel::roleNames() const {
+    return {
+        { NameRole, "name" },
+        { ActiveRole, "active" }
+    };
+}
+
+QStringList WarningIndicatorModel::names() const {
+    return m_names;
+}
+
+void WarningIndicatorModel::setNames(const QStringList &names) {
+    const QStringList trimmed = names.mid(0, MaxIndicators);
+    if (trimmed == m_names) {
+        return;
+    }
+
+    const bool countChanges = trimmed.size() != m_names.size();
+    beginResetModel();
+    m_names = trimmed;
+    // Bits of the old lamps do not describe the new ones
+    m_bits.store(0, std::memory_order_relaxed);
+    m_publishedBits = 0;
+    endResetModel();
+    if (countChanges) {
+        emit countChanged();
+    }
+}
+
+quint64 WarningIndicatorModel::bits() const {
+    return m_bits.load(std::memory_order_acquire);
+}
+
+void WarningIndicatorModel::setBits(quint64 bits) {
+    if (m_bits.exchange(bits, std::memory_order_acq_rel) != bits) {
+        schedulePublish();
+    }
+}
+
+void WarningIndicatorModel::storeBits(quint64 bits) {
+    m_bits.store(bits, std::memory_order_release);
+}
+
+void WarningIndicatorModel::setIndicator(int index, bool active) {
+    if (index < 0 || index >= MaxIndicators) {
+        return;
+    }
+
+    const quint64 bit = quint64(1) << index;
+    const quint64 previous = active ? m_bits.fetch_or(bit, std::memory_order_acq_rel)
+                                    : m_bits.fetch_and(~bit, std::memory_order_acq_rel);
+    if (((previous & bit) != 0) != active) {
+        schedulePublish();
+    }
+}
+
+quint64 WarningIndicatorModel::publishedBits() const {
+    return m_publishedBits;
+}
+
+bool WarningIndicatorModel::isActive(int index) const {
+    return index >= 0 && index < MaxIndicators && (m_publishedBits >> index) & 1;
+}
+
+void WarningIndicatorModel::schedulePublish() {
+    // One queued call covers every update until it runs
+    if (!m_publishPending.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, &WarningIndicatorModel::publishChanges, Qt::QueuedConnection);
+    }
+}
+
+void WarningIndicatorModel::publishChanges() {
+    // Cleared before reading, so an update racing with this call schedules another
+    m_publishPending.store(false, std::memory_order_release);
+
+    const quint64 bits = m_bits.load(std::memory_order_acquire);
+    const quint64 changed = bits ^ m_publishedBits;
+    if (changed == 0) {
+        return;
+    }
+    m_publishedBits = bits;
+
+    // One dataChanged per run of adjacent changed lamps. The roles list is
+    // shared, not built per emission.
+    static const QList<int> roles = { ActiveRole };
+    const int rows = int(m_names.size());
+    quint64 remaining = rows < MaxIndicators ? changed & ((quint64(1) << rows) - 1) : changed;
+    while (remaining) {
+        const int first = qCountTrailingZeroBits(remaining);
+        const int length = qCountTrailingZeroBits(~(remaining >> first));
+        emit dataChanged(index(first), index(first + length - 1), roles);
+        remaining &= length + first >= 64 ? 0 : ~quint64(0) << (first + length);
+    }
+
+    emit indicatorsChanged(changed);
+}
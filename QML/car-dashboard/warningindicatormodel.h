@@ -0,0 +1,73 @@
+#ifndef WARNINGINDICATORMODEL_H
+#define WARNINGINDICATORMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+
+// Warning lamps of the instrument cluster, one row per named lamp.
+//
+// All lamp states live in one 64-bit word that any thread may update
+// atomically. Updates are published on the model's thread by a single
+// queued call, however many arrive in between: it emits
+// indicatorsChanged() once with the mask of lamps that changed and
+// dataChanged for each run of changed rows, so views only touch those
+// lamps.
+class WarningIndicatorModel : public QAbstractListModel {
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Use DashboardManager.warningIndicators")
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    static constexpr int MaxIndicators = 64;
+
+    enum Roles {
+        NameRole = Qt::UserRole + 1,
+        ActiveRole
+    };
+    Q_ENUM(Roles)
+
+    explicit WarningIndicatorModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Lamp names in bit order; extra names beyond MaxIndicators are dropped
+    QStringList names() const;
+    void setNames(const QStringList &names);
+
+    // Thread-safe. Views see the new state once publishChanges() has run.
+    quint64 bits() const;
+    void setBits(quint64 bits);
+    void setIndicator(int index, bool active);
+
+    // As setBits(), but leaves the publishing to the caller. Posting the
+    // queued publish allocates an event, which a caller that publishes on
+    // its own schedule can do without.
+    void storeBits(quint64 bits);
+
+    // State as last announced to views
+    quint64 publishedBits() const;
+    Q_INVOKABLE bool isActive(int index) const;
+
+    // Announces everything changed since the last publish. Called
+    // automatically after an update; safe to call early, e.g. once per frame.
+    void publishChanges();
+
+signals:
+    void indicatorsChanged(quint64 changedMask);
+    void countChanged();
+
+private:
+    void schedulePublish();
+
+    QStringList m_names;
+    std::atomic<quint64> m_bits;
+    std::atomic<bool> m_publishPending;
+    quint64 m_publishedBits;
+};
+
+#endif // WARNINGINDICATORMODEL_H
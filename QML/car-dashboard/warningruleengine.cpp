@@ -0,0 +1,513 @@
+#include "warningruleengine.h"
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+
+namespace {
+
+// Deep enough for any expression a person would write in a rules file
+constexpr int MaxStackDepth = 64;
+
+const char *const SignalNames[] = { "speed", "fuelLevel", "gear", "acceleration", "engineFault" };
+static_assert(sizeof(SignalNames) / sizeof(SignalNames[0]) == WarningRuleEngine::SignalCount,
+              "every signal needs a name");
+
+// Recursive-descent compiler from an expression string to postfix
+// instructions. Precedence, loosest first: ||, &&, comparisons, + -, * /,
+// unary ! and -.
+class ExpressionCompiler {
+public:
+    using Instruction = WarningRuleEngine::Instruction;
+
+    ExpressionCompiler(QString source, const QHash<QString, int> &rules,
+                       std::vector<Instruction> &code)
+        : m_source(std::move(source)),
+        m_rules(rules),
+        m_code(code)
+    {
+    }
+
+    // Returns the stack depth the expression needs, or -1 with error set
+    int compile(QString *error) {
+        m_position = 0;
+        m_depth = 0;
+        m_maxDepth = 0;
+        m_error.clear();
+
+        parseOr();
+        skipSpaces();
+        if (m_error.isEmpty() && m_position < m_source.size()) {
+            fail(QStringLiteral("unexpected '%1'").arg(m_source.at(m_position)));
+        }
+        if (m_error.isEmpty() && m_maxDepth > MaxStackDepth) {
+            fail(QStringLiteral("expression is nested too deeply"));
+        }
+        if (!m_error.isEmpty()) {
+            *error = m_error;
+            return -1;
+        }
+        return m_maxDepth;
+    }
+
+private:
+    void parseOr() {
+        parseAnd();
+        while (m_error.isEmpty() && accept("||")) {
+            parseAnd();
+            emitBinary(WarningRuleEngine::Or);
+        }
+    }
+
+    void parseAnd() {
+        parseComparison();
+        while (m_error.isEmpty() && accept("&&")) {
+            parseComparison();
+            emitBinary(WarningRuleEngine::And);
+        }
+    }
+
+    void parseComparison() {
+        parseSum();
+        // Two-character operators first so "<=" is not read as "<"
+        static const struct {
+            const char *token;
+            WarningRuleEngine::Opcode opcode;
+        } operators[] = {
+            { "<=", WarningRuleEngine::LessOrEqual },
+            { ">=", WarningRuleEngine::GreaterOrEqual },
+            { "==", WarningRuleEngine::Equal },
+            { "!=", WarningRuleEngine::NotEqual },
+            { "<", WarningRuleEngine::Less },
+            { ">", WarningRuleEngine::Greater },
+        };
+        while (m_error.isEmpty()) {
+            bool matched = false;
+            for (const auto &op : operators) {
+                if (accept(op.token)) {
+                    parseSum();
+                    emitBinary(op.opcode);
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                return;
+            }
+        }
+    }
+
+    void parseSum() {
+        parseProduct();
+        while (m_error.isEmpty()) {
+            if (accept("+")) {
+                parseProduct();
+                emitBinary(WarningRuleEngine::Add);
+            } else if (accept("-")) {
+                parseProduct();
+                emitBinary(WarningRuleEngine::Subtract);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void parseProduct() {
+        parseUnary();
+        while (m_error.isEmpty()) {
+            if (accept("*")) {
+                parseUnary();
+                emitBinary(WarningRuleEngine::Multiply);
+            } else if (accept("/")) {
+                parseUnary();
+                emitBinary(WarningRuleEngine::Divide);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void parseUnary() {
+        if (peek("!=")) {
+            fail(QStringLiteral("expected an operand before '!='"));
+        } else if (accept("!")) {
+            parseUnary();
+            emitUnary(WarningRuleEngine::Not);
+        } else if (accept("-")) {
+            parseUnary();
+            emitUnary(WarningRuleEngine::Negate);
+        } else {
+            parsePrimary();
+        }
+    }
+
+    void parsePrimary() {
+        skipSpaces();
+        if (m_position >= m_source.size()) {
+            fail(QStringLiteral("unexpected end of expression"));
+            return;
+        }
+
+        const QChar c = m_source.at(m_position);
+        if (accept("(")) {
+            parseOr();
+            if (m_error.isEmpty() && !accept(")")) {
+                fail(QStringLiteral("expected ')'"));
+            }
+        } else if (c.isDigit() || c == QLatin1Char('.')) {
+            const int start = m_position;
+            while (m_position < m_source.size()
+                   && (m_source.at(m_position).isDigit() || m_source.at(m_position) == QLatin1Char('.'))) {
+                ++m_position;
+            }
+            bool ok = false;
+            const float value = m_source.mid(start, m_position - start).toFloat(&ok);
+            if (!ok) {
+                fail(QStringLiteral("invalid number"));
+                return;
+            }
+            emitPush(WarningRuleEngine::PushConstant, 0, value);
+        } else if (c == QLatin1Char('\'')) {
+            // Gear letters compare as their character codes
+            if (m_position + 2 >= m_source.size() || m_source.at(m_position + 2) != QLatin1Char('\'')) {
+                fail(QStringLiteral("expected a one-letter gear such as 'D'"));
+                return;
+            }
+            emitPush(WarningRuleEngine::PushConstant, 0, float(m_source.at(m_position + 1).toLatin1()));
+            m_position += 3;
+        } else if (c.isLetter() || c == QLatin1Char('_')) {
+            const int start = m_position;
+            while (m_position < m_source.size()
+                   && (m_source.at(m_position).isLetterOrNumber() || m_source.at(m_position) == QLatin1Char('_'))) {
+                ++m_position;
+            }
+            resolveName(m_source.mid(start, m_position - start));
+        } else {
+            fail(QStringLiteral("unexpected '%1'").arg(c));
+        }
+    }
+
+    void resolveName(const QString &name) {
+        if (name == QLatin1String("true") || name == QLatin1String("false")) {
+            emitPush(WarningRuleEngine::PushConstant, 0, name == QLatin1String("true") ? 1 : 0);
+            return;
+        }
+        for (int i = 0; i < WarningRuleEngine::SignalCount; ++i) {
+            if (name == QLatin1String(SignalNames[i])) {
+                emitPush(WarningRuleEngine::PushSignal, quint16(i), 0);
+                return;
+            }
+        }
+        const auto rule = m_rules.constFind(name);
+        if (rule != m_rules.constEnd()) {
+            emitPush(WarningRuleEngine::PushRule, quint16(*rule), 0);
+            return;
+        }
+        fail(QStringLiteral("unknown signal or earlier rule '%1'").arg(name));
+    }
+
+    void emitPush(WarningRuleEngine::Opcode opcode, quint16 index, float constant) {
+        m_code.push_back({ opcode, index, constant });
+        m_maxDepth = qMax(m_maxDepth, ++m_depth);
+    }
+
+    void emitUnary(WarningRuleEngine::Opcode opcode) {
+        m_code.push_back({ opcode, 0, 0 });
+    }
+
+    void emitBinary(WarningRuleEngine::Opcode opcode) {
+        m_code.push_back({ opcode, 0, 0 });
+        --m_depth;
+    }
+
+    void skipSpaces() {
+        while (m_position < m_source.size() && m_source.at(m_position).isSpace()) {
+            ++m_position;
+        }
+    }
+
+    bool peek(const char *token) {
+        skipSpaces();
+        return QStringView(m_source).mid(m_position).startsWith(QLatin1String(token));
+    }
+
+    bool accept(const char *token) {
+        if (!peek(token)) {
+            return false;
+        }
+        m_position += int(qstrlen(token));
+        return true;
+    }
+
+    void fail(const QString &message) {
+        if (m_error.isEmpty()) {
+            m_error = QStringLiteral("%1 at column %2").arg(message).arg(m_position + 1);
+        }
+    }
+
+    const QString m_source;
+    const QHash<QString, int> &m_rules;
+    std::vector<Instruction> &m_code;
+    int m_position = 0;
+    int m_depth = 0;
+    int m_maxDepth = 0;
+    QString m_error;
+};
+
+} // namespace
+
+bool WarningRuleEngine::load(const QString &path, QString *errorString) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return loadFromJson(file.readAll(), errorString);
+}
+
+bool WarningRuleEngine::loadFromJson(const QByteArray &json, QString *errorString) {
+    clear();
+
+    auto fail = [this, errorString](const QString &message) {
+        if (errorString) {
+            *errorString = message;
+        }
+        clear();
+        return false;
+    };
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (document.isNull()) {
+        return fail(parseError.errorString());
+    }
+    if (!document.isObject()) {
+        return fail(QStringLiteral("Expected an object with a \"rules\" array"));
+    }
+
+    QHash<QString, int> ruleIndex;
+    const QJsonArray rules = document.object().value(QStringLiteral("rules")).toArray();
+    for (const QJsonValue &value : rules) {
+        const QJsonObject object = value.toObject();
+        Rule rule;
+        rule.name = object.value(QStringLiteral("name")).toString();
+        if (rule.name.isEmpty()) {
+            return fail(QStringLiteral("Rule %1 has no name").arg(m_rules.size() + 1));
+        }
+        if (ruleIndex.contains(rule.name)) {
+            return fail(QStringLiteral("Duplicate rule '%1'").arg(rule.name));
+        }
+
+        const QString indicator = object.value(QStringLiteral("indicator")).toString(rule.name);
+        int indicatorIndex = m_indicators.indexOf(indicator);
+        if (indicatorIndex < 0) {
+            if (m_indicators.size() == MaxIndicators) {
+                return fail(QStringLiteral("More than %1 indicators").arg(MaxIndicators));
+            }
+            indicatorIndex = int(m_indicators.size());
+            m_indicators.append(indicator);
+        }
+        rule.indicator = quint8(indicatorIndex);
+
+        // Rules may only refer to rules defined before them, which rules out
+        // cycles and lets a tick see their current state
+        QString error;
+        rule.setStart = quint32(m_code.size());
+        const int setDepth = ExpressionCompiler(object.value(QStringLiteral("when")).toString(),
+                                                ruleIndex, m_code).compile(&error);
+        if (setDepth < 0) {
+            return fail(QStringLiteral("Rule '%1', when: %2").arg(rule.name, error));
+        }
+        rule.setEnd = rule.clearStart = quint32(m_code.size());
+
+        const QString clearWhen = object.value(QStringLiteral("clearWhen")).toString();
+        if (!clearWhen.isEmpty()) {
+            if (ExpressionCompiler(clearWhen, ruleIndex, m_code).compile(&error) < 0) {
+                return fail(QStringLiteral("Rule '%1', clearWhen: %2").arg(rule.name, error));
+            }
+        }
+        rule.clearEnd = quint32(m_code.size());
+
+        rule.onDelayNs = qint64(object.value(QStringLiteral("onDelayMs")).toDouble() * 1e6);
+        rule.offDelayNs = qint64(object.value(QStringLiteral("offDelayMs")).toDouble() * 1e6);
+
+        ruleIndex.insert(rule.name, int(m_rules.size()));
+        m_rules.push_back(rule);
+    }
+
+    reset();
+    return true;
+}
+
+void WarningRuleEngine::clear() {
+    m_code.clear();
+    m_rules.clear();
+    m_indicators.clear();
+    reset();
+}
+
+int WarningRuleEngine::ruleCount() const {
+    return int(m_rules.size());
+}
+
+QString WarningRuleEngine::ruleName(int rule) const {
+    return m_rules[std::size_t(rule)].name;
+}
+
+bool WarningRuleEngine::isRuleActive(int rule) const {
+    return m_active[std::size_t(rule)] != 0;
+}
+
+QStringList WarningRuleEngine::indicators() const {
+    return m_indicators;
+}
+
+int WarningRuleEngine::indicatorIndex(const QString &name) const {
+    return int(m_indicators.indexOf(name));
+}
+
+quint64 WarningRuleEngine::activeIndicators() const {
+    return m_activeIndicators;
+}
+
+void WarningRuleEngine::reset() {
+    m_active.assign(m_rules.size(), 0);
+    m_pendingSinceNs.assign(m_rules.size(), -1);
+    m_activeIndicators = 0;
+    m_hasLastSample = false;
+    m_acceleration = 0;
+}
+
+quint64 WarningRuleEngine::evaluate(const TelemetrySample &sample) {
+    const qint64 nowNs = sample.timestampNs;
+    if (m_hasLastSample && nowNs > m_lastTimestampNs) {
+        m_acceleration = float((sample.speed - m_lastSpeed) * 1e9 / double(nowNs - m_lastTimestampNs));
+    }
+    m_lastTimestampNs = nowNs;
+    m_lastSpeed = sample.speed;
+    m_hasLastSample = true;
+
+    float inputs[SignalCount];
+    inputs[Speed] = sample.speed;
+    inputs[FuelLevel] = sample.fuelLevel;
+    inputs[Gear] = float(sample.gear);
+    inputs[Acceleration] = m_acceleration;
+    inputs[EngineFault] = sample.engineWarning ? 1.0f : 0.0f;
+
+    quint64 indicators = 0;
+    for (std::size_t i = 0; i < m_rules.size(); ++i) {
+        const Rule &rule = m_rules[i];
+        const bool active = m_active[i] != 0;
+
+        // An inactive rule watches its set condition, an active one its clear condition
+        bool condition;
+        qint64 delayNs;
+        if (!active) {
+            condition = run(rule.setStart, rule.setEnd, inputs);
+            delayNs = rule.onDelayNs;
+        } else {
+            condition = rule.clearStart == rule.clearEnd
+                ? !run(rule.setStart, rule.setEnd, inputs)
+                : run(rule.clearStart, rule.clearEnd, inputs);
+            delayNs = rule.offDelayNs;
+        }
+
+        qint64 &pendingSinceNs = m_pendingSinceNs[i];
+        if (!condition) {
+            pendingSinceNs = -1;
+        } else {
+            if (pendingSinceNs < 0) {
+                pendingSinceNs = nowNs;
+            }
+            if (nowNs - pendingSinceNs >= delayNs) {
+                m_active[i] = active ? 0 : 1;
+                pendingSinceNs = -1;
+            }
+        }
+
+        indicators |= quint64(m_active[i]) << rule.indicator;
+    }
+
+    m_activeIndicators = indicators;
+    return indicators;
+}
+
+bool WarningRuleEngine::run(quint32 start, quint32 end, const float *inputs) const {
+    float stack[MaxStackDepth];
+    int top = -1;
+
+    const Instruction *code = m_code.data();
+    for (quint32 pc = start; pc < end; ++pc) {
+        const Instruction &instruction = code[pc];
+        switch (instruction.opcode) {
+        case PushConstant:
+            stack[++top] = instruction.constant;
+            break;
+        case PushSignal:
+            stack[++top] = inputs[instruction.index];
+            break;
+        case PushRule:
+            stack[++top] = m_active[instruction.index];
+            break;
+        case Add:
+            --top;
+            stack[top] += stack[top + 1];
+            break;
+        case Subtract:
+            --top;
+            stack[top] -= stack[top + 1];
+            break;
+        case Multiply:
+            --top;
+            stack[top] *= stack[top + 1];
+            break;
+        case Divide:
+            --top;
+            stack[top] /= stack[top + 1];
+            break;
+        case Negate:
+            stack[top] = -stack[top];
+            break;
+        case Less:
+            --top;
+            stack[top] = stack[top] < stack[top + 1];
+            break;
+        case LessOrEqual:
+            --top;
+            stack[top] = stack[top] <= stack[top + 1];
+            break;
+        case Greater:
+            --top;
+            stack[top] = stack[top] > stack[top + 1];
+            break;
+        case GreaterOrEqual:
+            --top;
+            stack[top] = stack[top] >= stack[top + 1];
+            break;
+        case Equal:
+            --top;
+            stack[top] = stack[top] == stack[top + 1];
+            break;
+        case NotEqual:
+            --top;
+            stack[top] = stack[top] != stack[top + 1];
+            break;
+        case And:
+            --top;
+            stack[top] = stack[top] != 0 && stack[top + 1] != 0;
+            break;
+        case Or:
+            --top;
+            stack[top] = stack[top] != 0 || stack[top + 1] != 0;
+            break;
+        case Not:
+            stack[top] = stack[top] == 0;
+            break;
+        }
+    }
+    return top >= 0 && stack[top] != 0;
+}
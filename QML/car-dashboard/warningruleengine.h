@@ -0,0 +1,119 @@
+#ifndef WARNINGRULEENGINE_H
+#define WARNINGRULEENGINE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include "telemetrysample.h"
+
+// Evaluates declarative warning rules against the telemetry stream.
+//
+// Rules are loaded from a JSON file:
+//
+//   { "rules": [ { "name": "engineStrain", "indicator": "engine",
+//                  "when": "speed > 200", "clearWhen": "speed < 180",
+//                  "onDelayMs": 2000, "offDelayMs": 500 }, ... ] }
+//
+// "when" raises the rule and "clearWhen" (default: not "when") lowers it,
+// which gives hysteresis. A condition must hold for onDelayMs/offDelayMs of
+// sample time before the state changes (debounce). Expressions combine the
+// signals speed, fuelLevel, gear ('P', 'R', 'N', 'D'), acceleration
+// (km/h per second) and engineFault (the engine warning reported by the
+// vehicle itself, 0 or 1) with arithmetic, comparisons, &&, || and !, and
+// may refer to earlier rules by name.
+//
+// Every expression is compiled into one shared array of stack-machine
+// instructions, so a tick evaluates all rules in a single tight loop.
+class WarningRuleEngine {
+public:
+    // Distinct indicators are reported as bits of a 64-bit mask
+    static constexpr int MaxIndicators = 64;
+
+    WarningRuleEngine() = default;
+
+    bool load(const QString &path, QString *errorString = nullptr);
+    bool loadFromJson(const QByteArray &json, QString *errorString = nullptr);
+    void clear();
+
+    int ruleCount() const;
+    QString ruleName(int rule) const;
+    bool isRuleActive(int rule) const;
+
+    // Indicator names in the order their bits are assigned
+    QStringList indicators() const;
+    int indicatorIndex(const QString &name) const;
+
+    // Runs every rule for one sample and returns the mask of indicators
+    // with at least one active rule
+    quint64 evaluate(const TelemetrySample &sample);
+    quint64 activeIndicators() const;
+
+    // Forget all rule states, e.g. when the sample clock jumps
+    void reset();
+
+    enum Opcode : quint8 {
+        PushConstant,
+        PushSignal,
+        PushRule,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Negate,
+        Less,
+        LessOrEqual,
+        Greater,
+        GreaterOrEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or,
+        Not
+    };
+
+    enum Signal : quint8 {
+        Speed,
+        FuelLevel,
+        Gear,
+        Acceleration,
+        EngineFault,
+        SignalCount
+    };
+
+    struct Instruction {
+        Opcode opcode;
+        quint16 index;      // signal or rule for PushSignal/PushRule
+        float constant;     // for PushConstant
+    };
+
+private:
+    struct Rule {
+        QString name;
+        quint32 setStart;
+        quint32 setEnd;
+        quint32 clearStart;     // clearStart == clearEnd: not the set condition
+        quint32 clearEnd;
+        qint64 onDelayNs;
+        qint64 offDelayNs;
+        quint8 indicator;
+    };
+
+    bool run(quint32 start, quint32 end, const float *inputs) const;
+
+    std::vector<Instruction> m_code;
+    std::vector<Rule> m_rules;
+    QStringList m_indicators;
+
+    // Per-rule state, indexed like m_rules
+    std::vector<quint8> m_active;
+    std::vector<qint64> m_pendingSinceNs;
+    quint64 m_activeIndicators = 0;
+
+    qint64 m_lastTimestampNs = 0;
+    float m_lastSpeed = 0;
+    float m_acceleration = 0;
+    bool m_hasLastSample = false;
+};
+
+#endif // WARNINGRULEENGINE_H
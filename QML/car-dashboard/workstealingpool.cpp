@@ -0,0 +1,121 @@
+#include "workstealingpool.h"
+
+WorkStealingPool::WorkStealingPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = int(qMax(1u, std::thread::hardware_concurrency()));
+    }
+
+    m_workers.reserve(std::size_t(threadCount));
+    for (int i = 0; i < threadCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // Start the threads only once every Worker exists, they steal from each other
+    for (int i = 0; i < threadCount; ++i) {
+        m_workers[std::size_t(i)]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_stopping = true;
+    }
+    m_jobStarted.notify_all();
+    for (auto &worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+int WorkStealingPool::threadCount() const {
+    return int(m_workers.size());
+}
+
+quint64 WorkStealingPool::stolenChunks() const {
+    return m_stolen.load(std::memory_order_relaxed);
+}
+
+void WorkStealingPool::parallelFor(int count, int grain, const std::function<void(int, int)> &kernel) {
+    if (count <= 0) {
+        return;
+    }
+    grain = qMax(1, grain);
+    const int chunks = (count + grain - 1) / grain;
+
+    // Published before any chunk; the deque mutexes order it for the workers
+    m_kernel.store(&kernel, std::memory_order_release);
+    m_remaining.store(chunks, std::memory_order_release);
+
+    // Contiguous blocks per worker keep neighbouring vehicles on one core
+    const int workers = threadCount();
+    for (int w = 0; w < workers; ++w) {
+        const int firstChunk = chunks * w / workers;
+        const int lastChunk = chunks * (w + 1) / workers;
+        Worker &worker = *m_workers[std::size_t(w)];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        for (int c = firstChunk; c < lastChunk; ++c) {
+            worker.chunks.push_back({ c * grain, qMin(count, (c + 1) * grain) });
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+    ++m_generation;
+    m_jobStarted.notify_all();
+    m_jobDone.wait(lock, [this] { return m_remaining.load(std::memory_order_acquire) == 0; });
+    m_kernel.store(nullptr, std::memory_order_relaxed);
+}
+
+void WorkStealingPool::workerLoop(int index) {
+    quint64 seenGeneration = 0;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_jobMutex);
+            m_jobStarted.wait(lock, [&] { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        Range range;
+        while (takeLocal(index, range) || steal(index, range)) {
+            (*m_kernel.load(std::memory_order_acquire))(range.begin, range.end);
+            finishChunk();
+        }
+    }
+}
+
+bool WorkStealingPool::takeLocal(int index, Range &range) {
+    Worker &worker = *m_workers[std::size_t(index)];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.chunks.empty()) {
+        return false;
+    }
+    range = worker.chunks.back();
+    worker.chunks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int thief, Range &range) {
+    const int workers = threadCount();
+    for (int offset = 1; offset < workers; ++offset) {
+        Worker &victim = *m_workers[std::size_t((thief + offset) % workers)];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            range = victim.chunks.front();
+            victim.chunks.pop_front();
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::finishChunk() {
+    if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Lock so the notification cannot slip in between the caller's
+        // predicate check and its wait
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobDone.notify_all();
+    }
+}
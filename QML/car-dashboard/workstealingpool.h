@@ -0,0 +1,68 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that execute data-parallel loops.
+//
+// parallelFor() cuts the index range into chunks and deals them out to the
+// workers' own deques. A worker takes chunks from the back of its own deque
+// and, when that runs dry, steals from the front of the others, so uneven
+// chunk costs or a descheduled thread do not leave cores idle.
+class WorkStealingPool {
+public:
+    // threadCount <= 0 uses one worker per hardware thread
+    explicit WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    int threadCount() const;
+
+    // Runs kernel(begin, end) over [0, count) in chunks of about grain
+    // indices and returns when all of them are done. Not reentrant.
+    void parallelFor(int count, int grain, const std::function<void(int, int)> &kernel);
+
+    // Chunks executed by a worker other than the one they were dealt to
+    quint64 stolenChunks() const;
+
+private:
+    struct Range {
+        int begin;
+        int end;
+    };
+
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Range> chunks;
+        std::thread thread;
+    };
+
+    void workerLoop(int index);
+    bool takeLocal(int index, Range &range);
+    bool steal(int thief, Range &range);
+    void finishChunk();
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobStarted;
+    std::condition_variable m_jobDone;
+    quint64 m_generation = 0;
+    bool m_stopping = false;
+
+    std::atomic<const std::function<void(int, int)> *> m_kernel{nullptr};
+    std::atomic<int> m_remaining{0};
+    std::atomic<quint64> m_stolen{0};
+};
+
+#endif // WORKSTEALINGPOOL_H
@@ -0,0 +1,25 @@
+# Adds the allocation tracer to a target:
+#
+#   include(${CMAKE_CURRENT_SOURCE_DIR}/../common/alloctracer/AllocTracer.cmake)
+#   add_alloc_tracer(appexample)
+#
+# Sources may always include alloctracer.h. The allocation functions (malloc
+# and friends on glibc, operator new/delete elsewhere) are only replaced,
+# and the ALLOC_TRACE_* macros only expand to counting code, when the
+# target is configured with -DQML_ALLOC_TRACER=ON. The replacements live in
+# the executable, so they must not be added to a shared library.
+
+option(QML_ALLOC_TRACER "Count heap allocations by replacing the allocation functions" OFF)
+
+set(ALLOC_TRACER_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(add_alloc_tracer target)
+    target_include_directories(${target} PRIVATE ${ALLOC_TRACER_DIR})
+    if(QML_ALLOC_TRACER)
+        target_sources(${target} PRIVATE
+            ${ALLOC_TRACER_DIR}/alloctracer.h
+            ${ALLOC_TRACER_DIR}/alloctracer.cpp
+        )
+        target_compile_definitions(${target} PRIVATE QML_ALLOC_TRACER)
+    endif()
+endfunction()
@@ -0,0 +1,335 @@
+#include "alloctracer.h"
+#include <QByteArray>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+// On glibc the C allocation functions are replaced too, so allocations of
+// Qt containers (QArrayData::allocate calls malloc and realloc) and of
+// other libraries are counted. The replacements forward to glibc's own
+// implementation, and operator new is left to the standard library, whose
+// operator new allocates through the replaced malloc.
+#ifdef __GLIBC__
+#define ALLOC_TRACER_REPLACES_MALLOC
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *p, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void *p);
+}
+#endif
+
+namespace {
+
+// Constant-initialized and trivially destructible, so the hooks can use it
+// on any thread at any time, including during static initialization
+thread_local AllocTracer::Counts t_counts;
+
+std::atomic<AllocTracer::Counter *> s_counters{nullptr};
+
+enum class TraceMode {
+    Off,
+    Report,
+    Fatal
+};
+
+TraceMode traceMode() {
+    static const TraceMode mode = [] {
+        const QByteArray value = qgetenv("QML_ALLOC_TRACE").trimmed().toLower();
+        if (value.isEmpty() || value == "0") {
+            return TraceMode::Off;
+        }
+        return value == "fatal" ? TraceMode::Fatal : TraceMode::Report;
+    }();
+    return mode;
+}
+
+const bool s_reportAtExit = [] {
+    if (traceMode() != TraceMode::Off) {
+        std::atexit(AllocTracer::logReport);
+    }
+    return true;
+}();
+
+void countAllocation(std::size_t size) {
+    ++t_counts.allocations;
+    t_counts.bytes += size;
+}
+
+void countDeallocation() {
+    ++t_counts.deallocations;
+}
+
+#ifndef ALLOC_TRACER_REPLACES_MALLOC
+void *allocate(std::size_t size) {
+    countAllocation(size);
+    for (;;) {
+        if (void *p = std::malloc(size ? size : 1)) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment) {
+    countAllocation(size);
+    const std::size_t align = std::size_t(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    const std::size_t rounded = (qMax<std::size_t>(size, 1) + align - 1) / align * align;
+    for (;;) {
+#ifdef Q_OS_WIN
+        void *p = _aligned_malloc(rounded, align);
+#else
+        void *p = std::aligned_alloc(align, rounded);
+#endif
+        if (p) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void deallocate(void *p) {
+    if (p) {
+        countDeallocation();
+        std::free(p);
+    }
+}
+
+void deallocateAligned(void *p) {
+    if (p) {
+        countDeallocation();
+#ifdef Q_OS_WIN
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+#endif
+
+} // namespace
+
+namespace AllocTracer {
+
+bool isCompiledIn() {
+    return true;
+}
+
+Counts threadCounts() {
+    return t_counts;
+}
+
+Counter::Counter(const char *name, bool allocationFree)
+    : m_name(name),
+    m_allocationFree(allocationFree)
+{
+    m_next = s_counters.load(std::memory_order_relaxed);
+    while (!s_counters.compare_exchange_weak(m_next, this, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+    }
+}
+
+void Counter::record(const Counts &delta) {
+    m_calls.fetch_add(1, std::memory_order_relaxed);
+    if (delta.allocations == 0) {
+        return;
+    }
+
+    m_allocations.fetch_add(delta.allocations, std::memory_order_relaxed);
+    m_bytes.fetch_add(delta.bytes, std::memory_order_relaxed);
+    m_allocatingCalls.fetch_add(1, std::memory_order_relaxed);
+    quint64 max = m_maxPerCall.load(std::memory_order_relaxed);
+    while (delta.allocations > max
+           && !m_maxPerCall.compare_exchange_weak(max, delta.allocations, std::memory_order_relaxed)) {
+    }
+
+    // Warn once per scope; every later call is still in the report
+    if (m_allocationFree && m_allocatingCalls.load(std::memory_order_relaxed) == 1) {
+        reportAllocations(m_name, delta);
+    }
+}
+
+Counter *Counter::first() {
+    return s_counters.load(std::memory_order_acquire);
+}
+
+Scope::Scope(Counter &counter)
+    : m_counter(counter),
+    m_start(t_counts)
+{
+}
+
+Scope::~Scope() {
+    m_counter.record(counts());
+}
+
+Counts Scope::counts() const {
+    return { t_counts.allocations - m_start.allocations,
+             t_counts.deallocations - m_start.deallocations,
+             t_counts.bytes - m_start.bytes };
+}
+
+bool reportAllocations(const char *what, const Counts &counts) {
+    if (counts.allocations == 0) {
+        return true;
+    }
+
+    const char *format = "alloc-tracer: %s made %llu allocations (%llu bytes) and %llu frees";
+    if (traceMode() == TraceMode::Fatal) {
+        qFatal(format, what, counts.allocations, counts.bytes, counts.deallocations);
+    }
+    qWarning(format, what, counts.allocations, counts.bytes, counts.deallocations);
+    return false;
+}
+
+void logReport() {
+    for (const Counter *counter = Counter::first(); counter; counter = counter->next()) {
+        qInfo("alloc-tracer: %s%s: %llu calls, %llu allocating, %llu allocations "
+              "(max %llu per call), %llu bytes",
+              counter->name(), counter->allocationFree() ? " [allocation-free]" : "",
+              counter->calls(), counter->allocatingCalls(), counter->allocations(),
+              counter->maxAllocationsPerCall(), counter->bytes());
+    }
+}
+
+} // namespace AllocTracer
+
+#ifdef ALLOC_TRACER_REPLACES_MALLOC
+
+// Replacements for the C allocation functions. The executable's
+// definitions take precedence over glibc's for every shared library, and
+// glibc calls them for its own allocations, e.g. in strdup().
+
+extern "C" void *malloc(std::size_t size) {
+    countAllocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(std::size_t count, std::size_t size) {
+    countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+// Growing or shrinking a block counts as a new allocation and a free,
+// even when glibc manages to resize it in place
+extern "C" void *realloc(void *p, std::size_t size) {
+    if (p) {
+        countDeallocation();
+    }
+    if (!p || size) {
+        countAllocation(size);
+    }
+    return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p) {
+    if (p) {
+        countDeallocation();
+    }
+    __libc_free(p);
+}
+
+extern "C" void *memalign(std::size_t alignment, std::size_t size) {
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void *aligned_alloc(std::size_t alignment, std::size_t size) {
+    countAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" int posix_memalign(void **result, std::size_t alignment, std::size_t size) {
+    // Power-of-two multiples of sizeof(void *), as the standard requires
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    countAllocation(size);
+    void *p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *result = p;
+    return 0;
+}
+
+#else
+
+// Replacements for the global allocation functions. The nothrow forms of
+// delete and of aligned new are specified to call these by default.
+
+void *operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *p) noexcept {
+    deallocate(p);
+}
+
+void operator delete[](void *p) noexcept {
+    deallocate(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    deallocate(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    deallocate(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    deallocateAligned(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    deallocateAligned(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    deallocateAligned(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    deallocateAligned(p);
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef ALLOCTRACER_H
+#define ALLOCTRACER_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Heap allocation counting for hot paths.
+//
+// Built with QML_ALLOC_TRACER defined (see AllocTracer.cmake), every heap
+// allocation of the calling thread is counted. On glibc that is malloc,
+// calloc, realloc and the aligned variants, which is where Qt containers
+// and operator new allocate; elsewhere only the global operator new and
+// delete are replaced, and Qt containers go uncounted. Code marks the
+// paths it cares about with a named scope:
+//
+//   void Model::tick() {
+//       ALLOC_TRACE_SCOPE("Model::tick");      // counts what tick() allocates
+//       ...
+//   }
+//
+// ALLOC_FREE_SCOPE(name) does the same and warns when the scope allocates
+// (QML_ALLOC_TRACE=fatal aborts instead). Every named scope is listed at
+// exit when QML_ALLOC_TRACE is set. Tests and benchmarks check a piece of
+// code directly:
+//
+//   ALLOC_ASSERT_NONE(model.tick());
+//   QVERIFY(AllocTracer::expectNoAllocations("tick", [&] { model.tick(); }));
+//
+// Without QML_ALLOC_TRACER the macros expand to nothing (ALLOC_ASSERT_NONE
+// still runs its statement) and the allocation functions are left alone.
+namespace AllocTracer {
+
+struct Counts {
+    quint64 allocations = 0;
+    quint64 deallocations = 0;
+    quint64 bytes = 0;
+};
+
+#ifdef QML_ALLOC_TRACER
+// Whether the allocation functions are replaced in this binary
+bool isCompiledIn();
+
+// Everything the current thread allocated and freed so far
+Counts threadCounts();
+
+// Logs what was allocated under the given name. Returns false if anything
+// was; always true without QML_ALLOC_TRACER.
+bool reportAllocations(const char *what, const Counts &counts);
+
+// Lists every named scope; runs at exit when QML_ALLOC_TRACE is set
+void logReport();
+#else
+inline bool isCompiledIn() { return false; }
+inline Counts threadCounts() { return {}; }
+inline bool reportAllocations(const char *, const Counts &) { return true; }
+inline void logReport() {}
+#endif
+
+// Totals of one named scope over all threads, listed by logReport()
+class Counter {
+public:
+    Counter(const char *name, bool allocationFree);
+    Counter(const Counter &) = delete;
+    Counter &operator=(const Counter &) = delete;
+
+    const char *name() const { return m_name; }
+    bool allocationFree() const { return m_allocationFree; }
+    quint64 calls() const { return m_calls.load(std::memory_order_relaxed); }
+    quint64 allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+    quint64 bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    quint64 maxAllocationsPerCall() const { return m_maxPerCall.load(std::memory_order_relaxed); }
+    quint64 allocatingCalls() const { return m_allocatingCalls.load(std::memory_order_relaxed); }
+
+    void record(const Counts &delta);
+
+    // Registered counters, most recently registered first
+    static Counter *first();
+    Counter *next() const { return m_next; }
+
+private:
+    const char *m_name;
+    bool m_allocationFree;
+    std::atomic<quint64> m_calls{0};
+    std::atomic<quint64> m_allocations{0};
+    std::atomic<quint64> m_bytes{0};
+    std::atomic<quint64> m_maxPerCall{0};
+    std::atomic<quint64> m_allocatingCalls{0};
+    Counter *m_next = nullptr;
+};
+
+// Adds what the current thread allocates during its lifetime to a Counter
+class Scope {
+public:
+    explicit Scope(Counter &counter);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+    // Allocations so far in this scope
+    Counts counts() const;
+
+private:
+    Counter &m_counter;
+    Counts m_start;
+};
+
+// Allocations made by the current thread while fn runs
+template <typename Fn>
+Counts measure(Fn &&fn)
+{
+    const Counts start = threadCounts();
+    fn();
+    const Counts end = threadCounts();
+    return { end.allocations - start.allocations,
+             end.deallocations - start.deallocations,
+             end.bytes - start.bytes };
+}
+
+template <typename Fn>
+bool expectNoAllocations(const char *what, Fn &&fn)
+{
+    return reportAllocations(what, measure(fn));
+}
+
+} // namespace AllocTracer
+
+#ifdef QML_ALLOC_TRACER
+#define ALLOC_TRACER_CONCAT_(a, b) a##b
+#define ALLOC_TRACER_CONCAT(a, b) ALLOC_TRACER_CONCAT_(a, b)
+#define ALLOC_TRACER_SCOPE_(name, allocationFree) \
+    static AllocTracer::Counter ALLOC_TRACER_CONCAT(allocTracerCounter_, __LINE__)(name, allocationFree); \
+    const AllocTracer::Scope ALLOC_TRACER_CONCAT(allocTracerScope_, __LINE__)( \
+        ALLOC_TRACER_CONCAT(allocTracerCounter_, __LINE__))
+#define ALLOC_TRACE_SCOPE(name) ALLOC_TRACER_SCOPE_(name, false)
+#define ALLOC_FREE_SCOPE(name) ALLOC_TRACER_SCOPE_(name, true)
+#define ALLOC_ASSERT_NONE(statement) \
+    do { \
+        if (!AllocTracer::expectNoAllocations(#statement, [&] { statement; })) \
+            qFatal("%s:%d: %s allocated", __FILE__, __LINE__, #statement); \
+    } while (false)
+#else
+#define ALLOC_TRACE_SCOPE(name)
+#define ALLOC_FREE_SCOPE(name)
+#define ALLOC_ASSERT_NONE(statement) \
+    do { \
+        statement; \
+    } while (false)
+#endif
+
+#endif // ALLOCTRACER_H
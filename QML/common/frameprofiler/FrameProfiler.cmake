@@ -0,0 +1,17 @@
+# Adds the frame profiler to an application target:
+#
+#   include(${CMAKE_CURRENT_SOURCE_DIR}/../common/frameprofiler/FrameProfiler.cmake)
+#   add_frame_profiler(appexample)
+#
+# The profiler stays inactive unless QML_FRAME_PROFILE is set at run time.
+
+set(FRAME_PROFILER_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(add_frame_profiler target)
+    target_sources(${target} PRIVATE
+        ${FRAME_PROFILER_DIR}/latencyhistogram.h
+        ${FRAME_PROFILER_DIR}/frameprofiler.h
+        ${FRAME_PROFILER_DIR}/frameprofiler.cpp
+    )
+    target_include_directories(${target} PRIVATE ${FRAME_PROFILER_DIR})
+endfunction()
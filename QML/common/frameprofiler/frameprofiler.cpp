@@ -0,0 +1,221 @@
+#include "frameprofiler.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPainter>
+#include <QQmlApplicationEngine>
+#include <QQuickPaintedItem>
+#include <QQuickWindow>
+#include <QTimer>
+
+namespace {
+
+enum class ProfileMode {
+    Off,
+    Report,
+    Overlay
+};
+
+ProfileMode profileMode() {
+    static const ProfileMode mode = [] {
+        const QByteArray value = qgetenv("QML_FRAME_PROFILE").trimmed().toLower();
+        if (value.isEmpty() || value == "0") {
+            return ProfileMode::Off;
+        }
+        return value == "overlay" ? ProfileMode::Overlay : ProfileMode::Report;
+    }();
+    return mode;
+}
+
+const char *phaseName(FrameProfiler::Phase phase) {
+    switch (phase) {
+    case FrameProfiler::Sync:
+        return "sync";
+    case FrameProfiler::Render:
+        return "render";
+    case FrameProfiler::Swap:
+        return "swap";
+    case FrameProfiler::PhaseCount:
+        break;
+    }
+    return "";
+}
+
+quint64 toMicroseconds(qint64 ns) {
+    return ns > 0 ? quint64(ns / 1000) : 0;
+}
+
+} // namespace
+
+// Text overlay in the top-left corner, refreshed twice a second
+class FrameStatsOverlay : public QQuickPaintedItem {
+public:
+    FrameStatsOverlay(const FrameProfiler *profiler, QQuickItem *parent)
+        : QQuickPaintedItem(parent),
+        m_profiler(profiler)
+    {
+        setZ(1e9);
+        setSize(QSizeF(300, 80));
+        setAcceptedMouseButtons(Qt::NoButton);
+    }
+
+    void paint(QPainter *painter) override {
+        painter->fillRect(boundingRect(), QColor(0, 0, 0, 160));
+        painter->setPen(Qt::white);
+        QFont font = painter->font();
+        font.setFamily(QStringLiteral("monospace"));
+        font.setPixelSize(13);
+        painter->setFont(font);
+
+        QString text = QStringLiteral("%1 %2 %3 %4\n")
+                           .arg(QStringLiteral("frames %1").arg(m_profiler->frameCount()), -17)
+                           .arg(QStringLiteral("p50us"), 6)
+                           .arg(QStringLiteral("p99us"), 6)
+                           .arg(QStringLiteral("maxus"), 6);
+        for (int i = 0; i < FrameProfiler::PhaseCount; ++i) {
+            const auto phase = FrameProfiler::Phase(i);
+            const LatencyHistogram &histogram = m_profiler->histogram(phase);
+            text += QStringLiteral("%1 %2 %3 %4\n")
+                        .arg(QLatin1String(phaseName(phase)), -17)
+                        .arg(histogram.percentileUs(50), 6)
+                        .arg(histogram.percentileUs(99), 6)
+                        .arg(histogram.maxUs(), 6);
+        }
+        painter->drawText(boundingRect().adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop, text);
+    }
+
+private:
+    const FrameProfiler *m_profiler;
+};
+
+bool FrameProfiler::isEnabled() {
+    return profileMode() != ProfileMode::Off;
+}
+
+void FrameProfiler::installIfEnabled(QQmlApplicationEngine &engine) {
+    const ProfileMode mode = profileMode();
+    if (mode == ProfileMode::Off) {
+        return;
+    }
+
+    for (QObject *root : engine.rootObjects()) {
+        if (auto *window = qobject_cast<QQuickWindow *>(root)) {
+            attach(window, mode == ProfileMode::Overlay);
+        }
+    }
+}
+
+FrameProfiler *FrameProfiler::attach(QQuickWindow *window, bool showOverlay) {
+    auto *profiler = new FrameProfiler(window);
+
+    if (showOverlay) {
+        profiler->m_overlay = new FrameStatsOverlay(profiler, window->contentItem());
+        profiler->m_overlayTimer = new QTimer(profiler);
+        connect(profiler->m_overlayTimer, &QTimer::timeout,
+                profiler->m_overlay, [overlay = profiler->m_overlay] { overlay->update(); });
+        profiler->m_overlayTimer->start(500);
+    }
+    return profiler;
+}
+
+FrameProfiler::FrameProfiler(QQuickWindow *window)
+    : QObject(window),
+    m_window(window)
+{
+    m_clock.start();
+
+    // With the threaded render loop these are emitted on the render thread;
+    // each handler only touches histograms and that thread's timestamps.
+    connect(window, &QQuickWindow::beforeSynchronizing,
+            this, &FrameProfiler::onBeforeSynchronizing, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterSynchronizing,
+            this, &FrameProfiler::onAfterSynchronizing, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRendering,
+            this, &FrameProfiler::onBeforeRendering, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering,
+            this, &FrameProfiler::onAfterRendering, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped,
+            this, &FrameProfiler::onFrameSwapped, Qt::DirectConnection);
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit,
+            this, &FrameProfiler::writeReportOnExit);
+}
+
+const LatencyHistogram &FrameProfiler::histogram(Phase phase) const {
+    return m_histograms[phase];
+}
+
+quint64 FrameProfiler::frameCount() const {
+    return m_histograms[Swap].count();
+}
+
+QJsonObject FrameProfiler::report() const {
+    QJsonObject phases;
+    for (int i = 0; i < PhaseCount; ++i) {
+        const LatencyHistogram &histogram = m_histograms[i];
+        QJsonObject stats;
+        stats["count"] = qint64(histogram.count());
+        stats["meanUs"] = histogram.meanUs();
+        stats["p50Us"] = qint64(histogram.percentileUs(50));
+        stats["p90Us"] = qint64(histogram.percentileUs(90));
+        stats["p99Us"] = qint64(histogram.percentileUs(99));
+        stats["maxUs"] = qint64(histogram.maxUs());
+        phases[phaseName(Phase(i))] = stats;
+    }
+
+    QJsonObject root;
+    root["application"] = QCoreApplication::applicationName();
+    root["window"] = m_window ? m_window->title() : QString();
+    root["frames"] = qint64(frameCount());
+    root["durationMs"] = m_clock.elapsed();
+    root["phases"] = phases;
+    return root;
+}
+
+bool FrameProfiler::writeReport(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "FrameProfiler: cannot write" << path << ":" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(report()).toJson());
+    return true;
+}
+
+void FrameProfiler::onBeforeSynchronizing() {
+    m_syncStartNs = m_clock.nsecsElapsed();
+}
+
+void FrameProfiler::onAfterSynchronizing() {
+    m_histograms[Sync].record(toMicroseconds(m_clock.nsecsElapsed() - m_syncStartNs));
+}
+
+void FrameProfiler::onBeforeRendering() {
+    m_renderStartNs = m_clock.nsecsElapsed();
+}
+
+void FrameProfiler::onAfterRendering() {
+    m_renderEndNs = m_clock.nsecsElapsed();
+    m_histograms[Render].record(toMicroseconds(m_renderEndNs - m_renderStartNs));
+}
+
+void FrameProfiler::onFrameSwapped() {
+    m_histograms[Swap].record(toMicroseconds(m_clock.nsecsElapsed() - m_renderEndNs));
+}
+
+void FrameProfiler::writeReportOnExit() {
+    if (m_reportWritten) {
+        return;
+    }
+    m_reportWritten = true;
+
+    QString path = qEnvironmentVariable("QML_FRAME_PROFILE_OUTPUT");
+    if (path.isEmpty()) {
+        path = QStringLiteral("frame-profile-%1.json").arg(QCoreApplication::applicationName());
+    }
+    if (writeReport(path)) {
+        qInfo() << "FrameProfiler: report written to" << path;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QPointer>
+#include "latencyhistogram.h"
+
+class QQmlApplicationEngine;
+class QQuickWindow;
+class QTimer;
+class FrameStatsOverlay;
+
+// Per-frame timing for QQuickWindow based apps.
+//
+// Records the sync (beforeSynchronizing -> afterSynchronizing), render
+// (beforeRendering -> afterRendering) and swap (afterRendering ->
+// frameSwapped) phase of every frame into lock-free histograms, optionally
+// shows p50/p99/max in an overlay and writes a JSON report when the
+// application quits.
+//
+// Controlled by environment variables, read once:
+//   QML_FRAME_PROFILE=1        collect and write the report
+//   QML_FRAME_PROFILE=overlay  additionally show the overlay
+//   QML_FRAME_PROFILE_OUTPUT   report path (default frame-profile-<app>.json)
+//
+// When QML_FRAME_PROFILE is unset installIfEnabled() returns immediately:
+// no objects are created and no signal is connected.
+class FrameProfiler : public QObject {
+    Q_OBJECT
+
+public:
+    enum Phase {
+        Sync,
+        Render,
+        Swap,
+        PhaseCount
+    };
+
+    static bool isEnabled();
+    static void installIfEnabled(QQmlApplicationEngine &engine);
+
+    // Unconditionally profile window; the profiler is owned by the window.
+    static FrameProfiler *attach(QQuickWindow *window, bool showOverlay = false);
+
+    const LatencyHistogram &histogram(Phase phase) const;
+    quint64 frameCount() const;
+
+    QJsonObject report() const;
+    bool writeReport(const QString &path) const;
+
+private:
+    explicit FrameProfiler(QQuickWindow *window);
+
+    void onBeforeSynchronizing();
+    void onAfterSynchronizing();
+    void onBeforeRendering();
+    void onAfterRendering();
+    void onFrameSwapped();
+    void writeReportOnExit();
+
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_clock;
+    LatencyHistogram m_histograms[PhaseCount];
+
+    // Only touched by the thread that renders this window
+    qint64 m_syncStartNs = 0;
+    qint64 m_renderStartNs = 0;
+    qint64 m_renderEndNs = 0;
+
+    bool m_reportWritten = false;
+    FrameStatsOverlay *m_overlay = nullptr;
+    QTimer *m_overlayTimer = nullptr;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,99 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+
+// Fixed-size, lock-free histogram of durations in microseconds.
+//
+// Buckets are log-linear: each power of two is split into 8 sub-buckets, so
+// any recorded value is reported within 12.5% while the whole range from
+// 1 us to hours fits in a few hundred counters. record() may be called from
+// any thread concurrently with the readers.
+class LatencyHistogram {
+public:
+    void record(quint64 valueUs)
+    {
+        m_buckets[bucketFor(valueUs)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sumUs.fetch_add(valueUs, std::memory_order_relaxed);
+
+        quint64 max = m_maxUs.load(std::memory_order_relaxed);
+        while (valueUs > max
+               && !m_maxUs.compare_exchange_weak(max, valueUs, std::memory_order_relaxed)) {
+        }
+    }
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 maxUs() const { return m_maxUs.load(std::memory_order_relaxed); }
+
+    double meanUs() const
+    {
+        const quint64 n = count();
+        return n ? double(m_sumUs.load(std::memory_order_relaxed)) / double(n) : 0.0;
+    }
+
+    // Upper bound of the bucket holding the given percentile (0..100)
+    quint64 percentileUs(double percentile) const
+    {
+        const quint64 n = count();
+        if (n == 0) {
+            return 0;
+        }
+
+        const quint64 rank = qMax<quint64>(1, quint64(percentile / 100.0 * double(n) + 0.5));
+        quint64 seen = 0;
+        for (int i = 0; i < BucketCount; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return qMin(bucketUpperBound(i), maxUs());
+            }
+        }
+        return maxUs();
+    }
+
+    void reset()
+    {
+        for (auto &bucket : m_buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        m_count.store(0, std::memory_order_relaxed);
+        m_sumUs.store(0, std::memory_order_relaxed);
+        m_maxUs.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr int SubBucketBits = 3;
+    static constexpr int SubBuckets = 1 << SubBucketBits;
+    static constexpr int BucketCount = (64 - SubBucketBits + 1) * SubBuckets;
+
+    static int bucketFor(quint64 value)
+    {
+        // Values below SubBuckets get one exact bucket each
+        if (value < SubBuckets) {
+            return int(value);
+        }
+        const int msb = 63 - qCountLeadingZeroBits(value);
+        const int shift = msb - SubBucketBits;
+        const int sub = int((value >> shift) & (SubBuckets - 1));
+        return (shift + 1) * SubBuckets + sub;
+    }
+
+    static quint64 bucketUpperBound(int index)
+    {
+        if (index < SubBuckets) {
+            return quint64(index);
+        }
+        const int shift = index / SubBuckets - 1;
+        const quint64 sub = quint64(index % SubBuckets);
+        return (((SubBuckets + sub + 1) << shift) - 1);
+    }
+
+    std::array<std::atomic<quint64>, BucketCount> m_buckets{};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sumUs{0};
+    std::atomic<quint64> m_maxUs{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -1,5 +1,6 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include "frameprofiler.h"
 
 int main(int argc, char *argv[])
 {
@@ -14,5 +15,7 @@ int main(int argc, char *argv[])
         Qt::QueuedConnection);
     engine.loadFromModule("qml1", "Main");
 
+    FrameProfiler::installIfEnabled(engine);
+
     return app.exec();
 }
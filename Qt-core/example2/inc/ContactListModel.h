@@ -0,0 +1,26 @@
+#ifndef CONTACTLISTMODEL_H
+#define CONTACTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include "Contact.h"
+
+// Contacts shown in a QListView. Adding or removing a contact inserts or
+// removes just its row instead of rebuilding the whole list.
+class ContactListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit ContactListModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void addContact(const ContactPtr& contact);
+    void removeContact(int row);
+    ContactPtr contactAt(int row) const;
+
+private:
+    QList<ContactPtr> m_contacts;
+};
+#endif // CONTACTLISTMODEL_H
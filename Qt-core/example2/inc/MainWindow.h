@@ -5,10 +5,11 @@
 #include <QList>
 #include <QHash>
 #include <QSharedPointer>
-#include <QListWidgetItem>
+#include <QListView>
 #include <QLabel>
 #include <QPushButton>
 #include "Contact.h"
+#include "ContactListModel.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -17,19 +18,18 @@ public:
     MainWindow(QWidget* parent = nullptr);
 
 private slots:
-    void showContactDetails(QListWidgetItem* item);
+    void showContactDetails(const QModelIndex& index);
     void addContact();
     void removeContact();
 
 private:
     void setupUI();
-    void updateContactList();
 
-    QList<ContactPtr> m_contacts;
+    ContactListModel* m_contactModel;
     QHash<QString, ContactPtr> m_contactsHash;
 
     // UI Elements
-    QListWidget* m_contactList;
+    QListView* m_contactList;
     QLabel* m_nameLabel;
     QLabel* m_phoneLabel;
     QLabel* m_emailLabel;
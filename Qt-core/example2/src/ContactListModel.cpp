@@ -0,0 +1,34 @@
+#include "ContactListModel.h"
+
+ContactListModel::ContactListModel(QObject* parent) : QAbstractListModel(parent) {}
+
+int ContactListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : int(m_contacts.size());
+}
+
+QVariant ContactListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_contacts.size() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    return m_contacts.at(index.row())->name();
+}
+
+void ContactListModel::addContact(const ContactPtr& contact) {
+    const int row = int(m_contacts.size());
+    beginInsertRows(QModelIndex(), row, row);
+    m_contacts.append(contact);
+    endInsertRows();
+}
+
+void ContactListModel::removeContact(int row) {
+    if (row < 0 || row >= m_contacts.size()) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    m_contacts.removeAt(row);
+    endRemoveRows();
+}
+
+ContactPtr ContactListModel::contactAt(int row) const {
+    return row >= 0 && row < m_contacts.size() ? m_contacts.at(row) : ContactPtr();
+}
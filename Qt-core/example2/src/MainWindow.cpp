@@ -2,17 +2,18 @@
 #include "ContactDialog.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QListWidgetItem>
 #include <QMessageBox>
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     setupUI();
-    updateContactList();
 }
 
 void MainWindow::setupUI() {
     // Widgets initialization
-    m_contactList = new QListWidget(this);
+    m_contactModel = new ContactListModel(this);
+    m_contactList = new QListView(this);
+    m_contactList->setModel(m_contactModel);
+    m_contactList->setUniformItemSizes(true);  // rows are laid out without measuring each one
     m_nameLabel = new QLabel("Name:", this);
     m_phoneLabel = new QLabel("Phone:", this);
     m_emailLabel = new QLabel("Email:", this);
@@ -37,20 +38,13 @@ void MainWindow::setupUI() {
     resize(400, 300);
 
     // Connections
-    connect(m_contactList, &QListWidget::itemClicked, this, &MainWindow::showContactDetails);
+    connect(m_contactList, &QListView::clicked, this, &MainWindow::showContactDetails);
     connect(m_addButton, &QPushButton::clicked, this, &MainWindow::addContact);
     connect(m_removeButton, &QPushButton::clicked, this, &MainWindow::removeContact);
 }
 
-void MainWindow::updateContactList() {
-    m_contactList->clear();
-    for (const auto& contact : m_contacts) {
-        new QListWidgetItem(contact->name(), m_contactList);
-    }
-}
-
-void MainWindow::showContactDetails(QListWidgetItem* item) {
-    if (auto contact = m_contactsHash.value(item->text())) {
+void MainWindow::showContactDetails(const QModelIndex& index) {
+    if (auto contact = m_contactModel->contactAt(index.row())) {
         m_nameLabel->setText("Name: " + contact->name());
         m_phoneLabel->setText("Phone: " + contact->phone());
         m_emailLabel->setText("Email: " + contact->email());
@@ -62,9 +56,8 @@ void MainWindow::addContact() {
     if (dialog->exec() == QDialog::Accepted) {
         auto contact = dialog->getContact();
         if (!m_contactsHash.contains(contact->name())) {
-            m_contacts.append(contact);
             m_contactsHash.insert(contact->name(), contact);
-            updateContactList();
+            m_contactModel->addContact(contact);
         } else {
             QMessageBox::warning(this, "Duplicate", "Contact already exists!");
         }
@@ -72,11 +65,9 @@ void MainWindow::addContact() {
 }
 
 void MainWindow::removeContact() {
-    if (auto currentItem = m_contactList->currentItem()) {
-        QString name = currentItem->text();
-        m_contactsHash.remove(name);
-        m_contacts.erase(std::remove_if(m_contacts.begin(), m_contacts.end(),
-            [&](const ContactPtr& c) { return c->name() == name; }), m_contacts.end());
-        updateContactList();
+    const QModelIndex current = m_contactList->currentIndex();
+    if (auto contact = m_contactModel->contactAt(current.row())) {
+        m_contactsHash.remove(contact->name());
+        m_contactModel->removeContact(current.row());
     }
 }
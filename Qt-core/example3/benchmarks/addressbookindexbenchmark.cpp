@@ -0,0 +1,142 @@
+// Cost per operation of the AddressBook indexes as the book grows.
+//
+// For every size the benchmark fills an address book, then times a batch
+// of lookups by ID, full name, email and phone number, edits of indexed
+// fields through Person setters, adds at the end of the book, removes of
+// random contacts from all over it and adds that reuse the freed slots.
+// With constant-time indexes the cost per operation stays flat from the
+// smallest book to the largest; lookups by name grow only with the number
+// of namesakes they return. The search index drops the keys of removed
+// contacts in batches, once a sixteenth of the book has gone, so removes
+// only include that share in books of at most 16 times --operations.
+//
+//   addressbook-index-benchmark [--sizes <n,...>] [--operations <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QSet>
+#include "addressbook.h"
+#include "contactbenchmark.h"
+
+using namespace ContactBenchmark;
+
+namespace {
+
+struct Sample {
+    AddressBook::Handle handle;
+    AddressBook::ContactId id;
+    QString fullName;
+    QString email;
+    QString phone;
+};
+
+// Nanoseconds per call of function over count calls
+template <typename Function>
+double nsPerOperation(int count, Function function)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        function(i);
+    }
+    return double(timer.nsecsElapsed()) / count;
+}
+
+void measure(int size, int operations)
+{
+    AddressBook book;
+    fillBook(book, size);
+    // Picks of contacts and the contacts added later, apart from the fill
+    QRandomGenerator rng(2);
+    
+    // Lookup keys of random contacts, copied out before timing
+    const QList<AddressBook::Handle> handles = book.getAllContacts();
+    const ContactStore &store = book.store();
+    QList<Sample> samples;
+    for (int i = 0; i < operations; ++i) {
+        const AddressBook::Handle handle = handles.at(rng.bounded(int(handles.size())));
+        samples.append({handle, store.id(handle), store.fullName(handle),
+                        store.string(handle, ContactStore::Email),
+                        store.string(handle, ContactStore::Phone)});
+    }
+    
+    qint64 found = 0;
+    qint64 namesakes = 0;
+    const double byId = nsPerOperation(operations, [&](int i) {
+        found += book.findById(samples.at(i).id) == samples.at(i).handle;
+    });
+    const double byName = nsPerOperation(operations, [&](int i) {
+        namesakes += book.findByName(samples.at(i).fullName).size();
+    });
+    const double byEmail = nsPerOperation(operations, [&](int i) {
+        found += book.findByEmail(samples.at(i).email).size();
+    });
+    const double byPhone = nsPerOperation(operations, [&](int i) {
+        found += book.findByPhone(samples.at(i).phone).size();
+    });
+    
+    // Edits go through the Person of each contact, like the form does
+    QList<Person*> persons;
+    for (const Sample &sample : samples) {
+        persons.append(book.person(sample.handle));
+    }
+    const double edit = nsPerOperation(operations, [&](int i) {
+        Person *person = persons.at(i);
+        person->setLastName(person->lastName() + QLatin1Char('x'));
+        person->setEmail(QLatin1Char('x') + person->email());
+    });
+    // A contact may have been sampled more than once
+    for (Person *person : QSet<Person*>(persons.begin(), persons.end())) {
+        book.releasePerson(person);
+    }
+    
+    const double add = nsPerOperation(operations, [&](int i) {
+        book.addContact(generateContact(size + i, rng));
+    });
+    
+    // Distinct random contacts, which sit in the middle of every column
+    // and posting rather than at their end
+    QList<AddressBook::Handle> victims = handles;
+    for (int i = 0; i < operations && i < victims.size(); ++i) {
+        victims.swapItemsAt(i, i + rng.bounded(int(victims.size()) - i));
+    }
+    victims.resize(qMin<qsizetype>(operations, victims.size()));
+    QList<ContactStore::Contact> removed;
+    for (AddressBook::Handle handle : victims) {
+        removed.append(store.contact(handle));
+    }
+    const int removals = int(victims.size());
+    const double remove = nsPerOperation(removals, [&](int i) {
+        book.removeContact(victims.at(i));
+    });
+    const double reAdd = nsPerOperation(removals, [&](int i) {
+        book.addContact(removed.at(i));
+    });
+    
+    qInfo("%9d contacts: id %7.0f ns, name %7.0f ns (%.1f matches), email %7.0f ns, phone %7.0f ns, "
+          "edit %7.0f ns, add %7.0f ns, remove %7.0f ns, add into freed slot %7.0f ns (%lld found)",
+          size, byId, byName, double(namesakes) / operations, byEmail, byPhone, edit, add, remove, reAdd,
+          found);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption =
+        ContactBenchmark::sizesOption(QStringLiteral("1000,10000,100000,1000000"));
+    QCommandLineOption operationsOption("operations", "Operations timed per kind and size.", "n", "10000");
+    parser.addOption(sizesOption);
+    parser.addOption(operationsOption);
+    parser.process(app);
+    
+    const int operations = qMax(1, parser.value(operationsOption).toInt());
+    for (int size : sizes(parser, sizesOption, ContactStore::MaxContacts - operations)) {
+        measure(size, operations);
+    }
+    return 0;
+}
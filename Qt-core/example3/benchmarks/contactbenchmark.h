@@ -0,0 +1,133 @@
+#ifndef CONTACTBENCHMARK_H
+#define CONTACTBENCHMARK_H
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QList>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <algorithm>
+#include "addressbook.h"
+#include "contactstore.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Helpers shared by the address book benchmarks.
+namespace ContactBenchmark {
+
+// The contact at position index of a synthetic address book. Full names
+// repeat, about fifteen times each in a million contacts, while emails and
+// phone numbers are unique.
+inline ContactStore::Contact generateContact(int index, QRandomGenerator &rng)
+{
+    static const QStringList firstNames = {
+        "James", "Mary", "John", "Patricia", "Robert", "Jennifer", "Michael", "Linda",
+        "William", "Elizabeth", "David", "Barbara", "Richard", "Susan", "Joseph", "Jessica",
+        "Thomas", "Sarah", "Charles", "Karen", "Ahmed", "Fatima", "Wei", "Mei",
+        "Carlos", "Sofia", "Ivan", "Olga", "Hiroshi", "Yuki", "Omar", "Layla"
+    };
+    // Last names are a stem and an ending, about two thousand of them
+    static const QStringList stems = {
+        "Ander", "Bald", "Carl", "Dal", "Eck", "Fair", "Gold", "Hart",
+        "Ing", "Jen", "Kirk", "Lind", "Mar", "Nor", "Ols", "Pem",
+        "Quin", "Ross", "Stan", "Thorn", "Ulm", "Van", "Wal", "York",
+        "Ash", "Brook", "Crane", "Dun", "Ell", "Ford", "Grim", "Hol",
+        "Kov", "Lew", "Mont", "Nash", "Ost", "Pratt", "Rid", "Shel",
+        "Tan", "Ward", "Wes", "Zell"
+    };
+    static const QStringList endings = {
+        "son", "sen", "man", "berg", "ley", "ton", "field", "wood",
+        "er", "ard", "ing", "ford", "stein", "ski", "ov", "ez",
+        "ini", "ston", "well", "by", "more", "ham", "ridge", "dale",
+        "ich", "ova", "ello", "ström", "ke", "ner", "quist", "ow",
+        "ara", "ida", "ani", "ic", "ett", "ock", "oni", "ay",
+        "ens", "ers", "ell", "oux", "yn", "az"
+    };
+    static const QStringList domains = {
+        "example.com", "mail.example.org", "corp.example.net", "example.co.uk"
+    };
+    
+    ContactStore::Contact contact;
+    contact.firstName = firstNames.at(rng.bounded(int(firstNames.size())));
+    contact.lastName = stems.at(rng.bounded(int(stems.size())))
+                       + endings.at(rng.bounded(int(endings.size())));
+    contact.birthDate = QDate(1940, 1, 1).addDays(rng.bounded(365 * 65));
+    contact.email = QStringLiteral("%1.%2%3@%4")
+                        .arg(contact.firstName.toLower(), contact.lastName.toLower())
+                        .arg(index)
+                        .arg(domains.at(index % domains.size()));
+    contact.phone = QStringLiteral("+1 (%1) 555-%2")
+                        .arg(200 + index / 10000 % 800)
+                        .arg(index % 10000, 4, 10, QLatin1Char('0'));
+    contact.vip = rng.bounded(20) == 0;
+    return contact;
+}
+
+// Add the first size synthetic contacts to book, the same ones in every
+// benchmark and every run
+inline void fillBook(AddressBook &book, int size)
+{
+    QRandomGenerator rng(1);
+    for (int i = 0; i < size; ++i) {
+        book.addContact(generateContact(i, rng));
+    }
+}
+
+// The --sizes option of the benchmarks: contact counts to measure at
+inline QCommandLineOption sizesOption(const QString &defaultSizes = QStringLiteral("10000,100000,1000000"))
+{
+    return QCommandLineOption(QStringLiteral("sizes"), QStringLiteral("Comma-separated contact counts."),
+                              QStringLiteral("n,..."), defaultSizes);
+}
+
+// The contact counts given with option, each between 1 and maxSize
+inline QList<int> sizes(const QCommandLineParser &parser, const QCommandLineOption &option,
+                        int maxSize = ContactStore::MaxContacts)
+{
+    QList<int> counts;
+    for (const QString &value : parser.value(option).split(',', Qt::SkipEmptyParts)) {
+        counts.append(qBound(1, value.toInt(), maxSize));
+    }
+    return counts;
+}
+
+// Bytes currently allocated from the heap, or -1 where that is unknown
+inline qint64 heapBytesInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return qint64(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+inline QString formatBytes(qint64 bytes)
+{
+    if (bytes < 0) {
+        return QStringLiteral("n/a");
+    }
+    return QStringLiteral("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+// Median wall time of runs calls of function, in milliseconds
+template <typename Function>
+double medianMs(int runs, Function function)
+{
+    QList<double> times;
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        times.append(timer.nsecsElapsed() / 1e6);
+    }
+    std::sort(times.begin(), times.end());
+    return times.at(times.size() / 2);
+}
+
+} // namespace ContactBenchmark
+
+#endif // CONTACTBENCHMARK_H
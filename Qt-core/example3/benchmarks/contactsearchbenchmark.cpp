@@ -0,0 +1,95 @@
+// Type-ahead latency of the contact search as the book grows.
+//
+// For every size the benchmark fills an address book and then, for a set of
+// queries typed a character at a time, measures how long the first page of
+// results takes to appear, the way the contact list fetches it, and how long
+// delivering every match takes. The first page should stay well under a
+// frame at every size, while the full drain grows with the number of
+// matches.
+//
+//   contact-search-benchmark [--sizes <n,...>] [--page <n>] [--runs <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include "addressbook.h"
+#include "contactbenchmark.h"
+
+using namespace ContactBenchmark;
+
+namespace {
+
+// Budget of the first fetch, as the contact list uses it
+const qint64 FirstPageBudgetNs = 1000000;
+
+// Queries typed one character at a time, so every prefix is searched
+const char *const Queries[] = {
+    "john",         // first name prefix
+    "anderson",     // last name
+    "erson",        // substring of last names
+    "mary hart",    // full name
+    "555-01",       // phone number
+    "@mail",        // email domain
+    "andersn",      // typo, found by similarity
+    "zzz"           // nothing
+};
+
+void measure(int size, int page, int runs)
+{
+    AddressBook book;
+    const qint64 heapBefore = heapBytesInUse();
+    fillBook(book, size);
+    qInfo("%d contacts, %s on the heap", size, qPrintable(formatBytes(heapBytesInUse() - heapBefore)));
+    
+    for (const char *query : Queries) {
+        const QString text = QString::fromLatin1(query);
+        
+        // Worst first page over the prefixes of the query
+        double firstPage = 0;
+        int shown = 0;
+        for (int length = 1; length <= text.size(); ++length) {
+            const QString prefix = text.left(length);
+            firstPage = qMax(firstPage, medianMs(runs, [&]() {
+                ContactSearch search = book.search(prefix);
+                QList<ContactSearch::Match> matches;
+                search.fetch(matches, page, FirstPageBudgetNs);
+                shown = int(matches.size());
+            }));
+        }
+        
+        int total = 0;
+        const double drain = medianMs(runs, [&]() {
+            ContactSearch search = book.search(text);
+            QList<ContactSearch::Match> matches;
+            while (search.fetch(matches, page, FirstPageBudgetNs)) {
+            }
+            total = int(matches.size());
+        });
+        
+        qInfo("  %-12s first page %8.3f ms (%4d shown), all %8.1f ms (%7d matches)",
+              query, firstPage, shown, drain, total);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption = ContactBenchmark::sizesOption();
+    QCommandLineOption pageOption("page", "Matches fetched per step.", "n", "100");
+    QCommandLineOption runsOption("runs", "Runs per measurement; the median is reported.", "n", "5");
+    parser.addOption(sizesOption);
+    parser.addOption(pageOption);
+    parser.addOption(runsOption);
+    parser.process(app);
+    
+    const int page = qMax(1, parser.value(pageOption).toInt());
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    for (int size : sizes(parser, sizesOption)) {
+        measure(size, page, runs);
+    }
+    return 0;
+}
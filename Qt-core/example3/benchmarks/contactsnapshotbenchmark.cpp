@@ -0,0 +1,129 @@
+// Time to open an address book snapshot and to answer the first queries.
+//
+// For every size the benchmark fills an address book, which is what
+// loading contacts one by one costs, and saves it as a snapshot. It then
+// opens the snapshot into new address books and times the open itself and
+// the first lookup by ID, name, email and phone number and the first page
+// of a search, which read their index from the file. Opening reads neither
+// the records nor the indexes, so it should take about as long for every
+// size. The first queries read the pages of the file they need, a page of
+// records among them, and should cost about what they cost on a filled
+// book.
+//
+// Runs after the first read the file from the page cache; drop the cache
+// between runs to see cold-start times.
+//
+//   contact-snapshot-benchmark [--sizes <n,...>] [--runs <n>] [--dir <path>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include "addressbook.h"
+#include "contactbenchmark.h"
+
+using namespace ContactBenchmark;
+
+namespace {
+
+struct Sample {
+    AddressBook::ContactId id;
+    QString fullName;
+    QString email;
+    QString phone;
+};
+
+double elapsedMs(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1e6;
+}
+
+void measure(int size, int runs, const QString &fileName)
+{
+    Sample sample;
+    {
+        AddressBook book;
+        QElapsedTimer timer;
+        timer.start();
+        fillBook(book, size);
+        const double fillMs = elapsedMs(timer);
+        
+        // A contact from the middle of the book to look up
+        const ContactStore &store = book.store();
+        const AddressBook::Handle handle = store.handleAt(size / 2);
+        sample = {store.id(handle), store.fullName(handle),
+                  store.string(handle, ContactStore::Email), store.string(handle, ContactStore::Phone)};
+        
+        timer.restart();
+        if (!book.save(fileName)) {
+            return;
+        }
+        qInfo("%d contacts: filled in %.0f ms, saved in %.0f ms, %s on disk",
+              size, fillMs, elapsedMs(timer), qPrintable(formatBytes(QFileInfo(fileName).size())));
+    }
+    
+    QList<double> openMs;
+    QList<double> firstQueryMs;
+    QList<double> firstSearchMs;
+    for (int run = 0; run < runs; ++run) {
+        AddressBook book;
+        const qint64 heapBefore = heapBytesInUse();
+        QElapsedTimer timer;
+        timer.start();
+        if (!book.open(fileName)) {
+            return;
+        }
+        openMs.append(elapsedMs(timer));
+        const qint64 heapAfter = heapBytesInUse();
+        
+        timer.restart();
+        int found = 0;
+        found += book.findById(sample.id) != ContactStore::InvalidHandle;
+        found += !book.findByName(sample.fullName).isEmpty();
+        found += !book.findByEmail(sample.email).isEmpty();
+        found += !book.findByPhone(sample.phone).isEmpty();
+        firstQueryMs.append(elapsedMs(timer));
+        
+        timer.restart();
+        ContactSearch search = book.search(sample.fullName.left(6));
+        QList<ContactSearch::Match> matches;
+        search.fetch(matches, 100, 1000000);
+        firstSearchMs.append(elapsedMs(timer));
+        
+        qInfo("  run %d: open %8.2f ms (%s on the heap), first lookups %7.3f ms (%d of 4 found), "
+              "first search page %7.3f ms (%d matches)",
+              run + 1, openMs.last(), qPrintable(formatBytes(heapAfter - heapBefore)), firstQueryMs.last(),
+              found, firstSearchMs.last(), int(matches.size()));
+    }
+    
+    std::sort(openMs.begin(), openMs.end());
+    std::sort(firstQueryMs.begin(), firstQueryMs.end());
+    std::sort(firstSearchMs.begin(), firstSearchMs.end());
+    qInfo("  median: open %.2f ms, first lookups %.3f ms, first search page %.3f ms",
+          openMs.at(runs / 2), firstQueryMs.at(runs / 2), firstSearchMs.at(runs / 2));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption = ContactBenchmark::sizesOption();
+    QCommandLineOption runsOption("runs", "Opens per size.", "n", "5");
+    QCommandLineOption dirOption("dir", "Directory for the snapshot files (default: a temporary one).", "path");
+    parser.addOption(sizesOption);
+    parser.addOption(runsOption);
+    parser.addOption(dirOption);
+    parser.process(app);
+    
+    QTemporaryDir temporaryDir;
+    const QString dir = parser.isSet(dirOption) ? parser.value(dirOption) : temporaryDir.path();
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    for (int size : sizes(parser, sizesOption)) {
+        measure(size, runs, QStringLiteral("%1/contacts-%2.snapshot").arg(dir).arg(size));
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Memory use and scan time of the address book, with the contacts in a
+// ContactStore against one Person QObject per contact.
+//
+// The QObject layout is the one AddressBook used before the store: a
+// QList<Person*> with a QMap from full name to person. For every size the
+// benchmark reports the heap growth of filling each layout, and the median
+// time of three scans that each read one or two fields of every contact.
+//
+//   contact-store-benchmark [--sizes <n,...>] [--runs <n>]
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QMap>
+#include "contactbenchmark.h"
+#include "person.h"
+
+using namespace ContactBenchmark;
+
+namespace {
+
+const QDate Cutoff(1970, 1, 1);
+
+struct Result {
+    qint64 heapBytes = 0;
+    qint64 storeBytes = -1;
+    double fillMs = 0;
+    double vipScanMs = 0;
+    double emailScanMs = 0;
+    double birthDateScanMs = 0;
+    qint64 matches = 0;
+};
+
+Result measurePersons(int size, int runs)
+{
+    Result result;
+    QRandomGenerator rng(1);
+    const qint64 heapBefore = heapBytesInUse();
+    
+    QElapsedTimer timer;
+    timer.start();
+    QList<Person*> people;
+    QMap<QString, Person*> nameIndex;
+    for (int i = 0; i < size; ++i) {
+        const ContactStore::Contact contact = generateContact(i, rng);
+        Person *person = new Person(contact.firstName, contact.lastName);
+        person->setBirthDate(contact.birthDate);
+        person->setEmail(contact.email);
+        person->setPhone(contact.phone);
+        person->setVip(contact.vip);
+        people.append(person);
+        nameIndex[person->fullName()] = person;
+    }
+    result.fillMs = timer.nsecsElapsed() / 1e6;
+    result.heapBytes = heapBefore < 0 ? -1 : heapBytesInUse() - heapBefore;
+    
+    result.vipScanMs = medianMs(runs, [&] {
+        for (const Person *person : people) {
+            result.matches += person->isVip();
+        }
+    });
+    result.emailScanMs = medianMs(runs, [&] {
+        for (const Person *person : people) {
+            result.matches += person->email().endsWith(u"@example.com");
+        }
+    });
+    result.birthDateScanMs = medianMs(runs, [&] {
+        for (const Person *person : people) {
+            result.matches += person->birthDate() < Cutoff;
+        }
+    });
+    
+    qDeleteAll(people);
+    return result;
+}
+
+Result measureStore(int size, int runs)
+{
+    Result result;
+    QRandomGenerator rng(1);
+    const qint64 heapBefore = heapBytesInUse();
+    
+    // The store alone, without the indexes AddressBook keeps next to it
+    QElapsedTimer timer;
+    timer.start();
+    ContactStore store;
+    for (int i = 0; i < size; ++i) {
+        store.add(generateContact(i, rng));
+    }
+    result.fillMs = timer.nsecsElapsed() / 1e6;
+    result.heapBytes = heapBefore < 0 ? -1 : heapBytesInUse() - heapBefore;
+    
+    // Scans walk the slots the way AddressBook::getAllVips() does
+    result.vipScanMs = medianMs(runs, [&] {
+        for (int slot = 0; slot < store.slotCount(); ++slot) {
+            const ContactStore::Handle handle = store.handleAt(slot);
+            result.matches += handle != ContactStore::InvalidHandle && store.isVip(handle);
+        }
+    });
+    result.emailScanMs = medianMs(runs, [&] {
+        for (int slot = 0; slot < store.slotCount(); ++slot) {
+            const ContactStore::Handle handle = store.handleAt(slot);
+            result.matches += handle != ContactStore::InvalidHandle
+                              && store.text(handle, ContactStore::Email).endsWith(u"@example.com");
+        }
+    });
+    result.birthDateScanMs = medianMs(runs, [&] {
+        for (int slot = 0; slot < store.slotCount(); ++slot) {
+            const ContactStore::Handle handle = store.handleAt(slot);
+            result.matches += handle != ContactStore::InvalidHandle && store.birthDate(handle) < Cutoff;
+        }
+    });
+    
+    result.storeBytes = store.memoryUsage();
+    return result;
+}
+
+void report(const char *label, int size, const Result &result)
+{
+    qInfo("  %-20s heap %s (%s bytes/contact), fill %.1f ms",
+          label, qPrintable(formatBytes(result.heapBytes)),
+          result.heapBytes < 0 ? "n/a" : qPrintable(QString::number(result.heapBytes / size)),
+          result.fillMs);
+    qInfo("  %-20s scan vip %.3f ms, email domain %.3f ms, birth date %.3f ms (%lld matches)",
+          "", result.vipScanMs, result.emailScanMs, result.birthDateScanMs, result.matches);
+    if (result.storeBytes >= 0) {
+        qInfo("  %-20s columns and text %s", "", qPrintable(formatBytes(result.storeBytes)));
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption = ContactBenchmark::sizesOption();
+    QCommandLineOption runsOption("runs", "Runs per scan; the median is reported.", "n", "5");
+    parser.addOption(sizesOption);
+    parser.addOption(runsOption);
+    parser.process(app);
+    
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    for (int size : sizes(parser, sizesOption)) {
+        qInfo("%d contacts", size);
+        report("QObject per contact", size, measurePersons(size, runs));
+        report("ContactStore", size, measureStore(size, runs));
+    }
+    return 0;
+}
@@ -1,98 +1,248 @@
 #include "addressbook.h"
 #include <QDebug>
+#include <QMetaMethod>
+#include <utility>
 
 AddressBook::AddressBook(QObject *parent)
-    : QObject(parent), m_vipCount(0)
+    : QObject(parent), m_searchIndex(&m_store), m_vipCount(0)
 {
 }
 
 AddressBook::~AddressBook()
 {
     // Clean up all Person objects
-    qDeleteAll(m_people);
-    m_people.clear();
-    m_nameIndex.clear();
+    const QList<Person*> persons = m_persons.values();
+    for (Person *person : persons) {
+        unbindPerson(person);
+    }
+    qDeleteAll(persons);
 }
 
 int AddressBook::contactCount() const
 {
-    return m_people.size();
+    return m_store.size();
 }
 
 int AddressBook::vipCount() const
 {
+    // The VIPs of an opened file are counted on first use
+    if (m_vipCount < 0) {
+        m_vipCount = 0;
+        for (int slot = 0; slot < m_store.slotCount(); ++slot) {
+            const Handle handle = m_store.handleAt(slot);
+            m_vipCount += handle != ContactStore::InvalidHandle && m_store.isVip(handle) ? 1 : 0;
+        }
+    }
     return m_vipCount;
 }
 
-void AddressBook::addPerson(Person *person)
+const ContactStore &AddressBook::store() const
 {
-    if (!person || m_people.contains(person)) {
-        return;
+    return m_store;
+}
+
+AddressBook::Handle AddressBook::addContact(const ContactStore::Contact &contact)
+{
+    const Handle handle = m_store.add(contact);
+    if (handle == ContactStore::InvalidHandle) {
+        qWarning() << "Address book is full, contact not added";
+        return handle;
     }
     
-    // Connect to the person's signals
-    connect(person, &Person::vipChanged, this, &AddressBook::onPersonVipChanged);
-    connect(person, &Person::fullNameChanged, [this, person](const QString &oldName) {
-        // Update the name index when a person's name changes
-        m_nameIndex.remove(oldName);
-        m_nameIndex[person->fullName()] = person;
-    });
-    
-    // Add the person to our collections
-    m_people.append(person);
-    m_nameIndex[person->fullName()] = person;
+    // Index the new contact
+    m_idIndex.insert(m_store.id(handle), handle);
+    indexField(handle, ContactStore::FirstName);
+    indexField(handle, ContactStore::Email);
+    indexField(handle, ContactStore::Phone);
+    m_searchIndex.addContact(handle);
     
     // Update VIP count if needed
-    if (person->isVip()) {
-        m_vipCount++;
-        emit vipCountChanged(m_vipCount);
+    if (contact.vip) {
+        changeVipCount(1);
     }
     
     // Emit signals
     emit contactCountChanged(contactCount());
-    emit personAdded(person);
+    emit contactAdded(handle);
+    return handle;
 }
 
-void AddressBook::removePerson(Person *person)
+void AddressBook::removeContact(Handle handle)
 {
-    if (!person || !m_people.contains(person)) {
+    if (!m_store.contains(handle)) {
         return;
     }
     
-    // Disconnect from the person's signals
-    disconnect(person, &Person::vipChanged, this, &AddressBook::onPersonVipChanged);
+    // The editing object goes away with its contact
+    if (Person *person = m_persons.value(handle)) {
+        unbindPerson(person);
+        person->deleteLater();
+    }
     
-    // Remove the person from our collections
-    m_people.removeOne(person);
-    m_nameIndex.remove(person->fullName());
+    // Drop the contact from the indexes
+    m_idIndex.remove(m_store.id(handle));
+    unindexField(handle, ContactStore::FirstName);
+    unindexField(handle, ContactStore::Email);
+    unindexField(handle, ContactStore::Phone);
+    m_searchIndex.removeContact(handle);
     
     // Update VIP count if needed
-    if (person->isVip()) {
-        m_vipCount--;
-        emit vipCountChanged(m_vipCount);
+    const bool vip = m_store.isVip(handle);
+    m_store.remove(handle);
+    if (vip) {
+        changeVipCount(-1);
     }
     
     // Emit signals
     emit contactCountChanged(contactCount());
-    emit personRemoved(person);
+    emit contactRemoved(handle);
 }
 
-Person* AddressBook::getPersonByName(const QString &fullName) const
+void AddressBook::addPerson(Person *person)
 {
-    return m_nameIndex.value(fullName, nullptr);
+    if (!person || m_personHandles.contains(person)) {
+        return;
+    }
+    
+    // Copy the person's values into the store
+    ContactStore::Contact contact;
+    contact.firstName = person->firstName();
+    contact.lastName = person->lastName();
+    contact.birthDate = person->birthDate();
+    contact.email = person->email();
+    contact.phone = person->phone();
+    contact.vip = person->isVip();
+    
+    const Handle handle = addContact(contact);
+    if (handle != ContactStore::InvalidHandle) {
+        bindPerson(person, handle);
+    }
+}
+
+void AddressBook::removePerson(Person *person)
+{
+    const Handle handle = handleOf(person);
+    if (handle == ContactStore::InvalidHandle) {
+        return;
+    }
+    
+    unbindPerson(person);
+    removeContact(handle);
+}
+
+Person* AddressBook::person(Handle handle)
+{
+    if (!m_store.contains(handle)) {
+        return nullptr;
+    }
+    if (Person *person = m_persons.value(handle)) {
+        return person;
+    }
+    
+    // Fill the person before binding it, so filling does not write back
+    Person *person = new Person(this);
+    person->setFirstName(m_store.string(handle, ContactStore::FirstName));
+    person->setLastName(m_store.string(handle, ContactStore::LastName));
+    person->setBirthDate(m_store.birthDate(handle));
+    person->setEmail(m_store.string(handle, ContactStore::Email));
+    person->setPhone(m_store.string(handle, ContactStore::Phone));
+    person->setVip(m_store.isVip(handle));
+    
+    bindPerson(person, handle);
+    return person;
 }
 
-QList<Person*> AddressBook::getAllPeople() const
+void AddressBook::releasePerson(Person *person)
 {
-    return m_people;
+    if (!person || !m_personHandles.contains(person)) {
+        return;
+    }
+    
+    unbindPerson(person);
+    delete person;
+}
+
+AddressBook::Handle AddressBook::handleOf(const Person *person) const
+{
+    return m_personHandles.value(person, ContactStore::InvalidHandle);
+}
+
+Person* AddressBook::getPersonByName(const QString &fullName)
+{
+    const QList<Handle> matches = findByName(fullName);
+    return matches.isEmpty() ? nullptr : person(matches.first());
+}
+
+AddressBook::Handle AddressBook::findById(ContactId id) const
+{
+    const Handle handle = m_idIndex.value(id, ContactStore::InvalidHandle);
+    if (handle != ContactStore::InvalidHandle || !m_snapshot) {
+        return handle;
+    }
+    
+    // Contacts of the snapshot are in its ID index, unless since removed;
+    // the store only gives a record the ID that leads back to it
+    const Handle loaded = m_store.handleAt(m_snapshot->findId(id));
+    return loaded != ContactStore::InvalidHandle && m_store.id(loaded) == id ? loaded : ContactStore::InvalidHandle;
+}
+
+QList<AddressBook::Handle> AddressBook::findByName(const QString &fullName) const
+{
+    return findInIndex(ContactStore::FirstName, fullName);
+}
+
+QList<AddressBook::Handle> AddressBook::findByEmail(const QString &email) const
+{
+    return findInIndex(ContactStore::Email, normalizedEmail(email));
+}
+
+QList<AddressBook::Handle> AddressBook::findByPhone(const QString &phone) const
+{
+    return findInIndex(ContactStore::Phone, normalizedPhone(phone));
+}
+
+ContactSearch AddressBook::search(const QString &query) const
+{
+    return ContactSearch(&m_searchIndex, query);
+}
+
+QString AddressBook::normalizedEmail(QStringView email)
+{
+    return email.trimmed().toString().toCaseFolded();
+}
+
+QString AddressBook::normalizedPhone(QStringView phone)
+{
+    QString digits;
+    digits.reserve(phone.size());
+    for (QChar c : phone) {
+        if (c.isDigit()) {
+            digits.append(c);
+        }
+    }
+    return digits;
+}
+
+QList<AddressBook::Handle> AddressBook::getAllContacts() const
+{
+    QList<Handle> contacts;
+    contacts.reserve(m_store.size());
+    for (int slot = 0; slot < m_store.slotCount(); ++slot) {
+        const Handle handle = m_store.handleAt(slot);
+        if (handle != ContactStore::InvalidHandle) {
+            contacts.append(handle);
+        }
+    }
+    return contacts;
 }
 
-QList<Person*> AddressBook::getAllVips() const
+QList<AddressBook::Handle> AddressBook::getAllVips() const
 {
-    QList<Person*> vips;
-    for (Person *person : m_people) {
-        if (person->isVip()) {
-            vips.append(person);
+    QList<Handle> vips;
+    for (int slot = 0; slot < m_store.slotCount(); ++slot) {
+        const Handle handle = m_store.handleAt(slot);
+        if (handle != ContactStore::InvalidHandle && m_store.isVip(handle)) {
+            vips.append(handle);
         }
     }
     return vips;
@@ -105,41 +255,258 @@ void AddressBook::printAllContacts() const
     qDebug() << "VIP Contacts:" << vipCount();
     qDebug() << "------------------------";
     
-    for (const Person *person : m_people) {
-        person->printInfo();
+    for (Handle handle : getAllContacts()) {
+        qDebug() << "Person Information:";
+        qDebug() << "  Name:" << m_store.fullName(handle);
+        qDebug() << "  Age:" << Person::ageFor(m_store.birthDate(handle));
+        qDebug() << "  Email:" << m_store.text(handle, ContactStore::Email);
+        qDebug() << "  Phone:" << m_store.text(handle, ContactStore::Phone);
+        qDebug() << "  VIP:" << (m_store.isVip(handle) ? "Yes" : "No");
         qDebug() << "------------------------";
     }
 }
 
-void AddressBook::onPersonVipChanged(bool vip)
+bool AddressBook::save(const QString &fileName) const
 {
-    // Get the person who emitted the signal
-    Person *person = qobject_cast<Person*>(sender());
-    if (!person) {
-        return;
+    QString errorString;
+    auto keyOf = [this](Handle handle, ContactStore::Field field) {
+        return indexKey(handle, field);
+    };
+    if (!ContactSnapshot::write(fileName, m_store, m_searchIndex, keyOf, &errorString)) {
+        qWarning() << "Could not save address book to" << fileName << ":" << errorString;
+        return false;
+    }
+    return true;
+}
+
+bool AddressBook::open(const QString &fileName)
+{
+    // The store reads the records as it uses them; the text stays in the
+    // file
+    auto snapshot = std::make_unique<ContactSnapshot>();
+    ContactStore store;
+    if (!snapshot->open(fileName) || !snapshot->load(store)) {
+        qWarning() << "Could not open address book" << fileName << ":" << snapshot->errorString();
+        return false;
     }
     
-    // Update VIP count
-    if (vip) {
-        m_vipCount++;
+    // Without the file's ID index, IDs are checked to be unique as the
+    // index is built
+    QHash<ContactId, Handle> idIndex;
+    if (!snapshot->hasIdIndex()) {
+        for (int slot = 0; slot < store.slotCount(); ++slot) {
+            const Handle handle = store.handleAt(slot);
+            const ContactId id = store.id(handle);
+            if (id == ContactStore::InvalidId) {
+                continue;
+            }
+            if (idIndex.contains(id)) {
+                qWarning() << "Could not open address book" << fileName << ": contact ID" << id << "is used twice";
+                return false;
+            }
+            idIndex.insert(id, handle);
+        }
+    }
+    
+    // The editing objects go away with the old contacts
+    const QList<Person*> persons = m_persons.values();
+    for (Person *person : persons) {
+        unbindPerson(person);
+        person->deleteLater();
+    }
+    m_idIndex = std::move(idIndex);
+    m_nameIndex.clear();
+    m_emailIndex.clear();
+    m_phoneIndex.clear();
+    m_searchIndex.clear();
+    
+    m_snapshotUnindexed.clear();
+    m_store = std::move(store);
+    m_snapshot = std::move(snapshot);
+    m_vipCount = -1;
+    
+    // Use the indexes of the file, and build those it does not have
+    const bool hasIndexes = m_snapshot->hasSearchIndex()
+                            && m_snapshot->hasKeyIndex(ContactStore::FirstName)
+                            && m_snapshot->hasKeyIndex(ContactStore::Email)
+                            && m_snapshot->hasKeyIndex(ContactStore::Phone);
+    const QList<Handle> handles = hasIndexes ? QList<Handle>() : getAllContacts();
+    for (ContactStore::Field field : {ContactStore::FirstName, ContactStore::Email, ContactStore::Phone}) {
+        if (!m_snapshot->hasKeyIndex(field)) {
+            for (Handle handle : handles) {
+                indexField(handle, field);
+            }
+        }
+    }
+    if (m_snapshot->hasSearchIndex()) {
+        m_searchIndex.attach(m_snapshot.get());
     } else {
-        m_vipCount--;
+        for (Handle handle : handles) {
+            m_searchIndex.addContact(handle);
+        }
     }
     
-    emit vipCountChanged(m_vipCount);
+    // Emit signals
+    emit contactsReset();
+    emit contactCountChanged(contactCount());
+    if (isSignalConnected(QMetaMethod::fromSignal(&AddressBook::vipCountChanged))) {
+        emit vipCountChanged(vipCount());
+    }
+    return true;
 }
 
-void AddressBook::updateVipCount()
+void AddressBook::bindPerson(Person *person, Handle handle)
 {
-    int count = 0;
-    for (const Person *person : m_people) {
-        if (person->isVip()) {
-            count++;
+    person->setParent(this);
+    m_persons.insert(handle, person);
+    m_personHandles.insert(person, handle);
+    
+    // Write every change of the person through to the store
+    auto writeField = [this, handle](ContactStore::Field field) {
+        return [this, handle, field](const QString &text) {
+            writeText(handle, field, text);
+        };
+    };
+    connect(person, &Person::firstNameChanged, this, writeField(ContactStore::FirstName));
+    connect(person, &Person::lastNameChanged, this, writeField(ContactStore::LastName));
+    connect(person, &Person::emailChanged, this, writeField(ContactStore::Email));
+    connect(person, &Person::phoneChanged, this, writeField(ContactStore::Phone));
+    connect(person, &Person::birthDateChanged, this, [this, handle](const QDate &birthDate) {
+        if (m_store.setBirthDate(handle, birthDate)) {
+            emit contactChanged(handle);
         }
+    });
+    connect(person, &Person::vipChanged, this, [this, handle](bool vip) {
+        if (!m_store.setVip(handle, vip)) {
+            return;
+        }
+        
+        // Update VIP count
+        changeVipCount(vip ? 1 : -1);
+        emit contactChanged(handle);
+    });
+}
+
+void AddressBook::unbindPerson(Person *person)
+{
+    disconnect(person, nullptr, this, nullptr);
+    m_persons.remove(m_personHandles.take(person));
+}
+
+void AddressBook::writeText(Handle handle, ContactStore::Field field, const QString &text)
+{
+    if (m_store.text(handle, field) == text) {
+        return;
+    }
+    
+    // Move the contact to the index entries of its new value
+    unindexField(handle, field);
+    m_searchIndex.removeField(handle, field);
+    m_store.setText(handle, field, text);
+    indexField(handle, field);
+    m_searchIndex.addField(handle, field);
+    
+    emit contactChanged(handle);
+}
+
+void AddressBook::indexField(Handle handle, ContactStore::Field field)
+{
+    const QString key = indexKey(handle, field);
+    if (!key.isEmpty()) {
+        indexFor(field).insert(qHash(key), handle);
+    }
+}
+
+void AddressBook::unindexField(Handle handle, ContactStore::Field field)
+{
+    // A contact still found through the snapshot's index only leaves it
+    if (inSnapshotIndex(handle, field)) {
+        m_snapshotUnindexed[ContactStore::slotOf(handle)] |= snapshotBit(field);
+        return;
+    }
+    
+    const QString key = indexKey(handle, field);
+    if (!key.isEmpty()) {
+        indexFor(field).remove(qHash(key), handle);
+    }
+}
+
+const QMultiHash<size_t, AddressBook::Handle> &AddressBook::indexFor(ContactStore::Field field) const
+{
+    switch (field) {
+    case ContactStore::Email:
+        return m_emailIndex;
+    case ContactStore::Phone:
+        return m_phoneIndex;
+    default:
+        return m_nameIndex;
+    }
+}
+
+QMultiHash<size_t, AddressBook::Handle> &AddressBook::indexFor(ContactStore::Field field)
+{
+    return const_cast<QMultiHash<size_t, Handle> &>(std::as_const(*this).indexFor(field));
+}
+
+QString AddressBook::indexKey(Handle handle, ContactStore::Field field) const
+{
+    switch (field) {
+    case ContactStore::Email:
+        return normalizedEmail(m_store.text(handle, ContactStore::Email));
+    case ContactStore::Phone:
+        return normalizedPhone(m_store.text(handle, ContactStore::Phone));
+    default:
+        return m_store.fullName(handle);
+    }
+}
+
+QList<AddressBook::Handle> AddressBook::findInIndex(ContactStore::Field field, const QString &key) const
+{
+    QList<Handle> matches;
+    if (key.isEmpty()) {
+        return matches;
     }
     
-    if (m_vipCount != count) {
-        m_vipCount = count;
-        emit vipCountChanged(m_vipCount);
+    // Contacts whose key only shares the hash are filtered out here
+    if (m_snapshot) {
+        for (int record : m_snapshot->findKey(field, key)) {
+            const Handle handle = m_store.handleAt(record);
+            if (inSnapshotIndex(handle, field) && indexKey(handle, field) == key) {
+                matches.append(handle);
+            }
+        }
+    }
+    const QMultiHash<size_t, Handle> &index = indexFor(field);
+    const auto range = index.equal_range(qHash(key));
+    for (auto it = range.first; it != range.second; ++it) {
+        if (indexKey(it.value(), field) == key) {
+            matches.append(it.value());
+        }
+    }
+    return matches;
+}
+
+bool AddressBook::inSnapshotIndex(Handle handle, ContactStore::Field field) const
+{
+    // Every record of the file is in its indexes until it leaves them
+    const int slot = ContactStore::slotOf(handle);
+    return m_snapshot && slot < m_snapshot->contactCount() && m_snapshot->hasKeyIndex(field)
+           && !(m_snapshotUnindexed.value(slot) & snapshotBit(field));
+}
+
+quint8 AddressBook::snapshotBit(ContactStore::Field field)
+{
+    // First and last name share the bit of the full name index
+    return quint8(1 << (field == ContactStore::LastName ? ContactStore::FirstName : field));
+}
+
+void AddressBook::changeVipCount(int change)
+{
+    // A count not taken yet sees the change once it is taken
+    if (m_vipCount >= 0) {
+        m_vipCount += change;
+    } else if (!isSignalConnected(QMetaMethod::fromSignal(&AddressBook::vipCountChanged))) {
+        return;
     }
+    emit vipCountChanged(vipCount());
 }
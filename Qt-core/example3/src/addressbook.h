@@ -3,9 +3,30 @@
 
 #include <QObject>
 #include <QList>
-#include <QMap>
+#include <QHash>
+#include <QMultiHash>
+#include <memory>
+#include "contactsearchindex.h"
+#include "contactsnapshot.h"
+#include "contactstore.h"
 #include "person.h"
 
+// Contacts are kept by value in a ContactStore. A Person object is only
+// created for a contact while it is being edited; its setters write through
+// to the store.
+//
+// Contacts can be looked up by ID, full name, email and phone number in
+// constant time. The name, email and phone indexes map a hash of the key to
+// the contacts with that hash and compare the key itself against the store,
+// so they hold no copies of the text. Every change to one of these fields
+// moves the contact between index entries right away. The same goes for
+// the type-ahead search index.
+//
+// An address book opened from a snapshot file reads the text of its
+// contacts and its indexes from the mapped file. A contact only moves to
+// the in-memory indexes once one of its indexed fields changes. Counting
+// the VIPs of the file reads every record, so it waits until vipCount() is
+// first called; open() only emits vipCountChanged when it is connected.
 class AddressBook : public QObject
 {
     Q_OBJECT
@@ -17,6 +38,9 @@ class AddressBook : public QObject
     Q_PROPERTY(int vipCount READ vipCount NOTIFY vipCountChanged)
     
 public:
+    using Handle = ContactStore::Handle;
+    using ContactId = ContactStore::ContactId;
+    
     explicit AddressBook(QObject *parent = nullptr);
     ~AddressBook();
     
@@ -24,43 +48,118 @@ public:
     int contactCount() const;
     int vipCount() const;
     
-    // Add a new person to the address book
+    // Read-only access to the contact values
+    const ContactStore &store() const;
+    
+    // Add a new contact to the address book
+    Handle addContact(const ContactStore::Contact &contact);
+    
+    // Remove a contact from the address book
+    void removeContact(Handle handle);
+    
+    // Add a new person to the address book; the address book takes
+    // ownership and keeps the person as the new contact's editing object
     void addPerson(Person *person);
     
-    // Remove a person from the address book
+    // Remove a person's contact from the address book and hand the person
+    // back to the caller
     void removePerson(Person *person);
     
-    // Get a person by their full name
-    Person* getPersonByName(const QString &fullName) const;
+    // Get the editing object of a contact, creating it if needed. It is
+    // owned by the address book and stays alive until released or until
+    // the contact is removed.
+    Person* person(Handle handle);
+    
+    // Let go of an editing object created by person()
+    void releasePerson(Person *person);
+    
+    // Get the contact a person is bound to
+    Handle handleOf(const Person *person) const;
+    
+    // Get a person by their full name, one of them if the name is shared
+    Person* getPersonByName(const QString &fullName);
+    
+    // Find contacts by key; only the ID is unique
+    Handle findById(ContactId id) const;
+    QList<Handle> findByName(const QString &fullName) const;
+    QList<Handle> findByEmail(const QString &email) const;
+    QList<Handle> findByPhone(const QString &phone) const;
+    
+    // Start a type-ahead search; see ContactSearch for what matches
+    ContactSearch search(const QString &query) const;
+    
+    // Emails are matched ignoring case and surrounding spaces, phone
+    // numbers by their digits only
+    static QString normalizedEmail(QStringView email);
+    static QString normalizedPhone(QStringView phone);
     
-    // Get all people in the address book
-    QList<Person*> getAllPeople() const;
+    // Get all contacts in the address book
+    QList<Handle> getAllContacts() const;
     
-    // Get all VIP people
-    QList<Person*> getAllVips() const;
+    // Get all VIP contacts
+    QList<Handle> getAllVips() const;
     
     // Print all contacts to the console
     void printAllContacts() const;
     
+    // Write all contacts and their indexes to a snapshot file
+    bool save(const QString &fileName) const;
+    
+    // Replace all contacts with those of a snapshot file. Handles and
+    // editing objects of the old contacts are no longer valid afterwards.
+    bool open(const QString &fileName);
+    
 signals:
     // Notification signals for property changes
     void contactCountChanged(int count);
     void vipCountChanged(int count);
-    void personAdded(Person *person);
-    void personRemoved(Person *person);
-    
-private slots:
-    // Slot to handle when a person's VIP status changes
-    void onPersonVipChanged(bool vip);
+    void contactAdded(Handle handle);
+    void contactRemoved(Handle handle);
+    void contactChanged(Handle handle);
+    void contactsReset();
     
 private:
-    // Private data members
-    QList<Person*> m_people;
-    QMap<QString, Person*> m_nameIndex;
-    int m_vipCount;
+    // Bind a person to a contact so its setters update the store
+    void bindPerson(Person *person, Handle handle);
+    void unbindPerson(Person *person);
+    
+    // Change a string field, keeping the indexes up to date
+    void writeText(Handle handle, ContactStore::Field field, const QString &text);
+    
+    // Add or remove the index entry that depends on a field
+    void indexField(Handle handle, ContactStore::Field field);
+    void unindexField(Handle handle, ContactStore::Field field);
+    
+    // The index a field is kept in, and a contact's key in that index.
+    // First and last name share the index on the full name.
+    const QMultiHash<size_t, Handle> &indexFor(ContactStore::Field field) const;
+    QMultiHash<size_t, Handle> &indexFor(ContactStore::Field field);
+    QString indexKey(Handle handle, ContactStore::Field field) const;
+    
+    // Contacts whose key in the field's index is key
+    QList<Handle> findInIndex(ContactStore::Field field, const QString &key) const;
+    
+    // Whether a contact is still found through the snapshot's index of a
+    // field, and the bit of m_snapshotUnindexed for that index
+    bool inSnapshotIndex(Handle handle, ContactStore::Field field) const;
+    static quint8 snapshotBit(ContactStore::Field field);
+    
+    // Apply a change to the VIP count and tell those connected
+    void changeVipCount(int change);
     
-    // Update VIP count
-    void updateVipCount();
+    // Private data members. The snapshot comes first, as the store and the
+    // search index may read from it until they are destroyed.
+    std::unique_ptr<ContactSnapshot> m_snapshot;
+    QHash<int, quint8> m_snapshotUnindexed;     // by slot, indexes of the snapshot the contact left
+    ContactStore m_store;
+    QHash<Handle, Person*> m_persons;
+    QHash<const Person*, Handle> m_personHandles;
+    QHash<ContactId, Handle> m_idIndex;
+    QMultiHash<size_t, Handle> m_nameIndex;
+    QMultiHash<size_t, Handle> m_emailIndex;
+    QMultiHash<size_t, Handle> m_phoneIndex;
+    ContactSearchIndex m_searchIndex;
+    mutable int m_vipCount;                     // -1 until counted
 };
 
 #endif // ADDRESSBOOK_H
@@ -0,0 +1,141 @@
+#include "contactlistmodel.h"
+#include <QFont>
+#include <algorithm>
+
+ContactListModel::ContactListModel(AddressBook *addressBook, QObject *parent)
+    : QAbstractListModel(parent), m_addressBook(addressBook), m_showingAll(false)
+{
+    connect(m_addressBook, &AddressBook::contactAdded, this, &ContactListModel::addContact);
+    connect(m_addressBook, &AddressBook::contactRemoved, this, &ContactListModel::removeContact);
+    connect(m_addressBook, &AddressBook::contactChanged, this, &ContactListModel::updateContact);
+    connect(m_addressBook, &AddressBook::contactsReset, this, &ContactListModel::reloadContacts);
+}
+
+int ContactListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_handles.size());
+}
+
+QVariant ContactListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_handles.size()) {
+        return QVariant();
+    }
+    
+    const AddressBook::Handle handle = m_handles.at(index.row());
+    const ContactStore &store = m_addressBook->store();
+    switch (role) {
+    case Qt::DisplayRole:
+        return store.fullName(handle);
+    case Qt::FontRole:
+        // Show VIPs in bold
+        if (store.isVip(handle)) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        return QVariant();
+    case HandleRole:
+        return handle;
+    default:
+        return QVariant();
+    }
+}
+
+void ContactListModel::showAllContacts()
+{
+    resetContacts(m_addressBook->getAllContacts(), true);
+}
+
+void ContactListModel::showContacts(const QList<AddressBook::Handle> &handles)
+{
+    resetContacts(handles, false);
+}
+
+void ContactListModel::appendContacts(const QList<AddressBook::Handle> &handles)
+{
+    if (handles.isEmpty()) {
+        return;
+    }
+    
+    const int first = int(m_handles.size());
+    beginInsertRows(QModelIndex(), first, first + int(handles.size()) - 1);
+    for (AddressBook::Handle handle : handles) {
+        m_rows.insert(handle, int(m_handles.size() + m_removedRows.size()));
+        m_handles.append(handle);
+    }
+    endInsertRows();
+}
+
+AddressBook::Handle ContactListModel::handleAt(int row) const
+{
+    return row >= 0 && row < m_handles.size() ? m_handles.at(row) : ContactStore::InvalidHandle;
+}
+
+int ContactListModel::rowOf(AddressBook::Handle handle) const
+{
+    const int row = m_rows.value(handle, -1);
+    if (row < 0) {
+        return -1;
+    }
+    return row - int(std::lower_bound(m_removedRows.begin(), m_removedRows.end(), row) - m_removedRows.begin());
+}
+
+void ContactListModel::addContact(AddressBook::Handle handle)
+{
+    if (m_showingAll) {
+        appendContacts({handle});
+    }
+}
+
+void ContactListModel::removeContact(AddressBook::Handle handle)
+{
+    const int row = rowOf(handle);
+    if (row < 0) {
+        return;
+    }
+    
+    beginRemoveRows(QModelIndex(), row, row);
+    m_handles.removeAt(row);
+    // The rows below move up by one, which rowOf() accounts for
+    const int numbered = m_rows.take(handle);
+    m_removedRows.insert(std::upper_bound(m_removedRows.begin(), m_removedRows.end(), numbered), numbered);
+    if (m_removedRows.size() >= MaxRemovedRows) {
+        renumberRows();
+    }
+    endRemoveRows();
+}
+
+void ContactListModel::updateContact(AddressBook::Handle handle)
+{
+    const int row = rowOf(handle);
+    if (row >= 0) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {Qt::DisplayRole, Qt::FontRole});
+    }
+}
+
+void ContactListModel::reloadContacts()
+{
+    // The handles of a chosen list are no longer valid
+    resetContacts(m_showingAll ? m_addressBook->getAllContacts() : QList<AddressBook::Handle>(), m_showingAll);
+}
+
+void ContactListModel::resetContacts(const QList<AddressBook::Handle> &handles, bool showingAll)
+{
+    beginResetModel();
+    m_handles = handles;
+    renumberRows();
+    m_showingAll = showingAll;
+    endResetModel();
+}
+
+void ContactListModel::renumberRows()
+{
+    m_rows.clear();
+    m_rows.reserve(m_handles.size());
+    for (int row = 0; row < m_handles.size(); ++row) {
+        m_rows.insert(m_handles.at(row), row);
+    }
+    m_removedRows.clear();
+}
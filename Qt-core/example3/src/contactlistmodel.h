@@ -0,0 +1,68 @@
+#ifndef CONTACTLISTMODEL_H
+#define CONTACTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include <vector>
+#include "addressbook.h"
+
+// A list of contacts of an AddressBook for a QListView: either all of them,
+// in store order, or a list chosen by the caller such as search results.
+//
+// Rows only hold handles and read names from the store when painted. The
+// model follows the address book signals and reports exactly the rows
+// that changed, so editing a contact repaints its row only and adding or
+// removing one inserts or removes a single row, however long the list is.
+class ContactListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    
+public:
+    enum Roles {
+        HandleRole = Qt::UserRole
+    };
+    
+    explicit ContactListModel(AddressBook *addressBook, QObject *parent = nullptr);
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    
+    // List every contact; contacts added later are appended
+    void showAllContacts();
+    
+    // List the given contacts only; contacts added later are not listed
+    void showContacts(const QList<AddressBook::Handle> &handles);
+    
+    // Add contacts to the end of the list
+    void appendContacts(const QList<AddressBook::Handle> &handles);
+    
+    // The contact of a row, and the row of a contact or -1
+    AddressBook::Handle handleAt(int row) const;
+    int rowOf(AddressBook::Handle handle) const;
+    
+private slots:
+    void addContact(AddressBook::Handle handle);
+    void removeContact(AddressBook::Handle handle);
+    void updateContact(AddressBook::Handle handle);
+    void reloadContacts();
+    
+private:
+    void resetContacts(const QList<AddressBook::Handle> &handles, bool showingAll);
+    void renumberRows();
+    
+    // Removals renumbered at once, often enough to keep m_removedRows short
+    static const size_t MaxRemovedRows = 1024;
+    
+    AddressBook *m_addressBook;
+    QList<AddressBook::Handle> m_handles;
+    // Row of every handle when the rows were last renumbered, and those of
+    // the contacts removed since, in order. Removing a contact moves the rows
+    // below it up without touching them here; rowOf() subtracts the removed
+    // rows above instead.
+    QHash<AddressBook::Handle, int> m_rows;
+    std::vector<int> m_removedRows;
+    bool m_showingAll;
+};
+
+#endif // CONTACTLISTMODEL_H
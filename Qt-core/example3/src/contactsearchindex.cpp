@@ -0,0 +1,735 @@
+#include "contactsearchindex.h"
+#include "contactsnapshot.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// Posting entries looked at between checks of the time budget
+const int WorkPerTimeCheck = 256;
+
+// Slots per block of a posting in memory; a full block is split in two,
+// and a posting from a snapshot is cut into half-full blocks
+const size_t MaxBlockSize = 1024;
+
+// A block left with fewer slots is merged with the next one if they fit
+const size_t MinBlockSize = MaxBlockSize / 4;
+
+// Stale keys are erased once their contacts make up this fraction of the
+// store, so a posting that lists every contact is rewritten once for every
+// sixteenth of its slots removed; and once there are this many at least
+const int PurgeFraction = 16;
+const size_t MinStaleKeysPerPurge = 1 << 16;
+
+const ContactStore::Field IndexedFields[] = {
+    ContactStore::FirstName,
+    ContactStore::LastName,
+    ContactStore::Email,
+    ContactStore::Phone
+};
+
+// Fields matched by similarity
+const ContactStore::Field SimilarFields[] = {
+    ContactStore::FirstName,
+    ContactStore::LastName,
+    ContactStore::Email
+};
+
+} // namespace
+
+ContactSearchIndex::ContactSearchIndex(const ContactStore *store)
+    : m_store(store)
+{
+}
+
+void ContactSearchIndex::attach(const ContactSnapshot *snapshot)
+{
+    m_postings.clear();
+    m_staleKeys.clear();
+    m_staleKeyCount = 0;
+    m_snapshot = snapshot;
+    m_revision++;
+}
+
+void ContactSearchIndex::addContact(Handle handle)
+{
+    for (ContactStore::Field field : IndexedFields) {
+        addField(handle, field);
+    }
+}
+
+void ContactSearchIndex::removeContact(Handle handle)
+{
+    // The keys stay in their postings until the next purge. The slot may
+    // have stale keys of an earlier contact already, none of them shared
+    // with this one.
+    const quint32 slot = quint32(ContactStore::slotOf(handle));
+    std::vector<quint64> &stale = m_staleKeys[slot];
+    std::vector<quint64> keys;
+    for (ContactStore::Field field : IndexedFields) {
+        collectKeys(field, indexedText(handle, field), keys);
+        stale.insert(stale.end(), keys.begin(), keys.end());
+        m_staleKeyCount += keys.size();
+    }
+    std::sort(stale.begin(), stale.end());
+    m_revision++;
+    
+    if (m_staleKeyCount >= MinStaleKeysPerPurge && m_staleKeys.size() > m_store->size() / PurgeFraction) {
+        purge();
+    }
+}
+
+void ContactSearchIndex::removeField(Handle handle, ContactStore::Field field)
+{
+    std::vector<quint64> keys;
+    collectKeys(field, indexedText(handle, field), keys);
+    
+    const quint32 slot = quint32(ContactStore::slotOf(handle));
+    for (quint64 key : keys) {
+        erase(key, &slot, &slot + 1);
+    }
+    m_revision++;
+}
+
+void ContactSearchIndex::addField(Handle handle, ContactStore::Field field)
+{
+    std::vector<quint64> keys;
+    collectKeys(field, indexedText(handle, field), keys);
+    const quint32 slot = quint32(ContactStore::slotOf(handle));
+    
+    // Stale keys of the slot that the field has are in their postings
+    // already and stop being stale; the others stay
+    const auto stale = m_staleKeys.find(slot);
+    if (stale != m_staleKeys.end()) {
+        std::vector<quint64> &staleKeys = stale.value();
+        std::vector<quint64> added;
+        std::set_difference(keys.begin(), keys.end(), staleKeys.begin(), staleKeys.end(),
+                            std::back_inserter(added));
+        const auto kept = std::set_difference(staleKeys.begin(), staleKeys.end(), keys.begin(), keys.end(),
+                                              staleKeys.begin());
+        m_staleKeyCount -= size_t(staleKeys.end() - kept);
+        staleKeys.erase(kept, staleKeys.end());
+        if (staleKeys.empty()) {
+            m_staleKeys.erase(stale);
+        }
+        keys.swap(added);
+    }
+    
+    for (quint64 key : keys) {
+        insertSlot(writablePosting(key), slot);
+    }
+    m_revision++;
+}
+
+void ContactSearchIndex::clear()
+{
+    m_postings.clear();
+    m_staleKeys.clear();
+    m_staleKeyCount = 0;
+    m_snapshot = nullptr;
+    m_revision++;
+}
+
+quint64 ContactSearchIndex::revision() const
+{
+    return m_revision;
+}
+
+qsizetype ContactSearchIndex::memoryUsage() const
+{
+    // A map node holds its block and about four pointers
+    qsizetype bytes = m_postings.capacity() * qsizetype(sizeof(quint64) + sizeof(Blocks));
+    for (const Blocks &posting : m_postings) {
+        bytes += posting.blocks.size() * (sizeof(BlockMap::value_type) + 4 * sizeof(void *));
+        for (const auto &block : posting.blocks) {
+            bytes += block.second.slots.capacity() * sizeof(quint32);
+        }
+    }
+    bytes += m_staleKeys.capacity() * qsizetype(sizeof(quint32) + sizeof(std::vector<quint64>));
+    for (const std::vector<quint64> &keys : m_staleKeys) {
+        bytes += keys.capacity() * sizeof(quint64);
+    }
+    return bytes;
+}
+
+quint64 ContactSearchIndex::key(KeyKind kind, ContactStore::Field field, QStringView chars)
+{
+    quint64 key = quint64(kind) << 62 | quint64(field) << 56 | quint64(qMin<qsizetype>(chars.size(), 3)) << 48;
+    for (qsizetype i = 0; i < chars.size() && i < 3; ++i) {
+        key |= quint64(chars[i].unicode()) << (32 - 16 * i);
+    }
+    return key;
+}
+
+QString ContactSearchIndex::foldCase(QStringView text)
+{
+    // Code unit by code unit, like the case insensitive comparisons that
+    // check the matches
+    QString folded(text.size(), Qt::Uninitialized);
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        folded[i] = QChar(char16_t(QChar::toCaseFolded(text[i].unicode())));
+    }
+    return folded;
+}
+
+QString ContactSearchIndex::digitsOf(QStringView text)
+{
+    QString digits;
+    digits.reserve(text.size());
+    for (QChar c : text) {
+        if (c.isDigit()) {
+            digits.append(c);
+        }
+    }
+    return digits;
+}
+
+QString ContactSearchIndex::indexedText(Handle handle, ContactStore::Field field) const
+{
+    const QStringView text = m_store->text(handle, field);
+    return field == ContactStore::Phone ? digitsOf(text) : foldCase(text);
+}
+
+void ContactSearchIndex::collectKeys(ContactStore::Field field, QStringView text, std::vector<quint64> &keys)
+{
+    keys.clear();
+    for (qsizetype length = 1; length <= qMin<qsizetype>(text.size(), 3); ++length) {
+        keys.push_back(key(Prefix, field, text.left(length)));
+    }
+    for (qsizetype i = 0; i + 3 <= text.size(); ++i) {
+        keys.push_back(key(Trigram, field, text.mid(i, 3)));
+    }
+    
+    // A trigram that occurs twice in a field is only indexed once
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+ContactSearchIndex::Posting ContactSearchIndex::posting(quint64 key) const
+{
+    const auto it = m_postings.constFind(key);
+    if (it != m_postings.cend()) {
+        Posting posting;
+        posting.blocks = &it->blocks;
+        posting.count = it->count;
+        return posting;
+    }
+    return m_snapshot ? m_snapshot->searchPosting(key) : Posting();
+}
+
+bool ContactSearchIndex::isStale(quint32 slot, quint64 key) const
+{
+    const auto it = m_staleKeys.constFind(slot);
+    return it != m_staleKeys.cend() && std::binary_search(it->cbegin(), it->cend(), key);
+}
+
+void ContactSearchIndex::purge()
+{
+    // Every posting is visited once, for the slots of all removed contacts
+    std::vector<std::pair<quint64, quint32>> entries;
+    entries.reserve(m_staleKeyCount);
+    for (auto it = m_staleKeys.cbegin(); it != m_staleKeys.cend(); ++it) {
+        for (quint64 key : it.value()) {
+            entries.emplace_back(key, it.key());
+        }
+    }
+    m_staleKeys.clear();
+    m_staleKeyCount = 0;
+    std::sort(entries.begin(), entries.end());
+    
+    std::vector<quint32> slots;
+    for (auto entry = entries.cbegin(); entry != entries.cend();) {
+        const quint64 key = entry->first;
+        slots.clear();
+        for (; entry != entries.cend() && entry->first == key; ++entry) {
+            slots.push_back(entry->second);
+        }
+        erase(key, slots.data(), slots.data() + slots.size());
+    }
+}
+
+void ContactSearchIndex::erase(quint64 key, const quint32 *begin, const quint32 *end)
+{
+    if (posting(key).isEmpty()) {
+        return;
+    }
+    Blocks &posting = writablePosting(key);
+    eraseSlots(posting, begin, end);
+    // An empty posting stays while it hides one of the snapshot
+    if (posting.count == 0 && (!m_snapshot || m_snapshot->searchPosting(key).isEmpty())) {
+        m_postings.remove(key);
+    }
+}
+
+ContactSearchIndex::Blocks &ContactSearchIndex::writablePosting(quint64 key)
+{
+    auto it = m_postings.find(key);
+    if (it == m_postings.end()) {
+        // The snapshot's slots stay in the file, a block at a time
+        Blocks posting;
+        const Posting base = m_snapshot ? m_snapshot->searchPosting(key) : Posting();
+        for (const quint32 *begin = base.begin; begin != base.end;) {
+            const quint32 size = quint32(qMin<size_t>(MaxBlockSize / 2, size_t(base.end - begin)));
+            Block block;
+            block.mapped = begin;
+            block.mappedSize = size;
+            posting.blocks.emplace_hint(posting.blocks.end(), posting.blocks.empty() ? 0 : *begin, std::move(block));
+            begin += size;
+        }
+        posting.count = base.size();
+        it = m_postings.emplace(key, std::move(posting));
+    }
+    return it.value();
+}
+
+void ContactSearchIndex::insertSlot(Blocks &posting, quint32 slot)
+{
+    BlockMap &blocks = posting.blocks;
+    auto block = blocks.upper_bound(slot);
+    if (block == blocks.begin()) {
+        block = blocks.emplace(0, Block()).first;
+    } else {
+        --block;
+    }
+    
+    // New contacts usually get the highest slot; past a full last block
+    // they start a new one, so appending leaves full blocks behind
+    if (std::next(block) == blocks.end() && block->second.size() >= MaxBlockSize && slot > block->second.last()) {
+        Block added;
+        added.slots.push_back(slot);
+        blocks.emplace_hint(blocks.end(), slot, std::move(added));
+        posting.count++;
+        return;
+    }
+    
+    std::vector<quint32> &slots = writableSlots(block->second);
+    const auto it = std::lower_bound(slots.begin(), slots.end(), slot);
+    if (it != slots.end() && *it == slot) {
+        return;
+    }
+    slots.insert(it, slot);
+    posting.count++;
+    
+    if (slots.size() > MaxBlockSize) {
+        Block upper;
+        upper.slots.assign(slots.begin() + slots.size() / 2, slots.end());
+        slots.resize(slots.size() / 2);
+        blocks.emplace_hint(std::next(block), upper.slots.front(), std::move(upper));
+    }
+}
+
+void ContactSearchIndex::eraseSlots(Blocks &posting, const quint32 *begin, const quint32 *end)
+{
+    BlockMap &blocks = posting.blocks;
+    while (begin != end && !blocks.empty()) {
+        // The slots that belong in one block
+        auto block = std::prev(blocks.upper_bound(*begin));
+        const auto next = std::next(block);
+        const quint32 *blockEnd = next == blocks.end() ? end : std::lower_bound(begin, end, next->first);
+        const quint32 *first = begin;
+        begin = blockEnd;
+        
+        // A block from a snapshot is only copied if it lists one of them
+        const bool listed = std::any_of(first, blockEnd, [&block](quint32 slot) {
+            return std::binary_search(block->second.begin(), block->second.end(), slot);
+        });
+        if (!listed) {
+            continue;
+        }
+        
+        // The runs of slots between them move down once each
+        std::vector<quint32> &slots = writableSlots(block->second);
+        auto kept = std::lower_bound(slots.begin(), slots.end(), *first);
+        auto run = kept;
+        for (; first != blockEnd; ++first) {
+            const auto it = std::lower_bound(run, slots.end(), *first);
+            if (it != slots.end() && *it == *first) {
+                kept = std::move(run, it, kept);
+                run = it + 1;
+            }
+        }
+        kept = std::move(run, slots.end(), kept);
+        posting.count -= size_t(slots.end() - kept);
+        slots.erase(kept, slots.end());
+        
+        // The first block stays, even empty, so that every slot has a block
+        if (slots.empty() && block != blocks.begin()) {
+            blocks.erase(block);
+        } else if (slots.size() < MinBlockSize && next != blocks.end()
+                   && slots.size() + next->second.size() <= MaxBlockSize) {
+            slots.insert(slots.end(), next->second.begin(), next->second.end());
+            blocks.erase(next);
+        }
+    }
+}
+
+std::vector<quint32> &ContactSearchIndex::writableSlots(Block &block)
+{
+    if (block.mapped) {
+        block.slots.assign(block.mapped, block.mapped + block.mappedSize);
+        block.mapped = nullptr;
+        block.mappedSize = 0;
+    }
+    return block.slots;
+}
+
+bool ContactSearchIndex::Posting::contains(quint32 slot) const
+{
+    if (!blocks) {
+        return std::binary_search(begin, end, slot);
+    }
+    auto block = blocks->upper_bound(slot);
+    if (block == blocks->begin()) {
+        return false;
+    }
+    --block;
+    return std::binary_search(block->second.begin(), block->second.end(), slot);
+}
+
+ContactSearchIndex::Posting::Iterator::Iterator(const Posting &posting)
+    : m_blocks(posting.blocks)
+{
+    if (m_blocks) {
+        m_block = m_blocks->begin();
+        enterBlock();
+    } else {
+        m_current = posting.begin;
+        m_end = posting.end;
+    }
+}
+
+void ContactSearchIndex::Posting::Iterator::next()
+{
+    if (++m_current == m_end && m_blocks) {
+        ++m_block;
+        enterBlock();
+    }
+}
+
+void ContactSearchIndex::Posting::Iterator::enterBlock()
+{
+    for (; m_block != m_blocks->end(); ++m_block) {
+        if (m_block->second.size() > 0) {
+            m_current = m_block->second.begin();
+            m_end = m_block->second.end();
+            return;
+        }
+    }
+    m_current = m_end = nullptr;
+}
+
+ContactSearch::ContactSearch(const ContactSearchIndex *index, const QString &query)
+    : m_index(index), m_revision(index->revision()), m_query(query)
+{
+    const QString trimmed = query.trimmed();
+    m_folded = ContactSearchIndex::foldCase(trimmed);
+    
+    // Phone numbers are matched by their digits, for queries without letters
+    if (std::none_of(trimmed.cbegin(), trimmed.cend(), [](QChar c) { return c.isLetter(); })) {
+        m_phoneDigits = ContactSearchIndex::digitsOf(trimmed);
+    }
+    
+    // Most of the query's trigrams have to be in one field for a similar
+    // match, which takes three of them at least
+    for (qsizetype i = 0; i + 3 <= m_folded.size(); ++i) {
+        const QString trigram = m_folded.mid(i, 3);
+        if (!m_similarTrigrams.contains(trigram)) {
+            m_similarTrigrams.append(trigram);
+        }
+    }
+    if (m_similarTrigrams.size() >= 3) {
+        m_similarThreshold = int((m_similarTrigrams.size() * 3 + 4) / 5);
+    }
+    
+    if (!m_folded.isEmpty()) {
+        enterRank(NamePrefix);
+    }
+}
+
+QString ContactSearch::query() const
+{
+    return m_query;
+}
+
+bool ContactSearch::fetch(QList<Match> &matches, int maxResults, qint64 budgetNs)
+{
+    if (!m_index || m_index->revision() != m_revision) {
+        m_rank = NoMatch;
+        return false;
+    }
+    
+    const ContactStore &store = *m_index->m_store;
+    QElapsedTimer timer;
+    timer.start();
+    int work = 0;
+    int nextTimeCheck = WorkPerTimeCheck;
+    int found = 0;
+    while (m_rank != NoMatch && found < maxResults) {
+        if (work >= nextTimeCheck) {
+            if (timer.nsecsElapsed() > budgetNs) {
+                break;
+            }
+            nextTimeCheck = work + WorkPerTimeCheck;
+        }
+        
+        const qint64 slot = nextSlot(work);
+        if (slot == Exhausted) {
+            enterRank(m_rank + 1);
+            continue;
+        }
+        
+        // A contact is delivered by the best rank it has, and only by that
+        const Handle handle = store.handleAt(int(slot));
+        if (handle != ContactStore::InvalidHandle && rankOf(handle) == m_rank) {
+            matches.append({handle, m_rank});
+            found++;
+        }
+    }
+    return m_rank != NoMatch;
+}
+
+bool ContactSearch::isFinished() const
+{
+    return m_rank == NoMatch;
+}
+
+ContactSearch::Rank ContactSearch::rankOf(Handle handle) const
+{
+    const ContactStore &store = *m_index->m_store;
+    const QStringView firstName = store.text(handle, ContactStore::FirstName);
+    const QStringView lastName = store.text(handle, ContactStore::LastName);
+    const QStringView email = store.text(handle, ContactStore::Email);
+    
+    if (firstName.startsWith(m_folded, Qt::CaseInsensitive)
+        || lastName.startsWith(m_folded, Qt::CaseInsensitive)
+        || matchesFullName(firstName, lastName)) {
+        return NamePrefix;
+    }
+    if (email.startsWith(m_folded, Qt::CaseInsensitive)) {
+        return OtherPrefix;
+    }
+    
+    QString phone;
+    if (!m_phoneDigits.isEmpty()) {
+        phone = ContactSearchIndex::digitsOf(store.text(handle, ContactStore::Phone));
+        if (phone.startsWith(m_phoneDigits)) {
+            return OtherPrefix;
+        }
+    }
+    
+    if (m_folded.size() >= 3
+        && (firstName.contains(m_folded, Qt::CaseInsensitive)
+            || lastName.contains(m_folded, Qt::CaseInsensitive)
+            || email.contains(m_folded, Qt::CaseInsensitive))) {
+        return Substring;
+    }
+    if (m_phoneDigits.size() >= 3 && phone.contains(m_phoneDigits)) {
+        return Substring;
+    }
+    // Only told apart from no match once the similar rank has started, as
+    // the earlier ranks only deliver their own matches
+    if (m_rank == Similar && isSimilar(handle)) {
+        return Similar;
+    }
+    return NoMatch;
+}
+
+bool ContactSearch::isSimilar(Handle handle) const
+{
+    // Counted in the fields rather than the postings, which can still list
+    // trigrams of a contact removed from the slot
+    const ContactStore &store = *m_index->m_store;
+    for (ContactStore::Field field : SimilarFields) {
+        const QStringView text = store.text(handle, field);
+        const auto shared = std::count_if(m_similarTrigrams.cbegin(), m_similarTrigrams.cend(),
+                                          [text](const QString &trigram) {
+            return text.contains(trigram, Qt::CaseInsensitive);
+        });
+        if (shared >= m_similarThreshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ContactSearch::matchesFullName(QStringView firstName, QStringView lastName) const
+{
+    // "john sm" matches John Smith
+    const qsizetype length = firstName.size();
+    const QStringView query(m_folded);
+    return query.size() > length
+           && query.at(length) == u' '
+           && query.left(length).compare(firstName, Qt::CaseInsensitive) == 0
+           && lastName.startsWith(query.mid(length + 1), Qt::CaseInsensitive);
+}
+
+void ContactSearch::enterRank(int rank)
+{
+    for (; rank < NoMatch; ++rank) {
+        if (startRank(Rank(rank))) {
+            return;
+        }
+    }
+    m_rank = NoMatch;
+}
+
+bool ContactSearch::startRank(Rank rank)
+{
+    m_rank = rank;
+    m_cursors.clear();
+    
+    switch (rank) {
+    case NamePrefix: {
+        // The first name part of "john sm" ends at the space
+        const qsizetype space = m_folded.indexOf(u' ');
+        addPrefixCursor(ContactStore::FirstName, space > 0 ? m_folded.left(space) : m_folded);
+        addPrefixCursor(ContactStore::LastName, m_folded);
+        break;
+    }
+    case OtherPrefix:
+        addPrefixCursor(ContactStore::Email, m_folded);
+        addPrefixCursor(ContactStore::Phone, m_phoneDigits);
+        break;
+    case Substring:
+        if (m_folded.size() >= 3) {
+            addTrigramCursor(ContactStore::FirstName, m_folded);
+            addTrigramCursor(ContactStore::LastName, m_folded);
+            addTrigramCursor(ContactStore::Email, m_folded);
+        }
+        if (m_phoneDigits.size() >= 3) {
+            addTrigramCursor(ContactStore::Phone, m_phoneDigits);
+        }
+        break;
+    case Similar:
+        if (m_similarThreshold > 0) {
+            for (ContactStore::Field field : SimilarFields) {
+                addSimilarCursors(field);
+            }
+        }
+        break;
+    case NoMatch:
+        break;
+    }
+    return !m_cursors.empty();
+}
+
+void ContactSearch::addPrefixCursor(ContactStore::Field field, const QString &text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    
+    // Longer queries are narrowed down by the check of every match
+    const quint64 key = ContactSearchIndex::key(ContactSearchIndex::Prefix, field, QStringView(text).left(3));
+    const Posting posting = m_index->posting(key);
+    if (!posting.isEmpty()) {
+        Cursor cursor;
+        cursor.driver = posting;
+        cursor.position = Posting::Iterator(posting);
+        m_cursors.push_back(cursor);
+    }
+}
+
+void ContactSearch::addSimilarCursors(ContactStore::Field field)
+{
+    std::vector<Posting> postings;
+    for (const QString &trigram : m_similarTrigrams) {
+        const quint64 key = ContactSearchIndex::key(ContactSearchIndex::Trigram, field, trigram);
+        const Posting posting = m_index->posting(key);
+        if (!posting.isEmpty()) {
+            postings.push_back(posting);
+        }
+    }
+    
+    // A contact with the threshold of these n trigrams lacks n - threshold
+    // of them at most, so it is in one of any n - threshold + 1. Only the
+    // rarest ones are walked, and their slots looked up in the others; the
+    // common trigrams, in most contacts, are never walked.
+    if (postings.size() < size_t(m_similarThreshold)) {
+        return;
+    }
+    std::sort(postings.begin(), postings.end(), [](const Posting &a, const Posting &b) {
+        return a.size() < b.size();
+    });
+    const size_t walked = postings.size() - size_t(m_similarThreshold) + 1;
+    for (size_t i = 0; i < walked; ++i) {
+        Cursor cursor;
+        cursor.driver = postings[i];
+        cursor.others = postings;
+        cursor.others.erase(cursor.others.begin() + qsizetype(i));
+        cursor.required = size_t(m_similarThreshold) - 1;
+        cursor.position = Posting::Iterator(postings[i]);
+        m_cursors.push_back(cursor);
+    }
+}
+
+void ContactSearch::addTrigramCursor(ContactStore::Field field, const QString &text)
+{
+    // Walk the shortest posting and look the slots up in the others
+    Cursor cursor;
+    for (qsizetype i = 0; i + 3 <= text.size(); ++i) {
+        const quint64 key = ContactSearchIndex::key(ContactSearchIndex::Trigram, field, QStringView(text).mid(i, 3));
+        const Posting posting = m_index->posting(key);
+        if (posting.isEmpty()) {
+            return;
+        }
+        if (cursor.driver.isEmpty() || posting.size() < cursor.driver.size()) {
+            if (!cursor.driver.isEmpty()) {
+                cursor.others.push_back(cursor.driver);
+            }
+            cursor.driver = posting;
+        } else if (!posting.isSameAs(cursor.driver)) {
+            cursor.others.push_back(posting);
+        }
+    }
+    cursor.required = cursor.others.size();
+    cursor.position = Posting::Iterator(cursor.driver);
+    m_cursors.push_back(cursor);
+}
+
+qint64 ContactSearch::nextSlot(int &work)
+{
+    // Union of the cursors, each slot once
+    qint64 next = Exhausted;
+    for (Cursor &cursor : m_cursors) {
+        const qint64 slot = peek(cursor, work);
+        if (slot != Exhausted && (next == Exhausted || slot < next)) {
+            next = slot;
+        }
+    }
+    if (next == Exhausted) {
+        return Exhausted;
+    }
+    
+    for (Cursor &cursor : m_cursors) {
+        if (cursor.current == next) {
+            cursor.position.next();
+            cursor.current = Unknown;
+        }
+    }
+    return next;
+}
+
+qint64 ContactSearch::peek(Cursor &cursor, int &work)
+{
+    if (cursor.current != Unknown) {
+        return cursor.current;
+    }
+    
+    for (; !cursor.position.atEnd(); cursor.position.next()) {
+        const quint32 slot = cursor.position.slot();
+        work++;
+        size_t listed = 0;
+        for (size_t i = 0; i < cursor.others.size() && listed < cursor.required
+                           && listed + cursor.others.size() - i >= cursor.required; ++i) {
+            listed += cursor.others[i].contains(slot) ? 1 : 0;
+        }
+        if (listed >= cursor.required) {
+            cursor.current = slot;
+            return slot;
+        }
+    }
+    cursor.current = Exhausted;
+    return Exhausted;
+}
@@ -0,0 +1,251 @@
+#ifndef CONTACTSEARCHINDEX_H
+#define CONTACTSEARCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <map>
+#include <vector>
+#include "contactstore.h"
+
+class ContactSnapshot;
+
+// Type-ahead search over the first name, last name, email and phone number
+// of the contacts in a ContactStore.
+//
+// Every field is indexed by its trigrams and by its first one, two and
+// three characters, each key mapping to the sorted slots of the contacts
+// that have it. Text is case folded and phone numbers are reduced to their
+// digits. Keys include the field, so changing one field only touches the
+// postings of that field, and the index is updated as fields change
+// instead of being rebuilt.
+//
+// Some keys, such as the "exa" of example.com or the first digit of a
+// phone number, are shared by nearly every contact. Postings are therefore
+// kept in an ordered map of blocks of a bounded number of slots, and adding
+// or removing a slot only moves the slots of one block, whatever the size
+// of the posting.
+//
+// Removing a contact does not touch its postings at all. Its keys are
+// kept as stale keys of its slot, which searches skip since the store has
+// no contact there, and are erased in one batch, a posting at a time, once
+// the removed contacts make up a sixteenth of the store. A contact added
+// into the slot before then keeps the stale keys it has too, as they are
+// in their postings already.
+//
+// The postings can also come from a ContactSnapshot. A posting from a
+// snapshot is split into blocks that point into the file when a change
+// first touches it, and a block is only copied into memory once it changes.
+class ContactSearchIndex
+{
+public:
+    using Handle = ContactStore::Handle;
+    
+    // Sorted slots of one block of a posting held in memory
+    struct Block {
+        const quint32 *mapped = nullptr;     // in a snapshot, until changed
+        quint32 mappedSize = 0;
+        std::vector<quint32> slots;
+        
+        const quint32 *begin() const { return mapped ? mapped : slots.data(); }
+        const quint32 *end() const { return mapped ? mapped + mappedSize : slots.data() + slots.size(); }
+        size_t size() const { return mapped ? mappedSize : slots.size(); }
+        quint32 last() const { return end()[-1]; }
+    };
+    
+    // Blocks by the lowest slot that belongs in them, starting at 0
+    using BlockMap = std::map<quint32, Block>;
+    
+    // Sorted slots of the contacts with one key: a single run of slots in a
+    // snapshot, or the blocks of a posting held in memory
+    struct Posting {
+        const quint32 *begin = nullptr;
+        const quint32 *end = nullptr;
+        const BlockMap *blocks = nullptr;
+        size_t count = 0;
+        
+        size_t size() const { return count; }
+        bool isEmpty() const { return count == 0; }
+        bool contains(quint32 slot) const;
+        bool isSameAs(const Posting &other) const { return begin == other.begin && blocks == other.blocks; }
+        
+        // Walks the slots of a posting in order
+        class Iterator
+        {
+        public:
+            Iterator() = default;
+            explicit Iterator(const Posting &posting);
+            
+            bool atEnd() const { return m_current == m_end; }
+            quint32 slot() const { return *m_current; }
+            void next();
+            
+        private:
+            void enterBlock();
+            
+            const BlockMap *m_blocks = nullptr;
+            BlockMap::const_iterator m_block;
+            const quint32 *m_current = nullptr;
+            const quint32 *m_end = nullptr;
+        };
+    };
+    
+    // The store must outlive the index
+    explicit ContactSearchIndex(const ContactStore *store);
+    
+    // Use the postings of a snapshot whose contacts were loaded into the
+    // store; the snapshot must stay open until the next clear()
+    void attach(const ContactSnapshot *snapshot);
+    
+    // Call after adding a contact to the store and before removing it
+    void addContact(Handle handle);
+    void removeContact(Handle handle);
+    
+    // Call around a change of one string field in the store
+    void removeField(Handle handle, ContactStore::Field field);
+    void addField(Handle handle, ContactStore::Field field);
+    
+    void clear();
+    
+    // Changes with every update, so searches can tell they are stale
+    quint64 revision() const;
+    
+    // Bytes allocated for the postings
+    qsizetype memoryUsage() const;
+    
+private:
+    friend class ContactSearch;
+    friend class ContactSnapshot;
+    
+    enum KeyKind : quint64 {
+        Trigram,
+        Prefix
+    };
+    
+    // A key packs its kind, field and up to three UTF-16 code units
+    static quint64 key(KeyKind kind, ContactStore::Field field, QStringView chars);
+    
+    // Text of a field as it is indexed
+    static QString foldCase(QStringView text);
+    static QString digitsOf(QStringView text);
+    QString indexedText(Handle handle, ContactStore::Field field) const;
+    
+    // A posting held in memory
+    struct Blocks {
+        BlockMap blocks;
+        size_t count = 0;
+    };
+    
+    static void collectKeys(ContactStore::Field field, QStringView text, std::vector<quint64> &keys);
+    Posting posting(quint64 key) const;
+    
+    // The in-memory posting of a key, split from the snapshot's if needed
+    Blocks &writablePosting(quint64 key);
+    
+    // Whether the posting of key lists slot for a removed contact
+    bool isStale(quint32 slot, quint64 key) const;
+    
+    // Erase the stale keys from their postings
+    void purge();
+    void erase(quint64 key, const quint32 *begin, const quint32 *end);
+    
+    static void insertSlot(Blocks &posting, quint32 slot);
+    static void eraseSlots(Blocks &posting, const quint32 *begin, const quint32 *end);
+    static std::vector<quint32> &writableSlots(Block &block);
+    
+    const ContactStore *m_store;
+    const ContactSnapshot *m_snapshot = nullptr;
+    QHash<quint64, Blocks> m_postings;     // override the snapshot's
+    QHash<quint32, std::vector<quint64>> m_staleKeys;     // sorted, by slot
+    size_t m_staleKeyCount = 0;
+    quint64 m_revision = 0;
+};
+
+// One run of a search, delivering its matches a batch at a time so a view
+// can show the best ones while the rest are still being looked for.
+//
+// Matches come best rank first: a first or last name (or the full name)
+// starting with the query, then an email or phone number starting with it,
+// then any of the fields containing it, and finally, for queries of five
+// or more characters, names and emails sharing most of the query's
+// trigrams. Queries shorter than three characters only match prefixes.
+// Within a rank, similar matches included, matches come in store order and
+// not by how close they are, so that every rank can be delivered as it is
+// found.
+class ContactSearch
+{
+public:
+    using Handle = ContactStore::Handle;
+    
+    enum Rank {
+        NamePrefix,
+        OtherPrefix,
+        Substring,
+        Similar,
+        NoMatch
+    };
+    
+    struct Match {
+        Handle handle;
+        Rank rank;
+    };
+    
+    // A search without matches
+    ContactSearch() = default;
+    ContactSearch(const ContactSearchIndex *index, const QString &query);
+    
+    QString query() const;
+    
+    // Append up to maxResults more matches, working for about budgetNs at
+    // most. Returns false once every match has been delivered, or when the
+    // index changed since the search started; run a new search then.
+    bool fetch(QList<Match> &matches, int maxResults, qint64 budgetNs);
+    bool isFinished() const;
+    
+private:
+    using Posting = ContactSearchIndex::Posting;
+    
+    // The slots of one field's posting that are also in required of others
+    struct Cursor {
+        Posting driver;
+        std::vector<Posting> others;
+        size_t required = 0;
+        Posting::Iterator position;
+        qint64 current = Unknown;     // slot at position, once checked
+    };
+    static constexpr qint64 Unknown = -2;
+    static constexpr qint64 Exhausted = -1;
+    
+    Rank rankOf(Handle handle) const;
+    bool isSimilar(Handle handle) const;
+    bool matchesFullName(QStringView firstName, QStringView lastName) const;
+    
+    // Move on to the first rank from rank on that can match anything
+    void enterRank(int rank);
+    bool startRank(Rank rank);
+    void addPrefixCursor(ContactStore::Field field, const QString &text);
+    void addTrigramCursor(ContactStore::Field field, const QString &text);
+    void addSimilarCursors(ContactStore::Field field);
+    
+    // Next slot of the current rank's cursors, or Exhausted; work counts
+    // the posting entries looked at
+    qint64 nextSlot(int &work);
+    qint64 peek(Cursor &cursor, int &work);
+    
+    const ContactSearchIndex *m_index = nullptr;
+    quint64 m_revision = 0;
+    QString m_query;
+    QString m_folded;
+    QString m_phoneDigits;
+    
+    Rank m_rank = NoMatch;
+    std::vector<Cursor> m_cursors;
+    
+    // Distinct trigrams of the query, and how many of them a field needs
+    // for a similar match, or 0 for queries too short for one
+    QStringList m_similarTrigrams;
+    int m_similarThreshold = 0;
+};
+
+#endif // CONTACTSEARCHINDEX_H
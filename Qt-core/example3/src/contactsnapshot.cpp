@@ -0,0 +1,667 @@
+#include "contactsnapshot.h"
+#include <QSaveFile>
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+// Layout of the file. Every structure is written in the byte order of the
+// writer, which the reader checks, and every section starts at a multiple
+// of 8 bytes.
+
+const char Magic[8] = {'Q', 'A', 'B', 'O', 'O', 'K', '\r', '\n'};
+const quint32 ByteOrderMark = 0x01020304;
+
+struct FileHeader {
+    char magic[8];
+    quint16 majorVersion;
+    quint16 minorVersion;
+    quint32 headerSize;         // offset of the section table
+    quint32 sectionCount;
+    quint32 recordSize;
+    quint32 contactCount;
+    quint32 vipCount;           // not read back, the records' flags are counted
+    quint32 nextId;
+    quint32 byteOrder;
+};
+
+struct SectionEntry {
+    quint32 type;
+    quint32 version;
+    quint64 offset;
+    quint64 size;
+};
+
+enum SectionType : quint32 {
+    StringsSection = 1,         // UTF-16 code units
+    RecordsSection = 2,         // contactCount records of recordSize bytes
+    IdIndexSection = 3,         // pairs of ID and record, by ID
+    NameIndexSection = 4,       // key tables, see KeyTableHeader
+    EmailIndexSection = 5,
+    PhoneIndexSection = 6,
+    SearchIndexSection = 7      // see ContactSearchIndex and readSearchIndex()
+};
+
+// Versions of the sections this reader knows and the writer writes. The
+// search index version changes with the keys of ContactSearchIndex.
+const quint32 StringsVersion = 1;
+const quint32 RecordsVersion = 1;
+const quint32 IdIndexVersion = 1;
+const quint32 KeyIndexVersion = 1;
+const quint32 SearchIndexVersion = 1;
+
+struct RecordText {
+    quint32 offset;             // into the string table
+    quint32 length;
+};
+
+// Newer writers may add fields at the end, so records are read from the
+// start and recordSize apart
+struct Record {
+    quint32 id;
+    RecordText text[4];         // by ContactStore::Field
+    qint32 birthDay;            // Julian day, INT_MIN for none
+    quint32 flags;
+};
+
+static_assert(ContactStore::FieldCount == 4, "records hold four string fields");
+
+enum RecordFlag : quint32 {
+    RecordVip = 0x1
+};
+
+// A key table is this header, bucketCount + 1 bucket starts, and then the
+// entries of all buckets, each a hash check and a record. A key is in the
+// bucket of the low bits of its keyHash() and has the high 32 bits as its
+// check.
+struct KeyTableHeader {
+    quint32 bucketCount;        // a power of two
+    quint32 entryCount;
+};
+
+const quint32 SectionAlignment = 8;
+
+template <typename T>
+void appendValue(QByteArray &bytes, const T &value)
+{
+    bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+void appendArray(QByteArray &bytes, const T *values, size_t count)
+{
+    bytes.append(reinterpret_cast<const char *>(values), qsizetype(count * sizeof(T)));
+}
+
+// Value of type T at an offset the caller checked
+template <typename T>
+T readValue(const uchar *data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+bool isAligned(const void *pointer, size_t alignment)
+{
+    return reinterpret_cast<quintptr>(pointer) % alignment == 0;
+}
+
+} // namespace
+
+bool ContactSnapshot::open(const QString &fileName)
+{
+    close();
+    m_errorString.clear();
+    
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(m_file.errorString());
+    }
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(FileHeader))) {
+        return fail(QStringLiteral("Not an address book snapshot"));
+    }
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        return fail(m_file.errorString());
+    }
+    
+    const FileHeader header = readValue<FileHeader>(m_data);
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        return fail(QStringLiteral("Not an address book snapshot"));
+    }
+    if (header.byteOrder != ByteOrderMark) {
+        return fail(QStringLiteral("Snapshot written with a different byte order"));
+    }
+    if (header.majorVersion != MajorVersion) {
+        return fail(QStringLiteral("Unsupported snapshot version %1.%2")
+                        .arg(header.majorVersion).arg(header.minorVersion));
+    }
+    if (header.headerSize < sizeof(FileHeader)
+        || quint64(header.headerSize) + quint64(header.sectionCount) * sizeof(SectionEntry) > quint64(m_size)) {
+        return fail(QStringLiteral("Damaged snapshot header"));
+    }
+    if (header.contactCount > quint32(ContactStore::MaxContacts)
+        || header.recordSize < sizeof(Record) || header.recordSize % alignof(Record) != 0) {
+        return fail(QStringLiteral("Damaged snapshot header"));
+    }
+    m_contactCount = int(header.contactCount);
+    m_nextId = header.nextId;
+    m_recordSize = header.recordSize;
+    
+    // Sections this reader does not know, or of versions it does not know,
+    // are skipped
+    bool hasStrings = false;
+    bool hasRecords = false;
+    for (quint32 i = 0; i < header.sectionCount; ++i) {
+        const SectionEntry section = readValue<SectionEntry>(m_data + header.headerSize + i * sizeof(SectionEntry));
+        if (section.offset > quint64(m_size) || section.size > quint64(m_size) - section.offset
+            || section.offset % SectionAlignment != 0) {
+            return fail(QStringLiteral("Damaged snapshot section table"));
+        }
+        const uchar *data = m_data + section.offset;
+        
+        switch (section.type) {
+        case StringsSection:
+            if (section.version != StringsVersion || section.size / 2 > quint64(UINT_MAX)) {
+                return fail(QStringLiteral("Unsupported snapshot string table"));
+            }
+            m_strings = reinterpret_cast<const char16_t *>(data);
+            m_stringLength = quint32(section.size / 2);
+            hasStrings = true;
+            break;
+        case RecordsSection:
+            if (section.version != RecordsVersion) {
+                return fail(QStringLiteral("Unsupported snapshot records"));
+            }
+            if (section.size < quint64(m_contactCount) * m_recordSize) {
+                return fail(QStringLiteral("Damaged snapshot records"));
+            }
+            m_records = data;
+            hasRecords = true;
+            break;
+        case IdIndexSection:
+            if (section.version == IdIndexVersion && section.size == quint64(m_contactCount) * 2 * sizeof(quint32)) {
+                m_ids = reinterpret_cast<const quint32 *>(data);
+                m_idCount = quint32(m_contactCount);
+                m_hasIdIndex = true;
+            }
+            break;
+        case NameIndexSection:
+        case EmailIndexSection:
+        case PhoneIndexSection:
+            if (section.version == KeyIndexVersion) {
+                KeyTable &table = m_keyTables[section.type - NameIndexSection];
+                table.present = readKeyTable(data, section.size, table);
+            }
+            break;
+        case SearchIndexSection:
+            if (section.version == SearchIndexVersion) {
+                m_hasSearchIndex = readSearchIndex(data, section.size);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    
+    if (!hasStrings || !hasRecords) {
+        return fail(QStringLiteral("Snapshot without contacts"));
+    }
+    return true;
+}
+
+void ContactSnapshot::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    
+    m_data = nullptr;
+    m_size = 0;
+    m_contactCount = 0;
+    m_nextId = 1;
+    m_records = nullptr;
+    m_recordSize = 0;
+    m_strings = nullptr;
+    m_stringLength = 0;
+    m_ids = nullptr;
+    m_idCount = 0;
+    m_hasIdIndex = false;
+    for (KeyTable &table : m_keyTables) {
+        table = KeyTable();
+    }
+    m_hasSearchIndex = false;
+    m_searchKeyCount = 0;
+    m_searchKeys = nullptr;
+    m_searchEnds = nullptr;
+    m_searchSlots = nullptr;
+    m_searchSlotCount = 0;
+}
+
+bool ContactSnapshot::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+QString ContactSnapshot::errorString() const
+{
+    return m_errorString;
+}
+
+int ContactSnapshot::contactCount() const
+{
+    return m_contactCount;
+}
+
+bool ContactSnapshot::load(ContactStore &store)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    
+    // The store reads the records a page at a time, see readRecords()
+    ContactStore loaded;
+    loaded.m_pages.resize(size_t(m_contactCount + ContactStore::PageSize - 1) / ContactStore::PageSize);
+    loaded.m_slotCount = m_contactCount;
+    loaded.m_size = m_contactCount;
+    loaded.m_nextId = m_nextId;
+    loaded.m_snapshot = this;
+    loaded.m_snapshotSlots = m_contactCount;
+    loaded.m_mappedChars = m_strings;
+    loaded.m_mappedLength = m_stringLength;
+    
+    store = std::move(loaded);
+    return true;
+}
+
+bool ContactSnapshot::hasIdIndex() const
+{
+    return m_hasIdIndex;
+}
+
+bool ContactSnapshot::hasKeyIndex(ContactStore::Field field) const
+{
+    return m_keyTables[keyIndexOf(field)].present;
+}
+
+bool ContactSnapshot::hasSearchIndex() const
+{
+    return m_hasSearchIndex;
+}
+
+int ContactSnapshot::findId(ContactId id) const
+{
+    if (!m_hasIdIndex) {
+        return -1;
+    }
+    
+    // Binary search over the pairs
+    quint32 low = 0;
+    quint32 high = m_idCount;
+    while (low < high) {
+        const quint32 middle = low + (high - low) / 2;
+        if (m_ids[middle * 2] < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    if (low == m_idCount || m_ids[low * 2] != id || m_ids[low * 2 + 1] >= quint32(m_contactCount)) {
+        return -1;
+    }
+    return int(m_ids[low * 2 + 1]);
+}
+
+QList<int> ContactSnapshot::findKey(ContactStore::Field field, QStringView key) const
+{
+    QList<int> records;
+    const KeyTable &table = m_keyTables[keyIndexOf(field)];
+    if (!table.present) {
+        return records;
+    }
+    
+    const quint64 hash = keyHash(key);
+    const quint32 bucket = quint32(hash) & (table.bucketCount - 1);
+    const quint32 check = quint32(hash >> 32);
+    const quint32 begin = table.bucketStarts[bucket];
+    const quint32 end = table.bucketStarts[bucket + 1];
+    if (begin > end || end > table.entryCount) {
+        return records;
+    }
+    for (quint32 i = begin; i < end; ++i) {
+        const quint32 record = table.entries[i * 2 + 1];
+        if (table.entries[i * 2] == check && record < quint32(m_contactCount)) {
+            records.append(int(record));
+        }
+    }
+    return records;
+}
+
+ContactSearchIndex::Posting ContactSnapshot::searchPosting(quint64 key) const
+{
+    if (!m_hasSearchIndex) {
+        return ContactSearchIndex::Posting();
+    }
+    
+    const quint64 *it = std::lower_bound(m_searchKeys, m_searchKeys + m_searchKeyCount, key);
+    if (it == m_searchKeys + m_searchKeyCount || *it != key) {
+        return ContactSearchIndex::Posting();
+    }
+    const quint64 index = quint64(it - m_searchKeys);
+    const quint64 begin = index == 0 ? 0 : m_searchEnds[index - 1];
+    const quint64 end = m_searchEnds[index];
+    if (begin > end || end > m_searchSlotCount) {
+        return ContactSearchIndex::Posting();
+    }
+    ContactSearchIndex::Posting posting;
+    posting.begin = m_searchSlots + begin;
+    posting.end = m_searchSlots + end;
+    posting.count = size_t(end - begin);
+    return posting;
+}
+
+bool ContactSnapshot::write(const QString &fileName, const ContactStore &store,
+                            const ContactSearchIndex &searchIndex,
+                            const std::function<QString(Handle, ContactStore::Field)> &keyOf,
+                            QString *errorString)
+{
+    // Contacts are numbered by slot order, leaving out free slots
+    const quint32 NoRecord = UINT_MAX;
+    std::vector<Handle> handles;
+    std::vector<quint32> recordOfSlot(size_t(store.slotCount()), NoRecord);
+    handles.reserve(size_t(store.size()));
+    quint32 vipCount = 0;
+    for (int slot = 0; slot < store.slotCount(); ++slot) {
+        const Handle handle = store.handleAt(slot);
+        if (handle != ContactStore::InvalidHandle) {
+            recordOfSlot[size_t(slot)] = quint32(handles.size());
+            handles.push_back(handle);
+            vipCount += store.isVip(handle) ? 1 : 0;
+        }
+    }
+    
+    // String table and records; repeated strings such as common names are
+    // stored once
+    std::vector<char16_t> strings;
+    QHash<QStringView, quint32> stringOffsets;
+    QByteArray records;
+    records.reserve(qsizetype(handles.size() * sizeof(Record)));
+    for (Handle handle : handles) {
+        const int slot = ContactStore::slotOf(handle);
+        Record record;
+        record.id = store.id(handle);
+        for (int field = 0; field < ContactStore::FieldCount; ++field) {
+            const QStringView text = store.text(handle, ContactStore::Field(field));
+            quint32 offset = quint32(strings.size());
+            const auto it = stringOffsets.constFind(text);
+            if (it != stringOffsets.cend()) {
+                offset = it.value();
+            } else {
+                stringOffsets.insert(text, offset);
+                strings.insert(strings.end(), text.utf16(), text.utf16() + text.size());
+            }
+            record.text[field] = RecordText{offset, quint32(text.size())};
+        }
+        record.birthDay = store.pageOf(slot).birthDays[ContactStore::indexInPage(slot)];
+        record.flags = store.isVip(handle) ? RecordVip : 0;
+        appendValue(records, record);
+    }
+    
+    // ID index
+    std::vector<std::pair<quint32, quint32>> ids;
+    ids.reserve(handles.size());
+    for (quint32 record = 0; record < handles.size(); ++record) {
+        ids.emplace_back(store.id(handles[record]), record);
+    }
+    std::sort(ids.begin(), ids.end());
+    QByteArray idIndex;
+    for (const auto &id : ids) {
+        appendValue(idIndex, id.first);
+        appendValue(idIndex, id.second);
+    }
+    
+    // Key tables, with about one entry per bucket
+    auto keyTable = [&](ContactStore::Field field) {
+        std::vector<std::pair<quint64, quint32>> entries;
+        entries.reserve(handles.size());
+        for (quint32 record = 0; record < handles.size(); ++record) {
+            const QString key = keyOf(handles[record], field);
+            if (!key.isEmpty()) {
+                entries.emplace_back(keyHash(key), record);
+            }
+        }
+        quint32 bucketCount = 1;
+        while (bucketCount < entries.size()) {
+            bucketCount *= 2;
+        }
+        const quint64 mask = bucketCount - 1;
+        std::stable_sort(entries.begin(), entries.end(), [mask](const auto &a, const auto &b) {
+            return (a.first & mask) < (b.first & mask);
+        });
+        
+        QByteArray bytes;
+        appendValue(bytes, KeyTableHeader{bucketCount, quint32(entries.size())});
+        quint32 entry = 0;
+        for (quint32 bucket = 0; bucket <= bucketCount; ++bucket) {
+            while (entry < entries.size() && (entries[entry].first & mask) < bucket) {
+                entry++;
+            }
+            appendValue(bytes, entry);
+        }
+        for (const auto &e : entries) {
+            appendValue(bytes, quint32(e.first >> 32));
+            appendValue(bytes, e.second);
+        }
+        return bytes;
+    };
+    
+    // Search index: every key of the index, in memory or still in the
+    // snapshot it was loaded from, with its posting renumbered by record
+    std::vector<quint64> searchKeys;
+    searchKeys.reserve(size_t(searchIndex.m_postings.size()));
+    for (auto it = searchIndex.m_postings.cbegin(); it != searchIndex.m_postings.cend(); ++it) {
+        searchKeys.push_back(it.key());
+    }
+    if (const ContactSnapshot *base = searchIndex.m_snapshot) {
+        searchKeys.insert(searchKeys.end(), base->m_searchKeys, base->m_searchKeys + base->m_searchKeyCount);
+    }
+    std::sort(searchKeys.begin(), searchKeys.end());
+    searchKeys.erase(std::unique(searchKeys.begin(), searchKeys.end()), searchKeys.end());
+    
+    // Removed contacts leave their keys in the postings until the index
+    // purges them; those of contacts that took over their slots are left
+    // out as well
+    std::vector<bool> hasStaleKeys(recordOfSlot.size(), false);
+    for (auto it = searchIndex.m_staleKeys.cbegin(); it != searchIndex.m_staleKeys.cend(); ++it) {
+        if (it.key() < hasStaleKeys.size()) {
+            hasStaleKeys[it.key()] = true;
+        }
+    }
+    
+    std::vector<quint64> searchEnds;
+    std::vector<quint32> searchSlots;
+    std::vector<quint64> nonEmptyKeys;
+    for (quint64 key : searchKeys) {
+        const ContactSearchIndex::Posting posting = searchIndex.posting(key);
+        // Slot order is record order, so the posting stays sorted
+        const size_t begin = searchSlots.size();
+        for (ContactSearchIndex::Posting::Iterator it(posting); !it.atEnd(); it.next()) {
+            const quint32 slot = it.slot();
+            if (slot < recordOfSlot.size() && recordOfSlot[slot] != NoRecord
+                && !(hasStaleKeys[slot] && searchIndex.isStale(slot, key))) {
+                searchSlots.push_back(recordOfSlot[slot]);
+            }
+        }
+        if (searchSlots.size() > begin) {
+            nonEmptyKeys.push_back(key);
+            searchEnds.push_back(searchSlots.size());
+        }
+    }
+    QByteArray searchIndexBytes;
+    appendValue(searchIndexBytes, quint64(nonEmptyKeys.size()));
+    appendArray(searchIndexBytes, nonEmptyKeys.data(), nonEmptyKeys.size());
+    appendArray(searchIndexBytes, searchEnds.data(), searchEnds.size());
+    appendArray(searchIndexBytes, searchSlots.data(), searchSlots.size());
+    
+    QByteArray stringBytes;
+    appendArray(stringBytes, strings.data(), strings.size());
+    
+    const std::pair<SectionEntry, QByteArray> sections[] = {
+        {{StringsSection, StringsVersion, 0, 0}, stringBytes},
+        {{RecordsSection, RecordsVersion, 0, 0}, records},
+        {{IdIndexSection, IdIndexVersion, 0, 0}, idIndex},
+        {{NameIndexSection, KeyIndexVersion, 0, 0}, keyTable(ContactStore::FirstName)},
+        {{EmailIndexSection, KeyIndexVersion, 0, 0}, keyTable(ContactStore::Email)},
+        {{PhoneIndexSection, KeyIndexVersion, 0, 0}, keyTable(ContactStore::Phone)},
+        {{SearchIndexSection, SearchIndexVersion, 0, 0}, searchIndexBytes}
+    };
+    const quint32 sectionCount = quint32(std::size(sections));
+    
+    FileHeader header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.majorVersion = MajorVersion;
+    header.minorVersion = MinorVersion;
+    header.headerSize = sizeof(FileHeader);
+    header.sectionCount = sectionCount;
+    header.recordSize = sizeof(Record);
+    header.contactCount = quint32(handles.size());
+    header.vipCount = vipCount;
+    header.nextId = store.nextId();
+    header.byteOrder = ByteOrderMark;
+    
+    // Lay the sections out after the section table
+    QByteArray head;
+    appendValue(head, header);
+    quint64 offset = head.size() + sectionCount * sizeof(SectionEntry);
+    for (const auto &section : sections) {
+        offset = (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+        SectionEntry entry = section.first;
+        entry.offset = offset;
+        entry.size = quint64(section.second.size());
+        appendValue(head, entry);
+        offset += entry.size;
+    }
+    
+    // Replace the file only once it is complete
+    QSaveFile file(fileName);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(head);
+        for (const auto &section : sections) {
+            const qint64 padding = (SectionAlignment - file.pos() % SectionAlignment) % SectionAlignment;
+            file.write(QByteArray(padding, '\0'));
+            file.write(section.second);
+        }
+        if (file.commit()) {
+            return true;
+        }
+    }
+    if (errorString) {
+        *errorString = file.errorString();
+    }
+    return false;
+}
+
+quint64 ContactSnapshot::keyHash(QStringView key)
+{
+    // 64-bit FNV-1a over the UTF-16 code units
+    quint64 hash = 14695981039346656037ULL;
+    for (QChar c : key) {
+        hash = (hash ^ c.unicode()) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+ContactSnapshot::KeyIndex ContactSnapshot::keyIndexOf(ContactStore::Field field)
+{
+    switch (field) {
+    case ContactStore::Email:
+        return EmailKeys;
+    case ContactStore::Phone:
+        return PhoneKeys;
+    default:
+        return NameKeys;
+    }
+}
+
+bool ContactSnapshot::fail(const QString &message)
+{
+    close();
+    m_errorString = message;
+    return false;
+}
+
+bool ContactSnapshot::readKeyTable(const uchar *data, quint64 size, KeyTable &table) const
+{
+    if (size < sizeof(KeyTableHeader)) {
+        return false;
+    }
+    const KeyTableHeader header = readValue<KeyTableHeader>(data);
+    if (header.bucketCount == 0 || (header.bucketCount & (header.bucketCount - 1)) != 0) {
+        return false;
+    }
+    const quint64 startsSize = (quint64(header.bucketCount) + 1) * sizeof(quint32);
+    if (size != sizeof(KeyTableHeader) + startsSize + quint64(header.entryCount) * 2 * sizeof(quint32)) {
+        return false;
+    }
+    
+    table.bucketCount = header.bucketCount;
+    table.entryCount = header.entryCount;
+    table.bucketStarts = reinterpret_cast<const quint32 *>(data + sizeof(KeyTableHeader));
+    table.entries = reinterpret_cast<const quint32 *>(data + sizeof(KeyTableHeader) + startsSize);
+    
+    // Each bucket is checked to lie inside the table as it is looked up
+    return table.bucketStarts[header.bucketCount] == header.entryCount;
+}
+
+void ContactSnapshot::readRecords(int first, int count, ContactStore::Page &page) const
+{
+    // The store trusts its pages, so every record is checked as it is
+    // copied. A damaged value reads as missing: an ID as InvalidId, text
+    // as empty. An ID also has to lead back to its record through the ID
+    // index, so that no two contacts have the same one.
+    for (int i = 0; i < count; ++i) {
+        const int index = first + i;
+        const Record record = readValue<Record>(m_records + size_t(index) * m_recordSize);
+        const bool validId = record.id != ContactStore::InvalidId && record.id < m_nextId
+                             && (!m_hasIdIndex || findId(record.id) == index);
+        page.ids[i] = validId ? record.id : ContactStore::InvalidId;
+        for (int field = 0; field < ContactStore::FieldCount; ++field) {
+            const RecordText &text = record.text[field];
+            const bool validText = text.offset <= m_stringLength && text.length <= m_stringLength - text.offset;
+            page.text[field][i] = validText ? ContactStore::TextRef{text.offset, text.length}
+                                            : ContactStore::TextRef{0, 0};
+        }
+        page.birthDays[i] = record.birthDay;
+        page.flags[i] = ContactStore::Alive | ((record.flags & RecordVip) ? ContactStore::Vip : 0);
+    }
+}
+
+bool ContactSnapshot::readSearchIndex(const uchar *data, quint64 size)
+{
+    // Key count, keys in order, the end of every key's posting, then the
+    // postings one after the other
+    if (size < sizeof(quint64)) {
+        return false;
+    }
+    const quint64 keyCount = readValue<quint64>(data);
+    if (keyCount > (size - sizeof(quint64)) / (2 * sizeof(quint64))) {
+        return false;
+    }
+    const quint64 slotsOffset = sizeof(quint64) + keyCount * 2 * sizeof(quint64);
+    const quint64 slotCount = (size - slotsOffset) / sizeof(quint32);
+    if (keyCount > 0 && readValue<quint64>(data + slotsOffset - sizeof(quint64)) != slotCount) {
+        return false;
+    }
+    
+    m_searchKeyCount = keyCount;
+    m_searchKeys = reinterpret_cast<const quint64 *>(data + sizeof(quint64));
+    m_searchEnds = m_searchKeys + keyCount;
+    m_searchSlots = reinterpret_cast<const quint32 *>(data + slotsOffset);
+    m_searchSlotCount = slotCount;
+    return isAligned(m_searchKeys, alignof(quint64));
+}
@@ -0,0 +1,149 @@
+#ifndef CONTACTSNAPSHOT_H
+#define CONTACTSNAPSHOT_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <functional>
+#include "contactsearchindex.h"
+#include "contactstore.h"
+
+// A file holding the contacts of an address book together with its indexes,
+// made to be opened without parsing it.
+//
+// The file starts with a header and a table of sections. The string table
+// holds the text of every field as UTF-16, each distinct string once. The
+// records are fixed-width and refer to their text by offset into the
+// string table. The index sections hold the ID, name, email, phone number
+// and search indexes as they are looked up, so nothing has to be built
+// when the file is opened.
+//
+// Opening a snapshot maps the file into memory and checks its structure,
+// and loading it into a ContactStore reads none of the records, so neither
+// grows with the number of contacts. The store copies a page of records
+// into its columns when one of them is first used, checking each record as
+// it goes. The text stays in the mapped file, and the indexes are read
+// from the file as lookups need them, so pages of the file are only read
+// from disk once they are used.
+//
+// Versions: a file's major version changes when older readers could not
+// read it correctly, and such files are refused. Additions that older
+// readers can do without, such as new sections, longer records or a longer
+// header, only change the minor version and are skipped by readers that do
+// not know them. Every section also has its own version; an index section
+// of a version this reader does not know is treated as missing, and the
+// index is then built from the records instead.
+class ContactSnapshot
+{
+public:
+    using Handle = ContactStore::Handle;
+    using ContactId = ContactStore::ContactId;
+    
+    static constexpr quint16 MajorVersion = 1;
+    static constexpr quint16 MinorVersion = 0;
+    
+    ContactSnapshot() = default;
+    ContactSnapshot(const ContactSnapshot &) = delete;
+    ContactSnapshot &operator=(const ContactSnapshot &) = delete;
+    
+    // Map a snapshot file and check it; on failure errorString() tells why
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+    
+    int contactCount() const;
+    
+    // Replace the contents of a store with the contacts of the snapshot,
+    // slot by record, or return false if no snapshot is open. The store
+    // reads the records as it uses them, so the snapshot must stay open
+    // until the store is cleared. A damaged value in a record reads as
+    // missing; without an ID index, IDs are only checked to be below
+    // nextId, not to be unique.
+    bool load(ContactStore &store);
+    
+    // Whether the file has a usable index of IDs, or of the keys of a
+    // field: the full name for FirstName and LastName, else the field's
+    // normalized text
+    bool hasIdIndex() const;
+    bool hasKeyIndex(ContactStore::Field field) const;
+    bool hasSearchIndex() const;
+    
+    // The record of a contact ID, or -1. With several records of the ID,
+    // the one the index lists first.
+    int findId(ContactId id) const;
+    
+    // Records that may have key in the field's index; the caller compares
+    // the keys
+    QList<int> findKey(ContactStore::Field field, QStringView key) const;
+    
+    // Posting of the search index, by record
+    ContactSearchIndex::Posting searchPosting(quint64 key) const;
+    
+    // Write the contacts of a store and their indexes to a file, records
+    // in slot order. keyOf gives a contact's key in the index of a field,
+    // as for hasKeyIndex(). Returns false and sets errorString on failure.
+    static bool write(const QString &fileName, const ContactStore &store,
+                      const ContactSearchIndex &searchIndex,
+                      const std::function<QString(Handle, ContactStore::Field)> &keyOf,
+                      QString *errorString = nullptr);
+    
+    // Hash of index keys, the same on every platform and in every run
+    static quint64 keyHash(QStringView key);
+    
+private:
+    friend class ContactStore;
+    
+    enum KeyIndex {
+        NameKeys,
+        EmailKeys,
+        PhoneKeys,
+        KeyIndexCount
+    };
+    
+    // A key index: bucket starts, then entries of the buckets in order
+    struct KeyTable {
+        bool present = false;
+        quint32 bucketCount = 0;
+        quint32 entryCount = 0;
+        const quint32 *bucketStarts = nullptr;
+        const quint32 *entries = nullptr;     // pairs of hash check and record
+    };
+    
+    static KeyIndex keyIndexOf(ContactStore::Field field);
+    
+    bool fail(const QString &message);
+    bool readKeyTable(const uchar *data, quint64 size, KeyTable &table) const;
+    
+    // Copy count records from first on into a page of a store's columns,
+    // first being the page's first slot
+    void readRecords(int first, int count, ContactStore::Page &page) const;
+    bool readSearchIndex(const uchar *data, quint64 size);
+    
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QString m_errorString;
+    
+    int m_contactCount = 0;
+    ContactId m_nextId = 1;
+    
+    const uchar *m_records = nullptr;
+    quint32 m_recordSize = 0;
+    const char16_t *m_strings = nullptr;
+    quint32 m_stringLength = 0;
+    
+    const quint32 *m_ids = nullptr;           // pairs of ID and record, by ID
+    quint32 m_idCount = 0;
+    bool m_hasIdIndex = false;
+    KeyTable m_keyTables[KeyIndexCount];
+    
+    bool m_hasSearchIndex = false;
+    quint64 m_searchKeyCount = 0;
+    const quint64 *m_searchKeys = nullptr;
+    const quint64 *m_searchEnds = nullptr;
+    const quint32 *m_searchSlots = nullptr;
+    quint64 m_searchSlotCount = 0;
+};
+
+#endif // CONTACTSNAPSHOT_H
@@ -0,0 +1,324 @@
+#include "contactstore.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include "contactsnapshot.h"
+
+namespace {
+
+// Rebuild the text buffer once at least this many characters, and at least
+// half of the buffer, are no longer used
+const qsizetype MinimumGarbage = 64 * 1024;
+
+} // namespace
+
+ContactStore::Handle ContactStore::add(const Contact &contact, ContactId id)
+{
+    int slot;
+    if (!m_freeSlots.empty()) {
+        slot = int(m_freeSlots.back());
+        m_freeSlots.pop_back();
+    } else {
+        if (slotCount() == MaxContacts) {
+            return InvalidHandle;
+        }
+        
+        // A new page every PageSize slots, its slots all free
+        slot = m_slotCount++;
+        if (size_t(slot >> PageBits) == m_pages.size()) {
+            m_pages.push_back(newPage());
+        }
+    }
+    
+    if (id == InvalidId) {
+        id = m_nextId;
+    }
+    m_nextId = qMax(m_nextId, id + 1);
+    
+    Page &page = pageOf(slot);
+    const int i = indexInPage(slot);
+    page.ids[i] = id;
+    page.text[FirstName][i] = appendText(contact.firstName);
+    page.text[LastName][i] = appendText(contact.lastName);
+    page.text[Email][i] = appendText(contact.email);
+    page.text[Phone][i] = appendText(contact.phone);
+    page.birthDays[i] = contact.birthDate.isValid() ? qint32(contact.birthDate.toJulianDay()) : NoBirthDate;
+    page.flags[i] = Alive | (contact.vip ? Vip : 0);
+    m_size++;
+    
+    return Handle(slot) | Handle(page.generations[i]) << 24;
+}
+
+bool ContactStore::remove(Handle handle)
+{
+    if (!contains(handle)) {
+        return false;
+    }
+    
+    const int slot = slotOf(handle);
+    Page &page = pageOf(slot);
+    const int i = indexInPage(slot);
+    for (TextRef (&column)[PageSize] : page.text) {
+        releaseText(column[i]);
+        column[i] = TextRef{0, 0};
+    }
+    page.ids[i] = InvalidId;
+    page.birthDays[i] = NoBirthDate;
+    page.flags[i] = 0;
+    // Handles of every generation of the slot are out there; reusing it
+    // would make one of them valid again
+    if (page.generations[i] != LastGeneration) {
+        page.generations[i]++;
+        m_freeSlots.push_back(quint32(slot));
+    }
+    m_size--;
+    
+    compactText();
+    return true;
+}
+
+void ContactStore::clear()
+{
+    *this = ContactStore();
+}
+
+void ContactStore::reserve(int count)
+{
+    m_pages.reserve(size_t(count + PageSize - 1) / PageSize);
+}
+
+bool ContactStore::contains(Handle handle) const
+{
+    const int slot = slotOf(handle);
+    if (handle == InvalidHandle || slot >= slotCount()) {
+        return false;
+    }
+    const Page &page = pageOf(slot);
+    const int i = indexInPage(slot);
+    return (page.flags[i] & Alive) && page.generations[i] == quint8(handle >> 24);
+}
+
+int ContactStore::size() const
+{
+    return m_size;
+}
+
+int ContactStore::slotCount() const
+{
+    return m_slotCount;
+}
+
+ContactStore::Handle ContactStore::handleAt(int slot) const
+{
+    if (slot < 0 || slot >= slotCount()) {
+        return InvalidHandle;
+    }
+    const Page &page = pageOf(slot);
+    const int i = indexInPage(slot);
+    if (!(page.flags[i] & Alive)) {
+        return InvalidHandle;
+    }
+    return Handle(slot) | Handle(page.generations[i]) << 24;
+}
+
+ContactStore::ContactId ContactStore::id(Handle handle) const
+{
+    const int slot = slotOf(handle);
+    return pageOf(slot).ids[indexInPage(slot)];
+}
+
+QStringView ContactStore::text(Handle handle, Field field) const
+{
+    const int slot = slotOf(handle);
+    const TextRef &ref = pageOf(slot).text[field][indexInPage(slot)];
+    return QStringView(charsAt(ref.offset), qsizetype(ref.length));
+}
+
+QString ContactStore::string(Handle handle, Field field) const
+{
+    return text(handle, field).toString();
+}
+
+QString ContactStore::fullName(Handle handle) const
+{
+    return text(handle, FirstName) + u' ' + text(handle, LastName);
+}
+
+QDate ContactStore::birthDate(Handle handle) const
+{
+    const int slot = slotOf(handle);
+    const qint32 day = pageOf(slot).birthDays[indexInPage(slot)];
+    return day == NoBirthDate ? QDate() : QDate::fromJulianDay(day);
+}
+
+bool ContactStore::isVip(Handle handle) const
+{
+    const int slot = slotOf(handle);
+    return pageOf(slot).flags[indexInPage(slot)] & Vip;
+}
+
+ContactStore::Contact ContactStore::contact(Handle handle) const
+{
+    Contact contact;
+    contact.firstName = string(handle, FirstName);
+    contact.lastName = string(handle, LastName);
+    contact.birthDate = birthDate(handle);
+    contact.email = string(handle, Email);
+    contact.phone = string(handle, Phone);
+    contact.vip = isVip(handle);
+    return contact;
+}
+
+bool ContactStore::setText(Handle handle, Field field, QStringView text)
+{
+    if (this->text(handle, field) == text) {
+        return false;
+    }
+    
+    // The new text may be a view into our own buffer, which appending
+    // could reallocate
+    const char16_t *begin = m_chars.data();
+    const char16_t *end = begin + m_chars.size();
+    if (text.utf16() >= begin && text.utf16() < end) {
+        return setText(handle, field, QStringView(text.toString()));
+    }
+    
+    const int slot = slotOf(handle);
+    TextRef &ref = pageOf(slot).text[field][indexInPage(slot)];
+    if (quint32(text.size()) <= ref.length && !isMapped(ref)) {
+        // Shorter text is written over the old one
+        std::copy(text.utf16(), text.utf16() + text.size(), m_chars.begin() + (ref.offset - m_mappedLength));
+        m_garbage += ref.length - quint32(text.size());
+        ref.length = quint32(text.size());
+    } else {
+        releaseText(ref);
+        ref = appendText(text);
+        compactText();
+    }
+    return true;
+}
+
+bool ContactStore::setBirthDate(Handle handle, const QDate &birthDate)
+{
+    const qint32 day = birthDate.isValid() ? qint32(birthDate.toJulianDay()) : NoBirthDate;
+    const int slot = slotOf(handle);
+    qint32 &current = pageOf(slot).birthDays[indexInPage(slot)];
+    if (current == day) {
+        return false;
+    }
+    current = day;
+    return true;
+}
+
+bool ContactStore::setVip(Handle handle, bool vip)
+{
+    const int slot = slotOf(handle);
+    quint8 &flags = pageOf(slot).flags[indexInPage(slot)];
+    if (bool(flags & Vip) == vip) {
+        return false;
+    }
+    flags = vip ? flags | Vip : flags & ~Vip;
+    return true;
+}
+
+ContactStore::ContactId ContactStore::nextId() const
+{
+    return m_nextId;
+}
+
+qsizetype ContactStore::memoryUsage() const
+{
+    qsizetype bytes = m_pages.capacity() * sizeof(std::unique_ptr<Page>);
+    for (const std::unique_ptr<Page> &page : m_pages) {
+        bytes += page ? sizeof(Page) : 0;
+    }
+    bytes += m_freeSlots.capacity() * sizeof(quint32);
+    bytes += m_chars.capacity() * sizeof(char16_t);
+    return bytes;
+}
+
+const ContactStore::Page &ContactStore::pageOf(int slot) const
+{
+    std::unique_ptr<Page> &page = m_pages[size_t(slot >> PageBits)];
+    if (!page) {
+        // Only pages of the snapshot's records are left empty
+        page = newPage();
+        const int first = slot & ~(PageSize - 1);
+        m_snapshot->readRecords(first, qMin(PageSize, m_snapshotSlots - first), *page);
+    }
+    return *page;
+}
+
+ContactStore::Page &ContactStore::pageOf(int slot)
+{
+    return const_cast<Page &>(std::as_const(*this).pageOf(slot));
+}
+
+std::unique_ptr<ContactStore::Page> ContactStore::newPage()
+{
+    // Zero is a free slot in every column but the birth dates
+    std::unique_ptr<Page> page(new Page());
+    std::fill(std::begin(page->birthDays), std::end(page->birthDays), NoBirthDate);
+    return page;
+}
+
+const char16_t *ContactStore::charsAt(quint32 offset) const
+{
+    return offset < m_mappedLength ? m_mappedChars + offset : m_chars.data() + (offset - m_mappedLength);
+}
+
+bool ContactStore::isMapped(const TextRef &ref) const
+{
+    return ref.offset < m_mappedLength;
+}
+
+ContactStore::TextRef ContactStore::appendText(QStringView text)
+{
+    const TextRef ref{m_mappedLength + quint32(m_chars.size()), quint32(text.size())};
+    m_chars.insert(m_chars.end(), text.utf16(), text.utf16() + text.size());
+    return ref;
+}
+
+void ContactStore::releaseText(const TextRef &ref)
+{
+    // Mapped text is never reused, so it does not count as garbage
+    if (!isMapped(ref)) {
+        m_garbage += ref.length;
+    }
+}
+
+void ContactStore::compactText()
+{
+    if (m_garbage < MinimumGarbage || m_garbage * 2 < qsizetype(m_chars.size())) {
+        return;
+    }
+    
+    // Copy the text that is still referenced to a new buffer, slot by slot;
+    // mapped text stays where it is, and pages not read from the snapshot
+    // yet have no other
+    std::vector<char16_t> chars;
+    chars.reserve(m_chars.size() - m_garbage);
+    for (const std::unique_ptr<Page> &page : m_pages) {
+        if (!page) {
+            continue;
+        }
+        for (int i = 0; i < PageSize; ++i) {
+            if (!(page->flags[i] & Alive)) {
+                continue;
+            }
+            for (TextRef (&column)[PageSize] : page->text) {
+                TextRef &ref = column[i];
+                if (isMapped(ref)) {
+                    continue;
+                }
+                const char16_t *text = charsAt(ref.offset);
+                const quint32 offset = m_mappedLength + quint32(chars.size());
+                chars.insert(chars.end(), text, text + ref.length);
+                ref.offset = offset;
+            }
+        }
+    }
+    
+    m_chars.swap(chars);
+    m_garbage = 0;
+}
@@ -0,0 +1,174 @@
+#ifndef CONTACTSTORE_H
+#define CONTACTSTORE_H
+
+#include <QString>
+#include <QStringView>
+#include <QDate>
+#include <climits>
+#include <memory>
+#include <vector>
+
+class ContactSnapshot;
+
+// Value storage for the contacts of an AddressBook.
+//
+// Each field is a column with one entry per slot instead of one QObject per
+// contact, so a scan over a field touches only that field's memory. The
+// columns are cut into pages of 1024 slots, so that a store can fill its
+// pages one at a time. The text of every string field lives in a single
+// character buffer, and a column entry is just the offset and length of
+// the text in it.
+//
+// A contact is addressed by a 32-bit handle made of its slot (low 24 bits)
+// and the generation of that slot (high 8 bits). Removing a contact frees
+// the slot for a later add and bumps its generation, so handles of removed
+// contacts stop being valid instead of silently pointing at the next one.
+// A slot that has been through every generation is retired rather than
+// reused, so an old handle can never come back to life; that costs one
+// unused slot per 256 removals from the same slot.
+//
+// Handles are only good for the lifetime of the store. Every contact also
+// has an ID that is never reused, for referring to it from outside.
+//
+// A store filled from a ContactSnapshot reads a page of records from the
+// snapshot when one of its slots is first used, and leaves the text in the
+// snapshot's string table until it is changed.
+class ContactStore
+{
+public:
+    using Handle = quint32;
+    static constexpr Handle InvalidHandle = 0xffffffff;
+    static constexpr int MaxContacts = 1 << 24;
+    
+    using ContactId = quint32;
+    static constexpr ContactId InvalidId = 0;
+    
+    // String fields, each stored in its own column
+    enum Field {
+        FirstName,
+        LastName,
+        Email,
+        Phone,
+        FieldCount
+    };
+    
+    // A contact as a plain value, for adding and copying contacts
+    struct Contact {
+        QString firstName;
+        QString lastName;
+        QDate birthDate;
+        QString email;
+        QString phone;
+        bool vip = false;
+    };
+    
+    ContactStore() = default;
+    
+    // Add a contact with the given ID, which the caller keeps unique, or
+    // with the next unused ID for InvalidId. Returns InvalidHandle when the
+    // store is full.
+    Handle add(const Contact &contact, ContactId id = InvalidId);
+    
+    // Remove a contact, returns false for a handle that is not valid
+    bool remove(Handle handle);
+    
+    void clear();
+    void reserve(int count);
+    
+    bool contains(Handle handle) const;
+    int size() const;
+    
+    // Slots are numbered 0 to slotCount() - 1; free slots have no handle
+    int slotCount() const;
+    Handle handleAt(int slot) const;
+    
+    // Field access; the handle must be valid. Views into the text buffer
+    // are only good until the next change to the store.
+    ContactId id(Handle handle) const;
+    QStringView text(Handle handle, Field field) const;
+    QString string(Handle handle, Field field) const;
+    QString fullName(Handle handle) const;
+    QDate birthDate(Handle handle) const;
+    bool isVip(Handle handle) const;
+    Contact contact(Handle handle) const;
+    
+    // Field setters, return whether the value changed
+    bool setText(Handle handle, Field field, QStringView text);
+    bool setBirthDate(Handle handle, const QDate &birthDate);
+    bool setVip(Handle handle, bool vip);
+    
+    // IDs above every ID handed out so far
+    ContactId nextId() const;
+    
+    // Bytes allocated for the columns and the text buffer
+    qsizetype memoryUsage() const;
+    
+    static int slotOf(Handle handle) { return int(handle & (MaxContacts - 1)); }
+    
+private:
+    friend class ContactSnapshot;
+    
+    // Offsets below m_mappedLength are into the mapped text, the others
+    // into m_chars
+    struct TextRef {
+        quint32 offset;
+        quint32 length;
+    };
+    
+    // Columns of PageSize slots, indexed by slot within the page
+    static constexpr int PageBits = 10;
+    static constexpr int PageSize = 1 << PageBits;
+    
+    struct Page {
+        ContactId ids[PageSize];
+        TextRef text[FieldCount][PageSize];
+        qint32 birthDays[PageSize];
+        quint8 flags[PageSize];
+        quint8 generations[PageSize];
+    };
+    
+    enum Flag : quint8 {
+        Alive = 0x1,
+        Vip = 0x2
+    };
+    
+    static constexpr quint8 LastGeneration = 0xff;
+    
+    // Birth dates as Julian days, with a marker for "no date"
+    static constexpr qint32 NoBirthDate = INT_MIN;
+    
+    // The page of a slot, read from the snapshot on first use
+    const Page &pageOf(int slot) const;
+    Page &pageOf(int slot);
+    static int indexInPage(int slot) { return slot & (PageSize - 1); }
+    static std::unique_ptr<Page> newPage();
+    
+    const char16_t *charsAt(quint32 offset) const;
+    bool isMapped(const TextRef &ref) const;
+    TextRef appendText(QStringView text);
+    void releaseText(const TextRef &ref);
+    void compactText();
+    
+    // Pages, indexed by slot / PageSize; those of the snapshot's records
+    // stay empty until first used
+    mutable std::vector<std::unique_ptr<Page>> m_pages;
+    int m_slotCount = 0;
+    
+    std::vector<quint32> m_freeSlots;
+    int m_size = 0;
+    ContactId m_nextId = 1;
+    
+    // Text of all string fields; m_garbage counts the characters no longer
+    // referenced by any field
+    std::vector<char16_t> m_chars;
+    qsizetype m_garbage = 0;
+    
+    // The snapshot the first m_snapshotSlots slots are read from, and its
+    // read-only text, both owned by the caller
+    const ContactSnapshot *m_snapshot = nullptr;
+    int m_snapshotSlots = 0;
+    const char16_t *m_mappedChars = nullptr;
+    quint32 m_mappedLength = 0;
+};
+
+#endif // CONTACTSTORE_H
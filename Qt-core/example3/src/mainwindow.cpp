@@ -7,30 +7,29 @@
 #include <QMetaProperty>
 #include <QDebug>
 
+namespace {
+
+// Search results listed at most, and how many are added per step
+const int MaxSearchResults = 1000;
+const int SearchBatchSize = 100;
+
+// Time one step of a search may take; the first step runs as the user types
+const qint64 SearchStepBudgetNs = 1000000;
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), m_currentPerson(nullptr)
 {
     m_addressBook = new AddressBook(this);
     
     // Create some sample data
-    Person *john = new Person("John", "Doe", m_addressBook);
-    john->setBirthDate(QDate(1980, 5, 15));
-    john->setEmail("john.doe@example.com");
-    john->setPhone("555-1234");
-    m_addressBook->addPerson(john);
-    
-    Person *jane = new Person("Jane", "Smith", m_addressBook);
-    jane->setBirthDate(QDate(1985, 8, 22));
-    jane->setEmail("jane.smith@example.com");
-    jane->setPhone("555-5678");
-    jane->setVip(true);
-    m_addressBook->addPerson(jane);
-    
-    Person *bob = new Person("Bob", "Johnson", m_addressBook);
-    bob->setBirthDate(QDate(1975, 3, 10));
-    bob->setEmail("bob.johnson@example.com");
-    bob->setPhone("555-9876");
-    m_addressBook->addPerson(bob);
+    m_addressBook->addContact({"John", "Doe", QDate(1980, 5, 15),
+                               "john.doe@example.com", "555-1234", false});
+    m_addressBook->addContact({"Jane", "Smith", QDate(1985, 8, 22),
+                               "jane.smith@example.com", "555-5678", true});
+    m_addressBook->addContact({"Bob", "Johnson", QDate(1975, 3, 10),
+                               "bob.johnson@example.com", "555-9876", false});
     
     setupUi();
     updatePersonList();
@@ -66,8 +65,23 @@ void MainWindow::setupUi()
     QWidget *leftWidget = new QWidget(splitter);
     QVBoxLayout *leftLayout = new QVBoxLayout(leftWidget);
     
-    m_personListWidget = new QListWidget(leftWidget);
-    leftLayout->addWidget(m_personListWidget);
+    m_searchEdit = new QLineEdit(leftWidget);
+    m_searchEdit->setPlaceholderText("Search contacts");
+    m_searchEdit->setClearButtonEnabled(true);
+    leftLayout->addWidget(m_searchEdit);
+    
+    // Rows are only created for the contacts in view, all of the same height
+    m_personListModel = new ContactListModel(m_addressBook, this);
+    m_personListView = new QListView(leftWidget);
+    m_personListView->setModel(m_personListModel);
+    m_personListView->setUniformItemSizes(true);
+    m_personListView->setSelectionMode(QAbstractItemView::SingleSelection);
+    leftLayout->addWidget(m_personListView);
+    
+    // Search results are listed a batch at a time from the event loop
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(0);
     
     m_contactCountLabel = new QLabel("Total Contacts: 0", leftWidget);
     leftLayout->addWidget(m_contactCountLabel);
@@ -127,11 +141,13 @@ void MainWindow::setupUi()
     resize(800, 500);
     
     // Connect signals/slots
-    connect(m_personListWidget, &QListWidget::currentRowChanged, 
+    connect(m_personListView->selectionModel(), &QItemSelectionModel::currentChanged, 
             this, &MainWindow::displaySelectedPerson);
     connect(m_addButton, &QPushButton::clicked, this, &MainWindow::addPerson);
     connect(m_clearButton, &QPushButton::clicked, this, &MainWindow::clearForm);
     connect(m_demoButton, &QPushButton::clicked, this, &MainWindow::showPropertyDemo);
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &MainWindow::updatePersonList);
+    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::fetchSearchResults);
     
     // Connect form field changes to update property
     connect(m_firstNameEdit, &QLineEdit::textChanged, this, &MainWindow::updatePersonProperty);
@@ -146,27 +162,29 @@ void MainWindow::addPerson()
 {
     // If m_currentPerson is not null, we're editing a person
     if (m_currentPerson) {
-        m_currentPerson = nullptr;
+        setCurrentPerson(nullptr);
         m_addButton->setText("Add Person");
         clearForm();
         return;
     }
     
-    // Create a new person with data from the form
-    Person *person = new Person(m_addressBook);
-    
-    person->setFirstName(m_firstNameEdit->text());
-    person->setLastName(m_lastNameEdit->text());
-    person->setBirthDate(m_birthDateEdit->date());
-    person->setEmail(m_emailEdit->text());
-    person->setPhone(m_phoneEdit->text());
-    person->setVip(m_vipCheckBox->isChecked());
-    
-    // Add to the address book
-    m_addressBook->addPerson(person);
+    // Create a new contact with data from the form
+    ContactStore::Contact contact;
+    contact.firstName = m_firstNameEdit->text();
+    contact.lastName = m_lastNameEdit->text();
+    contact.birthDate = m_birthDateEdit->date();
+    contact.email = m_emailEdit->text();
+    contact.phone = m_phoneEdit->text();
+    contact.vip = m_vipCheckBox->isChecked();
+    
+    // Add to the address book; the list shows it unless it is showing
+    // search results, which are searched again
+    m_addressBook->addContact(contact);
+    if (!m_searchEdit->text().trimmed().isEmpty()) {
+        startSearch();
+    }
     
     // Update UI
-    updatePersonList();
     clearForm();
 }
 
@@ -179,20 +197,21 @@ void MainWindow::clearForm()
     m_phoneEdit->clear();
     m_vipCheckBox->setChecked(false);
     
-    m_currentPerson = nullptr;
+    setCurrentPerson(nullptr);
     m_addButton->setText("Add Person");
-    m_personListWidget->clearSelection();
+    m_personListView->clearSelection();
 }
 
-void MainWindow::displaySelectedPerson(int row)
+void MainWindow::displaySelectedPerson(const QModelIndex &current)
 {
-    if (row < 0 || row >= m_personListWidget->count()) {
+    if (!current.isValid()) {
         clearForm();
         return;
     }
     
-    QString fullName = m_personListWidget->item(row)->text();
-    m_currentPerson = m_addressBook->getPersonByName(fullName);
+    // Edit the contact through its Person object
+    const AddressBook::Handle handle = m_personListModel->handleAt(current.row());
+    setCurrentPerson(m_addressBook->person(handle));
     
     if (m_currentPerson) {
         fillFormFromPerson(m_currentPerson);
@@ -206,21 +225,13 @@ void MainWindow::updatePersonProperty()
         return;
     }
     
-    // Block signals to prevent recursive updates
-    m_personListWidget->blockSignals(true);
-    
-    // Update the person with values from the form
+    // Update the person with values from the form; the list model
+    // repaints the contact's row by itself
     m_currentPerson->setFirstName(m_firstNameEdit->text());
     m_currentPerson->setLastName(m_lastNameEdit->text());
     m_currentPerson->setBirthDate(m_birthDateEdit->date());
     m_currentPerson->setEmail(m_emailEdit->text());
     m_currentPerson->setPhone(m_phoneEdit->text());
-    
-    // Update list widget
-    updatePersonList();
-    
-    // Restore signals
-    m_personListWidget->blockSignals(false);
 }
 
 void MainWindow::updateVipStatus(int state)
@@ -249,22 +260,57 @@ void MainWindow::showPropertyDemo()
 
 void MainWindow::updatePersonList()
 {
-    m_personListWidget->clear();
+    // While searching, the list shows the search results instead
+    if (!m_searchEdit->text().trimmed().isEmpty()) {
+        startSearch();
+        return;
+    }
+    
+    m_searchTimer->stop();
+    m_search = ContactSearch();
+    m_personListModel->showAllContacts();
+}
+
+void MainWindow::startSearch()
+{
+    m_searchTimer->stop();
+    m_personListModel->showContacts({});
     
-    for (Person *person : m_addressBook->getAllPeople()) {
-        QListWidgetItem *item = new QListWidgetItem(person->fullName());
-        
-        // Show VIPs in bold
-        if (person->isVip()) {
-            QFont font = item->font();
-            font.setBold(true);
-            item->setFont(font);
-        }
-        
-        m_personListWidget->addItem(item);
+    // The first results are listed right away, the rest as they are found
+    m_search = m_addressBook->search(m_searchEdit->text());
+    fetchSearchResults();
+}
+
+void MainWindow::fetchSearchResults()
+{
+    QList<ContactSearch::Match> matches;
+    const int room = MaxSearchResults - m_personListModel->rowCount();
+    const bool more = m_search.fetch(matches, qMin(room, SearchBatchSize), SearchStepBudgetNs);
+    
+    // Each batch is inserted as one block of rows
+    QList<AddressBook::Handle> handles;
+    handles.reserve(matches.size());
+    for (const ContactSearch::Match &match : matches) {
+        handles.append(match.handle);
+    }
+    m_personListModel->appendContacts(handles);
+    
+    if (more && m_personListModel->rowCount() < MaxSearchResults) {
+        m_searchTimer->start();
     }
 }
 
+void MainWindow::setCurrentPerson(Person *person)
+{
+    if (m_currentPerson == person) {
+        return;
+    }
+    
+    // Only the contact being edited keeps its Person object
+    m_addressBook->releasePerson(m_currentPerson);
+    m_currentPerson = person;
+}
+
 void MainWindow::updateContactCountLabel()
 {
     m_contactCountLabel->setText(QString("Total Contacts: %1").arg(m_addressBook->contactCount()));
@@ -375,7 +421,7 @@ void MainWindow::dynamicPropertyExample()
     info += "\nUniversal Property Access:\n";
     
     // Access Person properties by name
-    Person *person = m_addressBook->getAllPeople().first();
+    Person *person = m_addressBook->person(m_addressBook->getAllContacts().first());
     
     info += QString("- person->property(\"firstName\"): %1\n")
             .arg(person->property("firstName").toString());
@@ -385,6 +431,9 @@ void MainWindow::dynamicPropertyExample()
     
     // Clean up
     delete tmpObj;
+    if (person != m_currentPerson) {
+        m_addressBook->releasePerson(person);
+    }
     
     // Show in a message box
     QMessageBox::information(this, "Dynamic Properties", info);
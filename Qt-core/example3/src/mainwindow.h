@@ -7,9 +7,11 @@
 #include <QCheckBox>
 #include <QPushButton>
 #include <QLabel>
-#include <QListWidget>
+#include <QListView>
 #include <QGroupBox>
+#include <QTimer>
 #include "addressbook.h"
+#include "contactlistmodel.h"
 #include "person.h"
 
 class MainWindow : public QMainWindow
@@ -24,15 +26,18 @@ private slots:
     // Slots to handle UI interactions
     void addPerson();
     void clearForm();
-    void displaySelectedPerson(int row);
+    void displaySelectedPerson(const QModelIndex &current);
     void updatePersonProperty();
     void updateVipStatus(int state);
     void showPropertyDemo();
+    void fetchSearchResults();
     
 private:
     // Private methods
     void setupUi();
     void updatePersonList();
+    void startSearch();
+    void setCurrentPerson(Person *person);
     void updateContactCountLabel();
     void fillFormFromPerson(Person *person);
     
@@ -42,7 +47,9 @@ private:
     
     // Data
     AddressBook *m_addressBook;
+    ContactListModel *m_personListModel;
     Person *m_currentPerson;
+    ContactSearch m_search;
     
     // UI elements
     QWidget *m_centralWidget;
@@ -55,7 +62,9 @@ private:
     QPushButton *m_addButton;
     QPushButton *m_clearButton;
     QPushButton *m_demoButton;
-    QListWidget *m_personListWidget;
+    QLineEdit *m_searchEdit;
+    QTimer *m_searchTimer;
+    QListView *m_personListView;
     QLabel *m_contactCountLabel;
     QLabel *m_vipCountLabel;
     QGroupBox *m_formGroupBox;
@@ -32,21 +32,7 @@ QDate Person::birthDate() const
 
 int Person::age() const
 {
-    if (!m_birthDate.isValid()) {
-        return 0;
-    }
-    
-    QDate currentDate = QDate::currentDate();
-    int age = currentDate.year() - m_birthDate.year();
-    
-    // Adjust age if birthday hasn't occurred yet this year
-    if (currentDate.month() < m_birthDate.month() ||
-        (currentDate.month() == m_birthDate.month() && 
-         currentDate.day() < m_birthDate.day())) {
-        age--;
-    }
-    
-    return age;
+    return ageFor(m_birthDate);
 }
 
 QString Person::fullName() const
@@ -128,3 +114,22 @@ void Person::printInfo() const
     qDebug() << "  Phone:" << phone();
     qDebug() << "  VIP:" << (isVip() ? "Yes" : "No");
 }
+
+int Person::ageFor(const QDate &birthDate)
+{
+    if (!birthDate.isValid()) {
+        return 0;
+    }
+    
+    QDate currentDate = QDate::currentDate();
+    int age = currentDate.year() - birthDate.year();
+    
+    // Adjust age if birthday hasn't occurred yet this year
+    if (currentDate.month() < birthDate.month() ||
+        (currentDate.month() == birthDate.month() && 
+         currentDate.day() < birthDate.day())) {
+        age--;
+    }
+    
+    return age;
+}
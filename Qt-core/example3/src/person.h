@@ -47,6 +47,9 @@ public:
     // Custom method to print person info
     void printInfo() const;
     
+    // Age on today's date of someone born on birthDate, 0 for no date
+    static int ageFor(const QDate &birthDate);
+    
 signals:
     // Notification signals for property changes
     void firstNameChanged(const QString &firstName);